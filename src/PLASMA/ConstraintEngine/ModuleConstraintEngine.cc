@@ -52,7 +52,7 @@ namespace EUROPA {
       ces->registerCFunction((new CeilFunction())->getId());
 
       ConstraintEngine* ce = new ConstraintEngine(ces->getId());
-	  new DefaultPropagator(std::string("Default"), ce->getId());
+      createAgendaPropagator(*engine->getConfig(), "Default", ce->getId());
       ce->setAllowViolations(engine->getConfig()->getProperty("ConstraintEngine.allowViolations") == "true");
       
       engine->addComponent("ConstraintEngine",ce);
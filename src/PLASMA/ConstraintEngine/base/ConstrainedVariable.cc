@@ -12,6 +12,8 @@
 
 namespace EUROPA {
 
+  DEFINE_POOLED_ALLOCATION(ConstrainedVariable)
+
 ConstrainedVariableListener::ConstrainedVariableListener(const ConstrainedVariableId var)
     : m_id(this), m_var(var) {
   var->notifyAdded(m_id);
@@ -47,7 +49,7 @@ ConstrainedVariable::ConstrainedVariable(const ConstraintEngineId constraintEngi
       m_constraintEngine(constraintEngine), m_name(name), m_internal(internal),
   m_canBeSpecified(_canBeSpecified), m_specifiedFlag(false), m_specifiedValue(0),
   m_index(index), m_parent(_parent), m_deactivationRefCount(0), m_deleted(false),
-  m_listeners(), m_constraints() {
+  m_listeners(), m_constraints(), m_trailStamp(0) {
   check_error(m_constraintEngine.isValid());
   check_error(m_index == NO_INDEX || _parent.isValid());
   m_constraintEngine->add(m_id);
@@ -79,6 +81,7 @@ ConstrainedVariable::ConstrainedVariable(const ConstraintEngineId constraintEngi
     debugMsg("ConstrainedVariable:restrictBaseDomain",
 	     toString() << " restricted from " << baseDomain().toString() << " intersecting " << dom.toString());
 
+    m_constraintEngine->invalidateTrail(m_id);
     handleRestrictBaseDomain(dom);
 
     // Trigger events for propagation of this variable restriction, even if no domain restriction has occured, since it does
@@ -356,6 +359,8 @@ const std::string& ConstrainedVariable::getName() const {
     checkError(baseDomain().isMember(singletonValue), singletonValue << " not in " << baseDomain().toString());
     checkError(isActive(), toString());
 
+    m_constraintEngine->trail(m_id);
+
     bool violated = !getCurrentDomain().isMember(singletonValue);
     if(violated && getConstraintEngine()->getAllowViolations()) {
         reset();
@@ -388,6 +393,7 @@ const std::string& ConstrainedVariable::getName() const {
     checkError(domain.isSubsetOf(internal_baseDomain()),
 				 domain.toString() << " not in " << internal_baseDomain().toString());
 
+    m_constraintEngine->trail(m_id);
     m_specifiedFlag = false;
     getCurrentDomain().reset(domain);
   }
@@ -396,6 +402,7 @@ const std::string& ConstrainedVariable::getName() const {
     checkError(internal_baseDomain().isOpen(),
 	       "Attempted to close a variable but the base domain is already closed.");
 
+    m_constraintEngine->invalidateTrail(m_id);
     internal_baseDomain().close();
 
     if(getCurrentDomain().isOpen())
@@ -412,6 +419,7 @@ const std::string& ConstrainedVariable::getName() const {
 
     bool needReset = internal_baseDomain().isSingleton();
 
+    m_constraintEngine->invalidateTrail(m_id);
     internal_baseDomain().open();
     if(getCurrentDomain().isClosed())
       getCurrentDomain().open();
@@ -421,10 +429,13 @@ const std::string& ConstrainedVariable::getName() const {
   }
 
   void ConstrainedVariable::touch() {
+    m_constraintEngine->trail(m_id);
     getCurrentDomain().touch();
   }
 
   void ConstrainedVariable::relax() {
+    m_constraintEngine->trail(m_id);
+
     // If it has been specified, relax to the specified domain
     if(m_specifiedFlag)
       getCurrentDomain().relax(m_specifiedValue);
@@ -435,6 +446,7 @@ const std::string& ConstrainedVariable::getName() const {
   void ConstrainedVariable::insert(edouble value) {
     // the base domain has to be open in order for insertion to occur
     check_error(internal_baseDomain().isOpen(), "Can't insert a member into a variable with a closed base domain.");
+    m_constraintEngine->invalidateTrail(m_id);
     internal_baseDomain().insert(value);
 
     // Pass on insertion to derived domain if the variable has not yet been specified
@@ -444,6 +456,7 @@ const std::string& ConstrainedVariable::getName() const {
 
   void ConstrainedVariable::remove(edouble value) {
     // Always remove from base domain
+    m_constraintEngine->invalidateTrail(m_id);
     internal_baseDomain().remove(value);
 
     // Remove from derived domain
@@ -11,6 +11,7 @@
 #include "ConstraintEngineDefs.hh"
 #include "PSConstraintEngine.hh"
 #include "Entity.hh"
+#include "MemoryPool.hh"
 #include "unused.hh"
 #include <set>
 
@@ -54,6 +55,7 @@ namespace EUROPA {
   class ConstrainedVariable : public virtual PSVariable, public Entity {
   public:
     DECLARE_ENTITY_TYPE(ConstrainedVariable);
+    DECLARE_POOLED_ALLOCATION
 
     static const std::string& NO_NAME(); 
 
@@ -523,6 +525,8 @@ namespace EUROPA {
     ConstraintList m_constraints; /**< Holds the list of Constraint/Argument pairs. The argument indicates the
 				    index within the constraint scope, allowing for more efficient notification.
 				    @see reset() */
+    unsigned int m_trailStamp; /**< Stamp of the most recent trail level holding a copy of the derived domain.
+				 Zero if none. @see ConstraintEngine::pushTrail() */
   };
 
   /**
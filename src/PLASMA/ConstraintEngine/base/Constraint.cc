@@ -10,6 +10,8 @@
 
 namespace EUROPA {
 
+  DEFINE_POOLED_ALLOCATION(Constraint)
+
 Constraint::Constraint(const std::string& name,
                        const std::string& propagatorName,
                        const ConstraintEngineId constraintEngine,
@@ -25,6 +27,9 @@ Constraint::Constraint(const std::string& name,
     , m_createdBy("UNKNOWN")
     , m_deactivationRefCount(0)
     , m_isRedundant(false)
+    , m_isQueued(false)
+    , m_agendaPosition(0)
+    , m_eventMasks()
 {
   check_error(m_constraintEngine.isValid());
   check_error(!m_variables.empty());
@@ -208,6 +213,13 @@ const std::string& Constraint::getCreatedBy() const {return m_createdBy;}
     return false;
   }
 
+  void Constraint::setEventMask(unsigned int argIndex, DomainListener::EventMask mask) {
+    checkError(argIndex < m_variables.size(), "No argument " << argIndex << " in " << toString());
+    if(m_eventMasks.empty())
+      m_eventMasks.resize(m_variables.size(), DomainListener::EventMask(DomainListener::ALL_EVENTS));
+    m_eventMasks[argIndex] = mask | DomainListener::RELAXATION_EVENTS;
+  }
+
 const std::vector<ConstrainedVariableId>&
 Constraint::getModifiedVariables(const ConstrainedVariableId) const {
   return getScope();
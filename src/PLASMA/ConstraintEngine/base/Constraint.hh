@@ -10,6 +10,7 @@
  */
 
 #include "Entity.hh"
+#include "MemoryPool.hh"
 #include "ConstraintEngineDefs.hh"
 #include "PSConstraintEngine.hh"
 #include "DomainListener.hh"
@@ -47,6 +48,7 @@ namespace EUROPA {
   class Constraint : public virtual PSConstraint, public Entity {
   public:
     DECLARE_ENTITY_TYPE(Constraint);
+    DECLARE_POOLED_ALLOCATION
 
     /**
      * @brief Constructor for NARY constraint
@@ -153,6 +155,26 @@ namespace EUROPA {
      */
     inline bool isRedundant() const {return m_isRedundant;}
 
+    /**
+     * @brief Test if the constraint is currently held on the agenda of its propagator.
+     *
+     * Maintained by propagators with unordered agendas (e.g. PriorityPropagator) so that duplicate
+     * insertions can be suppressed without a lookup.
+     */
+    inline bool isQueued() const {return m_isQueued;}
+
+    /**
+     * @brief Update the agenda membership flag. Only the owner propagator should call this.
+     */
+    inline void setQueued(bool queued) {m_isQueued = queued;}
+
+    /**
+     * @brief Where the constraint was placed on its propagator's agenda, while isQueued(). Only the
+     * owner propagator should use these.
+     */
+    inline unsigned long getAgendaPosition() const {return m_agendaPosition;}
+    inline void setAgendaPosition(unsigned long position) {m_agendaPosition = position;}
+
     /**
      * @brief If the constraint is violated this must return a value >=0. It'll return 0 otherwise.
      */
@@ -270,6 +292,27 @@ namespace EUROPA {
      */
     virtual const std::vector<ConstrainedVariableId>& getModifiedVariables() const;
 
+    /**
+     * @brief Declare the change events on the given argument that can affect this constraint.
+     *
+     * By default a constraint is woken by every event on every argument. Derived classes whose filtering does
+     * not depend on state can call this from their constructor, so that the ConstraintEngine never routes
+     * irrelevant events to them at all. Relaxation events are always delivered. canIgnore() is still
+     * consulted for the events that remain.
+     * @param argIndex - the position of the variable within the constraint scope.
+     * @param mask - the events subscribed to.
+     * @see DomainListener::EventMask, ConstraintEngine::notify()
+     */
+    void setEventMask(unsigned int argIndex, DomainListener::EventMask mask);
+
+    /**
+     * @brief True if the given change on the given argument can affect this constraint.
+     * @see setEventMask()
+     */
+    inline bool isSubscribed(unsigned int argIndex, const DomainListener::ChangeType& changeType) const {
+      return m_eventMasks.empty() || (m_eventMasks[argIndex] & DomainListener::mask(changeType)) != 0;
+    }
+
     /**
      * @brief Allow implementation class to take action in the event of activation
      */
@@ -308,6 +351,9 @@ namespace EUROPA {
     const std::string m_createdBy; /**< Populated on construction. Indicates the user that created the constraint. */
     unsigned int m_deactivationRefCount; /*!< Tracks number of outstanding deactivation calls */
     bool m_isRedundant; /*!< True of the constraint is redundant */
+    bool m_isQueued; /*!< True if the constraint is on its propagator's agenda */
+    unsigned long m_agendaPosition; /*!< Meaningful only while m_isQueued */
+    std::vector<DomainListener::EventMask> m_eventMasks; /*!< Subscriptions by argument. Empty while subscribed to everything. */
   };
 
   std::vector<ConstrainedVariableId> makeScope(const ConstrainedVariableId arg1);
@@ -311,12 +311,18 @@ DomainListenerId ConstraintEngine::allocateVariableListener(const ConstrainedVar
     , m_dirty(false)
     , m_cycleCount(1)
     , m_mostRecentRepropagation(1)
+    , m_skippedWakeupCount(0)
     , m_listeners()
     , m_redundantConstraints()
     , m_violationMgr(NULL)
     , m_autoPropagate(true)
     , m_schema(schema)
     , m_callbacks()
+    , m_trail()
+    , m_trailLevels()
+    , m_trailStamp(0)
+    , m_retractingTrail(false)
+    , m_trailRelaxed()
   {
     m_violationMgr = new ViolationMgrImpl(0, *this);
   }
@@ -365,6 +371,7 @@ DomainListenerId ConstraintEngine::allocateVariableListener(const ConstrainedVar
 
   void ConstraintEngine::purge() {
     m_purged = true;
+    clearTrail();
     // Iteratively delete constraints. Note that each deletion will update the set
     // through notification of removal.
     check_error(Entity::isPurging() || m_constraints.empty());
@@ -397,6 +404,12 @@ DomainListenerId ConstraintEngine::allocateVariableListener(const ConstrainedVar
       delete static_cast<Propagator*>(prop);
     }
 
+    MemoryPool::trimAll();
+  }
+
+  void ConstraintEngine::getAllocationStats(std::vector<std::pair<std::string, MemoryPool::Stats> >& results) const {
+    check_error(results.empty());
+    MemoryPool::getAllStats(results);
   }
 
   bool ConstraintEngine::provenInconsistent() const {
@@ -455,6 +468,18 @@ DomainListenerId ConstraintEngine::allocateVariableListener(const ConstrainedVar
     if(Entity::isPurging())
       return;
 
+    // No level this variable predates can be restored without it, and its entries must not be used again
+    if(!m_trailLevels.empty()){
+      invalidateTrail(variable);
+      if(variable->m_trailStamp != 0){
+        for(std::vector<TrailEntry>::iterator it = m_trail.begin(); it != m_trail.end(); ++it)
+          if(it->var == variable)
+            it->var = ConstrainedVariableId::noId();
+      }
+    }
+    if(!m_trailRelaxed.empty())
+      m_trailRelaxed.erase(variable);
+
     if(getViolationMgr().isEmpty(variable))
       clearEmptyVariables();
 
@@ -501,6 +526,11 @@ void ConstraintEngine::add(const ConstraintId constraint, const std::string& pro
 
     constraint->getPropagator()->removeConstraint(constraint);
 
+    // Removing a constraint that predates a trail level changes the network that level would restore
+    for(std::vector<TrailLevel>::reverse_iterator it = m_trailLevels.rbegin();
+        it != m_trailLevels.rend() && constraint->getKey() <= it->constraintKey; ++it)
+      it->exact = false;
+
     // If the constraint is inactive, there is no need to relax. So just worry if it is actually active
     if(constraint->isActive()){
     	debugMsg("ConstraintEngine:remove:Constraint",
@@ -509,7 +539,10 @@ void ConstraintEngine::add(const ConstraintId constraint, const std::string& pro
     	const std::vector<ConstrainedVariableId>& scope = constraint->getModifiedVariables();
     	for(std::vector<ConstrainedVariableId>::const_iterator it = scope.begin(); it != scope.end(); ++it){
     		ConstrainedVariableId id(*it);
-    		if(id->lastRelaxed() < m_cycleCount)
+    		// When retracting a trail level, popTrail() restores these instead
+    		if(m_retractingTrail)
+    		  m_trailRelaxed.insert(id);
+    		else if(id->lastRelaxed() < m_cycleCount)
 		  id->relax();
     	}
     }
@@ -776,6 +809,15 @@ void ConstraintEngine::notify(const ConstrainedVariableId source,
 
   m_dirty = true;
 
+  // A change to a variable which predates the top trail level, but was not recorded in it, cannot be undone from the trail
+  if(!m_trailLevels.empty() && !m_retractingTrail){
+    const TrailLevel& level = m_trailLevels.back();
+    if(source->m_trailStamp != level.stamp && source->getKey() <= level.variableKey){
+      debugMsg("ConstraintEngine:trail", "Unrecorded change to " << source->toString());
+      m_trailLevels.back().exact = false;
+    }
+  }
+
   // If variable is inavtice, no impact.
   if(!source->isActive())
     return;
@@ -789,15 +831,21 @@ void ConstraintEngine::notify(const ConstrainedVariableId source,
     handleRestrict(source);
 
 
-  // In all cases, notify the propagators as well, unless over-ruled by by an empty variable or a decision to ignore it
-  for(ConstraintList::const_iterator it = source->m_constraints.begin(); it != source->m_constraints.end(); ++it){
-    const ConstraintId constraint = it->first;
-    checkError(constraint.isValid(), "Constraint is invalid on " << source->toLongString());
-    unsigned int argIndex = it->second;
-    if(constraint->isActive() &&
-       changeType != DomainListener::EMPTIED &&
-       !constraint->canIgnore(source, argIndex, changeType))
-      constraint->getPropagator()->handleNotification(source, argIndex, constraint, changeType);
+  // In all cases, notify the propagators as well, unless over-ruled by by an empty variable or a decision to ignore it.
+  // Constraints not subscribed to this kind of change on the variable are not asked at all.
+  if(changeType != DomainListener::EMPTIED) {
+    for(ConstraintList::const_iterator it = source->m_constraints.begin(); it != source->m_constraints.end(); ++it){
+      const ConstraintId constraint = it->first;
+      checkError(constraint.isValid(), "Constraint is invalid on " << source->toLongString());
+      unsigned int argIndex = it->second;
+      if(!constraint->isSubscribed(argIndex, changeType)) {
+        m_skippedWakeupCount++;
+        continue;
+      }
+      if(constraint->isActive() &&
+         !constraint->canIgnore(source, argIndex, changeType))
+        constraint->getPropagator()->handleNotification(source, argIndex, constraint, changeType);
+    }
   }
 
   publish(notifyChanged(source, changeType));
@@ -860,6 +908,12 @@ void ConstraintEngine::notify(const ConstrainedVariableId source,
 	getViolationMgr().relaxEmptyVariables();
     }
 
+    // When retracting a trail level, popTrail() decides what else to relax
+    if(m_retractingTrail){
+      m_trailRelaxed.insert(variable);
+      return;
+    }
+
 
     m_relaxing = true;
 
@@ -910,6 +964,8 @@ void ConstraintEngine::notify(const ConstrainedVariableId source,
 
     publish(notifyExecuted(constraint));
 
+    trail(constraint->getModifiedVariables());
+
     debugMsg("ConstraintEngine:execute", "BEFORE " << constraint->toLongString());
     constraint->execute();
     debugMsg("ConstraintEngine:execute", "AFTER " << constraint->toLongString());
@@ -926,6 +982,7 @@ void ConstraintEngine::notify(const ConstrainedVariableId source,
     check_error(m_propInProgress);
     publish(notifyExecuted(constraint));
     debugMsg("ConstraintEngine:execute", constraint->getName() << "(" << constraint->getKey() << ")");
+    trail(constraint->getModifiedVariables());
     constraint->execute(variable, argIndex, changeType);
   }
 
@@ -1065,6 +1122,11 @@ const PropagatorId ConstraintEngine::getPropagatorByName(const std::string& name
 	return m_violationMgr->getAllViolations();
   }
 
+  const ConstrainedVariableSet& ConstraintEngine::getEmptyVariables() const
+  {
+    return m_violationMgr->getEmptyVariables();
+  }
+
 
   void ConstraintEngine::notifyViolationAdded(ConstraintId constraint)
   {
@@ -1083,6 +1145,143 @@ const PropagatorId ConstraintEngine::getPropagatorByName(const std::string& name
 
   bool ConstraintEngine::isRelaxed() const {return !m_relaxed.empty();}
 
+  unsigned int ConstraintEngine::pushTrail() {
+    checkError(!m_propInProgress, "Cannot push a trail level during propagation.");
+    checkError(!m_retractingTrail, "Cannot push a trail level while retracting one.");
+
+    TrailLevel level;
+    level.stamp = ++m_trailStamp;
+    level.start = m_trail.size();
+    level.variableKey = (m_variables.empty() ? eint(-1) : (*m_variables.rbegin())->getKey());
+    level.constraintKey = (m_constraints.empty() ? eint(-1) : (*m_constraints.rbegin())->getKey());
+    level.variableCount = m_variables.size();
+    level.constraintCount = m_constraints.size();
+    // Restoring only reproduces the state at the push, so that state has to be a fixpoint. Violations
+    // are managed by deactivating constraints, which the trail does not record.
+    level.exact = !pending() && !getAllowViolations();
+    m_trailLevels.push_back(level);
+
+    debugMsg("ConstraintEngine:trail", "Pushed level " << m_trailLevels.size() << (level.exact ? "" : " (inexact)"));
+    return m_trailLevels.size();
+  }
+
+  void ConstraintEngine::retractTrail() {
+    checkError(!m_trailLevels.empty(), "No trail level to retract.");
+    checkError(!m_propInProgress, "Cannot retract a trail level during propagation.");
+    m_retractingTrail = true;
+  }
+
+  bool ConstraintEngine::popTrail() {
+    checkError(!m_trailLevels.empty(), "No trail level to pop.");
+    checkError(!m_propInProgress, "Cannot pop a trail level during propagation.");
+
+    const TrailLevel level = m_trailLevels.back();
+    m_trailLevels.pop_back();
+
+    const bool exact = level.exact &&
+      m_variables.size() == level.variableCount &&
+      m_constraints.size() == level.constraintCount;
+
+    debugMsg("ConstraintEngine:trail",
+             "Popping level " << m_trailLevels.size() + 1 << " with " << m_trail.size() - level.start <<
+             " domains" << (exact ? "" : ", relaxing instead"));
+
+    // Newest first, handing each variable back the stamp it had before this level
+    m_retractingTrail = true;
+    while(m_trail.size() > level.start){
+      TrailEntry& entry = m_trail.back();
+      if(entry.var.isId()){
+        entry.var->m_trailStamp = entry.stamp;
+        if(exact)
+          restoreDomain(entry.var, *entry.domain);
+        else
+          m_trailRelaxed.insert(entry.var);
+      }
+      delete entry.domain;
+      m_trail.pop_back();
+    }
+    m_retractingTrail = false;
+
+    // Relaxing can lead to variables being deleted, which takes them out of m_trailRelaxed
+    while(!exact && !m_trailRelaxed.empty()){
+      ConstrainedVariableId var = *m_trailRelaxed.begin();
+      m_trailRelaxed.erase(m_trailRelaxed.begin());
+      var->relax();
+      if(var->isActive())
+        handleRelax(var);
+    }
+
+    m_trailRelaxed.clear();
+    return exact;
+  }
+
+  void ConstraintEngine::clearTrail() {
+    for(std::vector<TrailEntry>::const_iterator it = m_trail.begin(); it != m_trail.end(); ++it){
+      if(it->var.isId() && !Entity::isPurging())
+        it->var->m_trailStamp = 0;
+      delete it->domain;
+    }
+    m_trail.clear();
+    m_trailLevels.clear();
+    m_trailRelaxed.clear();
+    m_retractingTrail = false;
+  }
+
+  unsigned int ConstraintEngine::getTrailDepth() const {return m_trailLevels.size();}
+
+  void ConstraintEngine::trail(const std::vector<ConstrainedVariableId>& vars) {
+    if(m_trailLevels.empty())
+      return;
+
+    for(std::vector<ConstrainedVariableId>::const_iterator it = vars.begin(); it != vars.end(); ++it)
+      recordDomain(*it);
+  }
+
+  void ConstraintEngine::recordDomain(const ConstrainedVariableId var) {
+    TrailLevel& level = m_trailLevels.back();
+    if(m_retractingTrail || var->m_trailStamp == level.stamp || var->getKey() > level.variableKey)
+      return;
+
+    const Domain& dom = var->lastDomain();
+    // Open domains can grow as well as shrink, so they cannot simply be restored
+    if(dom.isOpen() || dom.isEmpty())
+      level.exact = false;
+
+    m_trail.push_back(TrailEntry(var, var->m_trailStamp, dom.copy()));
+    var->m_trailStamp = level.stamp;
+  }
+
+  void ConstraintEngine::invalidateTrail(const ConstrainedVariableId var) {
+    for(std::vector<TrailLevel>::reverse_iterator it = m_trailLevels.rbegin();
+        it != m_trailLevels.rend() && var->getKey() <= it->variableKey; ++it)
+      it->exact = false;
+  }
+
+  void ConstraintEngine::restoreDomain(const ConstrainedVariableId var, const Domain& dom) {
+    Domain& current = var->getCurrentDomain();
+    if(current == dom)
+      return;
+
+    debugMsg("ConstraintEngine:trail", "Restoring " << var->toString() << " to " << dom.toString());
+
+    if(current.isEmpty() || current.isSubsetOf(dom))
+      current.relax(dom);
+    else {
+      var->relax();
+      current.intersect(dom);
+    }
+  }
+
+  void ConstraintEngine::restrictDomain(const ConstrainedVariableId var, const Domain& dom) {
+    checkError(!m_propInProgress, "Cannot restrict a domain during propagation.");
+    Domain& current = var->getCurrentDomain();
+    if(current == dom)
+      return;
+
+    debugMsg("ConstraintEngine:restrictDomain", "Restricting " << var->toString() << " to " << dom.toString());
+    current.intersect(dom);
+  }
+
   PSVariable* ConstraintEngine::getVariableByKey(PSEntityKey id)
   {
     ConstrainedVariableId entity = Entity::getEntity(id);
@@ -15,10 +15,12 @@
 #include "Entity.hh"
 #include "Propagator.hh"
 #include "ConstrainedVariable.hh"
+#include "MemoryPool.hh"
 
 #include <set>
 #include <map>
 #include <string>
+#include <vector>
 
 namespace EUROPA {
 
@@ -166,9 +168,16 @@ typedef Id<ConstraintEngineListener> ConstraintEngineListenerId;
 
     /**
      * @brief purge all elements from the Engine. Will delete all variables, constraints, and propagators.
+     * Memory freed by the deletions is then returned to the system.
      */
     void purge();
 
+    /**
+     * @brief Retrieve statistics of the memory pools from which variables, constraints, domains and
+     * tokens are allocated, by pool name. The pools are shared by all engines in the process.
+     */
+    void getAllocationStats(std::vector<std::pair<std::string, MemoryPool::Stats> >& results) const;
+
     /**
      * @brief test if the state is PROVEN_INCONSISTENT.
      */
@@ -201,6 +210,15 @@ typedef Id<ConstraintEngineListener> ConstraintEngineListenerId;
      */
     unsigned int mostRecentRepropagation() const;
 
+    /**
+     * @brief Count of constraints not woken by a change to one of their variables because they are not
+     * subscribed to that kind of change.
+     * @see Constraint::setEventMask()
+     */
+    inline unsigned long skippedWakeupCount() const {
+      return m_skippedWakeupCount;
+    }
+
     /**
      * @brief Initiate propagation of any pending domain change events.
      * Engine must be in a PENDING or CONSTRAINT_CONSISTENT state.
@@ -301,11 +319,61 @@ typedef Id<ConstraintEngineListener> ConstraintEngineListenerId;
      */
     bool isViolated(ConstraintId c) const;
 
+    /**
+     * @brief The variables emptied by the last propagation, if it failed and violations are not allowed.
+     * Cleared when the network is relaxed.
+     */
+    const ConstrainedVariableSet& getEmptyVariables() const;
+
     /**
      * @brief Test of the network is in a relaxed state
      */
     bool isRelaxed() const;
 
+    /**
+     * @brief Open a new level on the domain trail. While any level is open, the derived domain of a variable
+     * is copied to the trail before it first changes within the level, so that popTrail() can put the network
+     * back without relaxing and repropagating it. Intended for chronological search, where everything done after
+     * the push is retracted before the matching pop. Should be called on a propagated network.
+     * @return The number of open levels, including this one.
+     * @see retractTrail(), popTrail(), clearTrail()
+     */
+    unsigned int pushTrail();
+
+    /**
+     * @brief Announce that the changes made since the top level was pushed are about to be retracted.
+     * Until the matching popTrail(), relaxations caused by the retraction are not spread to linked variables,
+     * since popTrail() will restore the recorded domains instead.
+     */
+    void retractTrail();
+
+    /**
+     * @brief Close the top level of the trail, restoring every recorded domain to its value at the time of the push.
+     * If the network was not propagated at the push, or changed in a way the trail cannot undo (a variable or constraint
+     * older than the level was removed, a base domain was changed, a change was not recorded), the recorded and retracted
+     * variables are relaxed and their linked variables with them, exactly as if no trail had been kept.
+     * @return true if the domains were restored from the trail, false if it fell back to relaxation.
+     */
+    bool popTrail();
+
+    /**
+     * @brief Discard all levels of the trail without restoring anything. Use before retractions which
+     * are not chronological.
+     */
+    void clearTrail();
+
+    /**
+     * @brief The number of open trail levels.
+     */
+    unsigned int getTrailDepth() const;
+
+    /**
+     * @brief Restrict the derived domain of a variable to the domain it had in a propagated network, without
+     * executing any constraint. Used to restore a checkpoint. Constraints on the variable are notified as usual,
+     * so the next propagation checks the result, but once every variable is restored it has nothing left to narrow.
+     */
+    void restrictDomain(const ConstrainedVariableId var, const Domain& dom);
+
     const CESchemaId getCESchema() const;
 
     // PSConstraintEngine methods
@@ -542,6 +610,51 @@ typedef Id<ConstraintEngineListener> ConstraintEngineListenerId;
 				   std::list<ConstrainedVariableId>::iterator pos,
 				   ConstrainedVariableSet& visitedVars);
 
+    /**
+     * @brief Record the derived domain of the given variable(s) on the top trail level, if the variable predates the level
+     * and has not been recorded in it yet. Called before any change to a derived domain.
+     */
+    inline void trail(const ConstrainedVariableId var) {
+      if(!m_trailLevels.empty())
+        recordDomain(var);
+    }
+    void trail(const std::vector<ConstrainedVariableId>& vars);
+    void recordDomain(const ConstrainedVariableId var);
+
+    /**
+     * @brief Mark every open trail level that the given variable predates as not restorable. Called before any
+     * change to a base domain.
+     */
+    void invalidateTrail(const ConstrainedVariableId var);
+
+    /**
+     * @brief Change the derived domain of var back to dom, a domain it held earlier.
+     */
+    void restoreDomain(const ConstrainedVariableId var, const Domain& dom);
+
+    /**
+     * @brief A derived domain copied to the trail, with the trail stamp the variable carried before.
+     */
+    struct TrailEntry {
+      TrailEntry(const ConstrainedVariableId v, unsigned int s, Domain* d) : var(v), stamp(s), domain(d) {}
+      ConstrainedVariableId var; /*!< noId once the variable has been deleted. */
+      unsigned int stamp;
+      Domain* domain;
+    };
+
+    /**
+     * @brief Bookkeeping for one level of the trail.
+     */
+    struct TrailLevel {
+      unsigned int stamp; /*!< Unique across levels, compared with ConstrainedVariable::m_trailStamp. */
+      unsigned int start; /*!< Index of the first entry of this level in m_trail. */
+      eint variableKey; /*!< Key of the newest variable when pushed. Younger variables are not recorded. */
+      eint constraintKey; /*!< Key of the newest constraint when pushed. */
+      unsigned int variableCount;
+      unsigned int constraintCount;
+      bool exact; /*!< False once the level can no longer be restored from its entries. */
+    };
+
 
     ConstraintEngineId m_id;
     ConstrainedVariableSet m_variables; /*!< The set of all variables under the control of the ConstraintEngine. */
@@ -563,6 +676,7 @@ typedef Id<ConstraintEngineListener> ConstraintEngineListenerId;
     unsigned int m_cycleCount; /*!< A monotonically increasing count of propagation cycles. Identifies
                                  when propagation events have already been queued or handled. */
     unsigned int m_mostRecentRepropagation; /*!< A monotonically increasing record of cycles where a relaxation occurred. */
+    unsigned long m_skippedWakeupCount; /*!< @see skippedWakeupCount() */
 
     std::set<ConstraintEngineListenerId> m_listeners; /*!< Stores the set of registered listeners. */
 
@@ -573,6 +687,12 @@ typedef Id<ConstraintEngineListener> ConstraintEngineListenerId;
 
     const CESchemaId m_schema;
     std::list<PostPropagationCallbackId> m_callbacks; /*!< Post-propagation callbacks */
+
+    std::vector<TrailEntry> m_trail; /*!< Recorded domains of all open levels, oldest first. */
+    std::vector<TrailLevel> m_trailLevels; /*!< Open trail levels, innermost last. */
+    unsigned int m_trailStamp; /*!< Stamp of the most recently pushed level. */
+    bool m_retractingTrail; /*!< Set between retractTrail() and popTrail(). */
+    ConstrainedVariableSet m_trailRelaxed; /*!< Variables whose relaxation was not spread while retracting. */
   };
 
   /**
@@ -17,6 +17,7 @@ DataType::DataType(const std::string& name)
     , m_name(name)
     , m_isRestricted(false)
     , m_baseDomain(NULL)
+    , m_enumeration(NULL)
     , m_minDelta(EPSILON)
 {
 }
@@ -27,6 +28,8 @@ DataType::~DataType()
 
     if (m_baseDomain != NULL)
         delete m_baseDomain;
+
+    delete m_enumeration;
 }
 
 const DataTypeId DataType::getId() const { return m_id; }
@@ -80,6 +83,19 @@ const Domain & DataType::baseDomain() const
     return *m_baseDomain;
 }
 
+void DataType::setEnumeration(const Domain& _baseDomain)
+{
+    delete m_enumeration;
+    m_enumeration = NULL;
+
+    if (!_baseDomain.isEnumerated() || _baseDomain.isOpen() || _baseDomain.isEmpty())
+        return;
+
+    std::list<edouble> values;
+    _baseDomain.getValues(values);
+    m_enumeration = new std::vector<edouble>(values.begin(), values.end());
+}
+
 edouble DataType::minDelta() const
 {
     return m_minDelta;
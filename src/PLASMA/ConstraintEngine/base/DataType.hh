@@ -10,6 +10,7 @@
 
 #include "ConstraintEngineDefs.hh"
 #include "ConstrainedVariable.hh"
+#include <vector>
 
 namespace EUROPA {
 
@@ -101,6 +102,12 @@ class DataType: public PSDataType {
    */
   virtual const Domain& baseDomain() const;
 
+  /**
+   * @brief The sorted values of the base domain if it is a closed enumeration, otherwise NULL.
+   * Enumerated domains of this type share it as the universe their membership bits are indexed against.
+   */
+  const std::vector<edouble>* getEnumeration() const { return m_enumeration; }
+
   /**
    * @brief Create a value for a string
    */
@@ -128,10 +135,16 @@ class DataType: public PSDataType {
                                                unsigned int index = ConstrainedVariable::NO_INDEX) const;
 
  protected:
+  /**
+   * @brief Record the values of the given domain as the enumeration of this type, if it is a closed enumeration.
+   */
+  void setEnumeration(const Domain& baseDomain);
+
   DataTypeId m_id;
   std::string m_name;
   bool m_isRestricted;
   Domain* m_baseDomain;
+  std::vector<edouble>* m_enumeration;
   edouble m_minDelta; /**< The minimum amount by which elements of this data type may vary.  Once this is set, DO NOT CHANGE IT.*/
  private:
   DataType(const DataType& other);
@@ -7,6 +7,8 @@
 
 namespace EUROPA {
 
+  DEFINE_POOLED_ALLOCATION(Domain)
+
   ostream& operator<<(ostream& os, const Domain& dom) {
     dom >> os;
     return(os);
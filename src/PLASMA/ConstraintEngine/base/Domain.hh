@@ -38,6 +38,7 @@
 #include "ConstraintEngineDefs.hh"
 #include "DomainListener.hh"
 #include "Number.hh"
+#include "MemoryPool.hh"
 #include <list>
 #include <string>
 
@@ -99,6 +100,8 @@ class LabelStr;
      */
     virtual ~Domain();
 
+    DECLARE_POOLED_ALLOCATION
+
     /**
      * @brief Check if the domain is an enumerated set.
      */
@@ -460,7 +463,7 @@ class LabelStr;
      */
     static void assertSafeComparison(const Domain& domA, const Domain& domB);
 
-    void setDataType(const DataTypeId dt);
+    virtual void setDataType(const DataTypeId dt);
     friend class RestrictedDT;
 
     DataTypeId m_dataType;
@@ -70,6 +70,30 @@ namespace EUROPA{
       return changeType <= RESTRICT_TO_SINGLETON;
     }
 
+    /**
+     * @brief A set of ChangeTypes, one bit per type. Used by constraints to subscribe, per argument, to the
+     * events that can affect them.
+     * @see Constraint::setEventMask()
+     */
+    typedef unsigned int EventMask;
+
+    /**
+     * @brief The singleton event set for the given change type
+     */
+    inline static EventMask mask(const ChangeType& changeType){
+      return (1u << changeType);
+    }
+
+    /**
+     * @brief Events that every subscriber receives, since they may undo earlier inference.
+     */
+    static const EventMask RELAXATION_EVENTS = (1u << RESET) | (1u << RELAXED) | (1u << CLOSED) | (1u << OPENED);
+
+    /**
+     * @brief Every event. The default subscription for a constraint argument.
+     */
+    static const EventMask ALL_EVENTS = (1u << LAST_CHANGE_TYPE) - 1;
+
     /**
      * @brief Constructor sets up the Id.
      */
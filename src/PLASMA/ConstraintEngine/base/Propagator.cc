@@ -58,6 +58,7 @@ const std::string& Propagator::getName() const {return m_name;}
 
   Domain& Propagator::getCurrentDomain(const ConstrainedVariableId var) {
     check_error(var.isValid());
+    var->getConstraintEngine()->trail(var);
     return var->getCurrentDomain();
   }
 
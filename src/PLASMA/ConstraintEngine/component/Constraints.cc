@@ -16,6 +16,7 @@ namespace EUROPA {
     : Constraint("UNARY", "Default", var->getConstraintEngine(), makeScope(var)),
       m_x(dom.copy()),
       m_y(static_cast<Domain*>(& (getCurrentDomain(var)))) {
+    setEventMask(0, DomainListener::RELAXATION_EVENTS);
   }
 
   UnaryConstraint::UnaryConstraint(const std::string& name,
@@ -26,6 +27,7 @@ namespace EUROPA {
       m_x(0),
       m_y(static_cast<Domain*>(& (getCurrentDomain(variables[0])))) {
     checkError(variables.size() == 1, "Invalid arg count. " << toString());
+    setEventMask(0, DomainListener::RELAXATION_EVENTS);
   }
 
   /**
@@ -572,6 +574,7 @@ bool updateDivBounds(IntervalDomain& domZ,
       m_superSetDomain(getCurrentDomain(variables[1])){
     check_error(variables.size() == 2);
     check_error(Domain::canBeCompared(m_currentDomain, m_superSetDomain));
+    setEventMask(0, DomainListener::RELAXATION_EVENTS);
   }
 
   SubsetOfConstraint::~SubsetOfConstraint() {}
@@ -603,6 +606,8 @@ bool SubsetOfConstraint::canIgnore(const ConstrainedVariableId,
     checkError(variables.size() == ARG_COUNT, toString());
     checkError(m_x.isNumeric(), variables[X]->toString());
     checkError(m_y.isNumeric(), variables[Y]->toString());
+    setEventMask(X, DomainListener::ALL_EVENTS & ~DomainListener::mask(DomainListener::UPPER_BOUND_DECREASED));
+    setEventMask(Y, DomainListener::ALL_EVENTS & ~DomainListener::mask(DomainListener::LOWER_BOUND_INCREASED));
   }
 
   void LessThanEqualConstraint::handleExecute() {
@@ -732,6 +737,8 @@ bool NotEqualConstraint::canIgnore(const ConstrainedVariableId variable,
                                          const std::vector<ConstrainedVariableId>& variables)
     : Constraint(name, propagatorName, constraintEngine, variables) {
     check_error(variables.size() == ARG_COUNT);
+    setEventMask(X, DomainListener::ALL_EVENTS & ~DomainListener::mask(DomainListener::UPPER_BOUND_DECREASED));
+    setEventMask(Y, DomainListener::ALL_EVENTS & ~DomainListener::mask(DomainListener::LOWER_BOUND_INCREASED));
   }
 
   void LessThanConstraint::handleExecute() {
@@ -196,6 +196,8 @@ RestrictedDT::RestrictedDT(const std::string& name, const DataTypeId baseType,
     : DataType(name)
     , m_baseType(baseType)
 {
+    // Set first, so that the base domain is packed against it once it takes this type
+    setEnumeration(_baseDomain);
     m_baseDomain = _baseDomain.copy();
     m_baseDomain->setDataType(getId());
     setIsRestricted(true);
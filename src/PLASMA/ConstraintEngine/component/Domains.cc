@@ -31,14 +31,52 @@ namespace EUROPA {
 //     return(true);
 //   }
 
+  namespace {
+    // Word operations on the packed form of EnumeratedDomain
+    inline unsigned int countBits(unsigned long word) {
+#ifdef __GNUC__
+      return __builtin_popcountl(word);
+#else
+      unsigned int count = 0;
+      for ( ; word != 0; word &= word - 1)
+        count++;
+      return count;
+#endif
+    }
+
+    inline unsigned int lowestBit(unsigned long word) {
+#ifdef __GNUC__
+      return __builtin_ctzl(word);
+#else
+      unsigned int bit = 0;
+      for ( ; (word & 1) == 0; word >>= 1)
+        bit++;
+      return bit;
+#endif
+    }
+
+    inline unsigned int highestBit(unsigned long word) {
+#ifdef __GNUC__
+      return sizeof(unsigned long) * 8 - 1 - __builtin_clzl(word);
+#else
+      unsigned int bit = 0;
+      for ( ; word > 1; word >>= 1)
+        bit++;
+      return bit;
+#endif
+    }
+  }
+
 EnumeratedDomain::EnumeratedDomain(const DataTypeId dt)
-    : Domain(dt,true,false), m_values()
+    : Domain(dt,true,false), m_values(), m_universe(NULL), m_valuesUniverse(NULL)
 {
+  clearMembers();
 }
 
 EnumeratedDomain::EnumeratedDomain(const DataTypeId dt, const std::list<edouble>& values)
-    : Domain(dt,true,false), m_values()
+    : Domain(dt,true,false), m_values(), m_universe(NULL), m_valuesUniverse(NULL)
 {
+  clearMembers();
   for (std::list<edouble>::const_iterator it = values.begin(); it != values.end(); ++it)
     insert(*it);
 
@@ -46,26 +84,36 @@ EnumeratedDomain::EnumeratedDomain(const DataTypeId dt, const std::list<edouble>
 }
 
 EnumeratedDomain::EnumeratedDomain(const DataTypeId dt, edouble value)
-    : Domain(dt,true,false), m_values()
+    : Domain(dt,true,false), m_values(), m_universe(NULL), m_valuesUniverse(NULL)
 {
+  clearMembers();
   insert(value);
   close();
 }
 
 EnumeratedDomain::EnumeratedDomain(const DataTypeId dt, double value)
-    : Domain(dt,true,false), m_values()
+    : Domain(dt,true,false), m_values(), m_universe(NULL), m_valuesUniverse(NULL)
 {
+  clearMembers();
   insert(value);
   close();
 }
 
 EnumeratedDomain::EnumeratedDomain(const Domain& org)
-    : Domain(org), m_values()
+    : Domain(org), m_values(), m_universe(NULL), m_valuesUniverse(NULL)
 {
   check_error(org.isEnumerated(),
               "Invalid source domain " + org.getTypeName() + " for enumeration");
   const EnumeratedDomain& enumOrg = static_cast<const EnumeratedDomain&>(org);
-  m_values = enumOrg.m_values;
+  m_universe = enumOrg.m_universe;
+  for (unsigned int i = 0; i < PACKED_WORDS; i++)
+    m_members[i] = enumOrg.m_members[i];
+
+  if (!isPacked()) {
+    m_values = enumOrg.m_values;
+    if (isClosed())
+      pack();
+  }
 }
 
   bool EnumeratedDomain::isFinite() const {
@@ -73,31 +121,52 @@ EnumeratedDomain::EnumeratedDomain(const Domain& org)
   }
 
   bool EnumeratedDomain::isSingleton() const {
-	  return(m_values.size() == 1);
+	  return(getSize() == 1);
   }
 
   bool EnumeratedDomain::isEmpty() const {
-	  return(m_values.empty());
+	  if (!isPacked())
+		  return(m_values.empty());
+
+	  for (unsigned int i = 0; i < PACKED_WORDS; i++)
+		  if (m_members[i] != 0)
+			  return(false);
+	  return(true);
   }
 
   void EnumeratedDomain::empty() {
 	  m_values.clear();
+	  clearMembers();
 	  notifyChange(DomainListener::EMPTIED);
   }
 
   void EnumeratedDomain::close() {
+    if (isOpen())
+      pack();
     Domain::close();
     //commenting this out because ascending is a requirement of the std::set type, and the empty check by itself is nonsensical
     //check_error(isEmpty() || isAscending(m_values));
   }
 
+  void EnumeratedDomain::open() {
+    unpack();
+    Domain::open();
+  }
+
   Domain::size_type EnumeratedDomain::getSize() const {
-	  return(m_values.size());
+	  if (!isPacked())
+		  return(m_values.size());
+
+	  size_type size = 0;
+	  for (unsigned int i = 0; i < PACKED_WORDS; i++)
+		  size += countBits(m_members[i]);
+	  return(size);
   }
 
   void EnumeratedDomain::insert(edouble value) {
 	  check_error(check_value(value));
 	  checkError(isOpen(), "Cannot insert into a closed domain." << toString());
+	  check_error(!isPacked());
 	  std::set<edouble>::iterator it = m_values.begin();
 	  for ( ; it != m_values.end(); it++) {
 		  if (compareEqual(value, *it))
@@ -119,13 +188,24 @@ EnumeratedDomain::EnumeratedDomain(const Domain& org)
 
   void EnumeratedDomain::remove(edouble value) {
 	  check_error(check_value(value));
-	  std::set<edouble>::iterator it = m_values.begin();
-	  for ( ; it != m_values.end(); it++)
-		  if (compareEqual(value, *it))
-			  break;
-	  if (it == m_values.end())
-		  return; // not present: no-op
-	  m_values.erase(it);
+	  if (isPacked()) {
+		  int index = getIndex(*m_universe, value);
+		  if (index < 0)
+			  return; // not present: no-op
+		  Word bit = Word(1) << (index % WORD_BITS);
+		  if ((m_members[index / WORD_BITS] & bit) == 0)
+			  return;
+		  m_members[index / WORD_BITS] &= ~bit;
+	  }
+	  else {
+		  std::set<edouble>::iterator it = m_values.begin();
+		  for ( ; it != m_values.end(); it++)
+			  if (compareEqual(value, *it))
+				  break;
+		  if (it == m_values.end())
+			  return; // not present: no-op
+		  m_values.erase(it);
+	  }
 	  if (!isEmpty() || isOpen())
 		  notifyChange(DomainListener::VALUE_REMOVED);
 	  else
@@ -137,8 +217,15 @@ EnumeratedDomain::EnumeratedDomain(const Domain& org)
 		  close();
 
 	  if(isMember(value)){
-		  m_values.clear();
-		  m_values.insert(value);
+		  if (isPacked()) {
+			  int index = getIndex(*m_universe, value);
+			  clearMembers();
+			  m_members[index / WORD_BITS] = Word(1) << (index % WORD_BITS);
+		  }
+		  else {
+			  m_values.clear();
+			  m_values.insert(value);
+		  }
 		  // Generate the notification, even if already a singleton. This is because setting a value to a singleton
 		  // is different from restricting it.
 		  notifyChange(DomainListener::SET_TO_SINGLETON);
@@ -178,43 +265,71 @@ EnumeratedDomain::EnumeratedDomain(const Domain& org)
 	  bool changed_b = false;
 	  EnumeratedDomain& l_dom = static_cast<EnumeratedDomain&>(dom);
 
-	  std::set<edouble>::iterator it_a = m_values.begin();
-	  std::set<edouble>::iterator it_b = l_dom.m_values.begin();
+	  if (isEmpty() || l_dom.isEmpty())
+		  return(false);
 
-	  while (it_a != m_values.end() && it_b != l_dom.m_values.end()) {
-		  edouble val_a = *it_a;
-		  edouble val_b = *it_b;
+	  if (sharesUniverse(l_dom)) {
+		  Word both[PACKED_WORDS];
+		  bool intersects = false;
+		  for (unsigned int i = 0; i < PACKED_WORDS; i++) {
+			  both[i] = m_members[i] & l_dom.m_members[i];
+			  intersects = intersects || both[i] != 0;
+		  }
 
-		  if (compareEqual(val_a, val_b)) {
-			  ++it_a;
-			  ++it_b;
-		  } else
-			  if (val_a < val_b) {
-				  std::set<edouble>::iterator target = m_values.lower_bound(val_b);
-				  m_values.erase(it_a, target);
-				  it_a = target;
-				  changed_a = true;
-				  check_error(!isMember(val_a));
-			  } else {
-				  std::set<edouble>::iterator target = l_dom.m_values.lower_bound(val_a);
-				  l_dom.m_values.erase(it_b, target);
-				  it_b = target;
-				  changed_b = true;
-				  check_error(!l_dom.isMember(val_b));
+		  // As below, only one side is emptied if there is no intersection
+		  for (unsigned int i = 0; i < PACKED_WORDS; i++) {
+			  changed_a = changed_a || both[i] != m_members[i];
+			  m_members[i] = both[i];
+			  if (intersects) {
+				  changed_b = changed_b || both[i] != l_dom.m_members[i];
+				  l_dom.m_members[i] = both[i];
 			  }
+		  }
+	  }
+	  else if (isPacked() || l_dom.isPacked()) {
+		  changed_a = restrictTo(l_dom);
+		  if (!isEmpty())
+			  changed_b = l_dom.restrictTo(*this);
 	  }
+	  else {
+		  std::set<edouble>::iterator it_a = m_values.begin();
+		  std::set<edouble>::iterator it_b = l_dom.m_values.begin();
+
+		  while (it_a != m_values.end() && it_b != l_dom.m_values.end()) {
+			  edouble val_a = *it_a;
+			  edouble val_b = *it_b;
 
-	  if (it_a != m_values.end() && !l_dom.isEmpty()) {
-		  m_values.erase(it_a, m_values.end());
-		  changed_a = true;
-		  check_error(it_b == l_dom.m_values.end());
-	  } else
-		  if (it_b != l_dom.m_values.end() && !isEmpty()) {
-			  l_dom.m_values.erase(it_b, l_dom.m_values.end());
-			  changed_b = true;
-			  check_error(it_a == m_values.end());
+			  if (compareEqual(val_a, val_b)) {
+				  ++it_a;
+				  ++it_b;
+			  } else
+				  if (val_a < val_b) {
+					  std::set<edouble>::iterator target = m_values.lower_bound(val_b);
+					  m_values.erase(it_a, target);
+					  it_a = target;
+					  changed_a = true;
+					  check_error(!isMember(val_a));
+				  } else {
+					  std::set<edouble>::iterator target = l_dom.m_values.lower_bound(val_a);
+					  l_dom.m_values.erase(it_b, target);
+					  it_b = target;
+					  changed_b = true;
+					  check_error(!l_dom.isMember(val_b));
+				  }
 		  }
 
+		  if (it_a != m_values.end() && !l_dom.isEmpty()) {
+			  m_values.erase(it_a, m_values.end());
+			  changed_a = true;
+			  check_error(it_b == l_dom.m_values.end());
+		  } else
+			  if (it_b != l_dom.m_values.end() && !isEmpty()) {
+				  l_dom.m_values.erase(it_b, l_dom.m_values.end());
+				  changed_b = true;
+				  check_error(it_a == m_values.end());
+			  }
+	  }
+
 	  if (changed_a) {
 		  if (isEmpty())
 			  notifyChange(DomainListener::EMPTIED);
@@ -236,11 +351,16 @@ EnumeratedDomain::EnumeratedDomain(const Domain& org)
 	  }
 
 	  check_error(!isEmpty() || ! dom.isEmpty());
-	  check_error(isEmpty() || dom.isEmpty() || (l_dom.m_values == m_values));
+	  check_error(isEmpty() || dom.isEmpty() || (*this == l_dom));
 	  return(changed_a || changed_b);
   }
 
   bool EnumeratedDomain::isMember(edouble value) const {
+    if (isPacked()) {
+      int index = getIndex(*m_universe, value);
+      return index >= 0 && (m_members[index / WORD_BITS] & (Word(1) << (index % WORD_BITS))) != 0;
+    }
+
     if (m_values.empty())
       return false;
     std::set<edouble>::const_iterator it = m_values.lower_bound(value);
@@ -284,17 +404,16 @@ EnumeratedDomain::EnumeratedDomain(const Domain& org)
 	  const EnumeratedDomain& l_dom = static_cast<const EnumeratedDomain&>(dom);
 	  if (!Domain::operator==(dom))
 		  return(false);
+	  if (sharesUniverse(l_dom)) {
+		  for (unsigned int i = 0; i < PACKED_WORDS; i++)
+			  if (m_members[i] != l_dom.m_members[i])
+				  return(false);
+		  return(true);
+	  }
 	  // If any member of either is not a member of the other, they're not equal.
 	  // Since membership is not simple (due to minDelta()), this has to be done
 	  // via a scan of both memberships, one member at a time.
-	  std::set<edouble>::const_iterator it = m_values.begin();
-	  for ( ; it != m_values.end(); it++)
-		  if (!l_dom.isMember(*it))
-			  return(false);
-	  for (it = l_dom.m_values.begin(); it != l_dom.m_values.end(); it++)
-		  if (!isMember(*it))
-			  return(false);
-	  return(true);
+	  return(membersIn(l_dom) && l_dom.membersIn(*this));
   }
 
   bool EnumeratedDomain::operator!=(const Domain& dom) const {
@@ -309,7 +428,7 @@ EnumeratedDomain::EnumeratedDomain(const Domain& org)
 
 	  if (isEmpty() || this->isSubsetOf(dom)){
 		  const EnumeratedDomain& l_dom = static_cast<const EnumeratedDomain&>(dom);
-		  m_values = l_dom.m_values;
+		  assign(l_dom);
 		  // Open up if we are closed and need be be relaxed to an open domain
 		  if(dom.isOpen() && isClosed())
 			  open();
@@ -322,13 +441,19 @@ EnumeratedDomain::EnumeratedDomain(const Domain& org)
 	  checkError(isEmpty() || (isSingleton() && (getSingletonValue() == value)), toString());
 
 	  if (isEmpty()){
-		  m_values.insert(value);
+		  addValue(value);
 		  notifyChange(DomainListener::RELAXED);
 	  }
   }
 
   edouble EnumeratedDomain::getSingletonValue() const {
 	  checkError(isSingleton(), toString());
+	  if (isPacked()) {
+		  unsigned int w = 0;
+		  while (m_members[w] == 0)
+			  w++;
+		  return((*m_universe)[w * WORD_BITS + lowestBit(m_members[w])]);
+	  }
 	  return(*m_values.begin());
   }
 
@@ -336,14 +461,39 @@ EnumeratedDomain::EnumeratedDomain(const Domain& org)
 	  check_error(results.empty());
 	  check_error(isFinite());
 
+	  if (isPacked()) {
+		  for (unsigned int w = 0; w < PACKED_WORDS; w++)
+			  for (Word bits = m_members[w]; bits != 0; bits &= bits - 1)
+				  results.push_back((*m_universe)[w * WORD_BITS + lowestBit(bits)]);
+		  return;
+	  }
+
 	  for (std::set<edouble>::const_iterator it = m_values.begin(); it != m_values.end(); ++it)
 		  results.push_back(*it);
   }
 
   const std::set<edouble>& EnumeratedDomain::getValues() const{
+	  if (isPacked() && !valuesCurrent()) {
+		  m_values.clear();
+		  for (unsigned int w = 0; w < PACKED_WORDS; w++)
+			  for (Word bits = m_members[w]; bits != 0; bits &= bits - 1)
+				  m_values.insert(m_values.end(), (*m_universe)[w * WORD_BITS + lowestBit(bits)]);
+		  m_valuesUniverse = m_universe;
+		  for (unsigned int i = 0; i < PACKED_WORDS; i++)
+			  m_valuesMembers[i] = m_members[i];
+	  }
 	  return m_values;
   }
 
+  bool EnumeratedDomain::valuesCurrent() const {
+	  if (m_valuesUniverse != m_universe)
+		  return false;
+	  for (unsigned int i = 0; i < PACKED_WORDS; i++)
+		  if (m_valuesMembers[i] != m_members[i])
+			  return false;
+	  return true;
+  }
+
   edouble EnumeratedDomain::getUpperBound() const {
 	  edouble lb, ub;
 	  getBounds(lb, ub);
@@ -358,8 +508,20 @@ EnumeratedDomain::EnumeratedDomain(const Domain& org)
 
   bool EnumeratedDomain::getBounds(edouble& lb, edouble& ub) const {
 	  check_error(!isEmpty());
-	  lb = *m_values.begin();
-	  ub = *(--m_values.end());
+	  if (isPacked()) {
+		  unsigned int first = 0;
+		  while (m_members[first] == 0)
+			  first++;
+		  unsigned int last = PACKED_WORDS - 1;
+		  while (m_members[last] == 0)
+			  last--;
+		  lb = (*m_universe)[first * WORD_BITS + lowestBit(m_members[first])];
+		  ub = (*m_universe)[last * WORD_BITS + highestBit(m_members[last])];
+	  }
+	  else {
+		  lb = *m_values.begin();
+		  ub = *(--m_values.end());
+	  }
 	  check_error(lb <= ub);
 	  return(!isNumeric() || lb == MINUS_INFINITY || ub == PLUS_INFINITY);
   }
@@ -372,7 +534,7 @@ EnumeratedDomain::EnumeratedDomain(const Domain& org)
 	  if(isOpen() && dom.isClosed()){
 		  checkError(!dom.isInterval(), "Cannot intersect a closed interval and and open enumeration.");
 		  const EnumeratedDomain& l_dom = static_cast<const EnumeratedDomain&>(dom);
-		  m_values = l_dom.m_values;
+		  assign(l_dom);
 
 		  // Only close when values are added as it will otherwise generate an empty domain event
 		  close();
@@ -385,7 +547,17 @@ EnumeratedDomain::EnumeratedDomain(const Domain& org)
 
 	  bool changed = false;
 
-	  if (dom.isInterval()) {
+	  if (sharesUniverse(dom)) {
+		  const EnumeratedDomain& l_dom = static_cast<const EnumeratedDomain&>(dom);
+		  for (unsigned int i = 0; i < PACKED_WORDS; i++) {
+			  Word both = m_members[i] & l_dom.m_members[i];
+			  changed = changed || both != m_members[i];
+			  m_members[i] = both;
+		  }
+	  }
+	  else if (isPacked())
+		  changed = restrictTo(dom);
+	  else if (dom.isInterval()) {
 		  std::set<edouble>::iterator it = m_values.begin();
 		  while (it != m_values.end()) {
 			  edouble value = *it;
@@ -400,8 +572,9 @@ EnumeratedDomain::EnumeratedDomain(const Domain& org)
 				  ++it;
 			  }
 		  }
-	  } else if (dom.isOpen())
-		  return false;
+	  }
+	  else if (static_cast<const EnumeratedDomain&>(dom).isPacked())
+		  changed = restrictTo(dom);
 	  else {
 		  const EnumeratedDomain& l_dom = static_cast<const EnumeratedDomain&>(dom);
 		  std::set<edouble>::iterator it_a = m_values.begin();
@@ -463,16 +636,36 @@ EnumeratedDomain::EnumeratedDomain(const Domain& org)
 	  // are present in dom, remove them.
 	  bool value_removed = false;
 
-	  for (std::set<edouble>::iterator it = m_values.begin(); it != m_values.end();) {
-		  edouble value = *it;
-		  if (dom.isMember(value)) {
-			  m_values.erase(it++);
-			  value_removed = true;
-		  } else
-			  ++it;
+	  if (sharesUniverse(dom)) {
+		  const EnumeratedDomain& l_dom = static_cast<const EnumeratedDomain&>(dom);
+		  for (unsigned int i = 0; i < PACKED_WORDS; i++) {
+			  Word rest = m_members[i] & ~l_dom.m_members[i];
+			  value_removed = value_removed || rest != m_members[i];
+			  m_members[i] = rest;
+		  }
+	  }
+	  else if (isPacked()) {
+		  for (unsigned int w = 0; w < PACKED_WORDS; w++)
+			  for (Word bits = m_members[w]; bits != 0; bits &= bits - 1) {
+				  unsigned int bit = lowestBit(bits);
+				  if (dom.isMember((*m_universe)[w * WORD_BITS + bit])) {
+					  m_members[w] &= ~(Word(1) << bit);
+					  value_removed = true;
+				  }
+			  }
+	  }
+	  else {
+		  for (std::set<edouble>::iterator it = m_values.begin(); it != m_values.end();) {
+			  edouble value = *it;
+			  if (dom.isMember(value)) {
+				  m_values.erase(it++);
+				  value_removed = true;
+			  } else
+				  ++it;
+		  }
 	  }
 
-	  if (m_values.empty())
+	  if (isEmpty())
 		  notifyChange(DomainListener::EMPTIED);
 	  else
 		  if (value_removed)
@@ -485,7 +678,7 @@ Domain& EnumeratedDomain::operator=(const Domain& dom) {
   safeComparison(*this, dom);
   check_error(m_listener.isNoId(), "Can only do direct assigment if not registered with a listener");
   const EnumeratedDomain& e_dom = dynamic_cast<const EnumeratedDomain&>(dom);
-  m_values = e_dom.m_values;
+  assign(e_dom);
   return *this;
 }
 
@@ -499,11 +692,15 @@ Domain& EnumeratedDomain::operator=(const Domain& dom) {
 	  else if(isOpen())
 		  return false;
 
-	  for (std::set<edouble>::const_iterator it = m_values.begin(); it != m_values.end(); ++it)
-		  if (!dom.isMember(*it))
-			  return(false);
+	  if (sharesUniverse(dom)) {
+		  const EnumeratedDomain& l_dom = static_cast<const EnumeratedDomain&>(dom);
+		  for (unsigned int i = 0; i < PACKED_WORDS; i++)
+			  if ((m_members[i] & ~l_dom.m_members[i]) != 0)
+				  return(false);
+		  return(true);
+	  }
 
-	  return(true);
+	  return(membersIn(dom));
   }
 
   bool EnumeratedDomain::intersects(const Domain& dom) const {
@@ -511,6 +708,22 @@ Domain& EnumeratedDomain::operator=(const Domain& dom) {
 		  return true;
 
 	  safeComparison(*this, dom);
+	  if (sharesUniverse(dom)) {
+		  const EnumeratedDomain& l_dom = static_cast<const EnumeratedDomain&>(dom);
+		  for (unsigned int i = 0; i < PACKED_WORDS; i++)
+			  if ((m_members[i] & l_dom.m_members[i]) != 0)
+				  return(true);
+		  return(false);
+	  }
+
+	  if (isPacked()) {
+		  for (unsigned int w = 0; w < PACKED_WORDS; w++)
+			  for (Word bits = m_members[w]; bits != 0; bits &= bits - 1)
+				  if (dom.isMember((*m_universe)[w * WORD_BITS + lowestBit(bits)]))
+					  return(true);
+		  return(false);
+	  }
+
 	  for (std::set<edouble>::const_iterator it = m_values.begin(); it != m_values.end(); ++it)
 		  if (dom.isMember(*it))
 			  return(true);
@@ -526,7 +739,8 @@ Domain& EnumeratedDomain::operator=(const Domain& dom) {
 	  std::set<std::string> orderedSet;
 
 	  std::string comma = "";
-	  for (std::set<edouble>::const_iterator it = m_values.begin(); it != m_values.end(); ++it) {
+	  const std::set<edouble>& values = getValues();
+	  for (std::set<edouble>::const_iterator it = values.begin(); it != values.end(); ++it) {
 		  edouble valueAsDouble = *it;
 		  std::string valueAsStr = getDataType()->toString(valueAsDouble);
 
@@ -550,6 +764,133 @@ Domain& EnumeratedDomain::operator=(const Domain& dom) {
 
 void EnumeratedDomain::testPrecision(const edouble&) const {}
 
+  void EnumeratedDomain::setDataType(const DataTypeId dt) {
+	  unpack();
+	  Domain::setDataType(dt);
+	  if (isClosed())
+		  pack();
+  }
+
+  void EnumeratedDomain::addValue(edouble value) {
+	  if (isPacked()) {
+		  int index = getIndex(*m_universe, value);
+		  if (index >= 0) {
+			  m_members[index / WORD_BITS] |= Word(1) << (index % WORD_BITS);
+			  return;
+		  }
+		  unpack();
+	  }
+	  m_values.insert(value);
+  }
+
+  void EnumeratedDomain::pack() {
+	  if (isPacked())
+		  return;
+
+	  const std::vector<edouble>* universe = getDataType()->getEnumeration();
+	  if (universe == NULL || universe->size() > PACKED_CAPACITY)
+		  return;
+
+	  Word members[PACKED_WORDS];
+	  for (unsigned int i = 0; i < PACKED_WORDS; i++)
+		  members[i] = 0;
+
+	  for (std::set<edouble>::const_iterator it = m_values.begin(); it != m_values.end(); ++it) {
+		  int index = getIndex(*universe, *it);
+		  if (index < 0)
+			  return; // Not drawn from the enumeration, so stay as a set
+		  members[index / WORD_BITS] |= Word(1) << (index % WORD_BITS);
+	  }
+
+	  m_universe = universe;
+	  for (unsigned int i = 0; i < PACKED_WORDS; i++)
+		  m_members[i] = members[i];
+	  m_values.clear();
+	  m_valuesUniverse = NULL;
+  }
+
+  void EnumeratedDomain::unpack() {
+	  if (!isPacked())
+		  return;
+
+	  getValues();
+	  m_universe = NULL;
+	  m_valuesUniverse = NULL;
+	  clearMembers();
+  }
+
+  bool EnumeratedDomain::sharesUniverse(const Domain& dom) const {
+	  return(isPacked() && dom.isEnumerated() &&
+			  static_cast<const EnumeratedDomain&>(dom).m_universe == m_universe);
+  }
+
+  int EnumeratedDomain::getIndex(const std::vector<edouble>& universe, edouble value) const {
+	  std::vector<edouble>::const_iterator it = std::lower_bound(universe.begin(), universe.end(), value);
+	  // As in isMember(), the match may be just below the value
+	  if (it != universe.end() && (value == *it || compareEqual(value, *it)))
+		  return(it - universe.begin());
+	  if (it != universe.begin() && compareEqual(value, *(it - 1)))
+		  return(it - universe.begin() - 1);
+	  return(-1);
+  }
+
+  void EnumeratedDomain::assign(const EnumeratedDomain& dom) {
+	  if (isClosed() && dom.isPacked() && dom.m_universe == getDataType()->getEnumeration()) {
+		  m_universe = dom.m_universe;
+		  for (unsigned int i = 0; i < PACKED_WORDS; i++)
+			  m_members[i] = dom.m_members[i];
+		  m_values.clear();
+		  m_valuesUniverse = NULL;
+		  return;
+	  }
+
+	  m_universe = NULL;
+	  clearMembers();
+	  m_values = dom.getValues();
+	  if (isClosed())
+		  pack();
+  }
+
+  bool EnumeratedDomain::restrictTo(const Domain& dom) {
+	  bool changed = false;
+
+	  if (isPacked()) {
+		  for (unsigned int w = 0; w < PACKED_WORDS; w++)
+			  for (Word bits = m_members[w]; bits != 0; bits &= bits - 1) {
+				  unsigned int bit = lowestBit(bits);
+				  if (!dom.isMember((*m_universe)[w * WORD_BITS + bit])) {
+					  m_members[w] &= ~(Word(1) << bit);
+					  changed = true;
+				  }
+			  }
+		  return(changed);
+	  }
+
+	  for (std::set<edouble>::iterator it = m_values.begin(); it != m_values.end();) {
+		  if (!dom.isMember(*it)) {
+			  m_values.erase(it++);
+			  changed = true;
+		  } else
+			  ++it;
+	  }
+	  return(changed);
+  }
+
+  bool EnumeratedDomain::membersIn(const Domain& dom) const {
+	  if (isPacked()) {
+		  for (unsigned int w = 0; w < PACKED_WORDS; w++)
+			  for (Word bits = m_members[w]; bits != 0; bits &= bits - 1)
+				  if (!dom.isMember((*m_universe)[w * WORD_BITS + lowestBit(bits)]))
+					  return(false);
+		  return(true);
+	  }
+
+	  for (std::set<edouble>::const_iterator it = m_values.begin(); it != m_values.end(); ++it)
+		  if (!dom.isMember(*it))
+			  return(false);
+	  return(true);
+  }
+
   std::string EnumeratedDomain::toString() const
   {
 	  return Domain::toString();
@@ -1006,7 +1347,7 @@ StringDomain::StringDomain(const std::list<LabelStr>& values, const DataTypeId d
     checkError(isEmpty() || isMember(value), value << " is not a member of the domain :" << toString());
 
     // Insert the value into the set as a special behavior for strings
-    m_values.insert(value);
+    addValue(value);
     EnumeratedDomain::set(value);
   }
 
@@ -1015,7 +1356,7 @@ void StringDomain::set(const LabelStr& value) {
              value << " is not a member of the domain :" << toString());
 
   // Insert the value into the set as a special behavior for strings
-  m_values.insert(value);
+  addValue(value);
   EnumeratedDomain::set(value);
 }
 
@@ -17,8 +17,10 @@ namespace EUROPA {
    * @class EnumeratedDomain
    * @brief Declares an enumerated domain of doubles..
    *
-   * The implementation uses a sorted set of doubles which hold all the values possible in the set, and then refines membership using
-   * a bit vector.
+   * The implementation uses a sorted set of doubles which hold all the values possible in the set. Once closed, a domain whose
+   * data type has a small enumeration (see DataType::getEnumeration()) is packed instead: membership is held as a bit vector
+   * indexed against that enumeration, which is shared by all domains of the type. Operations between domains packed against
+   * the same enumeration then work a word at a time.
    */
   class EnumeratedDomain : public Domain {
   public:
@@ -84,6 +86,12 @@ namespace EUROPA {
 	   */
 	  void close();
 
+	  /**
+	   * @brief Over-ride to return to the set representation, since values may be inserted once open.
+	   * @see Domain::open()
+	   */
+	  void open();
+
 	  /**
 	   * @brief Return the number of elements in the set.
 	   * @return isEmpty() <=> 0, isSingleton() <=> 1
@@ -167,6 +175,8 @@ namespace EUROPA {
 
 	  /**
 	   * @brief Retrieve the contents as a set
+	   * @note Packed domains build the set on demand, so prefer the other accessors where possible. The set stays
+	   * valid, and is not rebuilt, until the domain changes.
 	   */
 	  const std::set<edouble>& getValues() const;
 
@@ -283,12 +293,81 @@ namespace EUROPA {
 	   */
     virtual void testPrecision(const edouble& value) const;
 
+	  /**
+	   * @brief Over-ride to pack against the enumeration of the new type, if it has one.
+	   */
+	  void setDataType(const DataTypeId dt);
+
 	  /**
 	   * @brief Implements equate where both are closed enumerations
 	   */
 	  bool equateClosedEnumerations(EnumeratedDomain& dom);
 
-	  std::set<edouble> m_values; /**< Holds the contents from which the set membership is then derived. */
+	  /**
+	   * @brief Add a value without generating an event, falling back to the set representation if it
+	   * is not in the enumeration.
+	   */
+	  void addValue(edouble value);
+
+	  typedef unsigned long Word;
+	  enum { PACKED_WORDS = 4, WORD_BITS = sizeof(Word) * 8, PACKED_CAPACITY = PACKED_WORDS * WORD_BITS };
+
+	  bool isPacked() const {return m_universe != NULL;}
+
+	  /**
+	   * @brief Switch to the bit vector if the data type has an enumeration of at most PACKED_CAPACITY values
+	   * which includes every member.
+	   */
+	  void pack();
+
+	  /**
+	   * @brief Switch back to the set representation.
+	   */
+	  void unpack();
+
+	  /**
+	   * @brief True if both domains are packed against the same enumeration, so their bit vectors line up.
+	   */
+	  bool sharesUniverse(const Domain& dom) const;
+
+	  /**
+	   * @brief Position of the value in the given enumeration, or -1 if it is not there.
+	   */
+	  int getIndex(const std::vector<edouble>& universe, edouble value) const;
+
+	  /**
+	   * @brief Take the members of the given domain, without generating an event.
+	   */
+	  void assign(const EnumeratedDomain& dom);
+
+	  /**
+	   * @brief Remove all members which are not members of the given domain, without generating an event.
+	   * @return true if any were removed.
+	   */
+	  bool restrictTo(const Domain& dom);
+
+	  /**
+	   * @brief True if every member is a member of the given domain.
+	   */
+	  bool membersIn(const Domain& dom) const;
+
+	  void clearMembers() { for(unsigned int i = 0; i < PACKED_WORDS; i++) m_members[i] = 0; }
+
+	  /**
+	   * @brief True if, when packed, m_values holds the current members, as last built by getValues().
+	   */
+	  bool valuesCurrent() const;
+
+	  /**
+	   * @brief Holds the contents when not packed. When packed, only a copy built on demand by getValues(),
+	   * kept until the members change so that references and iterators to it stay valid as long as the domain
+	   * is unchanged.
+	   */
+	  mutable std::set<edouble> m_values;
+	  const std::vector<edouble>* m_universe; /**< The enumeration indexing m_members. NULL unless packed. */
+	  Word m_members[PACKED_WORDS]; /**< Bit i is set iff (*m_universe)[i] is a member. Only used when packed. */
+	  mutable const std::vector<edouble>* m_valuesUniverse; /**< m_universe when m_values was last built from m_members */
+	  mutable Word m_valuesMembers[PACKED_WORDS]; /**< m_members when m_values was last built from them */
   };
 
 
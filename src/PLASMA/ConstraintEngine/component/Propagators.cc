@@ -13,6 +13,9 @@
 #include "ConstrainedVariable.hh"
 #include "Domains.hh"
 #include "Debug.hh"
+#include "Engine.hh"
+
+#include <algorithm>
 
 namespace EUROPA {
 
@@ -105,6 +108,189 @@ DefaultPropagator::DefaultPropagator(const std::string& name,
   }
 
 
+PriorityPropagator::PriorityPropagator(const std::string& name,
+                                       const ConstraintEngineId constraintEngine,
+                                       int priority)
+    : Propagator(name, constraintEngine, priority),
+      m_agendaSize(0),
+      m_activeConstraint(0) {
+    for(unsigned int i = 0; i < BUCKET_COUNT; i++)
+      m_bucketStarts[i] = 0;
+  }
+
+  PriorityPropagator::~PriorityPropagator(){
+    // Constraints may outlive us during a purge, so leave no stale flags behind
+    if(!Entity::isPurging())
+      clearAgenda();
+  }
+
+  unsigned int PriorityPropagator::getCostClass(const ConstraintId constraint){
+    size_t arity = constraint->getScope().size();
+    if(arity <= 2)
+      return (arity <= 1 ? 0 : 1);
+    return (arity == 3 ? 2 : BUCKET_COUNT - 1);
+  }
+
+  void PriorityPropagator::enqueue(const ConstraintId constraint){
+    if(constraint->isQueued())
+      return;
+    unsigned int costClass = getCostClass(constraint);
+    std::deque<ConstraintId>& bucket = m_buckets[costClass];
+    constraint->setQueued(true);
+    constraint->setAgendaPosition(m_bucketStarts[costClass] + bucket.size());
+    bucket.push_back(constraint);
+    m_agendaSize++;
+  }
+
+  void PriorityPropagator::dequeue(const ConstraintId constraint){
+    if(!constraint->isQueued())
+      return;
+    unsigned int costClass = getCostClass(constraint);
+    std::deque<ConstraintId>& bucket = m_buckets[costClass];
+    unsigned long index = constraint->getAgendaPosition() - m_bucketStarts[costClass];
+    check_error(index < bucket.size() && bucket[index] == constraint);
+
+    // Leave a tombstone for pop() to skip, since the constraint may be deleted before then
+    bucket[index] = ConstraintId::noId();
+    constraint->setQueued(false);
+    m_agendaSize--;
+
+    while(!bucket.empty() && bucket.back().isNoId())
+      bucket.pop_back();
+    if(m_agendaSize == 0)
+      clearAgenda();
+  }
+
+  ConstraintId PriorityPropagator::pop(){
+    check_error(m_agendaSize > 0);
+    for(unsigned int i = 0; i < BUCKET_COUNT; i++){
+      std::deque<ConstraintId>& bucket = m_buckets[i];
+      while(!bucket.empty()){
+        ConstraintId constraint = bucket.front();
+        bucket.pop_front();
+        m_bucketStarts[i]++;
+        if(constraint.isNoId())
+          continue;
+        constraint->setQueued(false);
+        m_agendaSize--;
+        return constraint;
+      }
+    }
+    return ConstraintId::noId();
+  }
+
+  void PriorityPropagator::clearAgenda(){
+    for(unsigned int i = 0; i < BUCKET_COUNT; i++){
+      std::deque<ConstraintId>& bucket = m_buckets[i];
+      for(std::deque<ConstraintId>::const_iterator it = bucket.begin(); it != bucket.end(); ++it)
+        if((*it).isId())
+          (*it)->setQueued(false);
+      m_bucketStarts[i] += bucket.size();
+      bucket.clear();
+    }
+    m_agendaSize = 0;
+  }
+
+  void PriorityPropagator::handleConstraintAdded(const ConstraintId constraint){
+    debugMsg("PriorityPropagator:handleConstraintAdded", "Adding to the agenda: " << constraint->getName() << "(" << constraint->getKey() << ")");
+    enqueue(constraint);
+  }
+
+  void PriorityPropagator::handleConstraintRemoved(const ConstraintId constraint){
+    debugMsg("PriorityPropagator:handleConstraintRemoved", "Removing from the agenda: " << constraint->getName() << "(" << constraint->getKey() << ")");
+    dequeue(constraint);
+    check_error(isValid());
+  }
+
+  void PriorityPropagator::handleConstraintActivated(const ConstraintId constraint){
+    debugMsg("PriorityPropagator:handleConstraintActivated", "Adding to the agenda: " << constraint->getName() << "(" << constraint->getKey() << ")");
+    enqueue(constraint);
+    check_error(isValid());
+  }
+
+  void PriorityPropagator::handleConstraintDeactivated(const ConstraintId constraint){
+    debugMsg("PriorityPropagator:handleConstraintDeactivated", "Removing from the agenda: " << constraint->getName() << "(" << constraint->getKey() << ")");
+    dequeue(constraint);
+    check_error(isValid());
+  }
+
+  void PriorityPropagator::handleNotification(const ConstrainedVariableId variable,
+					      unsigned int,
+					      const ConstraintId constraint,
+					      const DomainListener::ChangeType& changeType){
+    if(constraint->getKey() != m_activeConstraint) {
+      debugMsg("PriorityPropagator:handleNotification",
+          "Adding to the agenda: " << constraint->getName() << "(" << constraint->getKey() << ")"
+          << " because of " << DomainListener::toString(changeType) << " change to " << variable->toString()
+      );
+      enqueue(constraint);
+    }
+  }
+
+  void PriorityPropagator::execute(){
+    checkError(m_agendaSize > 0, "Should never be calling this with an empty agenda.");
+    check_error(!getConstraintEngine()->provenInconsistent());
+    check_error(m_activeConstraint == 0);
+
+    if(!getConstraintEngine()->provenInconsistent()){
+      ConstraintId constraint = pop();
+
+      if(constraint->isActive()){
+	m_activeConstraint = constraint->getKey();
+	Propagator::execute(constraint);
+      }
+    }
+
+    // If we can continue propagation despite the discovered inconsistency,
+    // keep agenda for when the ConstraintEngine recovers and decides to resume propagation
+    if(getConstraintEngine()->provenInconsistent()) {
+      if (getConstraintEngine()->canContinuePropagation()) {
+        debugMsg("PriorityPropagator:agenda","CE was proven inconsistent, keeping agenda because propagation can continue later");
+      }
+      else {
+        clearAgenda();
+        debugMsg("PriorityPropagator:agenda","Cleared agenda because CE was proven inconsistent");
+      }
+    }
+    m_activeConstraint = 0;
+  }
+
+  bool PriorityPropagator::updateRequired() const{
+    return (m_agendaSize > 0);
+  }
+
+  bool PriorityPropagator::isValid() const{
+    unsigned int count = 0;
+    for(unsigned int i = 0; i < BUCKET_COUNT; i++){
+      const std::deque<ConstraintId>& bucket = m_buckets[i];
+      for(std::deque<ConstraintId>::const_iterator it = bucket.begin(); it != bucket.end(); ++it){
+        ConstraintId constraint = *it;
+        if(constraint.isNoId())
+          continue;
+        checkError(constraint.isValid(), constraint);
+        checkError(constraint->isQueued(), constraint->toString() << " is on the agenda but not flagged as queued");
+        checkError(constraint->getAgendaPosition() == m_bucketStarts[i] + (it - bucket.begin()),
+                   constraint->toString() << " is not where its agenda position says");
+        count++;
+      }
+    }
+    checkError(count == m_agendaSize, "Agenda size is " << m_agendaSize << " but found " << count);
+    return true;
+  }
+
+PropagatorId createAgendaPropagator(const EngineConfig& config,
+                                    const std::string& name,
+                                    const ConstraintEngineId constraintEngine,
+                                    int priority) {
+  const std::string& agenda = config.getProperty("ConstraintEngine.agenda." + name);
+  debugMsg("createAgendaPropagator",
+           "Creating propagator " << name << " with agenda '" << agenda << "'");
+  if(agenda == "priority")
+    return (new PriorityPropagator(name, constraintEngine, priority))->getId();
+  return (new DefaultPropagator(name, constraintEngine, priority))->getId();
+}
+
+
 EqualityConstraintPropagator::EqualityConstraintPropagator(const std::string& name,
                                                            const ConstraintEngineId constraintEngine)
     : Propagator(name, constraintEngine), m_fullReprop(false), m_active(false),
@@ -11,10 +11,13 @@
 
 #include "Propagator.hh"
 #include "EquivalenceClassCollection.hh"
+#include <deque>
 #include <set>
 
 namespace EUROPA {
 
+  class EngineConfig;
+
   class DefaultPropagator: public Propagator
   {
   public:
@@ -39,6 +42,70 @@ namespace EUROPA {
     bool isValid() const;
   };
 
+  /**
+   * @class PriorityPropagator
+   * @brief Agenda-based propagator that executes cheap constraints before expensive ones.
+   *
+   * Functionally interchangeable with DefaultPropagator, but the agenda is a small, fixed array of FIFO
+   * buckets indexed by cost class rather than a set ordered by key:
+   * @li Enqueue, removal and pop are O(1). Duplicates are suppressed through Constraint::isQueued(), and a
+   * removed constraint is found through Constraint::getAgendaPosition() and left as a tombstone for pop to skip.
+   * @li Unary and binary constraints are processed before ternary ones, which are processed before n-ary
+   * (global) constraints, so cheap bound tightening is done before expensive filtering is attempted.
+   * @see createAgendaPropagator
+   */
+  class PriorityPropagator: public Propagator
+  {
+  public:
+    PriorityPropagator(const std::string& name, const ConstraintEngineId constraintEngine, int priority=USER_PRIORITY);
+    virtual ~PriorityPropagator();
+    virtual void execute();
+    virtual void execute(const ConstraintId constraint) {Propagator::execute(constraint);}
+    virtual bool updateRequired() const;
+
+    /**
+     * @brief The cost class, and hence agenda bucket, of a constraint. Lower classes run first.
+     */
+    static unsigned int getCostClass(const ConstraintId constraint);
+
+    static const unsigned int BUCKET_COUNT = 4;
+
+  protected:
+    virtual void handleConstraintAdded(const ConstraintId constrain);
+    virtual void handleConstraintRemoved(const ConstraintId constraint);
+    virtual void handleConstraintActivated(const ConstraintId constrain);
+    virtual void handleConstraintDeactivated(const ConstraintId constraint);
+    virtual void handleNotification(const ConstrainedVariableId variable,
+				    unsigned int argIndex,
+				    const ConstraintId constraint,
+				    const DomainListener::ChangeType& changeType);
+
+    void enqueue(const ConstraintId constraint);
+    void dequeue(const ConstraintId constraint);
+    ConstraintId pop();
+    void clearAgenda();
+
+    std::deque<ConstraintId> m_buckets[BUCKET_COUNT]; /**< The agenda, one FIFO per cost class. noId marks a removed entry */
+    unsigned long m_bucketStarts[BUCKET_COUNT]; /**< Agenda position of the front of each bucket */
+    unsigned int m_agendaSize; /**< Total number of queued constraints across all buckets */
+
+    eint m_activeConstraint;
+  private:
+    bool isValid() const;
+  };
+
+  /**
+   * @brief Allocate an agenda-based propagator, selecting its agenda from the engine configuration.
+   *
+   * The property "ConstraintEngine.agenda.<name>" picks the implementation. A value of "priority" yields a
+   * PriorityPropagator. Anything else, including no value, yields a DefaultPropagator.
+   * The propagator is owned, and will be cleaned up, by the ConstraintEngine.
+   */
+  PropagatorId createAgendaPropagator(const EngineConfig& config,
+                                      const std::string& name,
+                                      const ConstraintEngineId constraintEngine,
+                                      int priority=USER_PRIORITY);
+
   /**
    * @class EqualityConstraintPropagator
    * @brief Responsible for propagation management of all EqualConstraints when registered.
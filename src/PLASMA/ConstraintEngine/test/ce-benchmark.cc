@@ -0,0 +1,106 @@
+/**
+ * @file ce-benchmark.cc
+ * @brief Times propagation through chains of the arithmetic constraints, reporting
+ * constraint-chain propagations per second for each constraint type.
+ *
+ * Usage: ce-benchmark [chain length] [rounds]
+ */
+
+#include "ModuleConstraintEngine.hh"
+#include "ConstraintEngine.hh"
+#include "ConstrainedVariable.hh"
+#include "Domains.hh"
+#include "Engine.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <sys/time.h>
+#include <boost/cast.hpp>
+
+using namespace EUROPA;
+
+namespace {
+
+double now() {
+  timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+class BenchmarkEngine : public EngineBase {
+public:
+  BenchmarkEngine() {
+    addModule((new ModuleConstraintEngine())->getId());
+    addModule((new ModuleConstraintLibrary())->getId());
+    doStart();
+  }
+  ~BenchmarkEngine() {doShutdown();}
+  ConstraintEngine& getConstraintEngine() {
+    return *boost::polymorphic_cast<ConstraintEngine*>(getComponent("ConstraintEngine"));
+  }
+};
+
+/**
+ * @brief Build a chain v[i+1] = c(v[i], k[i]) (or c(v[i], v[i+1]) for binary constraints),
+ * then repeatedly pin the head of the chain and reset it, propagating each change down the chain.
+ */
+void run(ConstraintEngine& ce, const char* constraint, const char* type, bool binary,
+         const Domain& values, const Domain& factors, edouble head,
+         unsigned int length, unsigned int rounds) {
+  std::vector<ConstrainedVariableId> vars;
+  std::vector<ConstraintId> constraints;
+  vars.push_back(ce.createVariable(type, values));
+  for (unsigned int i = 0; i < length; i++) {
+    std::vector<ConstrainedVariableId> scope;
+    scope.push_back(vars.back());
+    if (!binary) {
+      vars.push_back(ce.createVariable(type, factors));
+      scope.push_back(vars.back());
+    }
+    vars.push_back(ce.createVariable(type, values));
+    scope.push_back(vars.back());
+    constraints.push_back(ce.createConstraint(constraint, scope));
+  }
+  ce.propagate();
+
+  double start = now();
+  for (unsigned int r = 0; r < rounds; r++) {
+    vars.front()->specify(head);
+    ce.propagate();
+    vars.front()->reset();
+    ce.propagate();
+  }
+  double seconds = now() - start;
+
+  std::cout << constraint << " (" << type << "): " << 2 * rounds << " propagations of " << length
+            << " constraints in " << seconds << "s";
+  if (seconds > 0)
+    std::cout << " (" << static_cast<unsigned long>(2 * rounds * length / seconds) << " constraints/s)";
+  std::cout << std::endl;
+
+  for (std::vector<ConstraintId>::const_iterator it = constraints.begin(); it != constraints.end(); ++it)
+    ce.deleteConstraint(*it);
+  for (std::vector<ConstrainedVariableId>::const_iterator it = vars.begin(); it != vars.end(); ++it)
+    delete static_cast<ConstrainedVariable*>(*it);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  const unsigned int length = (argc > 1 ? atoi(argv[1]) : 100);
+  const unsigned int rounds = (argc > 2 ? atoi(argv[2]) : 50);
+
+  BenchmarkEngine engine;
+  ConstraintEngine& ce = engine.getConstraintEngine();
+
+  run(ce, "addEq", "int", false, IntervalIntDomain(0, 1000000), IntervalIntDomain(1, 10), 5, length, rounds);
+  run(ce, "addEq", "float", false, IntervalDomain(0, 1000000), IntervalDomain(1, 10), 5, length, rounds);
+  run(ce, "leq", "int", true, IntervalIntDomain(0, 1000000), IntervalIntDomain(), 5, length, rounds);
+  run(ce, "lt", "int", true, IntervalIntDomain(0, 1000000), IntervalIntDomain(), 5, length, rounds);
+  run(ce, "lt", "float", true, IntervalDomain(0, 1000000), IntervalDomain(), 5, length, rounds);
+  run(ce, "multEq", "float", false, IntervalDomain(0, 1000), IntervalDomain(0.5, 1), 500, length, rounds);
+  run(ce, "divEq", "float", false, IntervalDomain(0, 1000), IntervalDomain(1, 2), 500, length, rounds);
+  return 0;
+}
@@ -31,6 +31,7 @@
 #include <string>
 
 #include <fstream>
+#include <sstream>
 #include <boost/cast.hpp>
 
 using namespace EUROPA;
@@ -106,6 +107,48 @@ static int s_instanceCount;
 int DelegationTestConstraint::s_executionCount = 0;
 int DelegationTestConstraint::s_instanceCount = 0;
 
+/**
+ * Records the order in which constraints are executed, without touching any domains.
+ */
+class OrderRecordingConstraint : public Constraint {
+public:
+OrderRecordingConstraint(const std::string& name,
+                         const std::string& propagatorName,
+                         const ConstraintEngineId constraintEngine,
+                         const std::vector<ConstrainedVariableId>& variables)
+    : Constraint(name, propagatorName, constraintEngine, variables){}
+
+void handleExecute(){
+s_order.push_back(getKey());
+}
+
+static std::vector<eint> s_order;
+};
+
+std::vector<eint> OrderRecordingConstraint::s_order;
+
+/**
+ * Only subscribes to lower bound increases (and, implicitly, relaxations) of its argument.
+ */
+class LowerBoundWatcher : public Constraint {
+public:
+LowerBoundWatcher(const std::string& name,
+                  const std::string& propagatorName,
+                  const ConstraintEngineId constraintEngine,
+                  const std::vector<ConstrainedVariableId>& variables)
+    : Constraint(name, propagatorName, constraintEngine, variables){
+  setEventMask(0, DomainListener::mask(DomainListener::LOWER_BOUND_INCREASED));
+}
+
+void handleExecute(){
+s_executionCount++;
+}
+
+static int s_executionCount;
+};
+
+int LowerBoundWatcher::s_executionCount = 0;
+
 typedef SymbolDomain Locations;
 
 class CETestEngine : public EngineBase
@@ -334,6 +377,131 @@ public:
     EUROPA_runCETest(testVariableLookupByIndex);
     EUROPA_runCETest(testGNATS_3133);
     EUROPA_runCETest(testPostPropagation);
+    EUROPA_runCETest(testPriorityPropagator);
+    EUROPA_runCETest(testTrail);
+    return true;
+  }
+
+  static bool testTrail() {
+    Variable<IntervalIntDomain> v0(ENGINE, IntervalIntDomain(0, 10));
+    Variable<IntervalIntDomain> v1(ENGINE, IntervalIntDomain(0, 10));
+    Variable<IntervalIntDomain> v2(ENGINE, IntervalIntDomain(0, 10));
+    ConstraintId c0 = (new EqualConstraint("EqualConstraint", "Default", ENGINE, makeScope(v0.getId(), v1.getId())))->getId();
+    CPPUNIT_ASSERT(ENGINE->propagate());
+
+    // Undoing a decision restores the domains recorded since the push
+    CPPUNIT_ASSERT(ENGINE->pushTrail() == 1);
+    v0.specify(3);
+    {
+      EqualConstraint c1("EqualConstraint", "Default", ENGINE, makeScope(v1.getId(), v2.getId()));
+      CPPUNIT_ASSERT(ENGINE->propagate());
+      CPPUNIT_ASSERT(v2.lastDomain().getSingletonValue() == 3);
+      ENGINE->retractTrail();
+      v0.reset();
+    }
+    CPPUNIT_ASSERT(ENGINE->popTrail());
+    CPPUNIT_ASSERT(ENGINE->getTrailDepth() == 0);
+    CPPUNIT_ASSERT(!v0.isSpecified());
+    CPPUNIT_ASSERT(v0.lastDomain() == IntervalIntDomain(0, 10));
+    CPPUNIT_ASSERT(v1.lastDomain() == IntervalIntDomain(0, 10));
+    CPPUNIT_ASSERT(v2.lastDomain() == IntervalIntDomain(0, 10));
+    CPPUNIT_ASSERT(ENGINE->propagate());
+    CPPUNIT_ASSERT(v1.lastDomain() == IntervalIntDomain(0, 10));
+
+    // Removing a constraint that predates the push forces the relaxation fallback
+    ENGINE->pushTrail();
+    v0.specify(3);
+    CPPUNIT_ASSERT(ENGINE->propagate());
+    ENGINE->retractTrail();
+    v0.reset();
+    delete static_cast<Constraint*>(c0);
+    CPPUNIT_ASSERT(!ENGINE->popTrail());
+    CPPUNIT_ASSERT(ENGINE->propagate());
+    CPPUNIT_ASSERT(v0.lastDomain() == IntervalIntDomain(0, 10));
+    CPPUNIT_ASSERT(v1.lastDomain() == IntervalIntDomain(0, 10));
+
+    // Levels nest, and clearing drops them all
+    ENGINE->pushTrail();
+    v1.specify(4);
+    CPPUNIT_ASSERT(ENGINE->pushTrail() == 2);
+    ENGINE->clearTrail();
+    CPPUNIT_ASSERT(ENGINE->getTrailDepth() == 0);
+    v1.reset();
+    CPPUNIT_ASSERT(ENGINE->propagate());
+    return true;
+  }
+
+  static bool testPriorityPropagator() {
+    PriorityPropagator* prop = new PriorityPropagator("Priority", ENGINE);
+    Variable<IntervalIntDomain> v0(ENGINE, IntervalIntDomain(0, 10));
+    Variable<IntervalIntDomain> v1(ENGINE, IntervalIntDomain(0, 10));
+    Variable<IntervalIntDomain> v2(ENGINE, IntervalIntDomain(0, 10));
+    Variable<IntervalIntDomain> v3(ENGINE, IntervalIntDomain(0, 10));
+
+    // Allocate the most expensive constraints first so key order and cost order disagree
+    std::vector<ConstrainedVariableId> scope = makeScope(v0.getId(), v1.getId(), v2.getId(), v3.getId());
+    OrderRecordingConstraint c0("OrderRecordingConstraint", "Priority", ENGINE, scope);
+    scope.pop_back();
+    OrderRecordingConstraint c1("OrderRecordingConstraint", "Priority", ENGINE, scope);
+    scope.pop_back();
+    OrderRecordingConstraint c2("OrderRecordingConstraint", "Priority", ENGINE, scope);
+    scope.pop_back();
+    OrderRecordingConstraint c3("OrderRecordingConstraint", "Priority", ENGINE, scope);
+
+    CPPUNIT_ASSERT(c0.isQueued() && c1.isQueued() && c2.isQueued() && c3.isQueued());
+    CPPUNIT_ASSERT(prop->updateRequired());
+
+    OrderRecordingConstraint::s_order.clear();
+    CPPUNIT_ASSERT(ENGINE->propagate());
+    CPPUNIT_ASSERT(!prop->updateRequired());
+    CPPUNIT_ASSERT(!c0.isQueued() && !c1.isQueued() && !c2.isQueued() && !c3.isQueued());
+    CPPUNIT_ASSERT(OrderRecordingConstraint::s_order.size() == 4);
+    CPPUNIT_ASSERT(OrderRecordingConstraint::s_order[0] == c3.getKey());
+    CPPUNIT_ASSERT(OrderRecordingConstraint::s_order[1] == c2.getKey());
+    CPPUNIT_ASSERT(OrderRecordingConstraint::s_order[2] == c1.getKey());
+    CPPUNIT_ASSERT(OrderRecordingConstraint::s_order[3] == c0.getKey());
+
+    // A restriction wakes each constraint on the variable exactly once
+    OrderRecordingConstraint::s_order.clear();
+    v0.restrictBaseDomain(IntervalIntDomain(1, 9));
+    v0.restrictBaseDomain(IntervalIntDomain(2, 8));
+    CPPUNIT_ASSERT(ENGINE->propagate());
+    CPPUNIT_ASSERT(OrderRecordingConstraint::s_order.size() == 4);
+
+    // Deactivation and deletion must take queued constraints off the agenda
+    v1.restrictBaseDomain(IntervalIntDomain(1, 9));
+    c2.deactivate();
+    CPPUNIT_ASSERT(!c2.isQueued());
+    c2.undoDeactivation();
+    CPPUNIT_ASSERT(c2.isQueued());
+
+    {
+      OrderRecordingConstraint c4("OrderRecordingConstraint", "Priority", ENGINE, makeScope(v3.getId()));
+      CPPUNIT_ASSERT(c4.isQueued());
+    }
+    CPPUNIT_ASSERT(ENGINE->propagate());
+    CPPUNIT_ASSERT(!prop->updateRequired());
+    CPPUNIT_ASSERT(!c2.isQueued());
+
+    // A constraint taken off the middle of a bucket leaves the order of the rest unchanged
+    OrderRecordingConstraint c5("OrderRecordingConstraint", "Priority", ENGINE, makeScope(v0.getId(), v2.getId()));
+    OrderRecordingConstraint c6("OrderRecordingConstraint", "Priority", ENGINE, makeScope(v0.getId(), v3.getId()));
+    CPPUNIT_ASSERT(ENGINE->propagate());
+    OrderRecordingConstraint::s_order.clear();
+    v0.restrictBaseDomain(IntervalIntDomain(3, 7));
+    c5.deactivate();
+    CPPUNIT_ASSERT(!c5.isQueued() && prop->updateRequired());
+    CPPUNIT_ASSERT(ENGINE->propagate());
+    CPPUNIT_ASSERT(OrderRecordingConstraint::s_order.size() == 5);
+    CPPUNIT_ASSERT(OrderRecordingConstraint::s_order[0] == c3.getKey());
+    CPPUNIT_ASSERT(OrderRecordingConstraint::s_order[1] == c2.getKey());
+    CPPUNIT_ASSERT(OrderRecordingConstraint::s_order[2] == c6.getKey());
+    CPPUNIT_ASSERT(OrderRecordingConstraint::s_order[3] == c1.getKey());
+    CPPUNIT_ASSERT(OrderRecordingConstraint::s_order[4] == c0.getKey());
+    c5.undoDeactivation();
+    CPPUNIT_ASSERT(c5.isQueued());
+    CPPUNIT_ASSERT(ENGINE->propagate());
+    CPPUNIT_ASSERT(!prop->updateRequired());
     return true;
   }
 
@@ -805,6 +973,7 @@ class ConstraintTest
 public:
   static bool test() {
     EUROPA_runCETest(testGNATS_3181);
+    EUROPA_runCETest(testEventSubscription);
     EUROPA_runCETest(testUnaryConstraint);
     EUROPA_runCETest(testAddEqualConstraint);
     EUROPA_runCETest(testLessThanEqualConstraint);
@@ -829,6 +998,7 @@ public:
     EUROPA_runCETest(testTestLessThanConstraint);
     EUROPA_runCETest(testTestLEQConstraint);
     EUROPA_runCETest(testGNATS_3075);
+    EUROPA_runCETest(testEqUnionPackedDomains);
     return(true);
   }
 
@@ -878,6 +1048,50 @@ private:
     return true;
   }
 
+  static bool testEventSubscription(){
+    Variable<IntervalIntDomain> v0(ENGINE, IntervalIntDomain(0, 1000));
+    LowerBoundWatcher::s_executionCount = 0;
+    LowerBoundWatcher c0("LowerBoundWatcher", "Default", ENGINE, makeScope(v0.getId()));
+    CPPUNIT_ASSERT(ENGINE->propagate());
+    CPPUNIT_ASSERT(LowerBoundWatcher::s_executionCount == 1);
+
+    // Upper bound changes never reach the constraint
+    unsigned long skipped = ENGINE->skippedWakeupCount();
+    v0.restrictBaseDomain(IntervalIntDomain(0, 900));
+    CPPUNIT_ASSERT(ENGINE->propagate());
+    CPPUNIT_ASSERT(LowerBoundWatcher::s_executionCount == 1);
+    CPPUNIT_ASSERT(ENGINE->skippedWakeupCount() > skipped);
+
+    v0.restrictBaseDomain(IntervalIntDomain(10, 900));
+    CPPUNIT_ASSERT(ENGINE->propagate());
+    CPPUNIT_ASSERT(LowerBoundWatcher::s_executionCount == 2);
+
+    skipped = ENGINE->skippedWakeupCount();
+    v0.specify(20);
+    CPPUNIT_ASSERT(ENGINE->propagate());
+    CPPUNIT_ASSERT(LowerBoundWatcher::s_executionCount == 2);
+    CPPUNIT_ASSERT(ENGINE->skippedWakeupCount() > skipped);
+
+    // Relaxations are always delivered
+    skipped = ENGINE->skippedWakeupCount();
+    v0.reset();
+    CPPUNIT_ASSERT(ENGINE->propagate());
+    CPPUNIT_ASSERT(LowerBoundWatcher::s_executionCount == 3);
+    CPPUNIT_ASSERT(ENGINE->skippedWakeupCount() == skipped);
+
+    // A plain constraint on the same variable still sees everything
+    OrderRecordingConstraint c1("OrderRecordingConstraint", "Default", ENGINE, makeScope(v0.getId()));
+    CPPUNIT_ASSERT(ENGINE->propagate());
+    OrderRecordingConstraint::s_order.clear();
+    skipped = ENGINE->skippedWakeupCount();
+    v0.restrictBaseDomain(IntervalIntDomain(10, 800));
+    CPPUNIT_ASSERT(ENGINE->propagate());
+    CPPUNIT_ASSERT(OrderRecordingConstraint::s_order.size() == 1);
+    CPPUNIT_ASSERT(LowerBoundWatcher::s_executionCount == 3);
+    CPPUNIT_ASSERT(ENGINE->skippedWakeupCount() > skipped);
+    return true;
+  }
+
   static bool testUnaryConstraint(){
     {
       Variable<IntervalIntDomain> v0(ENGINE, IntervalIntDomain(-10, 10));
@@ -1017,6 +1231,25 @@ private:
       CPPUNIT_ASSERT(v1.getDerivedDomain() == IntervalIntDomain(eint(0)));
     }
 
+    // Enumerated arguments mixed with intervals get the same bounds
+    {
+      std::list<edouble> values;
+      values.push_back(1);
+      values.push_back(2);
+      values.push_back(3);
+      Variable<NumericDomain> v0(ENGINE, NumericDomain(values));
+      Variable<IntervalIntDomain> v1(ENGINE, IntervalIntDomain(0, 10));
+      Variable<IntervalIntDomain> v2(ENGINE, IntervalIntDomain(5, 6));
+      Variable<IntervalIntDomain> v3(ENGINE, IntervalIntDomain(0, 3));
+      Variable<IntervalIntDomain> v4(ENGINE, IntervalIntDomain(0, 10));
+      AddEqualConstraint c0("AddEqualConstraint", "Default", ENGINE, makeScope(v0.getId(), v1.getId(), v2.getId()));
+      AddEqualConstraint c1("AddEqualConstraint", "Default", ENGINE, makeScope(v3.getId(), v4.getId(), v2.getId()));
+      CPPUNIT_ASSERT(ENGINE->propagate());
+      CPPUNIT_ASSERT(v0.getDerivedDomain().getSize() == 3);
+      CPPUNIT_ASSERT(v1.getDerivedDomain() == IntervalIntDomain(2, 5));
+      CPPUNIT_ASSERT(v4.getDerivedDomain() == IntervalIntDomain(2, 6));
+    }
+
     return true;
   }
 
@@ -2225,6 +2458,51 @@ private:
     return true;
   }
 
+  /**
+   * @brief EqUnion reads the values of domains packed against their type's enumeration.
+   */
+  static bool testEqUnionPackedDomains() {
+    std::list<edouble> values, low, high;
+    for (int i = 0; i < 10; i++) {
+      std::stringstream ss;
+      ss << "U" << i;
+      values.push_back(LabelStr(ss.str()));
+      if (i < 5)
+        low.push_back(values.back());
+      if (i >= 3 && i < 8)
+        high.push_back(values.back());
+    }
+    RestrictedDT dt("EqUnionType", SymbolDT::instance(), SymbolDomain(values));
+
+    Variable<SymbolDomain> v0(ENGINE, SymbolDomain(dt.baseDomain()));
+    Variable<SymbolDomain> v1(ENGINE, SymbolDomain(low, dt.getId()));
+    Variable<SymbolDomain> v2(ENGINE, SymbolDomain(high, dt.getId()));
+    EqUnionConstraint c0("EqUnionConstraint", "Default", ENGINE,
+                         makeScope(v0.getId(), v1.getId(), v2.getId()));
+    CPPUNIT_ASSERT(ENGINE->propagate());
+    CPPUNIT_ASSERT(v0.getDerivedDomain().getSize() == 8);
+    CPPUNIT_ASSERT(v0.getDerivedDomain().isMember(LabelStr("U7")));
+    CPPUNIT_ASSERT(!v0.getDerivedDomain().isMember(LabelStr("U8")));
+
+    std::list<edouble> ends;
+    ends.push_back(LabelStr("U0"));
+    ends.push_back(LabelStr("U1"));
+    v1.restrictBaseDomain(SymbolDomain(ends, dt.getId()));
+    CPPUNIT_ASSERT(ENGINE->propagate());
+    CPPUNIT_ASSERT(v0.getDerivedDomain().getSize() == 7);
+    CPPUNIT_ASSERT(!v0.getDerivedDomain().isMember(LabelStr("U2")));
+
+    // Each source is restricted to the union
+    std::list<edouble> picks;
+    picks.push_back(LabelStr("U0"));
+    picks.push_back(LabelStr("U3"));
+    v0.restrictBaseDomain(SymbolDomain(picks, dt.getId()));
+    CPPUNIT_ASSERT(ENGINE->propagate());
+    CPPUNIT_ASSERT(v1.getDerivedDomain().isSingleton() && v1.getDerivedDomain().getSingletonValue() == LabelStr("U0"));
+    CPPUNIT_ASSERT(v2.getDerivedDomain().isSingleton() && v2.getDerivedDomain().getSingletonValue() == LabelStr("U3"));
+    return true;
+  }
+
   static bool testUnaryQuery() {
     Variable<IntervalIntDomain> v0(ENGINE, IntervalIntDomain());
     Variable<IntervalIntDomain> v1(ENGINE, IntervalIntDomain());
@@ -2940,3 +3218,81 @@ class ConfigAllowViolationsTest {
 void ConstraintEngineModuleTests::configAllowViolationsTest() {
   ConfigAllowViolationsTest::test();
 }
+
+/**
+ * Sets ConstraintEngine.agenda.Default before the modules create the Default propagator.
+ */
+class ConfigAgendaTestEngine : public EngineBase {
+ public:
+  ConfigAgendaTestEngine(const std::string& agenda);
+  virtual ~ConfigAgendaTestEngine();
+  const ConstraintEngineId getConstraintEngine() const;
+ protected:
+  void createModules();
+};
+
+ConfigAgendaTestEngine::ConfigAgendaTestEngine(const std::string& agenda) {
+  getConfig()->setProperty("ConstraintEngine.agenda.Default", agenda);
+  createModules();
+  doStart();
+}
+
+ConfigAgendaTestEngine::~ConfigAgendaTestEngine() {
+  doShutdown();
+}
+
+void ConfigAgendaTestEngine::createModules() {
+  addModule((new ModuleConstraintEngine())->getId());
+  addModule((new ModuleConstraintLibrary())->getId());
+}
+
+const ConstraintEngineId ConfigAgendaTestEngine::getConstraintEngine() const {
+  return (boost::polymorphic_cast<const ConstraintEngine*>(getComponent("ConstraintEngine")))->getId();
+}
+
+class ConfigAgendaTest {
+ public:
+  static bool test() {
+    {
+      ConfigAgendaTestEngine engine("priority");
+      ConstraintEngineId ce = engine.getConstraintEngine();
+      PropagatorId prop = ce->getPropagatorByName("Default");
+      CPPUNIT_ASSERT(dynamic_cast<PriorityPropagator*>(static_cast<Propagator*>(prop)) != NULL);
+
+      // Constraints on the Default propagator now fire cheapest first, whatever their keys
+      Variable<IntervalIntDomain> v0(ce, IntervalIntDomain(0, 10));
+      Variable<IntervalIntDomain> v1(ce, IntervalIntDomain(0, 10));
+      Variable<IntervalIntDomain> v2(ce, IntervalIntDomain(0, 10));
+      Variable<IntervalIntDomain> v3(ce, IntervalIntDomain(0, 10));
+      std::vector<ConstrainedVariableId> scope = makeScope(v0.getId(), v1.getId(), v2.getId(), v3.getId());
+      OrderRecordingConstraint c0("OrderRecordingConstraint", "Default", ce, scope);
+      scope.pop_back();
+      OrderRecordingConstraint c1("OrderRecordingConstraint", "Default", ce, scope);
+      scope.pop_back();
+      OrderRecordingConstraint c2("OrderRecordingConstraint", "Default", ce, scope);
+      scope.pop_back();
+      OrderRecordingConstraint c3("OrderRecordingConstraint", "Default", ce, scope);
+
+      OrderRecordingConstraint::s_order.clear();
+      CPPUNIT_ASSERT(ce->propagate());
+      CPPUNIT_ASSERT(OrderRecordingConstraint::s_order.size() == 4);
+      CPPUNIT_ASSERT(OrderRecordingConstraint::s_order[0] == c3.getKey());
+      CPPUNIT_ASSERT(OrderRecordingConstraint::s_order[1] == c2.getKey());
+      CPPUNIT_ASSERT(OrderRecordingConstraint::s_order[2] == c1.getKey());
+      CPPUNIT_ASSERT(OrderRecordingConstraint::s_order[3] == c0.getKey());
+    }
+
+    // Without the property, or with any other agenda, Default stays a DefaultPropagator
+    ConfigAgendaTestEngine unset("");
+    ConfigAgendaTestEngine other("fifo");
+    CPPUNIT_ASSERT(dynamic_cast<DefaultPropagator*>(
+        static_cast<Propagator*>(unset.getConstraintEngine()->getPropagatorByName("Default"))) != NULL);
+    CPPUNIT_ASSERT(dynamic_cast<DefaultPropagator*>(
+        static_cast<Propagator*>(other.getConstraintEngine()->getPropagatorByName("Default"))) != NULL);
+    return true;
+  }
+};
+
+void ConstraintEngineModuleTests::configAgendaTest() {
+  ConfigAgendaTest::test();
+}
@@ -8,7 +8,7 @@
 
 class ConstraintEngineModuleTests : public CppUnit::TestFixture {
 
-  CPPUNIT_TEST_SUITE(ConstraintEngineModuleTests);
+  CPPUNIT_TEST_SUITE(ConstraintEngineModuleTests);
   CPPUNIT_TEST(domainTests);
   CPPUNIT_TEST(typeFactoryTests);
   CPPUNIT_TEST(entityTests);
@@ -19,19 +19,20 @@ class ConstraintEngineModuleTests : public CppUnit::TestFixture {
   CPPUNIT_TEST(equivalenceClassTests);
   CPPUNIT_TEST(typeCheckingTests);
   CPPUNIT_TEST(configAllowViolationsTest);
-  CPPUNIT_TEST_SUITE_END();
+  CPPUNIT_TEST(configAgendaTest);
+  CPPUNIT_TEST_SUITE_END();
 
-public:
-  void setUp()
+public:
+  void setUp()
   {
-    ConstraintEngineModuleTests::cppSetup();
-  }
-
-  void tearDown()
+    ConstraintEngineModuleTests::cppSetup();
+  }
+
+  void tearDown()
   {
 //    std::cout << "Finished" << std::endl;
-  }
-
+  }
+
   void cppSetup(void);
   void domainTests();
   void typeFactoryTests();
@@ -43,6 +44,7 @@ public:
   void equivalenceClassTests();
   void typeCheckingTests();
   void configAllowViolationsTest();
+  void configAgendaTest();
 };
 
 #endif /* H_CE_MODULE_TESTS */
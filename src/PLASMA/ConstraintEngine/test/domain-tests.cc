@@ -790,6 +790,7 @@ class IntrinsicsTest {
       EUROPA_runTest(testOperatorEquals);
       EUROPA_runTest(testEmptyOnClosure);
       EUROPA_runTest(testOpenEnumerations);
+      EUROPA_runTest(testPackedEnumerations);
       return true;
     }
 
@@ -1365,6 +1366,75 @@ class IntrinsicsTest {
 
       return(true);
     }
+
+    static bool testPackedEnumerations() {
+      // Large enough to span more than one word of the bit vector
+      std::list<edouble> values;
+      for (int i = 0; i < 100; i++) {
+        std::stringstream ss;
+        ss << "V" << i;
+        values.push_back(LabelStr(ss.str()));
+      }
+      RestrictedDT dt("PackedType", SymbolDT::instance(), SymbolDomain(values));
+
+      std::list<edouble> odds;
+      for (std::list<edouble>::const_iterator it = values.begin(); it != values.end(); ++it)
+        if (LabelStr(*it).toString().size() == 3 && (LabelStr(*it).toString()[2] - '0') % 2 == 1)
+          odds.push_back(*it);
+
+      SymbolDomain all(dt.baseDomain());
+      SymbolDomain someOdd(odds, dt.getId());
+      CPPUNIT_ASSERT(all.getSize() == 100);
+      CPPUNIT_ASSERT(someOdd.getSize() == 45);
+      CPPUNIT_ASSERT(someOdd.isSubsetOf(all) && !all.isSubsetOf(someOdd));
+      CPPUNIT_ASSERT(all.intersects(someOdd));
+      CPPUNIT_ASSERT(someOdd.isMember(someOdd.getLowerBound()) && someOdd.isMember(someOdd.getUpperBound()));
+      CPPUNIT_ASSERT(someOdd.getLowerBound() < someOdd.getUpperBound());
+      CPPUNIT_ASSERT(someOdd.getValues().size() == 45);
+
+      // The set built for a packed domain lasts until the domain changes, so two calls can bound a range
+      CPPUNIT_ASSERT(&someOdd.getValues() == &someOdd.getValues());
+      CPPUNIT_ASSERT(std::set<edouble>(someOdd.getValues().begin(), someOdd.getValues().end()).size() == 45);
+
+      SymbolDomain dom(all);
+      CPPUNIT_ASSERT(dom.intersect(someOdd));
+      CPPUNIT_ASSERT(dom == someOdd);
+      CPPUNIT_ASSERT(!dom.intersect(someOdd));
+      CPPUNIT_ASSERT(dom.isMember(LabelStr("V99")) && !dom.isMember(LabelStr("V98")));
+
+      SymbolDomain evens(all);
+      CPPUNIT_ASSERT(evens.difference(someOdd));
+      CPPUNIT_ASSERT(evens.getSize() == 55);
+      CPPUNIT_ASSERT(!evens.intersects(someOdd));
+
+      // With no intersection, equating empties just one side
+      CPPUNIT_ASSERT(evens.equate(dom));
+      CPPUNIT_ASSERT(evens.isEmpty() != dom.isEmpty());
+
+      dom.relax(all);
+      CPPUNIT_ASSERT(dom == all);
+      dom.remove(LabelStr("V0"));
+      CPPUNIT_ASSERT(dom.getSize() == 99 && !dom.isMember(LabelStr("V0")));
+      dom.set(LabelStr("V70"));
+      CPPUNIT_ASSERT(dom.isSingleton() && dom.getSingletonValue() == LabelStr("V70"));
+      dom.empty();
+      dom.relax(LabelStr("V3"));
+      CPPUNIT_ASSERT(dom.isSingleton() && dom.getSingletonValue() == LabelStr("V3"));
+
+      // Domains of other types, or with values outside the enumeration, are held as sets
+      SymbolDomain generic(odds);
+      SymbolDomain mixed(all);
+      CPPUNIT_ASSERT(mixed.equate(generic));
+      CPPUNIT_ASSERT(mixed == someOdd && generic == someOdd);
+
+      mixed.open();
+      mixed.insert(LabelStr("NotInEnumeration"));
+      mixed.close();
+      CPPUNIT_ASSERT(mixed.getSize() == 46 && mixed.isMember(LabelStr("NotInEnumeration")));
+      CPPUNIT_ASSERT(mixed.intersect(all));
+      CPPUNIT_ASSERT(mixed == someOdd);
+      return(true);
+    }
   };
 
   // These have to be "global" (outside any class, at least) or some
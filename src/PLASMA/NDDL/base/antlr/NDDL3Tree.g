@@ -891,6 +891,9 @@ predicateVarRef returns [PredicateInstanceRef* pi]
                reportSemanticError(CTX,std::string(varName)+" is an undefined token");
 
             pi = new PredicateInstanceRef(tokenType,"",varName,"");
+            // Top level statements are evaluated in the symbol table they are parsed in
+            if (CTX->SymbolTable->getParentST() == NULL)
+                pi->resolve(*CTX->SymbolTable);
 		}
 	;
 
@@ -945,7 +948,11 @@ qualified returns [Expr* result]
                 	// TODO!!: do type checking at each "."
                 	if (dt.isNoId())
                     	reportSemanticError(CTX,errorMsg);
-                   	result = new ExprVarRef(varName,dt);
+                   	ExprVarRef* varRef = new ExprVarRef(varName,dt);
+                   	// Top level statements are evaluated in the symbol table they are parsed in
+                   	if (CTX->SymbolTable->getParentST() == NULL)
+                   	    varRef->resolve(*CTX->SymbolTable);
+                   	result = varRef;
                     CTX->SymbolTable->pushToCleanupStack(result);
                 }
         }
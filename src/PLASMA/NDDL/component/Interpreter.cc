@@ -119,15 +119,6 @@ void makeConstraint(EvalContext& context,
       return m_domain->getDataType();
   }
 
-namespace {
-std::string getAutoName(const std::string& prefix) {
-  static int cnt = 0;
-  std::stringstream sstr;
-  sstr << prefix << ++cnt;
-  return sstr.str();
-}
-}
-
   DataRef ExprConstant::eval(EvalContext& context) const
   {
     // TODO: need to create a new variable every time this is evaluated, since propagation
@@ -136,7 +127,8 @@ std::string getAutoName(const std::string& prefix) {
     ConstrainedVariableId var;
 
     bool canBeSpecified = false;
-    std::string name = getAutoName("ExprConstant_PSEUDO_VARIABLE_");
+    std::string name = reinterpret_cast<PlanDatabase*>(context.getElement("PlanDatabase"))->makeAutoName(
+        "ExprConstant_PSEUDO_VARIABLE_");
 
     // TODO: this isn't pretty, have the different EvalContexts create the new var
     RuleInstanceEvalContext *riec = dynamic_cast<RuleInstanceEvalContext*>(&context);
@@ -190,6 +182,29 @@ std::string getAutoName(const std::string& prefix) {
 
 
 
+/*
+ * RuleSymbolTable
+ */
+RuleSymbolTable::RuleSymbolTable() : m_variables(), m_slaves() {}
+
+unsigned int RuleSymbolTable::declareVariable(const std::string& name) {
+  return m_variables.insert(std::make_pair(name, getVariableCount())).first->second;
+}
+
+unsigned int RuleSymbolTable::declareSlave(const std::string& name) {
+  return m_slaves.insert(std::make_pair(name, getSlaveCount())).first->second;
+}
+
+int RuleSymbolTable::getVariableSlot(const std::string& name) const {
+  std::map<std::string, unsigned int>::const_iterator it = m_variables.find(name);
+  return (it == m_variables.end() ? -1 : static_cast<int>(it->second));
+}
+
+int RuleSymbolTable::getSlaveSlot(const std::string& name) const {
+  std::map<std::string, unsigned int>::const_iterator it = m_slaves.find(name);
+  return (it == m_slaves.end() ? -1 : static_cast<int>(it->second));
+}
+
 /*
  * ExprVarRef
  */
@@ -198,6 +213,14 @@ ExprVarRef::ExprVarRef(const std::string& varName, const DataTypeId type)
     , m_varType(type)
     , m_parentName()
     , m_vars()
+    , m_variableSlot(-1)
+    , m_slaveSlot(-1)
+    , m_instanceDepth(-1)
+    , m_instanceSlot(0)
+    , m_scope(NULL)
+    , m_scopeDepth(0)
+    , m_scopeSlot(0)
+    , m_scopeToken(false)
 {
   tokenize(m_varName,m_vars,".");
 
@@ -222,10 +245,88 @@ ExprVarRef::ExprVarRef(const std::string& varName, const DataTypeId type)
       return m_varType;
   }
 
+void ExprVarRef::resolve(const RuleSymbolTable& symbols) const {
+  if (m_parentName == "")
+    m_variableSlot = symbols.getVariableSlot(m_varName);
+  else
+    m_slaveSlot = symbols.getSlaveSlot(m_parentName);
+}
+
+bool ExprVarRef::resolve(const EvalContext& scope) const {
+  const std::string& name = (m_parentName == "" ? m_varName : m_parentName);
+
+  // A reference to a token member starts with the token, a plain name with the variable
+  bool found;
+  if (m_parentName == "") {
+    m_scopeToken = false;
+    found = scope.resolveVar(name, m_scopeDepth, m_scopeSlot);
+    if (!found)
+      m_scopeToken = found = scope.resolveToken(name, m_scopeDepth, m_scopeSlot);
+  }
+  else {
+    m_scopeToken = true;
+    found = scope.resolveToken(name, m_scopeDepth, m_scopeSlot);
+    if (!found) {
+      m_scopeToken = false;
+      found = scope.resolveVar(name, m_scopeDepth, m_scopeSlot);
+    }
+  }
+
+  m_scope = (found ? &scope : NULL);
+  debugMsg("Interpreter:ExprVarRef", (found ? "Resolved " : "Couldn't resolve ") << name << " at depth " <<
+           m_scopeDepth << ", slot " << m_scopeSlot);
+  return found;
+}
+
 DataRef ExprVarRef::eval(EvalContext& context) const {
   ConstrainedVariableId var;
 
+  // Rule bodies are only evaluated in a RuleInstanceEvalContext, which has no subclasses, so comparing
+  // the exact type is enough, and cheaper than a dynamic_cast on every evaluation
+  RuleInstanceEvalContext* riec =
+      (typeid(context) == typeid(RuleInstanceEvalContext) ? static_cast<RuleInstanceEvalContext*>(&context) : NULL);
+
+  // Top level statements are evaluated in the context they were resolved in
+  TokenId scopeToken;
+  if (m_scope == &context) {
+    if (m_scopeToken)
+      scopeToken = context.getSlotToken(m_scopeDepth, m_scopeSlot);
+    else
+      var = context.getSlotVar(m_scopeDepth, m_scopeSlot);
+    if (m_parentName == "") {
+      if (scopeToken.isId())
+        return DataRef(scopeToken->getState());
+      if (var.isId())
+        return DataRef(var);
+    }
+  }
+
+  // Names declared in the rule are found by slot, unless not yet declared where this is evaluated
   if (m_parentName == "") {
+    if (riec != NULL && m_variableSlot >= 0) {
+      var = riec->getRuleInstance()->getSlotVariable(static_cast<unsigned int>(m_variableSlot));
+      if (var.isId())
+        return DataRef(var);
+    }
+
+    // Other names, such as the parameters of the token, are bound in the rule instance tree. This
+    // reference is at the same depth in the tree whichever instance evaluates it, and a name mostly
+    // keeps its slot across instances, so the coordinates found last time are tried first.
+    if (riec != NULL && m_variableSlot < 0) {
+      const InterpretedRuleInstanceId ruleInstance = riec->getRuleInstance();
+      if (m_instanceDepth >= 0) {
+        var = ruleInstance->getVariable(static_cast<unsigned int>(m_instanceDepth), m_instanceSlot);
+        if (var.isId() && var->getName() == m_varName)
+          return DataRef(var);
+      }
+
+      unsigned int depth;
+      if (ruleInstance->resolveVariable(m_varName, depth, m_instanceSlot)) {
+        m_instanceDepth = static_cast<int>(depth);
+        return DataRef(ruleInstance->getVariable(depth, m_instanceSlot));
+      }
+    }
+
     var = context.getVar(m_varName.c_str());
     if (var.isNoId()) {
       // If var evaluates to a token, return state var.
@@ -238,8 +339,12 @@ DataRef ExprVarRef::eval(EvalContext& context) const {
     }
   }
   else {
-    TokenId tok = context.getToken(m_parentName.c_str());
-    if (tok.isNoId()) {
+    TokenId tok = scopeToken;
+    if (riec != NULL && m_slaveSlot >= 0)
+      tok = riec->getRuleInstance()->getSlotSlave(static_cast<unsigned int>(m_slaveSlot));
+    if (tok.isNoId() && var.isNoId())
+      tok = context.getToken(m_parentName.c_str());
+    if (tok.isNoId() && var.isNoId()) {
       var = context.getVar(m_parentName.c_str());
       if (var.isNoId()) {
         check_runtime_error(ALWAYS_FAILS,std::string("Couldn't find variable or token '")+m_parentName+"' in Evaluation Context");
@@ -249,7 +354,6 @@ DataRef ExprVarRef::eval(EvalContext& context) const {
 
     // TODO: this isn't pretty, have the different EvalContexts perform the lookup
     // TODO: is this really still necessary?, code in "else" block should work in ruleInstance context as well
-    RuleInstanceEvalContext *riec = dynamic_cast<RuleInstanceEvalContext*>(&context);
     if (riec != NULL) {
       if (tok.isId())
         var = riec->getRuleInstance()->varfromtok(tok,m_varName);
@@ -848,6 +952,10 @@ PredicateInstanceRef::PredicateInstanceRef(const TokenTypeId tokenType,
     , m_predicateInstance(predInstance)
     , m_predicateName(predName)
     , m_attributes(0)
+    , m_slaveSlot(-1)
+    , m_scope(NULL)
+    , m_scopeDepth(0)
+    , m_scopeSlot(0)
   {
 	  m_attributes=0;
 	  if (!annotation.empty()) {
@@ -871,7 +979,15 @@ TokenId PredicateInstanceRef::getToken(EvalContext& context, const std::string&
 {
   TokenId result;
   if (m_predicateInstance.length() == 0) {
-    result = context.getToken(m_predicateName.c_str());
+    if (m_scope == &context)
+      result = context.getSlotToken(m_scopeDepth, m_scopeSlot);
+    if (result.isNoId() && m_slaveSlot >= 0) {
+      InterpretedRuleInstance* rule = reinterpret_cast<InterpretedRuleInstance*>(context.getElement("RuleInstance"));
+      if (rule != NULL)
+        result = rule->getSlotSlave(static_cast<unsigned int>(m_slaveSlot));
+    }
+    if (result.isNoId())
+      result = context.getToken(m_predicateName.c_str());
   }
   else {
     InterpretedRuleInstance* rule = reinterpret_cast<InterpretedRuleInstance*>(context.getElement("RuleInstance"));
@@ -904,6 +1020,8 @@ TokenId PredicateInstanceRef::createGlobalToken(EvalContext& context, bool isFac
   const std::string tokenName = m_predicateName;
 
   TokenId token = getPDB(context)->createToken(tokenType,tokenName,isRejectable,isFact);
+  if (!tokenName.empty())
+    context.addToken(tokenName,token);
 
   if (object.isId()) {
     // We restrict the base domain permanently since the name is specifically mentioned on creation
@@ -947,7 +1065,8 @@ TokenId PredicateInstanceRef::createSubgoal(EvalContext& context,
       predicateInstance,
       relationName,
       constrained,
-      owner
+      owner,
+      m_slaveSlot
                                       );
 
   context.addToken(predicateName.c_str(),slave);
@@ -956,6 +1075,23 @@ TokenId PredicateInstanceRef::createSubgoal(EvalContext& context,
   return slave;
 }
 
+bool PredicateInstanceRef::resolve(const EvalContext& scope) {
+  bool found = (m_predicateInstance.length() == 0 &&
+                scope.resolveToken(m_predicateName, m_scopeDepth, m_scopeSlot));
+  m_scope = (found ? &scope : NULL);
+  return found;
+}
+
+void PredicateInstanceRef::resolve(RuleSymbolTable& symbols, bool declare) {
+  if (m_predicateInstance.length() != 0) {
+    // A subgoal, named by m_predicateName
+    if (declare)
+      m_slaveSlot = static_cast<int>(symbols.declareSlave(m_predicateName));
+  }
+  else if (!declare)
+    m_slaveSlot = symbols.getSlaveSlot(m_predicateName);
+}
+
   int PredicateInstanceRef::getAttributes(  ) const
   {
     return m_attributes;
@@ -1245,6 +1381,7 @@ void createRelation(EvalContext& context,
     : m_varName(varName)
     , m_varValue(varValue)
     , m_loopBody(loopBody)
+    , m_slot(-1)
   {
   }
 
@@ -1255,8 +1392,12 @@ void createRelation(EvalContext& context,
       m_loopBody.clear();
   }
 
+void ExprLoop::resolve(RuleSymbolTable& symbols) const {
+  m_slot = static_cast<int>(symbols.declareVariable(m_varName));
+}
+
 DataRef ExprLoop::doEval(RuleInstanceEvalContext& context) const {
-  context.getRuleInstance()->executeLoop(context,m_varName,m_varValue,m_loopBody);
+  context.getRuleInstance()->executeLoop(context,m_varName,m_varValue,m_loopBody,m_slot);
   debugMsg("Interpreter:InterpretedRule",
            "Evaluated LOOP " << m_varName << "," << m_varValue);
   return DataRef::null;
@@ -1565,9 +1706,12 @@ bool TokenEvalContext::isClass(const std::string& className) const {
   InterpretedRuleInstance::InterpretedRuleInstance(const RuleId rule,
 						   const TokenId token,
 						   const PlanDatabaseId planDb,
-						   const std::vector<Expr*>& body)
+						   const std::vector<Expr*>& body,
+						   const RuleSymbolTable& symbols)
     : RuleInstance(rule, token, planDb)
     , m_body(body)
+    , m_variableSlots(symbols.getVariableCount())
+    , m_slaveSlots(symbols.getSlaveCount())
   {
   }
 
@@ -1579,7 +1723,12 @@ bool TokenEvalContext::isClass(const std::string& className) const {
 						   const std::vector<Expr*>& body)
     : RuleInstance(parent,var,domain,positive)
     , m_body(body)
+    , m_variableSlots()
+    , m_slaveSlots()
   {
+    InterpretedRuleInstance* interpretedParent = getInterpretedParent();
+    m_variableSlots.resize(interpretedParent->m_variableSlots.size());
+    m_slaveSlots.resize(interpretedParent->m_slaveSlots.size());
   }
 
 InterpretedRuleInstance::InterpretedRuleInstance(const RuleInstanceId parent,
@@ -1590,7 +1739,12 @@ InterpretedRuleInstance::InterpretedRuleInstance(const RuleInstanceId parent,
                                                  const std::vector<Expr*>& body)
     : RuleInstance(parent,var,domain,positive, guardComponents)
     , m_body(body)
+    , m_variableSlots()
+    , m_slaveSlots()
   {
+    InterpretedRuleInstance* interpretedParent = getInterpretedParent();
+    m_variableSlots.resize(interpretedParent->m_variableSlots.size());
+    m_slaveSlots.resize(interpretedParent->m_slaveSlots.size());
   }
 
   InterpretedRuleInstance::InterpretedRuleInstance(
@@ -1600,7 +1754,12 @@ InterpretedRuleInstance::InterpretedRuleInstance(const RuleInstanceId parent,
 						   const std::vector<Expr*>& body)
     : RuleInstance(parent,vars,positive)
     , m_body(body)
+    , m_variableSlots()
+    , m_slaveSlots()
   {
+    InterpretedRuleInstance* interpretedParent = getInterpretedParent();
+    m_variableSlots.resize(interpretedParent->m_variableSlots.size());
+    m_slaveSlots.resize(interpretedParent->m_slaveSlots.size());
   }
 
   InterpretedRuleInstance::~InterpretedRuleInstance()
@@ -1623,6 +1782,10 @@ InterpretedRuleInstance::InterpretedRuleInstance(const RuleInstanceId parent,
 	       "Body: " << (*it)->toString());
     }
 
+    // Anything declared by an earlier execution was undone with it
+    std::fill(m_variableSlots.begin(), m_variableSlots.end(), ConstrainedVariableId::noId());
+    std::fill(m_slaveSlots.begin(), m_slaveSlots.end(), TokenId::noId());
+
     for (unsigned int i=0; i < m_body.size(); i++) {
       m_body[i]->eval(evalContext);
     }
@@ -1637,7 +1800,8 @@ TokenId InterpretedRuleInstance::createSubgoal(const std::string& name,
                                                const std::string& predicateInstance,
                                                const std::string& relation,
                                                bool isConstrained,
-                                               ConstrainedVariableId owner) {
+                                               ConstrainedVariableId owner,
+                                               int slot) {
   TokenId slave;
 
   unsigned long tokenCnt =
@@ -1658,6 +1822,8 @@ TokenId InterpretedRuleInstance::createSubgoal(const std::string& name,
     slave = m_token->getPlanDatabase()->createSlaveToken(m_token,predicateType,relation);
   }
   addSlave(slave,name);
+  if (slot >= 0)
+    m_slaveSlots[slot] = slave;
 
   // For qualified names like "object.helloWorld" must add constraint to the object variable on the slave token
   // See RuleWriter.allocateSlave in Nddl compiler
@@ -1692,24 +1858,59 @@ TokenId InterpretedRuleInstance::createSubgoal(const std::string& name,
 
 ConstrainedVariableId InterpretedRuleInstance::addLocalVariable(const Domain& baseDomain,
                                                                 bool canBeSpecified,
-                                                                const std::string& name) {
-  return addVariable(baseDomain,canBeSpecified,name);
+                                                                const std::string& name,
+                                                                int slot) {
+  ConstrainedVariableId localVariable = addVariable(baseDomain,canBeSpecified,name);
+  setSlotVariable(slot,localVariable);
+  return localVariable;
 }
 
 ConstrainedVariableId InterpretedRuleInstance::addObjectVariable(const std::string& type,
                                                                  const ObjectDomain& baseDomain,
                                                                  bool canBeSpecified,
-                                                                 const std::string& name) {
+                                                                 const std::string& name,
+                                                                 int slot) {
   ConstrainedVariableId localVariable = addVariable(baseDomain,canBeSpecified,name);
   getPlanDatabase()->makeObjectVariableFromType(type,localVariable);
+  setSlotVariable(slot,localVariable);
 
   return localVariable;
 }
 
+void InterpretedRuleInstance::setSlotVariable(int slot, const ConstrainedVariableId var) {
+  if (slot >= 0)
+    m_variableSlots[slot] = var;
+}
+
+ConstrainedVariableId InterpretedRuleInstance::getSlotVariable(unsigned int slot) const {
+  for (const InterpretedRuleInstance* instance = this; instance != NULL; instance = instance->getInterpretedParent()) {
+    if (slot < instance->m_variableSlots.size() && instance->m_variableSlots[slot].isId())
+      return instance->m_variableSlots[slot];
+  }
+  return ConstrainedVariableId::noId();
+}
+
+TokenId InterpretedRuleInstance::getSlotSlave(unsigned int slot) const {
+  for (const InterpretedRuleInstance* instance = this; instance != NULL; instance = instance->getInterpretedParent()) {
+    if (slot < instance->m_slaveSlots.size() && instance->m_slaveSlots[slot].isId())
+      return instance->m_slaveSlots[slot];
+  }
+  return TokenId::noId();
+}
+
+InterpretedRuleInstance* InterpretedRuleInstance::getInterpretedParent() const {
+  if (m_parent.isNoId())
+    return NULL;
+  InterpretedRuleInstance* parent = dynamic_cast<InterpretedRuleInstance*>(static_cast<RuleInstance*>(m_parent));
+  check_error(parent != NULL, "Interpreted rule instances can only have interpreted parents");
+  return parent;
+}
+
 void InterpretedRuleInstance::executeLoop(EvalContext& evalContext,
                                           const std::string& loopVarName,
                                           const std::string& valueSet,
-                                          const std::vector<Expr*>& loopBody) {
+                                          const std::vector<Expr*>& loopBody,
+                                          int loopVarSlot) {
   // Create a local domain based on the objects included in the valueSet
   ConstrainedVariableId setVar = evalContext.getVar(valueSet.c_str());
   check_error(!setVar.isNoId(),"Loop var can't be NULL");
@@ -1752,7 +1953,7 @@ void InterpretedRuleInstance::executeLoop(EvalContext& evalContext,
       loopVarDomain.insert(loop_var->getKey());
       loopVarDomain.close();
       // This will automatically put it in the evalContext, since all RuleInstance vars are reachable there
-      addVariable(loopVarDomain, false, loopVarName);
+      setSlotVariable(loopVarSlot, addVariable(loopVarDomain, false, loopVarName));
     }
 
     // execute loop body
@@ -1760,6 +1961,7 @@ void InterpretedRuleInstance::executeLoop(EvalContext& evalContext,
       loopBody[i]->eval(evalContext);
 
     clearLoopVar(loopVarName);
+    setSlotVariable(loopVarSlot, ConstrainedVariableId::noId());
   }
 }
 
@@ -1772,6 +1974,7 @@ InterpretedRuleFactory::InterpretedRuleFactory(const std::string& predicate,
                                                const std::vector<Expr*>& body)
     : Rule(predicate,source)
     , m_body(body)
+    , m_symbols()
   {
     debugMsg("InterpretedRuleFactory:InterpretedRuleFactory",
 	     "Instantiating rule for " << source);
@@ -1780,6 +1983,16 @@ InterpretedRuleFactory::InterpretedRuleFactory(const std::string& predicate,
 	       (*it)->toString());
 
     }
+
+    // Number every name the rule declares, then resolve references to them, so that a reference
+    // can be resolved to a declaration that comes after it in the source
+    for(std::vector<Expr*>::const_iterator it = body.begin(); it != body.end(); ++it)
+      resolveRuleSymbols(*it, m_symbols, true);
+    for(std::vector<Expr*>::const_iterator it = body.begin(); it != body.end(); ++it)
+      resolveRuleSymbols(*it, m_symbols, false);
+    debugMsg("InterpretedRuleFactory:InterpretedRuleFactory",
+	     source << " declares " << m_symbols.getVariableCount() << " variables and " <<
+	     m_symbols.getSlaveCount() << " slaves");
   }
 
 InterpretedRuleFactory::~InterpretedRuleFactory() {
@@ -1800,7 +2013,7 @@ RuleInstanceId InterpretedRuleFactory::createInstance(const TokenId token,
                                                       const PlanDatabaseId planDb,
                                                       const RulesEngineId &rulesEngine) const {
 
-  InterpretedRuleInstance *foo = new InterpretedRuleInstance(m_id, token, planDb, m_body);
+  InterpretedRuleInstance *foo = new InterpretedRuleInstance(m_id, token, planDb, m_body, m_symbols);
     //TODO: Fix this once we start using smart pointers more.  setRulesEngine can throw,
     //      leaking foo
     try {
@@ -1913,6 +2126,7 @@ DataRef ExprEnumdef::eval(EvalContext& context) const {
       , m_type(type)
       , m_initValue(initValue)
       , m_canBeSpecified(canBeSpecified)
+      , m_slot(-1)
   {
   }
 
@@ -1927,6 +2141,10 @@ const std::string& ExprVarDeclaration::getName() const { return m_name; }
   const Expr* ExprVarDeclaration::getInitValue() const { return m_initValue; }
   void ExprVarDeclaration::setInitValue(Expr* iv) { m_initValue = iv; }
 
+  void ExprVarDeclaration::resolve(RuleSymbolTable& symbols) const {
+    m_slot = static_cast<int>(symbols.declareVariable(m_name));
+  }
+
   DataRef ExprVarDeclaration::eval(EvalContext& context) const
   {
       ConstrainedVariableId v;
@@ -1939,8 +2157,10 @@ const std::string& ExprVarDeclaration::getName() const { return m_name; }
           RuleInstanceEvalContext* riec = dynamic_cast<RuleInstanceEvalContext*>(&context);
           if (riec != NULL)
               v = makeRuleVar(*riec);
-          else
+          else {
               v = makeGlobalVar(context);
+              context.addVar(getName(),v);
+          }
       }
 
       debugMsg("Interpreter:varDeclaration","Declared variable:" << v->toLongString());
@@ -2032,7 +2252,8 @@ ConstrainedVariableId ExprVarDeclaration::makeRuleVar(RuleInstanceEvalContext& c
         getDataType()->getName(),
         ObjectDomain(dt),
         m_canBeSpecified,
-        m_name
+        m_name,
+        m_slot
                                                             );
   }
   else {
@@ -2041,7 +2262,8 @@ ConstrainedVariableId ExprVarDeclaration::makeRuleVar(RuleInstanceEvalContext& c
     localVar = context.getRuleInstance()->addLocalVariable(
         baseDomain,
         m_canBeSpecified,
-        m_name
+        m_name,
+        m_slot
                                                            );
   }
 
@@ -2590,5 +2812,83 @@ void getVariableReferences(const Expr* expr, EvalContext& ctx,
   }
 }
 
+void resolveRuleSymbols(const Expr* expr, RuleSymbolTable& symbols, bool declare) {
+  if(expr == NULL)
+    return;
+
+  if(dynamic_cast<const ExprList*>(expr) != NULL) {
+    const ExprList* e = static_cast<const ExprList*>(expr);
+    for(std::vector<Expr*>::const_iterator it = e->getChildren().begin();
+        it != e->getChildren().end(); ++it)
+      resolveRuleSymbols(*it, symbols, declare);
+  }
+  else if(dynamic_cast<const ExprVarRef*>(expr) != NULL) {
+    if(!declare)
+      static_cast<const ExprVarRef*>(expr)->resolve(symbols);
+  }
+  else if(dynamic_cast<const ExprVarDeclaration*>(expr) != NULL) {
+    const ExprVarDeclaration* e = static_cast<const ExprVarDeclaration*>(expr);
+    if(declare)
+      e->resolve(symbols);
+    resolveRuleSymbols(e->getInitValue(), symbols, declare);
+  }
+  else if(dynamic_cast<const ExprAssignment*>(expr) != NULL) {
+    const ExprAssignment* e = static_cast<const ExprAssignment*>(expr);
+    resolveRuleSymbols(e->getLhs(), symbols, declare);
+    resolveRuleSymbols(e->getRhs(), symbols, declare);
+  }
+  else if(dynamic_cast<const ExprConstraint*>(expr) != NULL) {
+    std::vector<Expr*> args = static_cast<const ExprConstraint*>(expr)->getArgs();
+    for(std::vector<Expr*>::const_iterator it = args.begin(); it != args.end(); ++it)
+      resolveRuleSymbols(*it, symbols, declare);
+  }
+  else if(dynamic_cast<const ExprMethodCall*>(expr) != NULL) {
+    const ExprMethodCall* e = static_cast<const ExprMethodCall*>(expr);
+    for(std::vector<Expr*>::const_iterator it = e->getArgs().begin(); it != e->getArgs().end(); ++it)
+      resolveRuleSymbols(*it, symbols, declare);
+  }
+  else if(dynamic_cast<const ExprRelation*>(expr) != NULL) {
+    const ExprRelation* e = static_cast<const ExprRelation*>(expr);
+    e->getOrigin()->resolve(symbols, declare);
+    for(std::vector<PredicateInstanceRef*>::const_iterator it = e->getTargets().begin();
+        it != e->getTargets().end(); ++it)
+      (*it)->resolve(symbols, declare);
+  }
+  else if(dynamic_cast<const ExprIf*>(expr) != NULL) {
+    const ExprIf* e = static_cast<const ExprIf*>(expr);
+    resolveRuleSymbols(e->getGuard(), symbols, declare);
+    for(std::vector<Expr*>::const_iterator it = e->getIfBody().begin(); it != e->getIfBody().end(); ++it)
+      resolveRuleSymbols(*it, symbols, declare);
+    for(std::vector<Expr*>::const_iterator it = e->getElseBody().begin(); it != e->getElseBody().end(); ++it)
+      resolveRuleSymbols(*it, symbols, declare);
+  }
+  else if(dynamic_cast<const ExprIfGuard*>(expr) != NULL) {
+    const ExprIfGuard* e = static_cast<const ExprIfGuard*>(expr);
+    resolveRuleSymbols(e->getLhs(), symbols, declare);
+    resolveRuleSymbols(e->getRhs(), symbols, declare);
+  }
+  else if(dynamic_cast<const ExprLoop*>(expr) != NULL) {
+    const ExprLoop* e = static_cast<const ExprLoop*>(expr);
+    if(declare)
+      e->resolve(symbols);
+    for(std::vector<Expr*>::const_iterator it = e->getLoopBody().begin(); it != e->getLoopBody().end(); ++it)
+      resolveRuleSymbols(*it, symbols, declare);
+  }
+  else if(dynamic_cast<const CExprFunction*>(expr) != NULL) {
+    std::vector<CExpr*> args = static_cast<const CExprFunction*>(expr)->getArgs();
+    for(std::vector<CExpr*>::const_iterator it = args.begin(); it != args.end(); ++it)
+      resolveRuleSymbols(*it, symbols, declare);
+  }
+  else if(dynamic_cast<const CExprValue*>(expr) != NULL) {
+    resolveRuleSymbols(static_cast<const CExprValue*>(expr)->getValue(), symbols, declare);
+  }
+  else if(dynamic_cast<const CExprBinary*>(expr) != NULL) {
+    const CExprBinary* e = static_cast<const CExprBinary*>(expr);
+    resolveRuleSymbols(e->getLhs(), symbols, declare);
+    resolveRuleSymbols(e->getRhs(), symbols, declare);
+  }
+  // Names in any other expression are looked up as they are evaluated
+}
+
 }
 
@@ -1,6 +1,7 @@
 #ifndef H_Interpreter
 #define H_Interpreter
 
+#include <map>
 #include <vector>
 
 #include "PDBInterpreter.hh"
@@ -42,6 +43,33 @@ private:
   class TokenEvalContext;
   class RuleInstanceEvalContext;
 
+  /**
+   * @brief Numbers the names declared in the body of an interpreted rule - local variables, loop
+   * variables and slaves - when the rule is defined. Rule instances keep what they declare in
+   * vectors indexed by these numbers, and references to the names are resolved to them, so that
+   * firing a rule does not look names up in maps at every level of the rule instance tree.
+   */
+  class RuleSymbolTable {
+  public:
+    RuleSymbolTable();
+
+    unsigned int declareVariable(const std::string& name);
+    unsigned int declareSlave(const std::string& name);
+
+    /**
+     * @return The slot of a name declared in the rule, or -1 if the rule declares no such name
+     */
+    int getVariableSlot(const std::string& name) const;
+    int getSlaveSlot(const std::string& name) const;
+
+    unsigned int getVariableCount() const { return static_cast<unsigned int>(m_variables.size()); }
+    unsigned int getSlaveCount() const { return static_cast<unsigned int>(m_slaves.size()); }
+
+  private:
+    std::map<std::string, unsigned int> m_variables;
+    std::map<std::string, unsigned int> m_slaves;
+  };
+
 class ExprVarDeclaration : public Expr {
  private:
   ExprVarDeclaration(const ExprVarDeclaration&);
@@ -58,11 +86,17 @@ class ExprVarDeclaration : public Expr {
   const Expr* getInitValue() const;
   void setInitValue(Expr* iv);
 
+  /**
+   * @brief Give the variable a slot in the rule declaring it
+   */
+  void resolve(RuleSymbolTable& symbols) const;
+
  protected:
   std::string m_name;
   DataTypeId m_type;
   Expr* m_initValue;
   bool m_canBeSpecified;
+  mutable int m_slot; /*!< Set when declared in a rule body */
 
   ConstrainedVariableId makeGlobalVar(EvalContext& context) const;
   ConstrainedVariableId makeTokenVar(TokenEvalContext& context) const;
@@ -78,11 +112,35 @@ class ExprVarRef : public Expr {
   virtual const DataTypeId getDataType() const;
   virtual std::string toString() const;
 
+  /**
+   * @brief Point the reference at the slots of the names it uses which are declared in a rule body
+   */
+  void resolve(const RuleSymbolTable& symbols) const;
+
+  /**
+   * @brief Point the reference at the (depth, slot) coordinates of the name it starts with in the
+   * context it will be evaluated in, such as that of top level statements.
+   * @return false if the context does not bind the name, which is then looked up by name
+   */
+  bool resolve(const EvalContext& scope) const;
+
  protected:
   std::string m_varName;
   DataTypeId m_varType;
   std::string m_parentName;
   std::vector<std::string> m_vars;
+  mutable int m_variableSlot; /*!< Of m_varName, if a rule local variable */
+  mutable int m_slaveSlot;    /*!< Of m_parentName, if a rule slave */
+  mutable int m_instanceDepth;          /*!< With m_instanceSlot, where m_varName was last found in a rule instance tree */
+  mutable unsigned int m_instanceSlot;
+  mutable const EvalContext* m_scope;   /*!< The context m_scopeDepth and m_scopeSlot were resolved in */
+  mutable unsigned int m_scopeDepth;
+  mutable unsigned int m_scopeSlot;
+  mutable bool m_scopeToken;            /*!< The name resolved in m_scope is bound to a token */
+
+ private:
+  ExprVarRef(const ExprVarRef&);
+  ExprVarRef& operator=(const ExprVarRef&);
 };
 
 class ExprAssignment : public Expr {
@@ -93,8 +151,8 @@ class ExprAssignment : public Expr {
   ExprAssignment(Expr* lhs, Expr* rhs);
   virtual ~ExprAssignment();
 
-  Expr* getLhs() { return m_lhs.get(); }
-  Expr* getRhs() { return m_rhs.get(); }
+  Expr* getLhs() const { return m_lhs.get(); }
+  Expr* getRhs() const { return m_rhs.get(); }
 
   virtual DataRef eval(EvalContext& context) const;
   virtual std::string toString() const;
@@ -300,14 +358,34 @@ class PredicateInstanceRef {
   int     getAttributes() const;
   const TokenTypeId getTokenType();
 
+  /**
+   * @brief In a rule body, give a subgoal a slot, or point a reference to a slave at its slot
+   */
+  void resolve(RuleSymbolTable& symbols, bool declare);
+
+  /**
+   * @brief Point a reference to a token at its (depth, slot) coordinates in the context it will be
+   * evaluated in, such as that of top level statements.
+   * @return false if the context does not bind the token, which is then looked up by name
+   */
+  bool resolve(const EvalContext& scope);
+
  protected:
   TokenTypeId m_tokenType;
   std::string m_predicateInstance;
   std::string m_predicateName;
   int m_attributes;
+  int m_slaveSlot;
+  const EvalContext* m_scope; /*!< The context m_scopeDepth and m_scopeSlot were resolved in */
+  unsigned int m_scopeDepth;
+  unsigned int m_scopeSlot;
 
   TokenId createSubgoal(EvalContext& ctx, InterpretedRuleInstance* rule, const std::string& relationName);
   TokenId createGlobalToken(EvalContext& context, bool isFact, bool isRejectable);
+
+ private:
+  PredicateInstanceRef(const PredicateInstanceRef&);
+  PredicateInstanceRef& operator=(const PredicateInstanceRef&);
 };
 
   class ExprProblemStmt : public Expr
@@ -341,6 +419,9 @@ private:
 
   void populateCausality( InterpretedTokenType* container );
 
+  PredicateInstanceRef* getOrigin() const { return m_origin; }
+  const std::vector<PredicateInstanceRef*>& getTargets() const { return m_targets; }
+
  protected:
   std::string m_relation;
   PredicateInstanceRef* m_origin;
@@ -427,6 +508,8 @@ private:
 
   virtual void checkType();
 
+  const Expr* getValue() const { return m_value.get(); }
+
  protected:
   boost::scoped_ptr<Expr> m_value;
 };
@@ -538,7 +621,8 @@ class TokenEvalContext : public EvalContext {
   	    InterpretedRuleInstance(const RuleId rule,
   	                            const TokenId token,
   	                            const PlanDatabaseId planDb,
-                                const std::vector<Expr*>& body);
+                                const std::vector<Expr*>& body,
+                                const RuleSymbolTable& symbols);
 
         InterpretedRuleInstance(const RuleInstanceId parent,
                                 const ConstrainedVariableId var,
@@ -566,27 +650,43 @@ class TokenEvalContext : public EvalContext {
                    const std::string& predicateInstance,
                    const std::string& relation,
                    bool isConstrained,
-                   ConstrainedVariableId owner);
+                   ConstrainedVariableId owner,
+                   int slot = -1);
 
         ConstrainedVariableId addLocalVariable(
                        const Domain& baseDomain,
 				       bool canBeSpecified,
-				       const std::string& name);
+				       const std::string& name,
+				       int slot = -1);
 
         ConstrainedVariableId addObjectVariable(
                        const std::string& type,
                        const ObjectDomain& baseDomain,
 				       bool canBeSpecified,
-				       const std::string& name);
+				       const std::string& name,
+				       int slot = -1);
 
         void executeLoop(EvalContext& evalContext,
                          const std::string& loopVarName,
                          const std::string& valueSet,
-                         const std::vector<Expr*>& loopBody);
+                         const std::vector<Expr*>& loopBody,
+                         int loopVarSlot = -1);
 
+        /**
+         * @brief The variable or slave declared in a slot of the rule's RuleSymbolTable, by this
+         * instance or the nearest ancestor to have declared it.
+         * @return noId if none has, in which case the name may still be found by getVariable or getSlave
+         */
+        ConstrainedVariableId getSlotVariable(unsigned int slot) const;
+        TokenId getSlotSlave(unsigned int slot) const;
 
     protected:
         std::vector<Expr*> m_body;
+        std::vector<ConstrainedVariableId> m_variableSlots;
+        std::vector<TokenId> m_slaveSlots;
+
+        void setSlotVariable(int slot, const ConstrainedVariableId var);
+        InterpretedRuleInstance* getInterpretedParent() const;
 
         virtual void handleExecute();
 
@@ -610,6 +710,7 @@ class TokenEvalContext : public EvalContext {
 
     protected:
         std::vector<Expr*> m_body;
+        RuleSymbolTable m_symbols;
   };
 
   class RuleInstanceEvalContext : public EvalContext
@@ -683,6 +784,10 @@ private:
   virtual DataRef doEval(RuleInstanceEvalContext& context) const;
   virtual std::string toString() const;
 
+  const ExprIfGuard* getGuard() const { return m_guard; }
+  const std::vector<Expr*>& getIfBody() const { return m_ifBody; }
+  const std::vector<Expr*>& getElseBody() const { return m_elseBody; }
+
  protected:
   ExprIfGuard* m_guard;
   std::vector<Expr*> m_ifBody;
@@ -697,10 +802,18 @@ private:
 
   	    virtual DataRef doEval(RuleInstanceEvalContext& context) const;
 
+        const std::vector<Expr*>& getLoopBody() const { return m_loopBody; }
+
+        /**
+         * @brief Give the loop variable a slot in the rule declaring it
+         */
+        void resolve(RuleSymbolTable& symbols) const;
+
     protected:
         std::string m_varName;
     std::string m_varValue;
         std::vector<Expr*> m_loopBody;
+        mutable int m_slot;
   };
 
   class NativeTokenType: public TokenType
@@ -715,6 +828,12 @@ private:
 void getVariableReferences(const Expr* expr, EvalContext& ctx,
                            std::vector<ConstrainedVariableId>& dest);
 
+/**
+ * @brief Declare the names a rule body declares in a symbol table, when declare is true, or
+ * resolve the references in the body to the names declared, when it is false.
+ */
+void resolveRuleSymbols(const Expr* expr, RuleSymbolTable& symbols, bool declare);
+
 }
 
 #endif // H_Interpreter
@@ -1,6 +1,9 @@
 
 #include "nddl-test-module.hh"
+#include <algorithm>
 #include <fstream>
+#include <sstream>
+#include <vector>
 #include "NddlUtils.hh"
 #include "NddlTestEngine.hh"
 #include "Utils.hh"
@@ -9,10 +12,56 @@
 #include "ModuleTemporalNetwork.hh"
 #include "ModuleRulesEngine.hh"
 #include "ModuleNddl.hh"
+#include "PlanDatabase.hh"
+#include "ConstraintEngine.hh"
+#include "Token.hh"
+#include "TokenVariable.hh"
+#include "DataTypes.hh"
+#include "Interpreter.hh"
 
 using namespace EUROPA;
 using namespace NDDL;
 
+namespace {
+/**
+ * @brief The values of the slaves of the goal with the given predicate, in ascending order
+ */
+std::vector<edouble> slaveValues(const PlanDatabaseId db, const std::string& predicate)
+{
+    std::vector<edouble> values;
+    for (TokenSet::const_iterator it = db->getTokens().begin(); it != db->getTokens().end(); ++it) {
+        if ((*it)->getPredicateName() != predicate)
+            continue;
+        const TokenSet& slaves = (*it)->slaves();
+        for (TokenSet::const_iterator slave = slaves.begin(); slave != slaves.end(); ++slave) {
+            const Domain& value = (*slave)->getVariable("value")->lastDomain();
+            CPPUNIT_ASSERT_MESSAGE(value.toString(), value.isSingleton());
+            values.push_back(value.getSingletonValue());
+        }
+    }
+    std::sort(values.begin(), values.end());
+    return values;
+}
+
+/**
+ * @brief A context for top level statements, standing in for the symbol table of the parser
+ */
+class StatementContext : public EvalContext {
+public:
+    StatementContext(const PlanDatabaseId db) : EvalContext(NULL), m_db(db) {}
+
+    virtual void* getElement(const std::string& name) const
+    {
+        if (name == "PlanDatabase")
+            return static_cast<PlanDatabase*>(m_db);
+        return EvalContext::getElement(name);
+    }
+
+private:
+    PlanDatabaseId m_db;
+};
+}
+
 void NDDLModuleTests::syntaxTests()
 {
     std::string filename="parser.nddl";
@@ -22,6 +71,90 @@ void NDDLModuleTests::syntaxTests()
     CPPUNIT_ASSERT_MESSAGE("Nddl3 parser reported problems :\n" + result,result.size() == 0);
 }
 
+void NDDLModuleTests::ruleSlotTests()
+{
+    NddlTestEngine engine;
+    engine.init();
+    std::string result = engine.executeScript("nddl","nddl/rule-slots.nddl",true /*isFile*/);
+    CPPUNIT_ASSERT_MESSAGE("Nddl3 parser reported problems :\n" + result,result.size() == 0);
+    PlanDatabaseId db = reinterpret_cast<PlanDatabase*>(engine.getComponent("PlanDatabase"))->getId();
+    CPPUNIT_ASSERT(db->getConstraintEngine()->propagate());
+
+    // The same names declared in sibling branches
+    std::vector<edouble> values = slaveValues(db, "Tester.siblings");
+    CPPUNIT_ASSERT(values.size() == 2);
+    CPPUNIT_ASSERT(values[0] == 10 && values[1] == 20);
+
+    // A slave declared for each pair of values of nested loops
+    values = slaveValues(db, "Tester.nested");
+    CPPUNIT_ASSERT(values.size() == 4);
+    CPPUNIT_ASSERT(values[0] == 2 && values[1] == 11 && values[2] == 11 && values[3] == 20);
+
+    // A reference to a global before a local of the same name is declared
+    values = slaveValues(db, "Tester.beforeDeclaration");
+    CPPUNIT_ASSERT(values.size() == 2);
+    CPPUNIT_ASSERT(values[0] == 7 && values[1] == 9);
+}
+
+void NDDLModuleTests::initialStateSlotTests()
+{
+    NddlTestEngine engine;
+    engine.init();
+    std::string result = engine.executeScript("nddl","nddl/initial-state-slots.nddl",true /*isFile*/);
+    CPPUNIT_ASSERT_MESSAGE("Nddl3 parser reported problems :\n" + result,result.size() == 0);
+    PlanDatabaseId db = reinterpret_cast<PlanDatabase*>(engine.getComponent("PlanDatabase"))->getId();
+
+    // A statement-heavy initial state, where each statement refers to globals and goals declared by
+    // earlier ones, and to step, which the model file declared and is only found by name
+    const unsigned int count = 500;
+    std::ostringstream state;
+    state << "int v0 = 0;" << std::endl
+          << "goal(counter.count c0);" << std::endl
+          << "eq(c0.value, v0);" << std::endl;
+    for (unsigned int i = 1; i <= count; i++) {
+        state << "int v" << i << ";" << std::endl
+              << "addEq(v" << i-1 << ", step, v" << i << ");" << std::endl
+              << "goal(counter.count c" << i << ");" << std::endl
+              << "eq(c" << i << ".value, v" << i << ");" << std::endl
+              << "c" << i-1 << " before c" << i << ";" << std::endl;
+    }
+    result = engine.executeScript("nddl",state.str(),false /*isFile*/);
+    CPPUNIT_ASSERT_MESSAGE("Nddl3 parser reported problems :\n" + result,result.size() == 0);
+    CPPUNIT_ASSERT(db->getConstraintEngine()->propagate());
+
+    std::ostringstream last;
+    last << count;
+    const Domain& lastValue = db->getGlobalVariable("v" + last.str())->lastDomain();
+    CPPUNIT_ASSERT_MESSAGE(lastValue.toString(), lastValue.isSingleton() && lastValue.getSingletonValue() == count);
+    const TokenId lastGoal = db->getGlobalToken("c" + last.str());
+    CPPUNIT_ASSERT(lastGoal->getVariable("value")->lastDomain() == lastValue);
+    CPPUNIT_ASSERT(lastGoal->start()->lastDomain().getLowerBound() >=
+                   db->getGlobalToken("c0")->end()->lastDomain().getLowerBound() + count - 1);
+
+    // Declarations bind their names in the context of the statement, where references resolve them
+    StatementContext scope(db);
+    ExprVarDeclaration declaration("slotted", IntDT::instance(), NULL, true);
+    ConstrainedVariableId slotted = declaration.eval(scope).getValue();
+    ExprVarRef varRef("slotted", IntDT::instance());
+    CPPUNIT_ASSERT(varRef.resolve(scope));
+    CPPUNIT_ASSERT(varRef.eval(scope).getValue() == slotted);
+    CPPUNIT_ASSERT(slotted == db->getGlobalVariable("slotted"));
+
+    const TokenTypeId countType = db->getSchema()->getTokenType("Counter.count");
+    PredicateInstanceRef goal(countType, "counter.count", "slottedGoal", "");
+    TokenId slottedGoal = goal.getToken(scope, "", true /*isFact*/, false /*isRejectable*/);
+    PredicateInstanceRef goalRef(countType, "", "slottedGoal", "");
+    CPPUNIT_ASSERT(goalRef.resolve(scope));
+    CPPUNIT_ASSERT(goalRef.getToken(scope, "any") == slottedGoal);
+    ExprVarRef memberRef("slottedGoal.value", IntDT::instance());
+    CPPUNIT_ASSERT(memberRef.resolve(scope));
+    CPPUNIT_ASSERT(memberRef.eval(scope).getValue() == slottedGoal->getVariable("value"));
+
+    // Globals from other statement contexts are left to lookups by name
+    ExprVarRef otherRef("step", IntDT::instance());
+    CPPUNIT_ASSERT(!otherRef.resolve(scope));
+}
+
 
 
 NddlTest::NddlTest(const std::string& testName,
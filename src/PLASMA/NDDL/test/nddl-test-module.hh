@@ -7,20 +7,24 @@
 #include "NddlTestEngine.hh"
 
 class NDDLModuleTests : public CppUnit::TestFixture {
-  CPPUNIT_TEST_SUITE(NDDLModuleTests);
+  CPPUNIT_TEST_SUITE(NDDLModuleTests);
   CPPUNIT_TEST(syntaxTests);
-  CPPUNIT_TEST_SUITE_END();
+  CPPUNIT_TEST(ruleSlotTests);
+  CPPUNIT_TEST(initialStateSlotTests);
+  CPPUNIT_TEST_SUITE_END();
 
 public:
-  inline void setUp()
+  inline void setUp()
   {
-  }
-
-  inline void tearDown()
+  }
+
+  inline void tearDown()
   {
   }
 
   void syntaxTests();
+  void ruleSlotTests();
+  void initialStateSlotTests();
 };
 
 class NddlTest : public CppUnit::TestFixture
@@ -56,7 +56,7 @@ void ModulePlanDatabase::initialize(EngineId engine) {
       boost::polymorphic_cast<ConstraintEngine*>(engine->getComponent("ConstraintEngine"));
   CESchema* ceSchema = boost::polymorphic_cast<CESchema*>(engine->getComponent("CESchema"));
 
-  new DefaultPropagator("PlanDatabaseSystemPropagator", ce->getId(), SYSTEM_PRIORITY);
+  createAgendaPropagator(*engine->getConfig(), "PlanDatabaseSystemPropagator", ce->getId(), SYSTEM_PRIORITY);
   REGISTER_SYSTEM_CONSTRAINT(ceSchema,ObjectTokenRelation, "ObjectTokenRelation", "PlanDatabaseSystemPropagator");
   
   REGISTER_CONSTRAINT_TYPE(ceSchema,CommonAncestorCT, "commonAncestor", "Default");
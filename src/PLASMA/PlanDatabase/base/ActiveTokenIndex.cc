@@ -0,0 +1,312 @@
+#include "ActiveTokenIndex.hh"
+#include "Token.hh"
+#include "TokenVariable.hh"
+#include "Domain.hh"
+#include "Debug.hh"
+#include "Error.hh"
+
+#include <algorithm>
+#include <iterator>
+
+namespace EUROPA {
+
+/**
+ * @class ActiveTokenIndex::IntervalTree
+ * @brief Intervals of tokens kept in a treap ordered by lower bound, with the greatest upper bound of
+ * each subtree, so that the intervals overlapping a query are found in time logarithmic in the number
+ * of intervals and linear in the number found.
+ */
+class ActiveTokenIndex::IntervalTree {
+public:
+  IntervalTree() : m_root(NULL) {}
+  ~IntervalTree() {clear(m_root);}
+
+  void insert(const TokenId token, const edouble lb, const edouble ub) {
+    Node* node = new Node(token, lb, ub);
+    Node* left = NULL;
+    Node* right = NULL;
+    split(m_root, node->lb, node->key, left, right);
+    m_root = merge(merge(left, node), right);
+  }
+
+  void remove(const TokenId token, const edouble lb) {
+    remove(m_root, lb, token->getKey());
+  }
+
+  /**
+   * @brief Collects the tokens whose interval overlaps [lb, ub].
+   * @param limit The most results wanted.
+   * @return false if there are more than limit results, in which case results are incomplete.
+   */
+  bool query(const edouble lb, const edouble ub, const unsigned long limit, std::vector<TokenId>& results) const {
+    return query(m_root, lb, ub, limit, results);
+  }
+
+private:
+  struct Node {
+    Node(const TokenId t, const edouble l, const edouble u)
+      : token(t), key(t->getKey()), lb(l), ub(u), maxUb(u),
+        priority(static_cast<unsigned int>(cast_long(t->getKey())) * 2654435761u), left(NULL), right(NULL) {}
+    TokenId token;
+    eint key;
+    edouble lb, ub;
+    edouble maxUb; /*!< Greatest upper bound in the subtree */
+    unsigned int priority;
+    Node* left;
+    Node* right;
+  };
+
+  static bool before(const edouble lb, const eint key, const Node* node) {
+    return lb < node->lb || (lb == node->lb && key < node->key);
+  }
+
+  static void update(Node* node) {
+    node->maxUb = node->ub;
+    if(node->left != NULL && node->left->maxUb > node->maxUb)
+      node->maxUb = node->left->maxUb;
+    if(node->right != NULL && node->right->maxUb > node->maxUb)
+      node->maxUb = node->right->maxUb;
+  }
+
+  /**
+   * @brief Splits the tree into the nodes ordered before (lb, key) and the rest.
+   */
+  static void split(Node* node, const edouble lb, const eint key, Node*& left, Node*& right) {
+    if(node == NULL) {
+      left = right = NULL;
+      return;
+    }
+    if(before(lb, key, node)) {
+      split(node->left, lb, key, left, node->left);
+      right = node;
+    }
+    else {
+      split(node->right, lb, key, node->right, right);
+      left = node;
+    }
+    update(node);
+  }
+
+  static Node* merge(Node* left, Node* right) {
+    if(left == NULL)
+      return right;
+    if(right == NULL)
+      return left;
+    if(left->priority > right->priority) {
+      left->right = merge(left->right, right);
+      update(left);
+      return left;
+    }
+    right->left = merge(left, right->left);
+    update(right);
+    return right;
+  }
+
+  static void remove(Node*& node, const edouble lb, const eint key) {
+    checkError(node != NULL, "No interval for token (" << key << ") to remove.");
+    if(node->key == key) {
+      Node* removed = node;
+      node = merge(node->left, node->right);
+      delete removed;
+      return;
+    }
+    if(before(lb, key, node))
+      remove(node->left, lb, key);
+    else
+      remove(node->right, lb, key);
+    update(node);
+  }
+
+  static bool query(const Node* node, const edouble lb, const edouble ub, const unsigned long limit,
+                    std::vector<TokenId>& results) {
+    if(node == NULL || node->maxUb < lb)
+      return true;
+    if(!query(node->left, lb, ub, limit, results))
+      return false;
+    // Everything to the right starts after this node
+    if(node->lb > ub)
+      return true;
+    if(node->ub >= lb) {
+      if(results.size() == limit)
+        return false;
+      results.push_back(node->token);
+    }
+    return query(node->right, lb, ub, limit, results);
+  }
+
+  static void clear(Node* node) {
+    if(node == NULL)
+      return;
+    clear(node->left);
+    clear(node->right);
+    delete node;
+  }
+
+  Node* m_root;
+};
+
+  ActiveTokenIndex::ActiveTokenIndex()
+    : m_tokens(), m_dirty(), m_filings(), m_positions(),
+      m_starts(new IntervalTree()), m_ends(new IntervalTree()) {}
+
+  ActiveTokenIndex::~ActiveTokenIndex() {
+    delete m_starts;
+    delete m_ends;
+  }
+
+  void ActiveTokenIndex::insert(const TokenId token) {
+    check_error(m_tokens.find(token) == m_tokens.end());
+    m_tokens.insert(token);
+    // Filed on the next refresh, when its domains are known to be consistent
+    m_dirty.insert(token);
+  }
+
+  void ActiveTokenIndex::remove(const TokenId token) {
+    check_error(m_tokens.find(token) != m_tokens.end());
+    unfile(token);
+    m_dirty.erase(token);
+    m_tokens.erase(token);
+  }
+
+  void ActiveTokenIndex::markDirty(const TokenId token) {
+    check_error(m_tokens.find(token) != m_tokens.end());
+    m_dirty.insert(token);
+  }
+
+  void ActiveTokenIndex::refresh() {
+    for(TokenSet::const_iterator it = m_dirty.begin(); it != m_dirty.end(); ++it) {
+      unfile(*it);
+      file(*it);
+    }
+    m_dirty.clear();
+  }
+
+  bool ActiveTokenIndex::isIndexedVariable(const TokenId token, unsigned int index) {
+    return index != 0 &&
+      index != token->start()->getIndex() &&
+      index != token->end()->getIndex() &&
+      index != token->duration()->getIndex();
+  }
+
+  bool ActiveTokenIndex::isBucketable(const Domain& dom) {
+    return dom.isClosed() && dom.isEnumerated() && !dom.isNumeric() && dom.isSingleton();
+  }
+
+  void ActiveTokenIndex::file(const TokenId token) {
+    check_error(m_filings.find(token) == m_filings.end());
+    Filing& filing = m_filings[token];
+
+    const Domain& start = token->start()->lastDomain();
+    const Domain& end = token->end()->lastDomain();
+    filing.startLb = start.getLowerBound();
+    filing.startUb = start.getUpperBound();
+    filing.endLb = end.getLowerBound();
+    filing.endUb = end.getUpperBound();
+    m_starts->insert(token, filing.startLb, filing.startUb);
+    m_ends->insert(token, filing.endLb, filing.endUb);
+
+    const std::vector<ConstrainedVariableId>& vars = token->getVariables();
+    if(m_positions.size() < vars.size())
+      m_positions.resize(vars.size());
+    filing.values.resize(vars.size(), std::make_pair(UNINDEXED, 0.0));
+
+    for(unsigned int i = 0; i < vars.size(); i++) {
+      if(!isIndexedVariable(token, i))
+        continue;
+      const Domain& dom = vars[i]->lastDomain();
+      if(isBucketable(dom)) {
+        filing.values[i] = std::make_pair(BUCKET, cast_double(dom.getSingletonValue()));
+        m_positions[i].buckets[filing.values[i].second].insert(token);
+      }
+      else {
+        filing.values[i] = std::make_pair(WILDCARD, 0.0);
+        m_positions[i].wildcards.insert(token);
+      }
+    }
+
+    debugMsg("ActiveTokenIndex:file",
+             "Filed " << token->getKey() << " with start [" << filing.startLb << " " << filing.startUb <<
+             "] and end [" << filing.endLb << " " << filing.endUb << "]");
+  }
+
+  void ActiveTokenIndex::unfile(const TokenId token) {
+    std::map<TokenId, Filing, EntityComparator<TokenId> >::iterator it = m_filings.find(token);
+    if(it == m_filings.end())
+      return;
+
+    const Filing& filing = it->second;
+    m_starts->remove(token, filing.startLb);
+    m_ends->remove(token, filing.endLb);
+
+    for(unsigned int i = 0; i < filing.values.size(); i++) {
+      Position& position = m_positions[i];
+      if(filing.values[i].first == BUCKET) {
+        boost::unordered_map<double, TokenSet>::iterator bucket = position.buckets.find(filing.values[i].second);
+        check_error(bucket != position.buckets.end());
+        bucket->second.erase(token);
+        if(bucket->second.empty())
+          position.buckets.erase(bucket);
+      }
+      else if(filing.values[i].first == WILDCARD)
+        position.wildcards.erase(token);
+    }
+
+    m_filings.erase(it);
+  }
+
+  bool ActiveTokenIndex::getCandidates(const TokenId token, std::vector<TokenId>& results) const {
+    checkError(m_dirty.empty(), "Index must be refreshed before it is queried.");
+    check_error(results.empty());
+
+    // Find the most selective bucket among the variables of the token which are singletons
+    const TokenSet* bucket = NULL;
+    const TokenSet* wildcards = NULL;
+    unsigned long best = m_tokens.size();
+    const std::vector<ConstrainedVariableId>& vars = token->getVariables();
+    for(unsigned int i = 0; i < vars.size() && i < m_positions.size(); i++) {
+      if(!isIndexedVariable(token, i))
+        continue;
+      const Domain& dom = vars[i]->lastDomain();
+      if(!isBucketable(dom))
+        continue;
+      static const TokenSet sl_noTokens;
+      const Position& position = m_positions[i];
+      boost::unordered_map<double, TokenSet>::const_iterator it =
+        position.buckets.find(cast_double(dom.getSingletonValue()));
+      const TokenSet& matches = (it == position.buckets.end() ? sl_noTokens : it->second);
+      if(matches.size() + position.wildcards.size() < best) {
+        best = matches.size() + position.wildcards.size();
+        bucket = &matches;
+        wildcards = &position.wildcards;
+      }
+    }
+
+    // An interval tree does better if it turns up fewer tokens. Query the one for the narrower of
+    // the start and end of the token. Bounds are widened by the tolerance of domain comparison.
+    const Domain& start = token->start()->lastDomain();
+    const Domain& end = token->end()->lastDomain();
+    bool useStart = (start.getUpperBound() - start.getLowerBound() <= end.getUpperBound() - end.getLowerBound());
+    const Domain& time = (useStart ? start : end);
+    const IntervalTree* tree = (useStart ? m_starts : m_ends);
+    if(best > 0 &&
+       tree->query(time.getLowerBound() - time.minDelta(), time.getUpperBound() + time.minDelta(),
+                   best - 1, results)) {
+      debugMsg("ActiveTokenIndex:getCandidates",
+               results.size() << " of " << m_tokens.size() << " tokens overlap the " <<
+               (useStart ? "start " : "end ") << time.toString() << " of " << token->getKey());
+      std::sort(results.begin(), results.end(), EntityComparator<TokenId>());
+      return true;
+    }
+    results.clear();
+
+    if(bucket == NULL)
+      return false;
+
+    debugMsg("ActiveTokenIndex:getCandidates",
+             best << " of " << m_tokens.size() << " tokens are in the bucket for " << token->getKey());
+    results.reserve(best);
+    std::set_union(bucket->begin(), bucket->end(), wildcards->begin(), wildcards->end(),
+                   std::back_inserter(results), EntityComparator<TokenId>());
+    return true;
+  }
+}
@@ -0,0 +1,120 @@
+#ifndef H_ActiveTokenIndex
+#define H_ActiveTokenIndex
+
+/**
+ * @file   ActiveTokenIndex.hh
+ * @brief Index of the active tokens of a predicate, used to prune merge candidates.
+ * @ingroup PlanDatabase
+ */
+
+#include "PlanDatabaseDefs.hh"
+#include "Number.hh"
+
+#include <boost/unordered_map.hpp>
+#include <map>
+#include <vector>
+
+namespace EUROPA {
+
+  /**
+   * @class ActiveTokenIndex
+   * @brief Holds the active tokens of one predicate, indexed by the domains of their variables.
+   *
+   * Tokens are filed in an interval tree over the bounds of their start times, another over
+   * the bounds of their end times, and, for the object variable and each parameter, in a hash
+   * bucket keyed by its value if it is a closed, non-numeric singleton. A token whose
+   * variable is not such a singleton is filed as a wildcard for that variable.
+   *
+   * Filings are brought up to date lazily: a token whose variables change is marked dirty, and
+   * is refiled from its current domains by the next call to refresh(). Domains must be
+   * consistent at that point, so the plan database only refreshes after propagation succeeds.
+   */
+  class ActiveTokenIndex {
+  public:
+    ActiveTokenIndex();
+    ~ActiveTokenIndex();
+
+    /**
+     * @brief All tokens in the index.
+     */
+    const TokenSet& getTokens() const {return m_tokens;}
+
+    void insert(const TokenId token);
+
+    void remove(const TokenId token);
+
+    /**
+     * @brief Note that the domains of the token may have changed since it was filed.
+     */
+    void markDirty(const TokenId token);
+
+    /**
+     * @brief Refile all dirty tokens from their current domains.
+     */
+    void refresh();
+
+    /**
+     * @brief Retrieve the tokens which may be compatible with the given token.
+     *
+     * Any token of the index which is not among the results cannot be merged with the given
+     * token, since one of its variables does not intersect the corresponding variable of the
+     * given token. The results must still be tested pairwise.
+     * @param token The token to find candidates for. Its variables must correspond to those of the indexed tokens.
+     * @param results Output parameter, initially empty. On success, holds the candidates ordered by key.
+     * @return false if the index cannot narrow getTokens() down, in which case results are not filled.
+     */
+    bool getCandidates(const TokenId token, std::vector<TokenId>& results) const;
+
+  private:
+    ActiveTokenIndex(const ActiveTokenIndex&);
+    ActiveTokenIndex& operator=(const ActiveTokenIndex&);
+
+    class IntervalTree;
+
+    enum Placement {
+      UNINDEXED = 0,
+      BUCKET,
+      WILDCARD
+    };
+
+    /**
+     * @brief Where a token is filed. Kept in full so that a token can be unfiled while it is being deleted.
+     */
+    struct Filing {
+      edouble startLb, startUb, endLb, endUb;
+      std::vector<std::pair<Placement, double> > values; /*!< By variable index, where the token is filed and the bucket key. */
+    };
+
+    /**
+     * @brief Buckets of the tokens by the value of one variable.
+     */
+    struct Position {
+      Position() : buckets(), wildcards() {}
+      boost::unordered_map<double, TokenSet> buckets;
+      TokenSet wildcards;
+    };
+
+    /**
+     * @brief True if the variable at the given index of the token is filed in buckets.
+     */
+    static bool isIndexedVariable(const TokenId token, unsigned int index);
+
+    /**
+     * @brief True if the domain can only intersect a closed, non-numeric singleton of the same value.
+     */
+    static bool isBucketable(const Domain& dom);
+
+    void file(const TokenId token);
+
+    void unfile(const TokenId token);
+
+    TokenSet m_tokens;
+    TokenSet m_dirty; /*!< Tokens whose filings may be out of date */
+    std::map<TokenId, Filing, EntityComparator<TokenId> > m_filings;
+    std::vector<Position> m_positions; /*!< Buckets by variable index */
+    IntervalTree* m_starts;
+    IntervalTree* m_ends;
+  };
+}
+
+#endif
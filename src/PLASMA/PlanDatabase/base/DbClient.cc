@@ -52,6 +52,11 @@ DbClient::DbClient(const PlanDatabaseId db)
       return m_planDb->getSchema();
   }
 
+  const PlanDatabaseId DbClient::getPlanDatabase() const
+  {
+      return m_planDb;
+  }
+
 
   ConstrainedVariableId
   DbClient::createVariable(const std::string& typeName, const Domain& baseDomain, const std::string& name, bool isTmpVar, bool canBeSpecified)
@@ -336,6 +336,7 @@ namespace EUROPA {
     // Temporarily exposing these to remove singletons, need to review DbClient concept in general
     const CESchemaId getCESchema() const;
     const SchemaId getSchema() const;
+    const PlanDatabaseId getPlanDatabase() const;
 
   private:
     friend class PlanDatabase;
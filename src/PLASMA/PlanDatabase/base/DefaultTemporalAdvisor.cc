@@ -33,6 +33,11 @@ namespace EUROPA {
     return first->getDerivedDomain().getLowerBound() <= second->getDerivedDomain().getUpperBound();
   }
 
+  /**
+   * @brief Domain bound checks are cheap enough that there is nothing to precompute.
+   */
+  void DefaultTemporalAdvisor::cacheOrderingDistances(const TokenId) {}
+
   bool DefaultTemporalAdvisor::canFitBetween(const TokenId token, const TokenId predecessor, const TokenId successor){
     check_error(token.isValid());
     check_error(predecessor.isValid());
@@ -51,6 +56,18 @@ namespace EUROPA {
       return false;
   }
 
+  /**
+   * @brief Tests each gap in turn, so that an implementation of canFitBetween is used as it is.
+   */
+  void DefaultTemporalAdvisor::canFitBetweenEach(const TokenId token,
+                                                 const std::vector<std::pair<TokenId, TokenId> >& gaps,
+                                                 std::vector<bool>& results) {
+    check_error(results.empty());
+    results.reserve(gaps.size());
+    for (std::vector<std::pair<TokenId, TokenId> >::const_iterator it = gaps.begin(); it != gaps.end(); ++it)
+      results.push_back(canFitBetween(token, it->first, it->second));
+  }
+
 
 /**
  * @brief Trivially return true since basic domain intersection tests have been done in
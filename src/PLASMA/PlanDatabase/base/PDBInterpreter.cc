@@ -41,7 +41,7 @@ namespace EUROPA {
    * EvalContext
    */
   EvalContext::EvalContext(EvalContext* parent)
-      : m_parent(parent), m_variables(), m_tokens()
+      : m_parent(parent), m_variables(), m_tokens(), m_variableSlots(), m_tokenSlots()
   {
   }
 
@@ -49,43 +49,106 @@ namespace EUROPA {
   {
   }
 
-  void EvalContext::addVar(const std::string& name,const ConstrainedVariableId v)
+  unsigned int EvalContext::addVar(const std::string& name,const ConstrainedVariableId v)
   {
-    m_variables[name] = v;
-    debugMsg("Interpreter:EvalContext","Added var:" << name << " to EvalContext");
+    std::pair<std::map<std::string,unsigned int>::iterator,bool> result =
+      m_variableSlots.insert(std::make_pair(name, static_cast<unsigned int>(m_variables.size())));
+    if (result.second)
+      m_variables.push_back(v);
+    else
+      m_variables[result.first->second] = v;
+    debugMsg("Interpreter:EvalContext","Added var:" << name << " to EvalContext in slot " << result.first->second);
+    return result.first->second;
   }
 
   ConstrainedVariableId EvalContext::getVar(const std::string& name)
   {
-    std::map<std::string,ConstrainedVariableId>::iterator it =
-      m_variables.find(name);
+    std::map<std::string,unsigned int>::const_iterator it =
+      m_variableSlots.find(name);
 
-    if( it != m_variables.end() )
-      return it->second;
+    if( it != m_variableSlots.end() )
+      return m_variables[it->second];
     else if (m_parent != NULL)
       return m_parent->getVar(name);
     else
       return ConstrainedVariableId::noId();
   }
 
-  void EvalContext::addToken(const std::string& name,const TokenId t)
+  unsigned int EvalContext::addToken(const std::string& name,const TokenId t)
   {
-    m_tokens[name] = t;
+    std::pair<std::map<std::string,unsigned int>::iterator,bool> result =
+      m_tokenSlots.insert(std::make_pair(name, static_cast<unsigned int>(m_tokens.size())));
+    if (result.second)
+      m_tokens.push_back(t);
+    else
+      m_tokens[result.first->second] = t;
+    debugMsg("Interpreter:EvalContext","Added token:" << name << " to EvalContext in slot " << result.first->second);
+    return result.first->second;
   }
 
   TokenId EvalContext::getToken(const std::string& name)
   {
-    std::map<std::string,TokenId>::iterator it =
-      m_tokens.find(name);
+    std::map<std::string,unsigned int>::const_iterator it =
+      m_tokenSlots.find(name);
 
-    if( it != m_tokens.end() )
-      return it->second;
+    if( it != m_tokenSlots.end() )
+      return m_tokens[it->second];
     else if (m_parent != NULL)
       return m_parent->getToken(name);
     else
       return TokenId::noId();
   }
 
+  bool EvalContext::resolveVar(const std::string& name, unsigned int& depth, unsigned int& slot) const
+  {
+    depth = 0;
+    for (const EvalContext* context = this; context != NULL; context = context->m_parent, depth++) {
+      std::map<std::string,unsigned int>::const_iterator it = context->m_variableSlots.find(name);
+      if (it != context->m_variableSlots.end()) {
+        slot = it->second;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool EvalContext::resolveToken(const std::string& name, unsigned int& depth, unsigned int& slot) const
+  {
+    depth = 0;
+    for (const EvalContext* context = this; context != NULL; context = context->m_parent, depth++) {
+      std::map<std::string,unsigned int>::const_iterator it = context->m_tokenSlots.find(name);
+      if (it != context->m_tokenSlots.end()) {
+        slot = it->second;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  const EvalContext* EvalContext::getAncestor(unsigned int depth) const
+  {
+    const EvalContext* context = this;
+    for (; context != NULL && depth > 0; depth--)
+      context = context->m_parent;
+    return context;
+  }
+
+  ConstrainedVariableId EvalContext::getSlotVar(unsigned int depth, unsigned int slot) const
+  {
+    const EvalContext* context = getAncestor(depth);
+    if (context == NULL || slot >= context->m_variables.size())
+      return ConstrainedVariableId::noId();
+    return context->m_variables[slot];
+  }
+
+  TokenId EvalContext::getSlotToken(unsigned int depth, unsigned int slot) const
+  {
+    const EvalContext* context = getAncestor(depth);
+    if (context == NULL || slot >= context->m_tokens.size())
+      return TokenId::noId();
+    return context->m_tokens[slot];
+  }
+
 void* EvalContext::getElement(const std::string&) const {return NULL;}
 
   std::string EvalContext::toString() const
@@ -97,16 +160,16 @@ void* EvalContext::getElement(const std::string&) const {return NULL;}
     else
       os << m_parent->toString();
 
-    std::map<std::string,ConstrainedVariableId>::const_iterator varIt = m_variables.begin();
+    std::map<std::string,unsigned int>::const_iterator varIt = m_variableSlots.begin();
     os << "    vars {";
-    for (;varIt != m_variables.end();++varIt)
-      os << varIt->first << " " << varIt->second->toString() << ",";
+    for (;varIt != m_variableSlots.end();++varIt)
+      os << varIt->first << " " << m_variables[varIt->second]->toString() << ",";
     os << "    }" << std::endl;
 
-    std::map<std::string,TokenId>::const_iterator tokenIt = m_tokens.begin();
+    std::map<std::string,unsigned int>::const_iterator tokenIt = m_tokenSlots.begin();
     os << "    tokens {";
-    for (;tokenIt != m_tokens.end();++tokenIt)
-      os << tokenIt->first << " " << tokenIt->second->getPredicateName() << ",";
+    for (;tokenIt != m_tokenSlots.end();++tokenIt)
+      os << tokenIt->first << " " << m_tokens[tokenIt->second]->getPredicateName() << ",";
     os << "    }"  << std::endl;
 
     if (m_parent == NULL)
@@ -31,21 +31,46 @@ class EvalContext {
   EvalContext(EvalContext* parent);
   virtual ~EvalContext();
 
-  virtual void addVar(const std::string& name,const ConstrainedVariableId v);
+  /**
+   * @brief Bind a name in this context. A name bound again keeps its slot.
+   * @return The slot of the name in this context
+   */
+  virtual unsigned int addVar(const std::string& name,const ConstrainedVariableId v);
   virtual ConstrainedVariableId getVar(const std::string& name);
 
-  virtual void addToken(const std::string& name,const TokenId t);
+  virtual unsigned int addToken(const std::string& name,const TokenId t);
   virtual TokenId getToken(const std::string& name);
 
+  /**
+   * @brief Find the coordinates of a name bound with addVar in this context or its ancestors,
+   * depth being the number of parents up from this context. Names subclasses supply from
+   * elsewhere, like token or object variables, are not seen, so a name is only worth resolving
+   * where nothing between here and its binding can shadow it.
+   * @return false if the name is not bound
+   */
+  bool resolveVar(const std::string& name, unsigned int& depth, unsigned int& slot) const;
+  bool resolveToken(const std::string& name, unsigned int& depth, unsigned int& slot) const;
+
+  /**
+   * @brief Lookups by resolved coordinates, which index straight into the context holding them.
+   * noId if there is no such slot.
+   */
+  ConstrainedVariableId getSlotVar(unsigned int depth, unsigned int slot) const;
+  TokenId getSlotToken(unsigned int depth, unsigned int slot) const;
+
   virtual void* getElement(const std::string& name) const;
 
   virtual std::string toString() const;
 
  protected:
   EvalContext* m_parent;
-  std::map<std::string,ConstrainedVariableId> m_variables;
-  std::map<std::string,TokenId> m_tokens;
+  std::vector<ConstrainedVariableId> m_variables; /*!< By slot */
+  std::vector<TokenId> m_tokens; /*!< By slot */
+  std::map<std::string,unsigned int> m_variableSlots; /*!< Slots of names, for resolution, debugging and lookups by name */
+  std::map<std::string,unsigned int> m_tokenSlots;
  private:
+  const EvalContext* getAncestor(unsigned int depth) const;
+
   EvalContext(const EvalContext&);
   EvalContext& operator=(const EvalContext&);
 };
@@ -1,5 +1,6 @@
 #include "PlanDatabase.hh"
 #include "PlanDatabaseWriter.hh"
+#include "ActiveTokenIndex.hh"
 #include "Object.hh"
 #include "Schema.hh"
 #include "Token.hh"
@@ -10,6 +11,7 @@
 #include "DbClient.hh"
 #include "Utils.hh"
 #include "ConstraintEngine.hh"
+#include "ConstraintEngineListener.hh"
 #include "ConstraintType.hh"
 #include "Entity.hh"
 #include "Debug.hh"
@@ -53,6 +55,29 @@ namespace EUROPA{
     const PlanDatabaseId m_planDb;
   };
 
+  /**
+   * @brief Implements a Listener to keep the indexes of active tokens in step with their variables.
+   */
+  class ActiveTokenListener: public ConstraintEngineListener {
+  public:
+    using ConstraintEngineListener::notifyActivated;
+
+    void notifyChanged(const ConstrainedVariableId var, const DomainListener::ChangeType&){
+      m_planDb->handleActiveTokenChange(var);
+    }
+
+    void notifyActivated(const ConstrainedVariableId var){
+      m_planDb->handleActiveTokenChange(var);
+    }
+
+  private:
+    friend class PlanDatabase;
+    ActiveTokenListener(const ConstraintEngineId ce, const PlanDatabaseId planDb)
+      : ConstraintEngineListener(ce), m_planDb(planDb){}
+
+    const PlanDatabaseId m_planDb;
+  };
+
 #define  publish(message){						\
     check_error(!Entity::isPurging());					\
     for(std::vector<PlanDatabaseListenerId>::const_reverse_iterator rit = m_listeners.rbegin(), rend = m_listeners.rend(); rit != rend; ++rit) \
@@ -82,19 +107,25 @@ namespace EUROPA{
       , m_globalTokensByName()
       , m_tokensToOrder()
       , m_activeTokensByPredicate()
+      , m_activeTokenIndexes()
+      , m_activeTokenListener()
       , m_objectVariablesByObjectType()
+      , m_autoNameCount(0)
 
   {
       check_error(m_constraintEngine.isValid());
       check_error(m_schema.isValid());
       m_client = (new DbClient(m_id))->getId();
       m_psClient = new PSPlanDatabaseClientImpl(m_client);
+      m_activeTokenListener = (new ActiveTokenListener(m_constraintEngine, m_id))->getId();
   }
 
   PlanDatabase::~PlanDatabase()
   {
       m_deleted = true;
 
+      delete static_cast<ConstraintEngineListener*>(m_activeTokenListener);
+
       if(!isPurged())
         purge();
 
@@ -111,6 +142,10 @@ namespace EUROPA{
         it != m_objectVariablesByObjectType.end(); ++it)
      	delete static_cast<ObjectVariableListener*>(it->second.second);
 
+      for(std::map<std::string, ActiveTokenIndex*>::const_iterator it = m_activeTokensByPredicate.begin();
+          it != m_activeTokensByPredicate.end(); ++it)
+        delete it->second;
+
       m_id.remove();
   }
 
@@ -404,10 +439,30 @@ bool PlanDatabase::hasObjectInstances(const std::string& objectType) const {
     if(!m_constraintEngine->propagate())
       return;
 
-    // Draw from list of active tokens of the same predicate
-    const TokenSet& candidates = getActiveTokens(inactiveToken->getPredicateName());
+    // Draw from list of active tokens of the same predicate, narrowed down by the index where possible
+    std::map<std::string, ActiveTokenIndex*>::const_iterator indexIt =
+        m_activeTokensByPredicate.find(inactiveToken->getPredicateName());
+    if(indexIt == m_activeTokensByPredicate.end()){
+      debugMsg("PlanDatabase:getCompatibleTokens", "No candidates to evaluate for " << inactiveToken->toString());
+      return;
+    }
 
-    condDebugMsg(candidates.empty(),
+    ActiveTokenIndex& index = *(indexIt->second);
+    index.refresh();
+    std::vector<TokenId> indexedCandidates;
+    if(index.getCandidates(inactiveToken, indexedCandidates))
+      getCompatibleTokens(inactiveToken, indexedCandidates.begin(), indexedCandidates.end(), results, limit, useExactTest);
+    else
+      getCompatibleTokens(inactiveToken, index.getTokens().begin(), index.getTokens().end(), results, limit, useExactTest);
+  }
+
+  template<class Iterator>
+  void PlanDatabase::getCompatibleTokens(const TokenId inactiveToken,
+                                         Iterator begin, Iterator end,
+                                         std::vector<TokenId>& results,
+                                         unsigned int limit,
+                                         bool useExactTest) {
+    condDebugMsg(begin == end,
 		 "PlanDatabase:getCompatibleTokens", "No candidates to evaluate for " << inactiveToken->toString());
 
     const std::vector<ConstrainedVariableId>& inactiveTokenVariables = inactiveToken->getVariables();
@@ -417,7 +472,7 @@ bool PlanDatabase::hasObjectInstances(const std::string& objectType) const {
 
     TemporalAdvisorId temporalAdvisor = getTemporalAdvisor();
 
-    for(TokenSet::const_iterator it = candidates.begin(); it != candidates.end(); ++it){
+    for(Iterator it = begin; it != end; ++it){
       TokenId candidate = *it;
 
       debugMsg("PlanDatabase:getCompatibleTokens",
@@ -635,10 +690,10 @@ void PlanDatabase::getObjectsByPredicate(const std::string& predicate,
 
 const TokenSet& PlanDatabase::getActiveTokens(const std::string& predicate) const {
   static const TokenSet sl_noTokens;
-  std::map<std::string, TokenSet>::const_iterator it =
+  std::map<std::string, ActiveTokenIndex*>::const_iterator it =
       m_activeTokensByPredicate.find(predicate);
   if(it != m_activeTokensByPredicate.end())
-    return it->second;
+    return it->second->getTokens();
   else
     return sl_noTokens;
 }
@@ -955,17 +1010,16 @@ void PlanDatabase::insertActiveToken(const TokenId token){
 
   debugMsg("PlanDatabase:insertActiveToken", token->toString());
 
+  std::pair<TokenId, std::vector<ActiveTokenIndex*> >& indexes = m_activeTokenIndexes[token->getKey()];
+  indexes.first = token;
+
   while(getSchema()->isPredicate(predicate)){
-    std::map<std::string, TokenSet>::iterator it = m_activeTokensByPredicate.find(predicate);
-    if(it == m_activeTokensByPredicate.end()){
-      static const TokenSet emptySet;
-      std::pair<std::string, TokenSet > entry(predicate, emptySet);
-      m_activeTokensByPredicate.insert(entry);
-      it = m_activeTokensByPredicate.find(predicate);
-    }
+    std::map<std::string, ActiveTokenIndex*>::iterator it = m_activeTokensByPredicate.find(predicate);
+    if(it == m_activeTokensByPredicate.end())
+      it = m_activeTokensByPredicate.insert(std::make_pair(predicate, new ActiveTokenIndex())).first;
 
-    TokenSet& activeTokens = it->second;
-    activeTokens.insert(token);
+    it->second->insert(token);
+    indexes.second.push_back(it->second);
     debugMsg("PlanDatabase:insertActiveToken", token->toString() << " added for " << predicate);
 
     // Break if we hit a built in class
@@ -988,11 +1042,12 @@ void PlanDatabase::insertActiveToken(const TokenId token){
 
     debugMsg("PlanDatabase:removeActiveToken", token->toString());
 
+    m_activeTokenIndexes.erase(token->getKey());
+
     while(getSchema()->isPredicate(predicate)){
-      std::map<std::string, TokenSet>::iterator it = m_activeTokensByPredicate.find(predicate);
+      std::map<std::string, ActiveTokenIndex*>::iterator it = m_activeTokensByPredicate.find(predicate);
       checkError(it != m_activeTokensByPredicate.end(), token->toString() << " must be present but isn't.")
-      TokenSet& activeTokens = it->second;
-      activeTokens.erase(token);
+      it->second->remove(token);
       debugMsg("PlanDatabase:removeActiveToken", token->toString() << " removed for " << predicate);
 
       // Break if we hit a built in class
@@ -1007,6 +1062,20 @@ void PlanDatabase::insertActiveToken(const TokenId token){
     }
   }
 
+  void PlanDatabase::handleActiveTokenChange(const ConstrainedVariableId var){
+    if(Entity::isPurging() || var->getIndex() == 0 || var->parent().isNoId())
+      return;
+
+    std::map<eint, std::pair<TokenId, std::vector<ActiveTokenIndex*> > >::const_iterator it =
+      m_activeTokenIndexes.find(var->parent()->getKey());
+    if(it == m_activeTokenIndexes.end())
+      return;
+
+    const std::vector<ActiveTokenIndex*>& indexes = it->second.second;
+    for(std::vector<ActiveTokenIndex*>::const_iterator indexIt = indexes.begin(); indexIt != indexes.end(); ++indexIt)
+      (*indexIt)->markDirty(it->second.first);
+  }
+
   // PSPlanDatabase methods
 PSList<PSObject*> PlanDatabase::getAllObjects() const {
   PSList<PSObject*> retval;
@@ -1084,22 +1153,18 @@ PSList<PSVariable*>  PlanDatabase::getAllGlobalVariables() const {
       return object;
   }
 
-namespace {
-std::string autoLabel(const char* prefix) {
-  static int cnt = 0;
+std::string PlanDatabase::makeAutoName(const std::string& prefix) {
   std::ostringstream os;
-  
-  os << prefix << "_" << cnt++;
+  os << prefix << m_autoNameCount++;
   return os.str();
 }
-}
 
 TokenId PlanDatabase::createToken(const std::string& tokenType,
                                   const std::string& tokenName,
                                   bool rejectable,
                                   bool isFact) {
       std::string ttype =tokenType;
-      std::string nameStr = (!tokenName.empty() ? tokenName : autoLabel("globalToken"));
+      std::string nameStr = (!tokenName.empty() ? tokenName : makeAutoName("globalToken_"));
       std::string tname(nameStr);
 
       debugMsg("PlanDatabase:createToken", ttype << " " << tname);
@@ -26,6 +26,8 @@
 namespace EUROPA {
 
 	class ObjectVariableListener;
+  class ActiveTokenIndex;
+  class ActiveTokenListener;
 
   /**
    * @brief The main mediator for interaction with entities of the plan and managing their relationships.
@@ -335,6 +337,11 @@ namespace EUROPA {
 
     bool hasTokenTypes() const;
 
+    /**
+     * @brief Makes a name, starting with the given prefix, that no other call on this database returns.
+     */
+    std::string makeAutoName(const std::string& prefix);
+
     PSPlanDatabaseClient* getPDBClient();
 
     virtual std::string toString();
@@ -344,6 +351,7 @@ namespace EUROPA {
     friend class Object;
     friend class PlanDatabaseListener;
     friend class ObjectVariableListener;
+    friend class ActiveTokenListener;
 
     void notifyAdded(const ObjectId object);
 
@@ -424,6 +432,22 @@ namespace EUROPA {
      */
     void removeActiveToken(const TokenId token);
 
+    /**
+     * @brief Marks an active token for refiling in the indexes which hold it, since one of its variables changed.
+     */
+    void handleActiveTokenChange(const ConstrainedVariableId var);
+
+    /**
+     * @brief Test candidate active tokens, in the given order, for compatibility with an inactive token.
+     * @see getCompatibleTokens
+     */
+    template<class Iterator>
+    void getCompatibleTokens(const TokenId inactiveToken,
+                             Iterator begin, Iterator end,
+                             std::vector<TokenId>& results,
+                             unsigned int limit,
+                             bool useExactTest);
+
     PlanDatabaseId m_id;
     const ConstraintEngineId m_constraintEngine;
     const SchemaId m_schema;
@@ -449,13 +473,17 @@ namespace EUROPA {
     std::map<eint, std::pair<TokenId, ObjectSet> > m_tokensToOrder; /*!< All tokens to order, with the object
 								     inducing the requirement stored in the set */
 
-    std::map<std::string, TokenSet > m_activeTokensByPredicate; /*!< All active tokens sorted by predicate */
+    std::map<std::string, ActiveTokenIndex*> m_activeTokensByPredicate; /*!< All active tokens sorted by predicate */
+    std::map<eint, std::pair<TokenId, std::vector<ActiveTokenIndex*> > > m_activeTokenIndexes; /*!< The indexes holding
+                                                                                                 each active token, by key */
+    ConstraintEngineListenerId m_activeTokenListener; /*!< Marks active tokens dirty as their variables change */
 
     // All this to store variables (and their listeners) for Open Object Types
     typedef std::multimap<std::string, std::pair<ConstrainedVariableId, ConstrainedVariableListenerId> > ObjVarsByObjType;
     typedef ObjVarsByObjType::iterator ObjVarsByObjType_I;
     typedef ObjVarsByObjType::const_iterator ObjVarsByObjType_CI;
     ObjVarsByObjType m_objectVariablesByObjectType;
+    unsigned int m_autoNameCount; /*!< Used by makeAutoName. Per database so that engines in separate threads do not share it */
 private:
     PlanDatabase(const PlanDatabase&);
     PlanDatabase& operator=(const PlanDatabase&);
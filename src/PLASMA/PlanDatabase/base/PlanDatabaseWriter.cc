@@ -11,6 +11,64 @@
 
 namespace EUROPA {
 
+  namespace {
+    void writeJsonString(std::ostream& os, const std::string& str) {
+      os << '"';
+      for (std::string::const_iterator it = str.begin(); it != str.end(); ++it) {
+        const char c = *it;
+        if (c == '"' || c == '\\')
+          os << '\\' << c;
+        else if (c == '\n')
+          os << "\\n";
+        else if (c == '\t')
+          os << "\\t";
+        else if (static_cast<unsigned char>(c) < 0x20) {
+          static const char hex[] = "0123456789abcdef";
+          os << "\\u00" << hex[(c >> 4) & 0xf] << hex[c & 0xf];
+        }
+        else
+          os << c;
+      }
+      os << '"';
+    }
+
+    void writeJsonBound(std::ostream& os, edouble bound) {
+      if (bound == MINUS_INFINITY)
+        os << "\"-inf\"";
+      else if (bound == PLUS_INFINITY)
+        os << "\"+inf\"";
+      else
+        os << bound;
+    }
+
+    void writeJsonBounds(std::ostream& os, const Domain& dom) {
+      os << '[';
+      writeJsonBound(os, dom.getLowerBound());
+      os << ',';
+      writeJsonBound(os, dom.getUpperBound());
+      os << ']';
+    }
+
+    void writeJsonDomain(std::ostream& os, const Domain& dom) {
+      std::ostringstream ss;
+      if (dom.isNumeric() && dom.minDelta() < 1)
+        ss.setf(std::ios::fixed);
+      ss << dom;
+      writeJsonString(os, ss.str());
+    }
+  }
+
+  PlanDatabaseWriter::Filter::Filter()
+    : objectTypes(), earliest(MINUS_INFINITY), latest(PLUS_INFINITY), merged(true), inactive(true) {}
+
+  PlanDatabaseWriter::Plan::Plan(const PlanDatabaseId db, const Filter& filter, Format format)
+    : m_db(db), m_filter(filter), m_format(format) {}
+
+  std::ostream& operator<<(std::ostream& os, const PlanDatabaseWriter::Plan& plan) {
+    PlanDatabaseWriter::write(plan.m_db, os, plan.m_filter, plan.m_format);
+    return os;
+  }
+
   // bool PlanDatabaseWriter::s_useStandardKeys = true;
 
     std::string PlanDatabaseWriter::toString(const PlanDatabaseId db, bool _useStandardKeys){
@@ -22,45 +80,80 @@ namespace EUROPA {
     }
 
     void PlanDatabaseWriter::write(PlanDatabaseId db, std::ostream& os) {
+      write(db, os, Filter());
+    }
+
+    void PlanDatabaseWriter::write(PlanDatabaseId db, std::ostream& os, const Filter& filter, Format format) {
       check_error(!db->getConstraintEngine()->provenInconsistent());
-      ObjectSet objs = db->getObjects();
-      TokenSet alltokens = db->getTokens();
+      if (format == JSON_LINES)
+        writeJson(db, os, filter);
+      else
+        writeText(db, os, filter);
+    }
+
+    void PlanDatabaseWriter::writeText(PlanDatabaseId db, std::ostream& os, const Filter& filter) {
+      const ObjectSet& objs = db->getObjects();
+      // Tokens written with their objects, or left out with them, rather than by state below
+      TokenSet written;
       os << "Objects *************************" << std::endl;
       indent()++;
       for (ObjectSet::const_iterator oit = objs.begin(); oit != objs.end() ; ++oit) {
 	ObjectId object = *oit;
+	const bool included = passes(object, filter);
+	TimelineId timeline;
+	if (TimelineId::convertable(object))
+	  timeline = object;
+
+	if (!included) {
+	  if (timeline.isId())
+	    written.insert(timeline->getTokenSequence().begin(), timeline->getTokenSequence().end());
+	  else
+	    written.insert(object->tokens().begin(), object->tokens().end());
+	  continue;
+	}
+
 	os << indentation() << object->getType() << ":"
 	   << object->getName() << "*************************" << std::endl;
 
-
-	std::list<TokenId> toks;
-	if (TimelineId::convertable((*oit))) {
-	  TimelineId timeline = (*oit);
-	  toks = timeline->getTokenSequence();
-	}
-	else { // Treat as any object
-	  const TokenSet& tokens = object->tokens();
-	  for(TokenSet::const_iterator tokit = tokens.begin(); tokit != tokens.end(); ++tokit){
-	    TokenId t = *tokit;
-	    toks.push_back(t);
+	bool hasTokens = false;
+	if (timeline.isId()) {
+	  const std::list<TokenId>& toks = timeline->getTokenSequence();
+	  for(std::list<TokenId>::const_iterator tokit = toks.begin(); tokit != toks.end(); ++tokit) {
+	    TokenId t = (*tokit);
+	    written.insert(t);
+	    if (!passes(t, filter))
+	      continue;
+	    if (!hasTokens) {
+	      indent()++;
+	      os << indentation() << "Tokens *************************" << std::endl;
+	      hasTokens = true;
+	    }
+	    writeToken(t, os, filter);
 	  }
 	}
-
-	if(!toks.empty()){
-	  indent()++;
-	  os << indentation() << "Tokens *************************" << std::endl;
-	  for(std::list<TokenId>::const_iterator tokit = toks.begin(); tokit != toks.end(); ++tokit) {
+	else { // Treat as any object
+	  const TokenSet& toks = object->tokens();
+	  for(TokenSet::const_iterator tokit = toks.begin(); tokit != toks.end(); ++tokit) {
 	    TokenId t = (*tokit);
-	    alltokens.erase(t);
-	    writeToken(t, os);
+	    written.insert(t);
+	    if (!passes(t, filter))
+	      continue;
+	    if (!hasTokens) {
+	      indent()++;
+	      os << indentation() << "Tokens *************************" << std::endl;
+	      hasTokens = true;
+	    }
+	    writeToken(t, os, filter);
 	  }
+	}
 
+	if(hasTokens){
 	  os << indentation() << "End Tokens *********************" << std::endl;
 	  indent()--;
 	}
 
 	// print variables associated with this object.
-	const std::vector<ConstrainedVariableId> variables = object->getVariables();
+	const std::vector<ConstrainedVariableId>& variables = object->getVariables();
 	std::vector<ConstrainedVariableId>::const_iterator varit;
 	if(!variables.empty()){
 	  indent()++;
@@ -79,7 +172,7 @@ namespace EUROPA {
       indent()--;
 
       // print global variables
-      const ConstrainedVariableSet globalVariablesSet = db->getGlobalVariables();
+      const ConstrainedVariableSet& globalVariablesSet = db->getGlobalVariables();
       if (! globalVariablesSet.empty()) {
         os << "Global Variables" << "*************************" << std::endl;
         for(ConstrainedVariableSet::const_iterator it = globalVariablesSet.begin(); it != globalVariablesSet.end(); ++it) {
@@ -88,55 +181,120 @@ namespace EUROPA {
 	  writeVariable(var,os);
         }
       }
-      if (alltokens.empty())
+
+      // One pass over the tokens for each state, rather than a copy of them sorted by state
+      const TokenSet& alltokens = db->getTokens();
+      if (alltokens.size() == written.size())
         return;
-      TokenSet activeTokens;
-      TokenSet inactiveTokens;
-      TokenSet incompleteTokens;
-      TokenSet mergedTokens;
-      TokenSet rejectedTokens;
-      TokenSet::const_iterator tokit = alltokens.begin();
-      for ( ; tokit != alltokens.end(); tokit++) {
-        TokenId t = *tokit;
-	checkError(t.isValid(), t);
-	checkError(!t->isTerminated(), t->getKey());
-
-        if (t->isMerged())
-          mergedTokens.insert(t);
-        else if (t->isActive())
-          activeTokens.insert(t);
-        else if (t->isRejected())
-          rejectedTokens.insert(t);
-        else if (t->isInactive())
-          inactiveTokens.insert(t);
-        else if (t->isIncomplete())
-          incompleteTokens.insert(t);
-        else
-          check_error(false, "Token with unknown status");
+      printTokensHelper(os, "Active", alltokens, written, filter);
+      printTokensHelper(os, "Merged", alltokens, written, filter);
+      printTokensHelper(os, "Rejected", alltokens, written, filter);
+      printTokensHelper(os, "Inactive", alltokens, written, filter);
+      printTokensHelper(os, "Incomplete", alltokens, written, filter);
+    }
+
+    void PlanDatabaseWriter::writeJson(PlanDatabaseId db, std::ostream& os, const Filter& filter) {
+      const ObjectSet& objs = db->getObjects();
+      for (ObjectSet::const_iterator oit = objs.begin(); oit != objs.end() ; ++oit) {
+	ObjectId object = *oit;
+	if (!passes(object, filter))
+	  continue;
+	os << "{\"kind\":\"object\",\"type\":";
+	writeJsonString(os, object->getType());
+	os << ",\"name\":";
+	writeJsonString(os, object->getName());
+	os << ",\"variables\":{";
+	const std::vector<ConstrainedVariableId>& variables = object->getVariables();
+	for(std::vector<ConstrainedVariableId>::const_iterator varit = variables.begin(); varit != variables.end(); ++varit) {
+	  if (varit != variables.begin())
+	    os << ',';
+	  writeJsonString(os, (*varit)->getName());
+	  os << ':';
+	  writeJsonDomain(os, (*varit)->lastDomain());
+	}
+	os << "}}" << std::endl;
+      }
+
+      const ConstrainedVariableSet& globalVariablesSet = db->getGlobalVariables();
+      for(ConstrainedVariableSet::const_iterator it = globalVariablesSet.begin(); it != globalVariablesSet.end(); ++it) {
+	os << "{\"kind\":\"global\",\"name\":";
+	writeJsonString(os, (*it)->getName());
+	os << ",\"domain\":";
+	writeJsonDomain(os, (*it)->lastDomain());
+	os << '}' << std::endl;
+      }
+
+      const TokenSet& tokens = db->getTokens();
+      for (TokenSet::const_iterator tokit = tokens.begin(); tokit != tokens.end(); ++tokit) {
+	if (passes(*tokit, filter))
+	  writeTokenJson(*tokit, os, filter);
       }
-      printTokensHelper(os, "Active", activeTokens);
-      printTokensHelper(os, "Merged", mergedTokens);
-      printTokensHelper(os, "Rejected", rejectedTokens);
-      printTokensHelper(os, "Inactive", inactiveTokens);
-      printTokensHelper(os, "Incomplete", incompleteTokens);
-      // Skip printing these for two reasons:
-      // 1. Expensive due to constraints not being propagated to their variable domains.
-      // 2. Their id's are printed when their active token is printed with writeToken().
-      // printTokensHelper(os, "Merged", mergedTokens);
     }
 
     void PlanDatabaseWriter::printTokensHelper(std::ostream& os,
                                   const std::string& name,
-                                  const TokenSet& tokens) {
-      if (tokens.empty())
-        return;
-      os << name << " Tokens: *************************" << std::endl;
+                                  const TokenSet& tokens,
+                                  const TokenSet& written,
+                                  const Filter& filter) {
+      bool first = true;
       TokenSet::const_iterator it = tokens.begin();
       for ( ; it != tokens.end(); ++it){
 	TokenId tok = *it;
 	checkError(tok.isValid(), tok);
-        writeToken(tok, os);
+	checkError(!tok->isTerminated(), tok->getKey());
+	if (name != stateName(tok) || written.find(tok) != written.end() || !passes(tok, filter))
+	  continue;
+	if (first) {
+	  os << name << " Tokens: *************************" << std::endl;
+	  first = false;
+	}
+        writeToken(tok, os, filter);
+      }
+    }
+
+    const char* PlanDatabaseWriter::stateName(const TokenId token) {
+      if (token->isMerged())
+        return "Merged";
+      else if (token->isActive())
+        return "Active";
+      else if (token->isRejected())
+        return "Rejected";
+      else if (token->isInactive())
+        return "Inactive";
+      check_error(token->isIncomplete(), "Token with unknown status");
+      return "Incomplete";
+    }
+
+    bool PlanDatabaseWriter::passes(const ObjectId object, const Filter& filter) {
+      if (filter.objectTypes.empty())
+        return true;
+      const SchemaId schema = object->getPlanDatabase()->getSchema();
+      for (std::set<std::string>::const_iterator it = filter.objectTypes.begin(); it != filter.objectTypes.end(); ++it) {
+        if (schema->isA(object->getType(), *it))
+          return true;
+      }
+      return false;
+    }
+
+    bool PlanDatabaseWriter::passes(const TokenId token, const Filter& filter) {
+      if ((!filter.merged && token->isMerged()) ||
+          (!filter.inactive && !token->isActive() && !token->isMerged()))
+        return false;
+
+      if (token->start()->lastDomain().getLowerBound() > filter.latest ||
+          token->end()->lastDomain().getUpperBound() < filter.earliest)
+        return false;
+
+      if (filter.objectTypes.empty())
+        return true;
+      // The token may be on an object of any subtype of the type it is declared on
+      const SchemaId schema = token->getPlanDatabase()->getSchema();
+      const std::string& type = token->getObject()->baseDomain().getTypeName();
+      for (std::set<std::string>::const_iterator it = filter.objectTypes.begin(); it != filter.objectTypes.end(); ++it) {
+        if (schema->isA(type, *it) || schema->isA(*it, type))
+          return true;
       }
+      return false;
     }
 
   std::string PlanDatabaseWriter::timeDomain(const Domain& dom){
@@ -178,13 +336,13 @@ namespace EUROPA {
     return ss.str();
 
   }
-    void PlanDatabaseWriter::writeToken(const TokenId t, std::ostream& os) {
+    void PlanDatabaseWriter::writeToken(const TokenId t, std::ostream& os, const Filter& filter) {
       indent()++;
       check_error(t.isValid());
       TempVarId st = t->start();
       os << indentation() << "\t" << timeDomain(st->lastDomain()) << std::endl;
       os << indentation() << "\t" << t->getPredicateName() << "(" ;
-      std::vector<ConstrainedVariableId> vars = t->parameters();
+      const std::vector<ConstrainedVariableId>& vars = t->parameters();
       for (std::vector<ConstrainedVariableId>::const_iterator varit = vars.begin(); varit != vars.end(); ++varit) {
 	ConstrainedVariableId v = (*varit);
 	checkError(v.isValid(), v);
@@ -206,9 +364,9 @@ namespace EUROPA {
 	os << "  Master=" << getKey(t->master()) << " " << simpleTokenSummary(t->master()) << std::endl;
 
 
-      TokenSet mergedtoks = t->getMergedTokens();
+      const TokenSet& mergedtoks = t->getMergedTokens();
 
-      for (TokenSet::const_iterator mit = mergedtoks.begin(); mit != mergedtoks.end(); ++mit) {
+      for (TokenSet::const_iterator mit = mergedtoks.begin(); filter.merged && mit != mergedtoks.end(); ++mit) {
 	TokenId mergedToken = *mit;
 	os << indentation() << "\t\tMerged Key=" << getKey(mergedToken);
 	if(mergedToken->master().isId()){
@@ -224,6 +382,48 @@ namespace EUROPA {
       indent()--;
     }
 
+    void PlanDatabaseWriter::writeTokenJson(const TokenId t, std::ostream& os, const Filter& filter) {
+      check_error(t.isValid());
+      os << "{\"kind\":\"token\",\"key\":";
+      writeJsonString(os, getKey(t));
+      os << ",\"predicate\":";
+      writeJsonString(os, t->getPredicateName());
+      os << ",\"state\":\"" << stateName(t) << "\",\"object\":";
+      writeJsonDomain(os, t->getObject()->lastDomain());
+      os << ",\"start\":";
+      writeJsonBounds(os, t->start()->lastDomain());
+      os << ",\"end\":";
+      writeJsonBounds(os, t->end()->lastDomain());
+      os << ",\"master\":";
+      if (t->master().isNoId())
+	os << "null";
+      else
+	writeJsonString(os, getKey(t->master()));
+
+      os << ",\"parameters\":{";
+      const std::vector<ConstrainedVariableId>& vars = t->parameters();
+      for (std::vector<ConstrainedVariableId>::const_iterator varit = vars.begin(); varit != vars.end(); ++varit) {
+	if (varit != vars.begin())
+	  os << ',';
+	writeJsonString(os, (*varit)->getName());
+	os << ':';
+	writeJsonDomain(os, (*varit)->lastDomain());
+      }
+      os << '}';
+
+      if (filter.merged) {
+	os << ",\"merged\":[";
+	const TokenSet& mergedtoks = t->getMergedTokens();
+	for (TokenSet::const_iterator mit = mergedtoks.begin(); mit != mergedtoks.end(); ++mit) {
+	  if (mit != mergedtoks.begin())
+	    os << ',';
+	  writeJsonString(os, getKey(*mit));
+	}
+	os << ']';
+      }
+      os << '}' << std::endl;
+    }
+
     void PlanDatabaseWriter::writeVariable(const ConstrainedVariableId var, std::ostream& os) {
       check_error(var.isValid());
       indent()++;
@@ -239,10 +439,7 @@ namespace EUROPA {
     }
 
     std::string PlanDatabaseWriter::indentation(){
-      std::string s;
-      for(unsigned int i=0; i<indent(); i++)
-	s = s + "\t";
-      return s;
+      return std::string(indent(), '\t');
     }
 
     unsigned int& PlanDatabaseWriter::indent(){
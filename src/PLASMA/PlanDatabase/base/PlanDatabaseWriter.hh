@@ -2,6 +2,7 @@
 #define H_PlanDatabaseWriter
 
 #include "PlanDatabaseDefs.hh"
+#include <set>
 #include <sstream>
 
 namespace EUROPA {
@@ -10,10 +11,48 @@ namespace EUROPA {
 
   public:
 
+    /**
+     * @brief Which parts of the database write() includes. The default includes everything.
+     */
+    struct Filter {
+      Filter();
+      std::set<std::string> objectTypes; /*!< Objects of these types and their subtypes, with the tokens they may hold. Empty for all. */
+      edouble earliest; /*!< Tokens which may overlap [earliest, latest] */
+      edouble latest;
+      bool merged;      /*!< Include merged tokens */
+      bool inactive;    /*!< Include inactive, incomplete and rejected tokens */
+    };
+
+    enum Format {
+      TEXT,      /*!< The layout of toString() */
+      JSON_LINES /*!< A JSON object on a line of its own for each object, token and global variable */
+    };
+
+    /**
+     * @brief Writes a database when inserted into a stream, so that a debug message can include
+     * the plan without building it into a string first:
+     * debugMsg("marker", std::endl << PlanDatabaseWriter::Plan(db));
+     */
+    class Plan {
+    public:
+      Plan(const PlanDatabaseId db, const Filter& filter = Filter(), Format format = TEXT);
+    private:
+      friend std::ostream& operator<<(std::ostream& os, const Plan& plan);
+      const PlanDatabaseId m_db;
+      const Filter m_filter;
+      const Format m_format;
+    };
+
     static std::string toString(const PlanDatabaseId db, bool _useStandardKeys = true);
 
     static void write(PlanDatabaseId db, std::ostream& os);
 
+    /**
+     * @brief Write the parts of the database passing a filter, directly to a stream. Memory used
+     * beyond the stream's own buffer is bounded by the tokens on objects, not the size of the output.
+     */
+    static void write(PlanDatabaseId db, std::ostream& os, const Filter& filter, Format format = TEXT);
+
     // [lb, ub] or {singleton}
     static std::string timeDomain(const Domain& dom);
 
@@ -21,14 +60,29 @@ namespace EUROPA {
 
   private:
 
+    static void writeText(PlanDatabaseId db, std::ostream& os, const Filter& filter);
+
+    static void writeJson(PlanDatabaseId db, std::ostream& os, const Filter& filter);
+
     static void printTokensHelper(std::ostream& os,
                                   const std::string& name,
-                                  const TokenSet& tokens);
+                                  const TokenSet& tokens,
+                                  const TokenSet& written,
+                                  const Filter& filter);
+
+    static void writeToken(const TokenId t, std::ostream& os, const Filter& filter);
 
-    static void writeToken(const TokenId t, std::ostream& os);
+    static void writeTokenJson(const TokenId t, std::ostream& os, const Filter& filter);
 
     static void writeVariable(const ConstrainedVariableId var, std::ostream& os);
 
+    // Active, Merged, Rejected, Inactive or Incomplete
+    static const char* stateName(const TokenId token);
+
+    static bool passes(const ObjectId object, const Filter& filter);
+
+    static bool passes(const TokenId token, const Filter& filter);
+
     static std::string getKey(const TokenId token);
 
     static std::string indentation();
@@ -39,6 +93,8 @@ namespace EUROPA {
 
   };
 
+  std::ostream& operator<<(std::ostream& os, const PlanDatabaseWriter::Plan& plan);
+
 }
 
 #endif /* #ifndef H_PlanDatabaseWriter */
@@ -60,6 +60,8 @@ Schema::Schema(const std::string& name, const CESchemaId ces)
     , predicates(), primitives(), membershipRelation(), childOfRelation()
     , objectPredicates(), typesWithNoPredicates(), allObjectTypes()
     , m_predTrueCache(), m_predFalseCache(), m_hasParentCache()
+    , m_typesCompiled(false), m_objectTypeIds(), m_objectTypeNames(), m_parentIds()
+    , m_lastDescendantIds(), m_hasPredicatesById()
   {
       reset();
       debugMsg("Schema:constructor", "created Schema:" << name);
@@ -97,7 +99,10 @@ Schema::Schema(const std::string& name, const CESchemaId ces)
     membershipRelation.clear();
     childOfRelation.clear();
     objectPredicates.clear();
-    typesWithNoPredicates.clear();
+    allObjectTypes.clear();
+    m_predTrueCache.clear();
+    m_hasParentCache.clear();
+    invalidateTypeHierarchy();
 
     // Add System entities
 	addPrimitive("int");
@@ -191,8 +196,19 @@ bool Schema::isPredicate(const std::string& predicateName) const {
     checkError(isType(ancestor),
 	       "Ancestor of '" << descendant << "' is '" << ancestor << "' which is not defined.");
 
-    if(hasParent(descendant))
-      return isA(getParent(descendant), ancestor);
+    // Object types are answered from the compiled hierarchy, and so are predicates, since a
+    // predicate's parent is the predicate of the same name on the parent type.
+    unsigned int descendantId, ancestorId;
+    if(findObjectTypeId(descendant, descendantId))
+      return findObjectTypeId(ancestor, ancestorId) && isA(descendantId, ancestorId);
+
+    std::string::size_type descendantPos = descendant.find(getDelimiter());
+    std::string::size_type ancestorPos = ancestor.find(getDelimiter());
+    if(descendantPos != std::string::npos && ancestorPos != std::string::npos &&
+       findObjectTypeId(descendant.substr(0, descendantPos), descendantId) &&
+       findObjectTypeId(ancestor.substr(0, ancestorPos), ancestorId))
+      return descendant.compare(descendantPos, std::string::npos, ancestor, ancestorPos, std::string::npos) == 0 &&
+        isA(descendantId, ancestorId);
 
     /** Temporary hack to allow primitives to be casted **/
     if(isPrimitive(descendant) && isPrimitive(ancestor))
@@ -201,6 +217,91 @@ bool Schema::isPredicate(const std::string& predicateName) const {
     return false;
   }
 
+  bool Schema::isA(unsigned int descendantId, unsigned int ancestorId) const {
+    if(!m_typesCompiled)
+      compileTypeHierarchy();
+    checkError(descendantId < m_objectTypeNames.size() && ancestorId < m_objectTypeNames.size(),
+               "Invalid object type id " << descendantId << " or " << ancestorId);
+    return ancestorId <= descendantId && descendantId <= m_lastDescendantIds[ancestorId];
+  }
+
+  unsigned int Schema::getObjectTypeId(const std::string& objectType) const {
+    unsigned int id = 0;
+    if(!findObjectTypeId(objectType, id))
+      checkError(ALWAYS_FAILS, objectType << " is not defined as an ObjectType");
+    return id;
+  }
+
+  const std::string& Schema::getObjectTypeName(unsigned int objectTypeId) const {
+    if(!m_typesCompiled)
+      compileTypeHierarchy();
+    checkError(objectTypeId < m_objectTypeNames.size(), "Invalid object type id " << objectTypeId);
+    return m_objectTypeNames[objectTypeId];
+  }
+
+  bool Schema::findObjectTypeId(const std::string& objectType, unsigned int& id) const {
+    if(!m_typesCompiled)
+      compileTypeHierarchy();
+    boost::unordered_map<std::string, unsigned int>::const_iterator it = m_objectTypeIds.find(objectType);
+    if(it == m_objectTypeIds.end())
+      return false;
+    id = it->second;
+    return true;
+  }
+
+  void Schema::compileTypeHierarchy() const {
+    m_objectTypeIds.clear();
+    m_objectTypeNames.clear();
+    m_parentIds.clear();
+    m_lastDescendantIds.clear();
+
+    std::map<std::string, std::vector<std::string> > children;
+    for(std::map<std::string, std::string>::const_iterator it = childOfRelation.begin(); it != childOfRelation.end(); ++it)
+      children[it->second].push_back(it->first);
+
+    // Roots are the types without a parent, i.e. the root object and types only declared so far.
+    // A root is passed the id it is about to get as its parent.
+    for(std::set<std::string>::const_iterator it = objectTypes.begin(); it != objectTypes.end(); ++it)
+      if(childOfRelation.find(*it) == childOfRelation.end())
+        numberObjectType(*it, static_cast<unsigned int>(m_objectTypeNames.size()), children);
+
+    checkError(m_objectTypeNames.size() == objectTypes.size(),
+               "Numbered " << m_objectTypeNames.size() << " of " << objectTypes.size() << " object types");
+
+    // Parents are numbered before their children, so one pass propagates predicates down
+    m_hasPredicatesById.assign(m_objectTypeNames.size(), false);
+    for(std::set<std::string>::const_iterator it = predicates.begin(); it != predicates.end(); ++it)
+      m_hasPredicatesById[m_objectTypeIds.find(it->substr(0, it->find(getDelimiter())))->second] = true;
+    for(unsigned int id = 0; id < m_objectTypeNames.size(); id++)
+      if(m_hasPredicatesById[m_parentIds[id]])
+        m_hasPredicatesById[id] = true;
+
+    m_typesCompiled = true;
+    debugMsg("Schema:compileTypeHierarchy", "[" << m_name << "] " << "Compiled " << m_objectTypeNames.size() << " object types");
+  }
+
+  void Schema::numberObjectType(const std::string& objectType, unsigned int parentId,
+                                const std::map<std::string, std::vector<std::string> >& children) const {
+    unsigned int id = static_cast<unsigned int>(m_objectTypeNames.size());
+    m_objectTypeIds.insert(std::make_pair(objectType, id));
+    m_objectTypeNames.push_back(objectType);
+    m_parentIds.push_back(parentId);
+    m_lastDescendantIds.push_back(id);
+
+    std::map<std::string, std::vector<std::string> >::const_iterator it = children.find(objectType);
+    if(it != children.end())
+      for(std::vector<std::string>::const_iterator child = it->second.begin(); child != it->second.end(); ++child)
+        numberObjectType(*child, id, children);
+
+    m_lastDescendantIds[id] = static_cast<unsigned int>(m_objectTypeNames.size() - 1);
+  }
+
+  void Schema::invalidateTypeHierarchy() {
+    m_typesCompiled = false;
+    m_predFalseCache.clear();
+    typesWithNoPredicates.clear();
+  }
+
 bool Schema::canContain(const std::string& parentType,
                         const std::string& memberType,
                         const std::string& memberName) const {
@@ -316,6 +417,10 @@ const std::vector<std::string>& Schema::getAllObjectTypes(const std::string& obj
     if(m_hasParentCache.find(type) != m_hasParentCache.end())
       return true;
 
+    unsigned int id;
+    if(findObjectTypeId(type, id))
+      return m_parentIds[id] != id;
+
     bool result = false;
 
     if(isPrimitive(type) || isEnum(type)) // If it is a primitive, it has no parent
@@ -338,9 +443,10 @@ const std::vector<std::string>& Schema::getAllObjectTypes(const std::string& obj
   const std::string Schema::getParent(const std::string& type) const {
     check_error(hasParent(type), type + " does not have a parent.");
 
-    // If it is an objectType. return child relation
-    if(isObjectType(type))
-      return childOfRelation.find(type)->second;
+    // If it is an objectType. return its parent from the compiled hierarchy
+    unsigned int id;
+    if(findObjectTypeId(type, id))
+      return m_objectTypeNames[m_parentIds[id]];
 
     // Otherwise it must be a predicate, so build the new fully qualified name
     std::string predStr;
@@ -380,6 +486,10 @@ const std::set<std::string>& Schema::getAllObjectTypes() const {
   bool Schema::hasPredicates(const std::string& objectType) {
     check_error(isType(objectType), objectType + " is undefined");
 
+    unsigned int id;
+    if(findObjectTypeId(objectType, id))
+      return m_hasPredicatesById[id];
+
     // Try for a quick hit
     if(typesWithNoPredicates.find(objectType) != typesWithNoPredicates.end())
       return false;
@@ -542,6 +652,7 @@ int Schema::getIndexFromName(const std::string& parentType, const std::string& m
       if (!this->isObjectType(objectType)) {
           debugMsg("Schema:declareObjectType", "[" << m_name << "] " << "Declaring object type " << objectType);
           objectTypes.insert(objectType);
+          invalidateTypeHierarchy();
           getCESchema()->registerDataType((new ObjectDT(objectType.c_str()))->getId());
       }
       else {
@@ -566,6 +677,7 @@ int Schema::getIndexFromName(const std::string& parentType, const std::string& m
     }
 
     objectTypes.insert(objectType);
+    invalidateTypeHierarchy();
     membershipRelation.insert(std::pair<std::string, NameValueVector>(objectType, NameValueVector()));
 
     // Add type for constrained variables to be able to hold references to objects of the new type
@@ -590,6 +702,7 @@ void Schema::addPredicate(const std::string& predicate) {
   debugMsg("Schema:addPredicate",
            "[" << m_name << "] " << "Added predicate " << predicate);
   predicates.insert(predicate);
+  invalidateTypeHierarchy();
   membershipRelation.insert(std::pair<std::string, NameValueVector>(predicate, NameValueVector()));
 }
 
@@ -675,15 +788,15 @@ bool Schema::makeParentPredicateString(const std::string& predicate, std::string
   check_error(std::count(predicate.begin(), predicate.end(), getDelimiter()) == 1,
               "Invalid format for predicate " + predicate);
 
-  std::string prefix = predicate.substr(0, predicate.find(getDelimiter()));
+  std::string::size_type pos = predicate.find(getDelimiter());
 
   // If not a defined class, or has no parent class, do no more and return false
-  if(!isObjectType(prefix) || !hasParent(prefix))
+  unsigned int id;
+  if(!findObjectTypeId(predicate.substr(0, pos), id) || m_parentIds[id] == id)
     return false;
 
   // Otherwise we are ready to compose with the parent
-  std::string suffix = predicate.substr(predicate.find(getDelimiter()) + 1);
-  predStr = getParent(prefix) + getDelimiter() + suffix;
+  predStr = m_objectTypeNames[m_parentIds[id]] + predicate.substr(pos);
   return true;
 }
 
@@ -16,6 +16,7 @@
 #include "Method.hh"
 
 #include <vector>
+#include <boost/unordered_map.hpp>
 
 namespace EUROPA {
 class LabelStr;
@@ -163,6 +164,25 @@ class LabelStr;
      */
     bool isA(const std::string& descendant, const std::string& ancestor) const;
 
+    /**
+     * @brief Determine if one object type is a sub type of another, given their ids.
+     * @see getObjectTypeId
+     */
+    bool isA(unsigned int descendantId, unsigned int ancestorId) const;
+
+    /**
+     * @brief Obtains the id of an object type. Ids are dense, starting at 0, and remain valid until
+     * the next change to the schema.
+     * @param objectType Must be a defined objectType.
+     */
+    unsigned int getObjectTypeId(const std::string& objectType) const;
+
+    /**
+     * @brief Obtains the name of the object type with the given id.
+     * @see getObjectTypeId
+     */
+    const std::string& getObjectTypeName(unsigned int objectTypeId) const;
+
     /**
      * @brief Tests if the given type has a parent.
      * @param objectType The objectType to test. Must be a valid type.
@@ -394,9 +414,33 @@ class LabelStr;
     mutable std::set<std::string> m_predTrueCache, m_predFalseCache; /**< Caches from isPredicate, now useful and not static . */
     mutable std::set<std::string> m_hasParentCache; /**< Cache from hasParent, now useful and not static */
 
+    /*! The class hierarchy compiled for constant time queries. Object types are numbered in a depth
+     * first walk, so the descendants of a type are exactly those with ids in
+     * [id, m_lastDescendantIds[id]]. */
+    mutable bool m_typesCompiled; /*! True if the members below are up to date */
+    mutable boost::unordered_map<std::string, unsigned int> m_objectTypeIds;
+    mutable std::vector<std::string> m_objectTypeNames; /*! By id */
+    mutable std::vector<unsigned int> m_parentIds; /*! By id. A type without a parent is its own */
+    mutable std::vector<unsigned int> m_lastDescendantIds; /*! By id */
+    mutable std::vector<bool> m_hasPredicatesById; /*! By id. True if the type or an ancestor declares a predicate */
+
     Schema(const Schema&); /**< NO IMPL */
     static const std::set<std::string>& getBuiltInVariableNames();
 
+    /**
+     * @brief Looks up the id of an object type, compiling the class hierarchy first if it has changed.
+     * @return false if the given name is not an object type.
+     */
+    bool findObjectTypeId(const std::string& objectType, unsigned int& id) const;
+    void compileTypeHierarchy() const;
+    void numberObjectType(const std::string& objectType, unsigned int parentId,
+                          const std::map<std::string, std::vector<std::string> >& children) const;
+
+    /**
+     * @brief Discards the compiled class hierarchy and any cached answers a change to the schema may falsify.
+     */
+    void invalidateTypeHierarchy();
+
   };
 
 }
@@ -21,11 +21,22 @@ namespace EUROPA{
      * @param first Candidate to be predecessor
      * @param second Candidate to be successor
      * @return true if temporal distance first.end to second.start can be >= 0
+     * @note Must be false whenever the earliest end of first is after the latest start of second.
+     * Timelines rely on this to rule out positions by the bounds of their tokens alone.
      */
     virtual bool canPrecede(const TokenId first, const TokenId second) = 0;
 
     virtual bool canPrecede(const TimeVarId first, const TimeVarId second) = 0;
 
+    /**
+     * @brief Hint that many canPrecede and canFitBetween queries relating token to
+     * other tokens follow, as when enumerating the places token can take on a timeline.
+     * Implementations may precompute distances from token's end and to token's start
+     * so that each of those queries is answered without a search.
+     * @param token The token the queries will be about
+     */
+    virtual void cacheOrderingDistances(const TokenId token) = 0;
+
     /**
      * @brief test if the given token can fit between the predecessor and successor.
      * @param token The token to be tested if it can fit in the middle
@@ -37,6 +48,17 @@ namespace EUROPA{
     virtual bool canFitBetween(const TokenId token, const TokenId predecessor,
 			       const TokenId successor) = 0;
 
+    /**
+     * @brief test if the given token can fit in each of several gaps, as when enumerating the
+     * places token can take on a timeline.
+     * @param token The token to be tested if it can fit in the middle
+     * @param gaps Pairs of predecessor and successor, each as for canFitBetween
+     * @param results Output parameter, initially empty. Holds the canFitBetween test of each gap, in order.
+     */
+    virtual void canFitBetweenEach(const TokenId token,
+                                   const std::vector<std::pair<TokenId, TokenId> >& gaps,
+                                   std::vector<bool>& results) = 0;
+
     /**
      * @brief test of the given tokens can have a zero temporal distance between their respective timepoints. Particularly
      * useful as a look-ahead when evaluating merge candidates.
@@ -22,6 +22,8 @@
 
 namespace EUROPA{
 
+  DEFINE_POOLED_ALLOCATION(Token)
+
   StateDomain::StateDomain()
     : EnumeratedDomain(SymbolDT::instance())
   {
@@ -1013,12 +1015,7 @@ bool Token::canBeTerminated(eint) const{
 
 
 std::string Token::makePseudoVarName(){
-  static int sl_varKey(0);
-  static std::string sl_prefix("PSEUDO_VARIABLE_");
-  std::stringstream ss;
-  ss << sl_prefix;
-  ss << sl_varKey++;
-  return ss.str();
+  return m_planDatabase->makeAutoName("PSEUDO_VARIABLE_");
 }
 
 // PS Methods:
@@ -9,6 +9,7 @@
 #include "UnifyMemento.hh"
 #include "Schema.hh"
 #include "Entity.hh"
+#include "MemoryPool.hh"
 #include "LabelStr.hh"
 #include "Domains.hh"
 #include "PlanDatabase.hh"
@@ -31,6 +32,7 @@ namespace EUROPA {
   class Token: public virtual PSToken, public Entity {
   public:
     DECLARE_ENTITY_TYPE(Token);
+    DECLARE_POOLED_ALLOCATION
 
     /**
      * Begin Declaration of allowable states for a Token.
@@ -371,9 +373,10 @@ namespace EUROPA {
 
     /**
      * @brief Utility for allocating pseudo variable names such that there are no duplicates. Duplicates can be dangerous
-     * since associative maps look up variables by name and can lead to mix-ups.
+     * since associative maps look up variables by name and can lead to mix-ups. Names are unique within
+     * the plan database of the token.
      */
-    static std::string makePseudoVarName();
+    std::string makePseudoVarName();
 
     /**
      * @brief Add a parameter as a member to the object. This is used when building the instance
@@ -0,0 +1,243 @@
+#include "BinaryTransactionLog.hh"
+#include "tinyxml.h"
+#include "Error.hh"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#ifndef _MSC_VER
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace EUROPA {
+
+  namespace {
+    const char HEADER[] = "EUTXLOG";
+    const unsigned long VERSION = 2;
+    const char STRING_RECORD = 'S';
+    const char TRANSACTION_RECORD = 'T';
+  }
+
+  BinaryTransactionWriter::BinaryTransactionWriter(std::ostream& os)
+    : m_os(os), m_strings(), m_payload() {
+    check_runtime_error(m_os.good(), "Invalid output stream for binary transactions.");
+    m_os.write(HEADER, sizeof(HEADER));
+    std::string version;
+    encodeNumber(VERSION, version);
+    m_os.write(version.data(), version.size());
+  }
+
+  void BinaryTransactionWriter::write(const TiXmlElement& tx) {
+    // Strings first seen in the transaction are written ahead of it as encode finds them
+    m_payload.clear();
+    encode(tx, m_payload);
+    writeRecord(TRANSACTION_RECORD, m_payload);
+  }
+
+  void BinaryTransactionWriter::flush() {
+    m_os.flush();
+  }
+
+  void BinaryTransactionWriter::encode(const TiXmlElement& element, std::string& payload) {
+    encodeString(element.Value(), payload);
+
+    unsigned long count = 0;
+    for (const TiXmlAttribute* attr = element.FirstAttribute(); attr != NULL; attr = attr->Next())
+      count++;
+    encodeNumber(count, payload);
+    for (const TiXmlAttribute* attr = element.FirstAttribute(); attr != NULL; attr = attr->Next()) {
+      encodeString(attr->Name(), payload);
+      encodeValue(attr->Name(), attr->Value(), payload);
+    }
+
+    count = 0;
+    for (const TiXmlElement* child = element.FirstChildElement(); child != NULL; child = child->NextSiblingElement())
+      count++;
+    encodeNumber(count, payload);
+    for (const TiXmlElement* child = element.FirstChildElement(); child != NULL; child = child->NextSiblingElement())
+      encode(*child, payload);
+  }
+
+  unsigned long BinaryTransactionWriter::intern(const char* str) {
+    std::pair<boost::unordered_map<std::string, unsigned long>::iterator, bool> result =
+      m_strings.insert(std::make_pair(std::string(str), m_strings.size()));
+    if (result.second) {
+      // Stored with its terminator so that readers can use it in place
+      writeRecord(STRING_RECORD, std::string(str, strlen(str) + 1));
+    }
+    return result.first->second;
+  }
+
+  void BinaryTransactionWriter::encodeString(const char* str, std::string& payload) {
+    encodeNumber(intern(str), payload);
+  }
+
+  void BinaryTransactionWriter::encodeValue(const char* attribute, const char* value, std::string& payload) {
+    if (isName(attribute)) {
+      encodeNumber(2 * intern(value), payload);
+      return;
+    }
+    const size_t length = strlen(value);
+    encodeNumber(2 * length + 1, payload);
+    payload.append(value, length + 1);
+  }
+
+  bool BinaryTransactionWriter::isName(const char* attribute) {
+    static const char* const sl_names[] = {"name", "type", "identifier", "object", "relation", "component"};
+    for (unsigned int i = 0; i < sizeof(sl_names) / sizeof(sl_names[0]); i++)
+      if (strcmp(attribute, sl_names[i]) == 0)
+        return true;
+    return false;
+  }
+
+  void BinaryTransactionWriter::encodeNumber(unsigned long number, std::string& payload) {
+    while (number >= 0x80) {
+      payload.push_back(static_cast<char>((number & 0x7f) | 0x80));
+      number >>= 7;
+    }
+    payload.push_back(static_cast<char>(number));
+  }
+
+  void BinaryTransactionWriter::writeRecord(char kind, const std::string& payload) {
+    std::string length;
+    encodeNumber(payload.size(), length);
+    m_os.put(kind);
+    m_os.write(length.data(), length.size());
+    m_os.write(payload.data(), payload.size());
+  }
+
+  void BinaryTransactionWriter::fromXml(std::istream& xml, std::ostream& binary) {
+    check_runtime_error(xml.good(), "Invalid input stream of xml transactions.");
+    BinaryTransactionWriter writer(binary);
+    while (!xml.eof()) {
+      if (xml.peek() != '<') {
+        xml.get(); // discard characters up to '<'
+        continue;
+      }
+      TiXmlElement tx("");
+      xml >> tx;
+      writer.write(tx);
+    }
+    writer.flush();
+  }
+
+  BinaryTransactionReader::BinaryTransactionReader(const std::string& fileName)
+    : m_data(NULL), m_size(0), m_pos(NULL), m_buffer(), m_strings() {
+#ifndef _MSC_VER
+    int fd = open(fileName.c_str(), O_RDONLY);
+    check_runtime_error(fd >= 0, "Failed to open binary transactions in " + fileName);
+    struct stat status;
+    bool statted = (fstat(fd, &status) == 0);
+    m_size = statted ? static_cast<size_t>(status.st_size) : 0;
+    if (m_size > 0) {
+      void* mapping = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      m_data = (mapping == MAP_FAILED ? NULL : static_cast<const char*>(mapping));
+    }
+    close(fd);
+    check_runtime_error(m_data != NULL, "Failed to map binary transactions in " + fileName);
+#else
+    std::ifstream is(fileName.c_str(), std::ios::in | std::ios::binary);
+    check_runtime_error(is.good(), "Failed to open binary transactions in " + fileName);
+    m_buffer.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+    m_size = m_buffer.size();
+    m_data = (m_buffer.empty() ? NULL : &m_buffer[0]);
+#endif
+
+    const char* end = m_data + m_size;
+    check_runtime_error(m_size > sizeof(HEADER) && memcmp(m_data, HEADER, sizeof(HEADER)) == 0,
+                        fileName + " does not hold binary transactions.");
+    m_pos = m_data + sizeof(HEADER);
+    unsigned long version = decodeNumber(m_pos, end);
+    check_runtime_error(version == VERSION, fileName + " holds binary transactions of an unknown version.");
+  }
+
+  BinaryTransactionReader::~BinaryTransactionReader() {
+#ifndef _MSC_VER
+    if (m_data != NULL)
+      munmap(const_cast<char*>(m_data), m_size);
+#endif
+  }
+
+  bool BinaryTransactionReader::next(TiXmlElement& tx) {
+    const char* end = m_data + m_size;
+    while (m_pos < end) {
+      char kind = *(m_pos++);
+      unsigned long length = decodeNumber(m_pos, end);
+      check_runtime_error(length <= static_cast<unsigned long>(end - m_pos), "Truncated binary transaction record.");
+      const char* payload = m_pos;
+      m_pos += length;
+
+      if (kind == STRING_RECORD) {
+        check_runtime_error(length > 0 && payload[length - 1] == '\0', "Malformed string in binary transactions.");
+        m_strings.push_back(payload);
+      }
+      else if (kind == TRANSACTION_RECORD) {
+        decode(tx, payload, m_pos);
+        return true;
+      }
+      // Records of other kinds are skipped
+    }
+    return false;
+  }
+
+  void BinaryTransactionReader::toXml(std::ostream& xml) {
+    for (;;) {
+      TiXmlElement tx("");
+      if (!next(tx))
+        return;
+      xml << tx << std::endl;
+    }
+  }
+
+  unsigned long BinaryTransactionReader::decodeNumber(const char*& pos, const char* end) const {
+    unsigned long number = 0;
+    for (unsigned int shift = 0; ; shift += 7) {
+      check_runtime_error(pos < end && shift < 8 * sizeof(unsigned long), "Truncated binary transaction record.");
+      unsigned char byte = static_cast<unsigned char>(*(pos++));
+      number |= static_cast<unsigned long>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0)
+        return number;
+    }
+  }
+
+  const char* BinaryTransactionReader::decodeString(const char*& pos, const char* end) const {
+    unsigned long index = decodeNumber(pos, end);
+    check_runtime_error(index < m_strings.size(), "Binary transaction refers to an undefined string.");
+    return m_strings[index];
+  }
+
+  const char* BinaryTransactionReader::decodeValue(const char*& pos, const char* end) const {
+    unsigned long number = decodeNumber(pos, end);
+    if ((number & 1) == 0) {
+      check_runtime_error(number / 2 < m_strings.size(), "Binary transaction refers to an undefined string.");
+      return m_strings[number / 2];
+    }
+    unsigned long length = number / 2;
+    check_runtime_error(length < static_cast<unsigned long>(end - pos) && pos[length] == '\0',
+                        "Malformed string in binary transactions.");
+    const char* value = pos;
+    pos += length + 1;
+    return value;
+  }
+
+  void BinaryTransactionReader::decode(TiXmlElement& element, const char*& pos, const char* end) const {
+    element.SetValue(decodeString(pos, end));
+
+    unsigned long count = decodeNumber(pos, end);
+    for (unsigned long i = 0; i < count; i++) {
+      const char* name = decodeString(pos, end);
+      element.SetAttribute(name, decodeValue(pos, end));
+    }
+
+    count = decodeNumber(pos, end);
+    for (unsigned long i = 0; i < count; i++) {
+      TiXmlElement* child = new TiXmlElement("");
+      decode(*child, pos, end);
+      element.LinkEndChild(child);
+    }
+  }
+}
@@ -0,0 +1,103 @@
+#ifndef H_BinaryTransactionLog
+#define H_BinaryTransactionLog
+
+#include <boost/unordered_map.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * @file BinaryTransactionLog.hh
+ * @brief Compact binary encoding of the transactions logged by DbClientTransactionLog.
+ *
+ * A log is a header followed by records, each a kind byte, a length and that many bytes of payload.
+ * Element names, attribute names and the names of types, predicates, variables and objects are
+ * written once, in a string record, and referred to afterwards by their position among the string
+ * records. Other attribute values, such as numbers, domains and token paths, are mostly distinct,
+ * so they are written inline, lest the table grow with every transaction. A transaction record
+ * holds one element: its name, its attributes and its child elements. An attribute value is a
+ * number twice the position of an interned string, or twice the length plus one of an inline
+ * string, which follows with its terminator. Numbers are unsigned base 128 varints.
+ *
+ * Only elements and attributes are carried. Text and comments are dropped, as the player reads neither.
+ */
+
+namespace EUROPA {
+
+  class TiXmlElement;
+
+  /**
+   * @class BinaryTransactionWriter
+   * @brief Writes transactions to a stream as they are given, holding only the table of names written so far.
+   */
+  class BinaryTransactionWriter {
+  public:
+    /**
+     * @param os Stream to write to. Should be opened in binary mode.
+     */
+    BinaryTransactionWriter(std::ostream& os);
+
+    void write(const TiXmlElement& tx);
+
+    void flush();
+
+    /**
+     * @brief Convert a stream of xml transactions, as written by DbClientTransactionLog::flush, to the binary format.
+     */
+    static void fromXml(std::istream& xml, std::ostream& binary);
+
+  private:
+    void encode(const TiXmlElement& element, std::string& payload);
+    unsigned long intern(const char* str);
+    void encodeString(const char* str, std::string& payload);
+    void encodeValue(const char* attribute, const char* value, std::string& payload);
+    static bool isName(const char* attribute);
+    static void encodeNumber(unsigned long number, std::string& payload);
+    void writeRecord(char kind, const std::string& payload);
+
+    std::ostream& m_os;
+    boost::unordered_map<std::string, unsigned long> m_strings;
+    std::string m_payload; /*!< Reused between transactions */
+  };
+
+  /**
+   * @class BinaryTransactionReader
+   * @brief Reads transactions from a file mapped into memory.
+   *
+   * Strings are used in place in the mapping rather than copied into a table of their own.
+   */
+  class BinaryTransactionReader {
+  public:
+    BinaryTransactionReader(const std::string& fileName);
+    ~BinaryTransactionReader();
+
+    /**
+     * @brief Read the next transaction.
+     * @param tx An element with no attributes or children, to be given the contents of the transaction.
+     * @return false if there are no more transactions, in which case tx is unchanged.
+     */
+    bool next(TiXmlElement& tx);
+
+    /**
+     * @brief Write the remaining transactions as xml, in the form DbClientTransactionLog::flush writes.
+     */
+    void toXml(std::ostream& xml);
+
+  private:
+    BinaryTransactionReader(const BinaryTransactionReader&);
+    BinaryTransactionReader& operator=(const BinaryTransactionReader&);
+
+    unsigned long decodeNumber(const char*& pos, const char* end) const;
+    const char* decodeString(const char*& pos, const char* end) const;
+    const char* decodeValue(const char*& pos, const char* end) const;
+    void decode(TiXmlElement& element, const char*& pos, const char* end) const;
+
+    const char* m_data;
+    size_t m_size;
+    const char* m_pos;
+    std::vector<char> m_buffer; /*!< Holds the file where it cannot be mapped */
+    std::vector<const char*> m_strings;
+  };
+}
+
+#endif
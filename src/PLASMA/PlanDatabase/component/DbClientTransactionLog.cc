@@ -3,21 +3,79 @@
 #include "Domains.hh"
 #include "tinyxml.h"
 #include "Object.hh"
+#include "PlanDatabase.hh"
+#include "ConstraintEngine.hh"
 #include "UnifyMemento.hh"
 #include "Token.hh"
 #include "DbClientTransactionLog.hh"
+#include "BinaryTransactionLog.hh"
+#include "ConstraintEngineListener.hh"
 
 namespace EUROPA {
+
+  /**
+   * @brief Records the variables whose domains change between checkpoints, so that a checkpoint
+   * writes only those.
+   */
+  class DbClientTransactionLog::ChangeListener : public ConstraintEngineListener {
+  public:
+    ChangeListener(const ConstraintEngineId ce, ConstrainedVariableSet& changed)
+      : ConstraintEngineListener(ce), m_changed(changed) {}
+
+    using ConstraintEngineListener::notifyAdded;
+    using ConstraintEngineListener::notifyRemoved;
+    using ConstraintEngineListener::notifyActivated;
+    using ConstraintEngineListener::notifyDeactivated;
+
+    void notifyAdded(const ConstrainedVariableId variable) {m_changed.insert(variable);}
+    void notifyRemoved(const ConstrainedVariableId variable) {m_changed.erase(variable);}
+    void notifyActivated(const ConstrainedVariableId variable) {m_changed.insert(variable);}
+    void notifyDeactivated(const ConstrainedVariableId variable) {m_changed.insert(variable);}
+    void notifyChanged(const ConstrainedVariableId variable, const DomainListener::ChangeType&) {
+      m_changed.insert(variable);
+    }
+
+  private:
+    ConstrainedVariableSet& m_changed;
+  };
+
   DbClientTransactionLog::DbClientTransactionLog(const DbClientId client, bool chronologicalBacktracking)
     : DbClientListener(client)
     , m_bufferedTransactions()
+    , m_binaryWriter(NULL)
     , m_chronologicalBacktracking(chronologicalBacktracking)
+    , m_checkpointed(0)
+    , m_retracted(0)
+    , m_changeListener(NULL)
+    , m_changedVariables()
+    , m_checkpointAll(true)
+    , m_tokensCreated(0)
+    , m_client(client)
+  {
+    m_changeListener = new ChangeListener(client->getPlanDatabase()->getConstraintEngine(), m_changedVariables);
+  }
+
+  DbClientTransactionLog::DbClientTransactionLog(const DbClientId client, std::ostream& binaryOut)
+    : DbClientListener(client)
+    , m_bufferedTransactions()
+    , m_binaryWriter(new BinaryTransactionWriter(binaryOut))
+    , m_chronologicalBacktracking(false)
+    , m_checkpointed(0)
+    , m_retracted(0)
+    , m_changeListener(NULL)
+    , m_changedVariables()
+    , m_checkpointAll(true)
     , m_tokensCreated(0)
     , m_client(client)
   {}
 
   DbClientTransactionLog::~DbClientTransactionLog(){
     cleanup(m_bufferedTransactions);
+    delete m_changeListener;
+    if (m_binaryWriter != NULL) {
+      m_binaryWriter->flush();
+      delete m_binaryWriter;
+    }
   }
 
   const std::list<TiXmlElement*>& DbClientTransactionLog::getBufferedTransactions() const {return m_bufferedTransactions;}
@@ -38,6 +96,7 @@ namespace EUROPA {
   }
 
   void DbClientTransactionLog::removeBreakpoint() {
+    checkError(m_binaryWriter == NULL, "Cannot remove a breakpoint from a streamed log.");
     check_error(!m_bufferedTransactions.empty());
     checkError(m_bufferedTransactions.back()->Value() == std::string("breakpoint"),
                "Last transaction is a " << m_bufferedTransactions.back()->Value() <<
@@ -62,7 +121,7 @@ void DbClientTransactionLog::notifyVariableCreated(const ConstrainedVariableId v
     element->SetAttribute("index", static_cast<int>(m_client->getIndexByVariable(variable)));
       
     if (!baseDomain.isEmpty()) {
-      TiXmlElement * value = abstractDomainAsXml(&baseDomain);
+      TiXmlElement * value = abstractDomainAsXml(m_client, &baseDomain);
       element->LinkEndChild(value);
     }
     pushTransaction(element);
@@ -91,7 +150,7 @@ void DbClientTransactionLog::notifyObjectCreated(const ObjectId object,
   element->SetAttribute("type", object->getType());
   std::vector<const Domain*>::const_iterator iter;
   for (iter = arguments.begin() ; iter != arguments.end() ; iter++) {
-    element->LinkEndChild(abstractDomainAsXml(*iter));
+    element->LinkEndChild(abstractDomainAsXml(m_client, *iter));
   }
   pushTransaction(element);
 }
@@ -137,13 +196,7 @@ void DbClientTransactionLog::notifyObjectCreated(const ObjectId object,
   }
 
   void DbClientTransactionLog::notifyConstrained(const ObjectId object, const TokenId predecessor, const TokenId successor){
-    TiXmlElement * element = allocateXmlElement("constrain");
-    TiXmlElement * object_el = allocateXmlElement("object");
-    object_el->SetAttribute("name", object->getName());
-    element->LinkEndChild(object_el);
-    element->LinkEndChild(tokenAsXml(predecessor));
-    element->LinkEndChild(tokenAsXml(successor));
-    pushTransaction(element);
+    pushTransaction(constrainAsXml(m_client, object, predecessor, successor));
   }
 
 
@@ -158,34 +211,27 @@ void DbClientTransactionLog::notifyObjectCreated(const ObjectId object,
     TiXmlElement * object_el = allocateXmlElement("object");
     object_el->SetAttribute("name", object->getName());
     element->LinkEndChild(object_el);
-    element->LinkEndChild(tokenAsXml(predecessor));
-    element->LinkEndChild(tokenAsXml(successor));
+    element->LinkEndChild(tokenAsXml(m_client, predecessor));
+    element->LinkEndChild(tokenAsXml(m_client, successor));
     pushTransaction(element);
   }
 
   void DbClientTransactionLog::notifyActivated(const TokenId token){
-    TiXmlElement * element = allocateXmlElement("activate");
-    element->LinkEndChild(tokenAsXml(token));
-    pushTransaction(element);
+    pushTransaction(activateAsXml(m_client, token));
   }
 
   void DbClientTransactionLog::notifyMerged(const TokenId token, const TokenId activeToken){
-    TiXmlElement * element = allocateXmlElement("merge");
-    element->LinkEndChild(tokenAsXml(token));
-    element->LinkEndChild(tokenAsXml(activeToken));
-    pushTransaction(element);
+    pushTransaction(mergeAsXml(m_client, token, activeToken));
   }
 
   void DbClientTransactionLog::notifyMerged(const TokenId token){
     TiXmlElement * element = allocateXmlElement("merge");
-    element->LinkEndChild(tokenAsXml(token));
+    element->LinkEndChild(tokenAsXml(m_client, token));
     pushTransaction(element);
   }
 
   void DbClientTransactionLog::notifyRejected(const TokenId token){
-    TiXmlElement * element = allocateXmlElement("reject");
-    element->LinkEndChild(tokenAsXml(token));
-    pushTransaction(element);
+    pushTransaction(rejectAsXml(m_client, token));
   }
 
   void DbClientTransactionLog::notifyCancelled(const TokenId token){
@@ -198,7 +244,7 @@ void DbClientTransactionLog::notifyObjectCreated(const ObjectId object,
       return;
     }
     TiXmlElement * element = allocateXmlElement("cancel");
-    element->LinkEndChild(tokenAsXml(token));
+    element->LinkEndChild(tokenAsXml(m_client, token));
     pushTransaction(element);
   }
 
@@ -210,7 +256,7 @@ void DbClientTransactionLog::notifyConstraintCreated(const ConstraintId constrai
   std::vector<ConstrainedVariableId>::const_iterator iter;
   for (iter = variables.begin() ; iter != variables.end() ; iter++) {
     const ConstrainedVariableId variable = *iter;
-    element->LinkEndChild(variableAsXml(variable));
+    element->LinkEndChild(variableAsXml(m_client, variable));
     }
   pushTransaction(element);
 }
@@ -223,7 +269,7 @@ void DbClientTransactionLog::notifyConstraintDeleted(const ConstraintId constrai
   std::vector<ConstrainedVariableId>::const_iterator iter;
   for (iter = variables.begin() ; iter != variables.end() ; iter++) {
     const ConstrainedVariableId variable = *iter;
-    element->LinkEndChild(variableAsXml(variable));
+    element->LinkEndChild(variableAsXml(m_client, variable));
   }
   pushTransaction(element);
 }
@@ -231,18 +277,15 @@ void DbClientTransactionLog::notifyConstraintDeleted(const ConstraintId constrai
 	void DbClientTransactionLog::notifyVariableSpecified(const ConstrainedVariableId variable){
 		if(!variable->isInternal()) {
 			checkError(variable->lastDomain().isSingleton(), variable->toString() << " is not a singleton.");
-			TiXmlElement * element = allocateXmlElement("specify");
-			element->LinkEndChild(variableAsXml(variable));
-			element->LinkEndChild(domainValueAsXml(&variable->lastDomain(), variable->lastDomain().getSingletonValue()));
-			pushTransaction(element);
+			pushTransaction(specifyAsXml(m_client, variable, variable->lastDomain().getSingletonValue()));
 		}
 	}
 
 	void DbClientTransactionLog::notifyVariableRestricted(const ConstrainedVariableId variable){
 		if(!variable->isInternal()) {
 			TiXmlElement * element = allocateXmlElement("restrict");
-			element->LinkEndChild(variableAsXml(variable));
-			element->LinkEndChild(abstractDomainAsXml(&variable->baseDomain()));
+			element->LinkEndChild(variableAsXml(m_client, variable));
+			element->LinkEndChild(abstractDomainAsXml(m_client, &variable->baseDomain()));
 			pushTransaction(element);
 		}
   }
@@ -256,7 +299,7 @@ void DbClientTransactionLog::notifyConstraintDeleted(const ConstraintId constrai
 				return;
 			}
 			TiXmlElement * element = allocateXmlElement("reset");
-			element->LinkEndChild(variableAsXml(variable));
+			element->LinkEndChild(variableAsXml(m_client, variable));
 			pushTransaction(element);
 		}
   }
@@ -267,6 +310,74 @@ void DbClientTransactionLog::notifyConstraintDeleted(const ConstraintId constrai
       os << **iter << std::endl;
     }
     cleanup(m_bufferedTransactions);
+    m_changedVariables.clear();
+    m_checkpointAll = true;
+    m_checkpointed = 0;
+    m_retracted = 0;
+    if (m_binaryWriter != NULL)
+      m_binaryWriter->flush();
+  }
+
+  void DbClientTransactionLog::checkpoint(BinaryTransactionWriter& writer) {
+    checkError(m_binaryWriter == NULL, "Cannot checkpoint a streamed log.");
+    const PlanDatabaseId db = m_client->getPlanDatabase();
+    checkError(db->getConstraintEngine()->constraintConsistent(), "Can only checkpoint a propagated database.");
+
+    TiXmlElement marker("checkpoint");
+    marker.SetAttribute("version", CHECKPOINT_VERSION());
+    marker.SetAttribute("retract", static_cast<int>(m_retracted));
+    writer.write(marker);
+
+    std::list<TiXmlElement*>::const_iterator iter = m_bufferedTransactions.begin();
+    std::advance(iter, m_checkpointed);
+    for ( ; iter != m_bufferedTransactions.end(); ++iter)
+      writer.write(**iter);
+
+    // Variables deleted since the last checkpoint have dropped out of the changed ones
+    const ConstrainedVariableSet& variables =
+      (m_checkpointAll ? db->getConstraintEngine()->getVariables() : m_changedVariables);
+    unsigned int written = 0;
+    for (ConstrainedVariableSet::const_iterator it = variables.begin(); it != variables.end(); ++it)
+      written += checkpointDomain(writer, *it);
+    writer.flush();
+
+    debugMsg("DbClientTransactionLog:checkpoint",
+             "Retracted " << m_retracted << " and wrote " << m_bufferedTransactions.size() - m_checkpointed <<
+             " transactions and " << written << " of " << variables.size() << " domains");
+    m_changedVariables.clear();
+    m_checkpointAll = false;
+    m_checkpointed = m_bufferedTransactions.size();
+    m_retracted = 0;
+  }
+
+  int DbClientTransactionLog::CHECKPOINT_VERSION() {
+    return 1;
+  }
+
+  bool DbClientTransactionLog::checkpointDomain(BinaryTransactionWriter& writer, const ConstrainedVariableId variable) {
+    const EntityId parent = variable->parent();
+    if (parent.isNoId() ? m_client->getPlanDatabase()->getGlobalVariables().count(variable) == 0
+        : !TokenId::convertable(parent) && !ObjectId::convertable(parent))
+      return false;
+
+    const Domain& base = variable->baseDomain();
+    const Domain& derived = variable->lastDomain();
+    // Open domains can still grow, so they are left to the transactions which populate them
+    if (variable->isInternal() || base.isOpen() || derived.isOpen() || derived.isEmpty())
+      return false;
+
+    TiXmlElement element("domain");
+    if (parent.isNoId()) {
+      TiXmlElement * global_el = allocateXmlElement("id");
+      global_el->SetAttribute("name", variable->getName());
+      element.LinkEndChild(global_el);
+    }
+    else
+      element.LinkEndChild(variableAsXml(m_client, variable));
+    element.LinkEndChild(abstractDomainAsXml(m_client, &base));
+    element.LinkEndChild(abstractDomainAsXml(m_client, &derived));
+    writer.write(element);
+    return true;
   }
 
   std::string
@@ -279,7 +390,12 @@ void DbClientTransactionLog::notifyConstraintDeleted(const ConstraintId constrai
       if (domain->isNumeric()) {
         // CMG: Do not use snprintf. Not supported on DEC
         std::stringstream ss;
-        if (isInt(domain->getTypeName())) {
+        // Spelled the way the data types parse them; an infinite bound does not fit an int
+        if (value == MINUS_INFINITY)
+          ss << "-inf";
+        else if (value == PLUS_INFINITY)
+          ss << "+inf";
+        else if (isInt(domain->getTypeName())) {
           ss << cast_int(value);
         } else {
           ss << value;
@@ -295,10 +411,10 @@ void DbClientTransactionLog::notifyConstraintDeleted(const ConstraintId constrai
   }
 
   TiXmlElement *
-  DbClientTransactionLog::domainValueAsXml(const Domain * domain, edouble value)
+  DbClientTransactionLog::domainValueAsXml(const DbClientId client, const Domain * domain, edouble value)
   {
     std::string typeName = domain->getTypeName();
-    if (m_client->getSchema()->isObjectType(typeName)) {
+    if (client->getSchema()->isObjectType(typeName)) {
       TiXmlElement * element = allocateXmlElement("object");
       element->SetAttribute("value", domainValueAsString(domain, value));
       return element;
@@ -330,11 +446,11 @@ void DbClientTransactionLog::notifyConstraintDeleted(const ConstraintId constrai
   }
 
   TiXmlElement *
-  DbClientTransactionLog::abstractDomainAsXml(const Domain * domain)
+  DbClientTransactionLog::abstractDomainAsXml(const DbClientId client, const Domain * domain)
   {
     check_error(!domain->isEmpty());
     if (domain->isSingleton()) {
-      return domainValueAsXml(domain, domain->getSingletonValue());
+      return domainValueAsXml(client, domain, domain->getSingletonValue());
     } else if (domain->isEnumerated()) {
       TiXmlElement * element = allocateXmlElement("set");
       element->SetAttribute("type", domain->getTypeName());
@@ -342,7 +458,7 @@ void DbClientTransactionLog::notifyConstraintDeleted(const ConstraintId constrai
       domain->getValues(values);
       std::list<edouble>::const_iterator iter;
       for (iter = values.begin() ; iter != values.end() ; iter++) {
-        element->LinkEndChild(domainValueAsXml(domain, *iter));
+        element->LinkEndChild(domainValueAsXml(client, domain, *iter));
       }
       return element;
     } else if (domain->isInterval()) {
@@ -358,22 +474,22 @@ void DbClientTransactionLog::notifyConstraintDeleted(const ConstraintId constrai
   }
 
   TiXmlElement *
-  DbClientTransactionLog::tokenAsXml(const TokenId token) const
+  DbClientTransactionLog::tokenAsXml(const DbClientId client, const TokenId token)
   {
     TiXmlElement * token_el = allocateXmlElement("token");
-    token_el->SetAttribute("path", m_client->getPathAsString(token));
+    token_el->SetAttribute("path", client->getPathAsString(token));
     return token_el;
   }
 
 TiXmlElement *
-DbClientTransactionLog::variableAsXml(const ConstrainedVariableId variable) const {
+DbClientTransactionLog::variableAsXml(const DbClientId client, const ConstrainedVariableId variable) {
   TiXmlElement * var_el = allocateXmlElement("variable");
   const EntityId parent = variable->parent();
   if (parent != EntityId::noId()) {
     if (TokenId::convertable(parent)) {
       TokenId token = parent;
       check_error(token.isValid());
-      var_el->SetAttribute("token", m_client->getPathAsString(token));
+      var_el->SetAttribute("token", client->getPathAsString(token));
     }
     else if (ObjectId::convertable(parent)) {
       ObjectId object = parent;
@@ -381,34 +497,79 @@ DbClientTransactionLog::variableAsXml(const ConstrainedVariableId variable) cons
       var_el->SetAttribute("object", object->getName());
     }
     else {
-      var_el->SetAttribute("index", static_cast<int>(m_client->getIndexByVariable(variable)));
+      var_el->SetAttribute("index", static_cast<int>(client->getIndexByVariable(variable)));
       return var_el;
     }
   }
   else {
-    var_el->SetAttribute("index", static_cast<int>(m_client->getIndexByVariable(variable)));
-    return var_el;
-  }
-  if (variable->getIndex() != ConstrainedVariable::NO_INDEX) {
-    var_el->SetAttribute("index", static_cast<int>(variable->getIndex()));
-  }
-  else {
-    var_el->SetAttribute("index", static_cast<int>(m_client->getIndexByVariable(variable)));
+    var_el->SetAttribute("index", static_cast<int>(client->getIndexByVariable(variable)));
     return var_el;
   }
+  // The index of a token or object variable is its position among the variables of its parent,
+  // which for the first of them is NO_INDEX
+  var_el->SetAttribute("index", static_cast<int>(variable->getIndex()));
   return var_el;
 }
 
-  TiXmlElement * DbClientTransactionLog::allocateXmlElement(const std::string& name) const {
+  TiXmlElement * DbClientTransactionLog::specifyAsXml(const DbClientId client, const ConstrainedVariableId variable,
+                                                      edouble value) {
+    TiXmlElement * element = allocateXmlElement("specify");
+    element->LinkEndChild(variableAsXml(client, variable));
+    element->LinkEndChild(domainValueAsXml(client, &variable->lastDomain(), value));
+    return element;
+  }
+
+  TiXmlElement * DbClientTransactionLog::activateAsXml(const DbClientId client, const TokenId token) {
+    TiXmlElement * element = allocateXmlElement("activate");
+    element->LinkEndChild(tokenAsXml(client, token));
+    return element;
+  }
+
+  TiXmlElement * DbClientTransactionLog::mergeAsXml(const DbClientId client, const TokenId token,
+                                                    const TokenId activeToken) {
+    TiXmlElement * element = allocateXmlElement("merge");
+    element->LinkEndChild(tokenAsXml(client, token));
+    element->LinkEndChild(tokenAsXml(client, activeToken));
+    return element;
+  }
+
+  TiXmlElement * DbClientTransactionLog::rejectAsXml(const DbClientId client, const TokenId token) {
+    TiXmlElement * element = allocateXmlElement("reject");
+    element->LinkEndChild(tokenAsXml(client, token));
+    return element;
+  }
+
+  TiXmlElement * DbClientTransactionLog::constrainAsXml(const DbClientId client, const ObjectId object,
+                                                        const TokenId predecessor, const TokenId successor) {
+    TiXmlElement * element = allocateXmlElement("constrain");
+    TiXmlElement * object_el = allocateXmlElement("object");
+    object_el->SetAttribute("name", object->getName());
+    element->LinkEndChild(object_el);
+    element->LinkEndChild(tokenAsXml(client, predecessor));
+    element->LinkEndChild(tokenAsXml(client, successor));
+    return element;
+  }
+
+  TiXmlElement * DbClientTransactionLog::allocateXmlElement(const std::string& name) {
     TiXmlElement * element = new TiXmlElement(name);
     return element;
   }
 
   void DbClientTransactionLog::pushTransaction(TiXmlElement * tx){
+    if (m_binaryWriter != NULL) {
+      m_binaryWriter->write(*tx);
+      delete tx;
+      return;
+    }
     m_bufferedTransactions.push_back(tx);
   }
 
   void DbClientTransactionLog::popTransaction(){
+    checkError(m_binaryWriter == NULL, "Cannot take back a transaction from a streamed log.");
+    if (m_bufferedTransactions.size() <= m_checkpointed) {
+      m_checkpointed--;
+      m_retracted++;
+    }
     TiXmlElement* tx = m_bufferedTransactions.back();
     m_bufferedTransactions.pop_back();
     delete tx;
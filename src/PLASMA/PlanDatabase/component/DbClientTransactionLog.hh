@@ -17,10 +17,19 @@ namespace EUROPA {
 
 
 	class TiXmlElement;
+  class BinaryTransactionWriter;
 
   class DbClientTransactionLog: public DbClientListener {
   public:
     DbClientTransactionLog(const DbClientId client, bool chronologicalBacktracking = true);
+
+    /**
+     * @brief Construct a log which streams transactions to the given stream in the binary format
+     * of BinaryTransactionLog.hh rather than buffering them. Retracted transactions cannot be
+     * taken back from the stream, so they are logged as transactions of their own.
+     * @param binaryOut Stream to write to, opened in binary mode. Must outlive the log.
+     */
+    DbClientTransactionLog(const DbClientId client, std::ostream& binaryOut);
     ~DbClientTransactionLog();
 
     /* Declare DbClient event handlers we will over-ride */
@@ -50,22 +59,95 @@ namespace EUROPA {
     void removeBreakpoint();
     /**
      * @brief Flush all buffered transactions to an output stream and clear the buffer. Handy for checkpointing.
+     * A streaming log has nothing buffered, and flushes its own stream instead.
      */
     void flush(std::ostream& os);
 
+    /**
+     * @brief Write a checkpoint to a binary log, from which DbClientTransactionPlayer::restore brings a
+     * database to the state logged so far without replaying the propagation that led to it.
+     *
+     * A checkpoint starts with a "checkpoint" element carrying the format version and the number of
+     * transactions of earlier checkpoints popped since. It goes on with the transactions buffered since
+     * the last checkpoint, which create the objects, tokens, variables and explicit constraints and make
+     * the decisions in force; with chronological backtracking none of the retracted ones are among them.
+     * It ends with a "domain" element for each variable of an object or token, or global variable, whose
+     * base or derived domain has changed since the last checkpoint, holding the address of the variable
+     * and both domains. The first checkpoint, and the first after a flush, has one for every such variable.
+     * Changes are those the constraint engine publishes, which leaves out inactive variables; their domains
+     * only change by the transactions themselves. The database must be propagated.
+     */
+    void checkpoint(BinaryTransactionWriter& writer);
+
+    /**
+     * @brief The version of the checkpoint format, written into every checkpoint.
+     */
+    static int CHECKPOINT_VERSION();
+
+  //! XML output functions, for transactions built outside a log
+
+    /**
+     * @brief create an xml element to represent a token
+     */
+    static TiXmlElement * tokenAsXml(const DbClientId client, const TokenId token);
+
+    /**
+     * @brief create an xml element to represent a variable
+     */
+    static TiXmlElement * variableAsXml(const DbClientId client, const ConstrainedVariableId variable);
+
+    /**
+     * @brief create the transaction which specifies a variable to a value
+     */
+    static TiXmlElement * specifyAsXml(const DbClientId client, const ConstrainedVariableId variable, edouble value);
+
+    /**
+     * @brief create the transaction which activates a token
+     */
+    static TiXmlElement * activateAsXml(const DbClientId client, const TokenId token);
+
+    /**
+     * @brief create the transaction which merges a token onto an active token
+     */
+    static TiXmlElement * mergeAsXml(const DbClientId client, const TokenId token, const TokenId activeToken);
+
+    /**
+     * @brief create the transaction which rejects a token
+     */
+    static TiXmlElement * rejectAsXml(const DbClientId client, const TokenId token);
+
+    /**
+     * @brief create the transaction which orders two tokens on an object
+     */
+    static TiXmlElement * constrainAsXml(const DbClientId client, const ObjectId object,
+                                         const TokenId predecessor, const TokenId successor);
+
   private:
+    class ChangeListener;
     friend class DbClientTransactionPlayer;
     const std::list<TiXmlElement*>& getBufferedTransactions() const;
 
-    TiXmlElement * allocateXmlElement(const std::string&) const;
+    static TiXmlElement * allocateXmlElement(const std::string&);
     void pushTransaction(TiXmlElement *);
     void popTransaction();
 
-    bool isBool(const std::string& typeName);
-    bool isInt(const std::string& typeName);
+    /**
+     * @brief Write the domains of a variable to a checkpoint if it is of an object or token, or global.
+     * @return true if the domains were written.
+     */
+    bool checkpointDomain(BinaryTransactionWriter& writer, const ConstrainedVariableId variable);
+
+    static bool isBool(const std::string& typeName);
+    static bool isInt(const std::string& typeName);
 
     std::list<TiXmlElement*> m_bufferedTransactions;
+    BinaryTransactionWriter* m_binaryWriter; /*!< Set if transactions are streamed rather than buffered */
     bool m_chronologicalBacktracking;
+    unsigned int m_checkpointed; /*!< Buffered transactions already written to a checkpoint */
+    unsigned int m_retracted; /*!< Checkpointed transactions popped since the last checkpoint */
+    ChangeListener* m_changeListener; /*!< Records changed variables, unless transactions are streamed */
+    ConstrainedVariableSet m_changedVariables; /*!< Since the last checkpoint */
+    bool m_checkpointAll; /*!< Set until the first checkpoint after construction or a flush */
     int m_tokensCreated;
     const DbClientId m_client;
     
@@ -74,29 +156,19 @@ namespace EUROPA {
     /** 
      * @brief create a string to describe a value, given its domain
      */
-    std::string domainValueAsString(const Domain * domain, edouble value);
+    static std::string domainValueAsString(const Domain * domain, edouble value);
 
   //! XML output functions
 
     /** 
      * @brief create an xml element to represent a value, given its domain
      */
-    TiXmlElement * domainValueAsXml(const Domain * domain, edouble value);
+    static TiXmlElement * domainValueAsXml(const DbClientId client, const Domain * domain, edouble value);
 
     /** 
      * @brief create an xml element to represent a domain
      */
-    TiXmlElement * abstractDomainAsXml(const Domain * domain);
-
-    /** 
-     * @brief create an xml element to represent a token
-     */
-    TiXmlElement * tokenAsXml(const TokenId token) const;
-
-    /** 
-     * @brief create an xml element to represent a variable
-     */
-    TiXmlElement * variableAsXml(const ConstrainedVariableId variable) const;
+    static TiXmlElement * abstractDomainAsXml(const DbClientId client, const Domain * domain);
   };
 }
 #endif
@@ -11,6 +11,7 @@
 #include "DbClient.hh"
 #include "DbClientTransactionPlayer.hh"
 #include "DbClientTransactionLog.hh"
+#include "BinaryTransactionLog.hh"
 #include "Utils.hh"
 #include "CESchema.hh"
 
@@ -92,7 +93,7 @@ namespace EUROPA {
   }
 
   DbClientTransactionPlayer::DbClientTransactionPlayer(const DbClientId & client)
-      : m_client(client), m_objectCount(0), m_varCount(0), m_filters(), m_tokens(),
+      : m_client(client), m_objectCount(0), m_varCount(0), m_txCount(0), m_filters(), m_tokens(),
         m_variables(), m_relations(){
   }
 
@@ -140,6 +141,170 @@ CESchemaId DbClientTransactionPlayer::getCESchema() const {
     }
   }
 
+  void DbClientTransactionPlayer::play(BinaryTransactionReader& reader) {
+    for (;;) {
+      TiXmlElement tx("");
+      if (!reader.next(tx))
+        return;
+      processTransaction(tx);
+    }
+  }
+
+  void DbClientTransactionPlayer::restore(BinaryTransactionReader& reader) {
+    std::list<TiXmlElement*> transactions; // Net of those retracted by later checkpoints
+    std::map<std::string, TiXmlElement*> domains; // The latest domains recorded for each variable, by its address
+    for (;;) {
+      TiXmlElement* tx = new TiXmlElement("");
+      if (!reader.next(*tx)) {
+        delete tx;
+        break;
+      }
+
+      if (strcmp(tx->Value(), "domain") == 0) {
+        checkRuntimeError(tx->FirstChildElement() != NULL, "No variable in " << *tx);
+        std::ostringstream address;
+        address << *tx->FirstChildElement();
+        std::map<std::string, TiXmlElement*>::iterator it = domains.find(address.str());
+        if (it == domains.end())
+          domains.insert(std::make_pair(address.str(), tx));
+        else {
+          delete it->second;
+          it->second = tx;
+        }
+        continue;
+      }
+
+      if (strcmp(tx->Value(), "checkpoint") != 0) {
+        transactions.push_back(tx);
+        continue;
+      }
+
+      int version = 0;
+      int retract = 0;
+      tx->Attribute("version", &version);
+      tx->Attribute("retract", &retract);
+      delete tx;
+      checkRuntimeError(version == DbClientTransactionLog::CHECKPOINT_VERSION(),
+                        "Checkpoint format version " << version << " is not " <<
+                        DbClientTransactionLog::CHECKPOINT_VERSION() << ".");
+      checkRuntimeError(retract >= 0 && static_cast<unsigned int>(retract) <= transactions.size(),
+                        "Checkpoint retracts " << retract << " of " << transactions.size() << " transactions.");
+      debugMsg("DbClientTransactionPlayer:restore",
+               "Retracting " << retract << " of " << transactions.size() << " transactions");
+      for ( ; retract > 0; retract--) {
+        delete transactions.back();
+        transactions.pop_back();
+      }
+    }
+
+    debugMsg("DbClientTransactionPlayer:restore",
+             "Restoring " << transactions.size() << " transactions and " << domains.size() << " domains");
+    // Otherwise each transaction which creates a constraint or a token would propagate
+    const ConstraintEngineId ce = m_client->getPlanDatabase()->getConstraintEngine();
+    const bool autoPropagation = ce->getAutoPropagation();
+    ce->setAutoPropagation(false);
+    for (std::list<TiXmlElement*>::const_iterator it = transactions.begin(); it != transactions.end(); ++it) {
+      // The slaves of a guarded rule only exist once propagation has decided the guard
+      if (!tokensExist(**it)) {
+        debugMsg("DbClientTransactionPlayer:restore", "Propagating to create the tokens of " << **it);
+        installDomains(domains);
+        m_client->propagate();
+        checkRuntimeError(tokensExist(**it), "Cannot find the tokens of " << **it);
+      }
+      playTransaction(**it);
+    }
+
+    while (installDomains(domains) && !domains.empty())
+      m_client->propagate();
+    debugMsg("DbClientTransactionPlayer:restore",
+             domains.size() << " domains are of variables no longer in the database");
+
+    // Every derived domain is at the fixpoint it was checkpointed at, so this only settles the propagators.
+    // Turning auto propagation back on propagates by itself.
+    ce->setAutoPropagation(autoPropagation);
+    if (!autoPropagation)
+      m_client->propagate();
+
+    cleanup(transactions);
+    for (std::map<std::string, TiXmlElement*>::const_iterator it = domains.begin(); it != domains.end(); ++it)
+      delete it->second;
+  }
+
+  bool DbClientTransactionPlayer::tokensExist(const TiXmlElement& element) const {
+    const char* path = NULL;
+    if (strcmp(element.Value(), "token") == 0)
+      path = element.Attribute("path");
+    else if (strcmp(element.Value(), "variable") == 0)
+      path = element.Attribute("token");
+    if (path != NULL && m_client->getTokenByPath(pathAsVector(path)).isNoId())
+      return false;
+
+    for (const TiXmlElement* child = element.FirstChildElement(); child != NULL; child = child->NextSiblingElement())
+      if (!tokensExist(*child))
+        return false;
+    return true;
+  }
+
+  bool DbClientTransactionPlayer::installDomains(std::map<std::string, TiXmlElement*>& domains) {
+    bool installed = false;
+    std::map<std::string, TiXmlElement*>::iterator it = domains.begin();
+    while (it != domains.end()) {
+      const TiXmlElement* var_el = it->second->FirstChildElement();
+      ConstrainedVariableId variable;
+      if (strcmp(var_el->Value(), "id") == 0) {
+        const char* name = var_el->Attribute("name");
+        if (m_client->isGlobalVariable(name))
+          variable = m_client->getGlobalVariable(name);
+      }
+      else if (tokensExist(*var_el) &&
+               (var_el->Attribute("object") == NULL || m_client->getObject(var_el->Attribute("object")).isId()))
+        variable = xmlAsVariable(*var_el);
+
+      if (variable.isNoId()) {
+        ++it;
+        continue;
+      }
+
+      const TiXmlElement* base_el = var_el->NextSiblingElement();
+      checkRuntimeError(base_el != NULL && base_el->NextSiblingElement() != NULL,
+                        "Expected a base and a derived domain in " << *it->second);
+      Domain* base = xmlAsDomain(*base_el, NULL, variable->baseDomain().getTypeName().c_str());
+      Domain* derived = xmlAsDomain(*base_el->NextSiblingElement(), NULL, variable->baseDomain().getTypeName().c_str());
+      debugMsg("DbClientTransactionPlayer:restore",
+               "Restoring " << variable->toString() << " to " << base->toString() << " and " << derived->toString());
+      // A merged token has inactive variables, whose base domains are of no account
+      if (variable->isActive())
+        variable->restrictBaseDomain(*base);
+      m_client->getPlanDatabase()->getConstraintEngine()->restrictDomain(variable, *derived);
+      delete base;
+      delete derived;
+
+      delete it->second;
+      domains.erase(it++);
+      installed = true;
+    }
+    return installed;
+  }
+
+  void DbClientTransactionPlayer::playTransaction(const TiXmlElement& element) {
+    checkError(strcmp(element.Value(), "nddl") != 0, "Play the transactions of a block one at a time.");
+    dispatchTransaction(element);
+  }
+
+  void DbClientTransactionPlayer::playInverse(const TiXmlElement& element) {
+    debugMsg("DbClientTransactionPlayer:playInverse", "Playing inverse of " << element);
+    if (transactionMatch(element, "specify"))
+      playVariableReset(element);
+    else if (transactionMatch(element, "activate") ||
+             transactionMatch(element, "merge") ||
+             transactionMatch(element, "reject"))
+      playCancelled(element);
+    else if (transactionMatch(element, "constrain"))
+      playFreed(element);
+    else
+      checkError(ALWAYS_FAILS, "The inverse of " << element << " needs the transactions before it.");
+  }
+
   void DbClientTransactionPlayer::rewind(std::istream& is, bool breakpoint) {
     check_error(is, "Invalid input stream for playing transactions.");
     std::list<TiXmlElement*> transactions;
@@ -191,12 +356,23 @@ CESchemaId DbClientTransactionPlayer::getCESchema() const {
   }
 
   void DbClientTransactionPlayer::processTransaction(const TiXmlElement & element) {
-    static unsigned int sl_txCount(0);
-    check_error_variable(const char * tagname = element.Value());
+    if (!dispatchTransaction(element)) {
+      check_error_variable(const char * tagname = element.Value());
+      checkError(strcmp(tagname, "nddl") == 0, "Unknown tag name " << tagname);
+      for (TiXmlElement * child_el = element.FirstChildElement() ;
+           child_el != NULL ; child_el = child_el->NextSiblingElement()) {
+        processTransaction(*child_el);
+        if (!m_client->propagate())
+          return;
+      }
+    }
+    m_client->propagate();
+  }
 
-    sl_txCount++;
+  bool DbClientTransactionPlayer::dispatchTransaction(const TiXmlElement & element) {
+    m_txCount++;
     debugMsg("DbClientTransactionPlayer:processTransaction",
-	     "Processing transaction " << element);
+	     "Processing transaction " << m_txCount << ": " << element);
     if(!transactionFiltered(element)) {
       if(transactionMatch(element, "breakpoint")) {}
       else if (transactionMatch(element, "class_decl"))
@@ -247,17 +423,10 @@ CESchemaId DbClientTransactionPlayer::getCESchema() const {
 	playInvokeConstraint(element);
       else if(transactionMatch(element, "deleteconstraint"))
 	playUninvokeConstraint(element);
-      else {
-	checkError(strcmp(tagname, "nddl") == 0, "Unknown tag name " << tagname);
-	for (TiXmlElement * child_el = element.FirstChildElement() ;
-	     child_el != NULL ; child_el = child_el->NextSiblingElement()) {
-	  processTransaction(*child_el);
-	  if (!m_client->propagate())
-	    return;
-	}
-      }
+      else
+	return false;
     }
-    m_client->propagate();
+    return true;
   }
 
   template<typename Iterator>
@@ -1398,7 +1567,10 @@ void DbClientTransactionPlayer::playTokenCreated(const TiXmlElement & element) {
       const char * type = element.Attribute("type");
       check_error(type != NULL);
       Domain * domain = getCESchema()->baseDomain(type).copy();
-      domain->set(m_client->createValue(tag, value_st));
+      edouble value = m_client->createValue(tag, value_st);
+      if(domain->isOpen() && !domain->isMember(value))
+	domain->insert(value);
+      domain->set(value);
       return(domain);
     }
 
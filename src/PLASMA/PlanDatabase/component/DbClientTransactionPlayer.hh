@@ -6,6 +6,7 @@
 #include <map>
 #include <list>
 #include <set>
+#include <string>
 
 
 /**
@@ -17,6 +18,7 @@
 namespace EUROPA {
 
 	class TiXmlElement;
+  class BinaryTransactionReader;
 
   class DbClientTransactionPlayer {
   public:
@@ -35,6 +37,33 @@ namespace EUROPA {
      */
     void play(const DbClientTransactionLogId txLog);
 
+    /**
+     * @brief Play all remaining transactions from a binary log
+     * @param reader The source of transactions, as written by a streaming DbClientTransactionLog
+     */
+    void play(BinaryTransactionReader& reader);
+
+    /**
+     * @brief Bring the database to the state of the last checkpoint in a binary log, without replaying
+     * the propagation that led to it. Transactions retracted by later checkpoints are dropped unplayed.
+     * The rest are played without propagating, and the recorded base and derived domains are then
+     * installed directly, so that a single propagation finds nothing left to narrow. Propagation only
+     * comes earlier where a transaction refers to a slave token which a guarded rule has yet to create.
+     * @param reader The source of checkpoints, as written by DbClientTransactionLog::checkpoint
+     */
+    void restore(BinaryTransactionReader& reader);
+
+    /**
+     * @brief Play a single transaction without propagating.
+     */
+    void playTransaction(const TiXmlElement& element);
+
+    /**
+     * @brief Play the inverse of a decision transaction without propagating: reset a specified variable,
+     * cancel an activated, merged or rejected token, or free an ordering.
+     */
+    void playInverse(const TiXmlElement& element);
+
     /**
      * @brief Play the inverses of transactions from an input stream.
      * @param is a stream of xml-based transactions
@@ -60,12 +89,39 @@ namespace EUROPA {
                                         const std::string& predicate,
                                         ObjectId& object);
 
+    /**
+     * @brief return a variable as represented by an xml element
+     */
+    ConstrainedVariableId xmlAsVariable(const TiXmlElement & variable);
+
+    /**
+     * @brief return a token as represented by an xml element
+     */
+    TokenId xmlAsToken(const TiXmlElement & token);
+
   protected:
     typedef std::multimap<std::pair<ConstrainedVariableId, ConstrainedVariableId>, ConstraintId> TemporalRelations;
 
     bool transactionMatch(const TiXmlElement& trans, const std::string& name) const;
     bool transactionFiltered(const TiXmlElement& trans) const;
     virtual void processTransaction(const TiXmlElement & element);
+
+    /**
+     * @brief Play a transaction without propagating.
+     * @return false if the element is a block of transactions rather than a transaction.
+     */
+    bool dispatchTransaction(const TiXmlElement & element);
+
+    /**
+     * @brief Tests if every token the element refers to by path exists.
+     */
+    bool tokensExist(const TiXmlElement& element) const;
+
+    /**
+     * @brief Install the recorded domains of the variables which exist, dropping their records.
+     * @return true if any were installed.
+     */
+    bool installDomains(std::map<std::string, TiXmlElement*>& domains);
     template<typename Iterator>
     void processTransactionInverse(const TiXmlElement& element,
 				   Iterator start, Iterator end);
@@ -134,6 +190,7 @@ namespace EUROPA {
     DbClientId m_client;
     int m_objectCount;
     int m_varCount;
+    unsigned int m_txCount;
     std::set<std::string> m_filters;
     std::map<std::string, TokenId> m_tokens;
     std::map<std::string, ConstrainedVariableId> m_variables;
@@ -180,16 +237,6 @@ namespace EUROPA {
      */
     edouble xmlAsValue(const TiXmlElement & value, const char * name = NULL);
 
-    /**
-     * @brief return a variable as represented by an xml element
-     */
-    ConstrainedVariableId xmlAsVariable(const TiXmlElement & variable);
-
-    /**
-     * @brief return a token as represented by an xml element
-     */
-    TokenId xmlAsToken(const TiXmlElement & token);
-
     /**
      * @brief return a newly created variable as represented by an xml element
      */
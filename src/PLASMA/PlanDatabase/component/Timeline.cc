@@ -23,19 +23,185 @@
 
 namespace EUROPA {
 
+/**
+ * @class Timeline::SequenceTree
+ * @brief The token sequence of a timeline held in a treap, ordered by position in the sequence.
+ *
+ * Bounds of the tokens change with propagation, so they are not stored but read as the tree is
+ * descended. When constraints are consistent the precedence constraints of the sequence make
+ * latest starts and earliest ends non-decreasing along it, so a test on either is a search key.
+ */
+class Timeline::SequenceTree {
+public:
+  SequenceTree() : m_root(NULL), m_nodes() {}
+  ~SequenceTree() {clear(m_root);}
+
+  /**
+   * @brief Adds the token at the given position, just before the successor, or last if the successor is noId.
+   */
+  void insert(const TokenId token, const std::list<TokenId>::iterator& position, const TokenId successor) {
+    check_error(m_nodes.find(token->getKey()) == m_nodes.end());
+    Node* node = new Node(position, static_cast<unsigned int>(cast_long(token->getKey())) * 2654435761u);
+    m_nodes.insert(std::make_pair(token->getKey(), node));
+
+    if (m_root == NULL) {
+      m_root = node;
+      return;
+    }
+
+    // Attach as the rightmost node of the left subtree of the successor, or of the whole tree
+    Node* parent = NULL;
+    if (successor.isNoId())
+      parent = m_root;
+    else {
+      parent = getNode(successor);
+      if (parent->left == NULL) {
+        parent->left = node;
+        node->parent = parent;
+      }
+      else
+        parent = parent->left;
+    }
+    if (node->parent == NULL) {
+      while (parent->right != NULL)
+        parent = parent->right;
+      parent->right = node;
+      node->parent = parent;
+    }
+
+    while (node->parent != NULL && node->parent->priority < node->priority)
+      rotateUp(node);
+  }
+
+  void remove(const TokenId token) {
+    std::map<eint, Node*>::iterator it = m_nodes.find(token->getKey());
+    check_error(it != m_nodes.end());
+    Node* node = it->second;
+    m_nodes.erase(it);
+
+    // Rotate down to a leaf, then detach
+    while (node->left != NULL || node->right != NULL) {
+      if (node->right == NULL || (node->left != NULL && node->left->priority > node->right->priority))
+        rotateUp(node->left);
+      else
+        rotateUp(node->right);
+    }
+    replaceChild(node->parent, node, NULL);
+    delete node;
+  }
+
+  /**
+   * @brief The first position in the sequence whose token satisfies the test.
+   * @param test Must be false up to some position in the sequence and true from there on.
+   * @param end Returned if no token satisfies the test.
+   */
+  template<class Test>
+  std::list<TokenId>::iterator findFirst(const Test& test, const std::list<TokenId>::iterator& end) const {
+    std::list<TokenId>::iterator result = end;
+    Node* node = m_root;
+    while (node != NULL) {
+      if (test(*(node->position))) {
+        result = node->position;
+        node = node->left;
+      }
+      else
+        node = node->right;
+    }
+    return result;
+  }
+
+private:
+  struct Node {
+    Node(const std::list<TokenId>::iterator& p, const unsigned int pr)
+      : position(p), priority(pr), parent(NULL), left(NULL), right(NULL) {}
+    std::list<TokenId>::iterator position;
+    unsigned int priority;
+    Node* parent;
+    Node* left;
+    Node* right;
+  };
+
+  Node* getNode(const TokenId token) const {
+    std::map<eint, Node*>::const_iterator it = m_nodes.find(token->getKey());
+    checkError(it != m_nodes.end(), "Token (" << token->getKey() << ") is not in the sequence tree.");
+    return it->second;
+  }
+
+  void replaceChild(Node* parent, Node* child, Node* replacement) {
+    if (parent == NULL)
+      m_root = replacement;
+    else if (parent->left == child)
+      parent->left = replacement;
+    else
+      parent->right = replacement;
+    if (replacement != NULL)
+      replacement->parent = parent;
+  }
+
+  /**
+   * @brief Swaps the node with its parent, preserving the order of the sequence.
+   */
+  void rotateUp(Node* node) {
+    Node* parent = node->parent;
+    replaceChild(parent->parent, parent, node);
+    if (parent->left == node) {
+      parent->left = node->right;
+      if (node->right != NULL)
+        node->right->parent = parent;
+      node->right = parent;
+    }
+    else {
+      parent->right = node->left;
+      if (node->left != NULL)
+        node->left->parent = parent;
+      node->left = parent;
+    }
+    parent->parent = node;
+  }
+
+  static void clear(Node* node) {
+    if (node == NULL)
+      return;
+    clear(node->left);
+    clear(node->right);
+    delete node;
+  }
+
+  Node* m_root;
+  std::map<eint, Node*> m_nodes; /*!< Node of each token by key */
+};
+
+  /**
+   * @brief True of tokens in the sequence which the given token might precede by the same bound test as
+   * DefaultTemporalAdvisor::canPrecede, which every advisor must pass.
+   */
+  class CanPrecedeByBounds {
+  public:
+    CanPrecedeByBounds(const TokenId token)
+      : m_earliestEnd(cast_int(token->end()->lastDomain().getLowerBound())) {}
+    bool operator()(const TokenId successor) const {
+      return m_earliestEnd <= cast_int(successor->start()->lastDomain().getUpperBound());
+    }
+  private:
+    eint m_earliestEnd;
+  };
+
   /** TIMELINE IMPLEMENTATION **/
 
 Timeline::Timeline(const PlanDatabaseId planDatabase, const std::string& type, 
                    const std::string& name, bool open)
-    : Object(planDatabase, type, name, true), m_tokenSequence(), m_tokenIndex() 
+    : Object(planDatabase, type, name, true), m_tokenSequence(), m_tokenIndex(),
+      m_sequenceTree(new SequenceTree())
 {commonInit(open);}
 
   Timeline::Timeline(const ObjectId parent, const std::string& type, 
                      const std::string& localName, bool open)
-      : Object(parent, type, localName, true), m_tokenSequence(), m_tokenIndex() 
+      : Object(parent, type, localName, true), m_tokenSequence(), m_tokenIndex(),
+        m_sequenceTree(new SequenceTree())
 {commonInit(open);}
 
   Timeline::~Timeline(){
+    delete m_sequenceTree;
   }
 
   void Timeline::commonInit(bool open){
@@ -82,8 +248,12 @@ Timeline::Timeline(const PlanDatabaseId planDatabase, const std::string& type,
 
     TemporalAdvisorId temporalAdvisor = getPlanDatabase()->getTemporalAdvisor();
 
+    // Every query below relates the token to members of the sequence
+    temporalAdvisor->cacheOrderingDistances(token);
+
     // Alternatively, we can go through the sequence till we find something that we can precede.
-    std::list<TokenId>::iterator current = m_tokenSequence.begin(); // Start at first token in the sequence
+    // Tokens which the bounds alone show it cannot precede are skipped by searching the tree.
+    std::list<TokenId>::iterator current = firstPossibleSuccessor(token);
     const std::list<TokenId>::iterator& last = m_tokenSequence.end(); // For termination criteria
 
     // Move forward until we find a Token we can precede
@@ -117,33 +287,45 @@ Timeline::Timeline(const PlanDatabaseId planDatabase, const std::string& type,
     // Step back to start the predecessor and current at the right locations
     --current;
 
+    std::vector<std::pair<TokenId, TokenId> > gaps;
+    std::vector<bool> fits;
     while (!foundLastToken && !foundLastPredecessor && choiceCount < limit) {
-      // Prune if the token cannot fit between tokens
-      TokenId predecessor = *(current++);
-      TokenId successor = *current;
-      check_error(predecessor.isValid() && predecessor->isActive());
-      check_error(successor.isValid() && successor->isActive());
-
-      // we still need to check that the predecessor can precede the token,
-      // otherwise we'll return bogus successors (see PlanDatabse::module-tests::testNoChoicesThatFit
-      if (!temporalAdvisor->canPrecede(predecessor,token)) {
-	debugMsg("Timeline:getOrderingChoices:canPrecede",predecessor->toString() << " cannot precede " << token->toString());
-	foundLastPredecessor = true;
-      }
-      else {
-	if (temporalAdvisor->canFitBetween(token, predecessor, successor)){
-	  debugMsg("Timeline:getOrderingChoices:canPrecede",
-		   token->toString() << "can be inserted between " << predecessor->toString() << " and " << successor->toString());
-	  results.push_back(std::make_pair(token, successor));
-	  choiceCount++;
-	}
-	else {
-	  debugMsg("Timeline:getOrderingChoices:canPrecede",
-		   token->toString() << "cannot be inserted between " << predecessor->toString() << " and " << successor->toString());
-	}
+      // Gather the gaps to test, no more than could all become choices
+      gaps.clear();
+      while (!foundLastToken && gaps.size() < limit - choiceCount) {
+        TokenId predecessor = *(current++);
+        TokenId successor = *current;
+        check_error(predecessor.isValid() && predecessor->isActive());
+        check_error(successor.isValid() && successor->isActive());
+
+        // we still need to check that the predecessor can precede the token,
+        // otherwise we'll return bogus successors (see PlanDatabse::module-tests::testNoChoicesThatFit
+        if (!temporalAdvisor->canPrecede(predecessor,token)) {
+          debugMsg("Timeline:getOrderingChoices:canPrecede",predecessor->toString() << " cannot precede " << token->toString());
+          foundLastPredecessor = true;
+          break;
+        }
+
+        gaps.push_back(std::make_pair(predecessor, successor));
+        foundLastToken = (successor == lastToken);
       }
 
-      foundLastToken = (successor == lastToken);
+      // Prune if the token cannot fit between tokens
+      fits.clear();
+      if (!gaps.empty())
+        temporalAdvisor->canFitBetweenEach(token, gaps, fits);
+      for (unsigned int i = 0; i < gaps.size(); i++) {
+        if (fits[i]) {
+          debugMsg("Timeline:getOrderingChoices:canPrecede",
+                   token->toString() << "can be inserted between " << gaps[i].first->toString() << " and " << gaps[i].second->toString());
+          results.push_back(std::make_pair(token, gaps[i].second));
+          choiceCount++;
+        }
+        else {
+          debugMsg("Timeline:getOrderingChoices:canPrecede",
+                   token->toString() << "cannot be inserted between " << gaps[i].first->toString() << " and " << gaps[i].second->toString());
+        }
+      }
     }
 
     // Special case, the token could be placed at the end, which can't precede anything. This
@@ -162,6 +344,14 @@ Timeline::Timeline(const PlanDatabaseId planDatabase, const std::string& type,
     }
   }
 
+  std::list<TokenId>::iterator Timeline::firstPossibleSuccessor(const TokenId token) {
+    // The order of bounds along the sequence only holds if its precedence constraints are all satisfied
+    ConstraintEngineId ce = getPlanDatabase()->getConstraintEngine();
+    if (!ce->constraintConsistent() || ce->getViolation() > 0)
+      return m_tokenSequence.begin();
+    return m_sequenceTree->findFirst(CanPrecedeByBounds(token), m_tokenSequence.end());
+  }
+
   void Timeline::getTokensToOrder(std::vector<TokenId>& results) {
     check_error(results.empty());
 
@@ -313,6 +503,7 @@ Timeline::Timeline(const PlanDatabaseId planDatabase, const std::string& type,
     --token_pos;
 
     // Erase the current token from the sequence and index
+    m_sequenceTree->remove(token);
     m_tokenSequence.erase(token_it->second);
     m_tokenIndex.erase(token_it);
 
@@ -504,9 +695,14 @@ Timeline::Timeline(const PlanDatabaseId planDatabase, const std::string& type,
   void Timeline::insertToIndex(const TokenId token, const std::list<TokenId>::iterator& position){
     // Remove the cache entry for this token as it is now inserted
     m_tokenIndex.insert(std::make_pair(token->getKey(), position));
+
+    std::list<TokenId>::iterator next = position;
+    ++next;
+    m_sequenceTree->insert(token, position, (next == m_tokenSequence.end() ? TokenId::noId() : *next));
   }
 
   void Timeline::removeFromIndex(const TokenId token){
+    m_sequenceTree->remove(token);
     m_tokenIndex.erase(token->getKey());
     notifyOrderingRequired(token);
   }
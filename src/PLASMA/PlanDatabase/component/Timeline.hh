@@ -60,6 +60,8 @@ namespace EUROPA {
     void notifyDeleted(const TokenId token);
 
   private:
+    class SequenceTree;
+
     /**
      * @brief Initialization utility
      */
@@ -75,6 +77,12 @@ namespace EUROPA {
     void removeFromIndex(const TokenId token);
     bool orderingRequired(const TokenId token);
 
+    /**
+     * @brief The first position in the sequence which the token might precede, judging by bounds alone.
+     * Every token before it has a latest start earlier than the earliest end of the token.
+     */
+    std::list<TokenId>::iterator firstPossibleSuccessor(const TokenId token);
+
     bool isValid(bool cleaningUp = false) const;
 
     /**
@@ -106,6 +114,9 @@ namespace EUROPA {
     /** Index to find position in sequence by Token */
     std::map<eint, std::list<TokenId>::iterator > m_tokenIndex;
 
+    /** Balanced tree over the sequence, to search it by the bounds of its tokens */
+    SequenceTree* m_sequenceTree;
+
     static const bool CLEANING_UP = true;
   };
 
@@ -13,6 +13,9 @@
 #include "HasAncestorConstraint.hh"
 #include "DbClientTransactionLog.hh"
 #include "DbClientTransactionPlayer.hh"
+#include "BinaryTransactionLog.hh"
+#include "PDBInterpreter.hh"
+#include "tinyxml.h"
 
 #include "DbClient.hh"
 #include "ObjectType.hh"
@@ -23,6 +26,7 @@
 #include "PlanDatabaseWriter.hh"
 #include "CESchema.hh"
 
+#include "ConstraintEngineListener.hh"
 #include "Constraints.hh"
 #include "Engine.hh"
 #include "ModuleConstraintEngine.hh"
@@ -31,6 +35,7 @@
 #include "unused.hh"
 
 #include <iostream>
+#include <fstream>
 #include <sstream>
 #include <iomanip>
 #include <string>
@@ -323,6 +328,7 @@ public:
     EUROPA_runTest(testEnumerations);
     EUROPA_runTest(testObjectTypeRelationships);
     EUROPA_runTest(testObjectPredicateRelationships);
+    EUROPA_runTest(testCompiledTypeHierarchy);
     EUROPA_runTest(testPredicateParameterAccessors);
     EUROPA_runTest(testTokenTypeAttributes);
 
@@ -543,6 +549,65 @@ private:
     return(true);
   }
 
+  static bool testCompiledTypeHierarchy() {
+    DEFAULT_SETUP(ce, db, true);
+
+    schema->addObjectType("Vehicle");
+    schema->addObjectType("Car", "Vehicle");
+    schema->addObjectType("Truck", "Vehicle");
+    schema->addObjectType("Sedan", "Car");
+    schema->addObjectType("Building");
+    schema->addPredicate("Vehicle.move");
+    schema->addPredicate("Car.park");
+
+    CPPUNIT_ASSERT(schema->isA("Sedan", "Vehicle"));
+    CPPUNIT_ASSERT(schema->isA("Sedan", Schema::rootObject()));
+    CPPUNIT_ASSERT(!schema->isA("Sedan", "Truck"));
+    CPPUNIT_ASSERT(!schema->isA("Truck", "Car"));
+    CPPUNIT_ASSERT(!schema->isA("Vehicle", "Car"));
+    CPPUNIT_ASSERT(!schema->isA("Building", "Vehicle"));
+    CPPUNIT_ASSERT(schema->isA("Sedan.move", "Vehicle.move"));
+    CPPUNIT_ASSERT(schema->isA("Sedan.park", "Car.park"));
+    CPPUNIT_ASSERT(!schema->isA("Vehicle.move", "Car.move"));
+    CPPUNIT_ASSERT(!schema->isA("Car.park", "Car.move"));
+    CPPUNIT_ASSERT(!schema->isA("Car.move", "Car"));
+    CPPUNIT_ASSERT(!schema->isA("Car", "int"));
+    CPPUNIT_ASSERT(schema->isA("int", "float"));
+
+    // Ids agree with the string queries and map back to the names
+    unsigned int sedan = schema->getObjectTypeId("Sedan");
+    unsigned int car = schema->getObjectTypeId("Car");
+    unsigned int truck = schema->getObjectTypeId("Truck");
+    CPPUNIT_ASSERT(schema->getObjectTypeName(sedan) == "Sedan");
+    CPPUNIT_ASSERT(schema->isA(sedan, car));
+    CPPUNIT_ASSERT(schema->isA(car, car));
+    CPPUNIT_ASSERT(!schema->isA(car, sedan));
+    CPPUNIT_ASSERT(!schema->isA(truck, car));
+
+    CPPUNIT_ASSERT(schema->hasParent("Sedan"));
+    CPPUNIT_ASSERT(schema->getParent("Sedan") == "Car");
+    CPPUNIT_ASSERT(!schema->hasParent(Schema::rootObject()));
+    CPPUNIT_ASSERT(schema->getParent("Sedan.move") == "Car.move");
+    CPPUNIT_ASSERT(schema->hasPredicates("Sedan"));
+    CPPUNIT_ASSERT(!schema->hasPredicates("Building"));
+
+    // Changes to the schema are picked up by the next query
+    schema->addObjectType("Office", "Building");
+    schema->addObjectType("Van", "Truck");
+    schema->addPredicate("Building.open");
+    CPPUNIT_ASSERT(schema->isA("Office", "Building"));
+    CPPUNIT_ASSERT(schema->isA("Van", "Vehicle"));
+    CPPUNIT_ASSERT(!schema->isA("Van", "Car"));
+    CPPUNIT_ASSERT(schema->isA(schema->getObjectTypeId("Van"), schema->getObjectTypeId("Truck")));
+    CPPUNIT_ASSERT(schema->isA("Office.open", "Building.open"));
+    CPPUNIT_ASSERT(schema->isPredicate("Office.open"));
+    CPPUNIT_ASSERT(schema->hasPredicates("Building"));
+
+    DEFAULT_TEARDOWN();
+
+    return true;
+  }
+
   static bool testPredicateParameterAccessors() {
       DEFAULT_SETUP(ce, db, true);
     schema->addObjectType("Reservoir");
@@ -655,6 +720,7 @@ public:
     EUROPA_runTest(testInterleavedDynamicObjetAndVariableCreation);
     EUROPA_runTest(testTokenObjectVariable);
     EUROPA_runTest(testFreeAndConstrain);
+    EUROPA_runTest(testEvalContextSlots);
     return(true);
   }
 
@@ -1165,6 +1231,46 @@ private:
 
     return true;
   }
+
+  static bool testEvalContextSlots(){
+    DEFAULT_SETUP(ce,db,false);
+    Object o1(db->getId(), LabelStr(DEFAULT_OBJECT_TYPE), "o1");
+    IntervalToken t1(db, LabelStr(DEFAULT_PREDICATE), true, false);
+
+    ConstrainedVariableId a = (new Variable<ObjectDomain>(ce, ObjectDomain(GET_DEFAULT_OBJECT_TYPE(ce))))->getId();
+    ConstrainedVariableId b = (new Variable<ObjectDomain>(ce, ObjectDomain(GET_DEFAULT_OBJECT_TYPE(ce))))->getId();
+
+    EvalContext outer(NULL);
+    EvalContext inner(&outer);
+    CPPUNIT_ASSERT(outer.addVar("a", a) == 0);
+    CPPUNIT_ASSERT(outer.addVar("b", b) == 1);
+    CPPUNIT_ASSERT(outer.addToken("t", t1.getId()) == 0);
+    CPPUNIT_ASSERT(inner.addVar("a", b) == 0);
+
+    // Names resolve to the innermost binding, which the coordinates then index directly
+    unsigned int depth = 0, slot = 0;
+    CPPUNIT_ASSERT(inner.resolveVar("a", depth, slot) && depth == 0 && slot == 0);
+    CPPUNIT_ASSERT(inner.getSlotVar(depth, slot) == b);
+    CPPUNIT_ASSERT(inner.resolveVar("b", depth, slot) && depth == 1 && slot == 1);
+    CPPUNIT_ASSERT(inner.getSlotVar(depth, slot) == b);
+    CPPUNIT_ASSERT(inner.resolveToken("t", depth, slot) && depth == 1 && slot == 0);
+    CPPUNIT_ASSERT(inner.getSlotToken(depth, slot) == t1.getId());
+    CPPUNIT_ASSERT(!inner.resolveVar("c", depth, slot));
+    CPPUNIT_ASSERT(inner.getSlotVar(1, 2).isNoId());
+    CPPUNIT_ASSERT(inner.getSlotVar(2, 0).isNoId());
+
+    // Binding a name again keeps its slot, and lookups by name still work
+    CPPUNIT_ASSERT(outer.addVar("a", b) == 0);
+    CPPUNIT_ASSERT(outer.getSlotVar(0, 0) == b);
+    CPPUNIT_ASSERT(inner.getVar("b") == b);
+    CPPUNIT_ASSERT(inner.getToken("t") == t1.getId());
+    CPPUNIT_ASSERT(inner.getVar("c").isNoId());
+
+    delete static_cast<ConstrainedVariable*>(a);
+    delete static_cast<ConstrainedVariable*>(b);
+    DEFAULT_TEARDOWN();
+    return true;
+  }
 };
 
 class TokenTest {
@@ -1184,6 +1290,7 @@ public:
     EUROPA_runTest(testNonChronGNATS2439);
     EUROPA_runTest(testMergingPerformance);
     EUROPA_runTest(testTokenCompatibility);
+    EUROPA_runTest(testCompatibleTokenIndex);
     EUROPA_runTest(testPredicateInheritance);
     EUROPA_runTest(testTokenType);
     EUROPA_runTest(testCorrectSplit_Gnats2450);
@@ -2118,6 +2225,102 @@ private:
     return true;
   }
 
+  /**
+   * Candidates for merging are drawn from an index of active tokens by time and by singleton
+   * values. Make sure the pruned candidates are exactly the compatible ones, in key order, and
+   * that the index follows changes to active tokens.
+   */
+  static bool testCompatibleTokenIndex(){
+    DEFAULT_SETUP(ce, db, false);
+    ObjectId o0 = (new Object(db, LabelStr(DEFAULT_OBJECT_TYPE), "o0"))->getId();
+    ObjectId o1 = (new Object(db, LabelStr(DEFAULT_OBJECT_TYPE), "o1"))->getId();
+    db->close();
+
+    typedef Id<IntervalToken> IntervalTokenId;
+
+    // Active tokens starting at 0, 10, ..., 190, alternating between the objects
+    std::vector<TokenId> actives;
+    for(int i = 0; i < 20; i++){
+      IntervalTokenId t = (new IntervalToken(db,
+                                             LabelStr(DEFAULT_PREDICATE),
+                                             true,
+                                             false,
+                                             IntervalIntDomain(0, 1000),
+                                             IntervalIntDomain(0, 1000),
+                                             IntervalIntDomain(1, 1000),
+                                             Token::noObject(), false))->getId();
+      t->close();
+      t->activate();
+      t->start()->specify(i*10);
+      t->getObject()->specify((i % 2 == 0 ? o0 : o1)->getKey());
+      actives.push_back(t);
+    }
+    CPPUNIT_ASSERT(ce->propagate());
+
+    IntervalToken query(db,
+                        LabelStr(DEFAULT_PREDICATE),
+                        true,
+                        false,
+                        IntervalIntDomain(0, 1000),
+                        IntervalIntDomain(0, 1000),
+                        IntervalIntDomain(1, 1000),
+                        Token::noObject(), false);
+    query.close();
+
+    // Pruned by object
+    query.getObject()->specify(o0->getKey());
+    std::vector<TokenId> compatibleTokens;
+    db->getCompatibleTokens(query.getId(), compatibleTokens);
+    CPPUNIT_ASSERT(compatibleTokens.size() == 10);
+    for(unsigned int i = 0; i < compatibleTokens.size(); i++)
+      CPPUNIT_ASSERT(compatibleTokens[i] == actives[2*i]);
+    CPPUNIT_ASSERT(db->countCompatibleTokens(query.getId(), 3) == 3);
+
+    // Pruned by start time as well
+    query.start()->restrictBaseDomain(IntervalIntDomain(25, 45));
+    compatibleTokens.clear();
+    db->getCompatibleTokens(query.getId(), compatibleTokens);
+    CPPUNIT_ASSERT(compatibleTokens.size() == 1);
+    CPPUNIT_ASSERT(compatibleTokens[0] == actives[4]);
+
+    // Pruned by start time only
+    query.getObject()->reset();
+    compatibleTokens.clear();
+    db->getCompatibleTokens(query.getId(), compatibleTokens);
+    CPPUNIT_ASSERT(compatibleTokens.size() == 2);
+    CPPUNIT_ASSERT(compatibleTokens[0] == actives[3]);
+    CPPUNIT_ASSERT(compatibleTokens[1] == actives[4]);
+
+    // Changes to the active tokens are picked up
+    query.getObject()->specify(o0->getKey());
+    actives[4]->getObject()->reset();
+    actives[4]->getObject()->specify(o1->getKey());
+    actives[6]->start()->reset();
+    actives[6]->start()->specify(30);
+    compatibleTokens.clear();
+    db->getCompatibleTokens(query.getId(), compatibleTokens);
+    CPPUNIT_ASSERT(compatibleTokens.size() == 1);
+    CPPUNIT_ASSERT(compatibleTokens[0] == actives[6]);
+
+    // An object variable which is not a singleton matches any object
+    actives[4]->getObject()->reset();
+    compatibleTokens.clear();
+    db->getCompatibleTokens(query.getId(), compatibleTokens);
+    CPPUNIT_ASSERT(compatibleTokens.size() == 2);
+    CPPUNIT_ASSERT(compatibleTokens[0] == actives[4]);
+    CPPUNIT_ASSERT(compatibleTokens[1] == actives[6]);
+
+    // Deactivated tokens drop out
+    actives[6]->cancel();
+    compatibleTokens.clear();
+    db->getCompatibleTokens(query.getId(), compatibleTokens);
+    CPPUNIT_ASSERT(compatibleTokens.size() == 1);
+    CPPUNIT_ASSERT(compatibleTokens[0] == actives[4]);
+
+    DEFAULT_TEARDOWN();
+    return true;
+  }
+
   static LabelStr encodePredicateNames(const std::vector<TokenId>& tokens){
     std::string str;
     for(std::vector<TokenId>::const_iterator it = tokens.begin(); it != tokens.end(); ++it){
@@ -2877,9 +3080,11 @@ public:
     EUROPA_runTest(testTokenOrderQuery);
     EUROPA_runTest(testEventTokenInsertion);
     EUROPA_runTest(testNoChoicesThatFit);
+    EUROPA_runTest(testOrderingChoicesOnLongTimeline);
     EUROPA_runTest(testAssignment);
     EUROPA_runTest(testFreeAndConstrain);
     EUROPA_runTest(testRemovalOfMasterAndSlave);
+    EUROPA_runTest(testFilteredPlanOutput);
 
     /* The archiving algorithm needs to be rewritten in EUROPA. Or better still, taken out of EUROPA. We can keep these tests for reference but they are both
        incomplete and incorrect. CMG
@@ -3429,6 +3634,142 @@ private:
     return true;
   }
 
+  static unsigned int countOf(const std::string& text, const std::string& pattern){
+    unsigned int count = 0;
+    for(std::string::size_type pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1))
+      count++;
+    return count;
+  }
+
+  static bool testFilteredPlanOutput(){
+    DEFAULT_SETUP(ce, db, false);
+    Timeline timeline(db, LabelStr(DEFAULT_OBJECT_TYPE), "o2");
+    db->close();
+
+    // Two tokens sequenced at [0 10] and [20 30], and one left inactive
+    std::vector<TokenId> tokens;
+    for(int i = 0; i < 3; i++){
+      TokenId t = (new IntervalToken(db,
+                                     LabelStr(DEFAULT_PREDICATE),
+                                     true,
+                                     false,
+                                     IntervalIntDomain(i*20, i*20),
+                                     IntervalIntDomain(i*20 + 10, i*20 + 10),
+                                     IntervalIntDomain(10, 10)))->getId();
+      tokens.push_back(t);
+    }
+    tokens[0]->activate();
+    tokens[1]->activate();
+    timeline.constrain(tokens[0], tokens[1]);
+    CPPUNIT_ASSERT(ce->propagate());
+
+    // The default filter writes the whole plan, as toString does
+    std::ostringstream all;
+    all << PlanDatabaseWriter::Plan(db);
+    CPPUNIT_ASSERT(all.str() == PlanDatabaseWriter::toString(db));
+    CPPUNIT_ASSERT(countOf(all.str(), "Key=") == 3);
+    CPPUNIT_ASSERT(countOf(all.str(), "Inactive Tokens") == 1);
+
+    PlanDatabaseWriter::Filter filter;
+    filter.inactive = false;
+    filter.earliest = 15;
+    std::ostringstream filtered;
+    PlanDatabaseWriter::write(db, filtered, filter);
+    CPPUNIT_ASSERT(countOf(filtered.str(), "Key=") == 1);
+    CPPUNIT_ASSERT(countOf(filtered.str(), "Inactive Tokens") == 0);
+
+    std::ostringstream json;
+    PlanDatabaseWriter::write(db, json, PlanDatabaseWriter::Filter(), PlanDatabaseWriter::JSON_LINES);
+    CPPUNIT_ASSERT(countOf(json.str(), "\n") == 4);
+    CPPUNIT_ASSERT(countOf(json.str(), "{\"kind\":\"object\",\"type\":\"" + std::string(DEFAULT_OBJECT_TYPE) + "\",\"name\":\"o2\"") == 1);
+    CPPUNIT_ASSERT(countOf(json.str(), "\"state\":\"Active\"") == 2);
+    CPPUNIT_ASSERT(countOf(json.str(), "\"start\":[20,20],\"end\":[30,30]") == 1);
+
+    std::ostringstream filteredJson;
+    filteredJson << PlanDatabaseWriter::Plan(db, filter, PlanDatabaseWriter::JSON_LINES);
+    CPPUNIT_ASSERT(countOf(filteredJson.str(), "\"kind\":\"token\"") == 1);
+
+    for(std::vector<TokenId>::const_iterator it = tokens.begin(); it != tokens.end(); ++it)
+      delete static_cast<Token*>(*it);
+    DEFAULT_TEARDOWN();
+    return true;
+  }
+
+  static bool testOrderingChoicesOnLongTimeline(){
+    DEFAULT_SETUP(ce, db, false);
+    Timeline timeline(db, LabelStr(DEFAULT_OBJECT_TYPE), "o2");
+    db->close();
+
+    // Tokens at [0 5], [10 15], ..., [490 495]
+    std::vector<TokenId> tokens;
+    for(int i = 0; i < 50; i++){
+      TokenId t = (new IntervalToken(db,
+                                     LabelStr(DEFAULT_PREDICATE),
+                                     true,
+                                     false,
+                                     IntervalIntDomain(i*10, i*10),
+                                     IntervalIntDomain(i*10 + 5, i*10 + 5),
+                                     IntervalIntDomain(1, 1000)))->getId();
+      t->activate();
+      tokens.push_back(t);
+    }
+
+    // Sequence from the middle outwards, inserting both after and before sequenced tokens
+    timeline.constrain(tokens[24], tokens[25]);
+    for(int i = 26; i < 50; i++)
+      timeline.constrain(tokens[i-1], tokens[i]);
+    for(int i = 23; i >= 0; i--)
+      timeline.constrain(tokens[i], tokens[i+1]);
+    CPPUNIT_ASSERT(ce->propagate());
+    CPPUNIT_ASSERT(std::equal(tokens.begin(), tokens.end(), timeline.getTokenSequence().begin()));
+
+    IntervalToken query(db,
+                        LabelStr(DEFAULT_PREDICATE),
+                        true,
+                        false,
+                        IntervalIntDomain(200, 240),
+                        IntervalIntDomain(203, 250),
+                        IntervalIntDomain(3, 1000));
+    query.activate();
+
+    std::vector<std::pair<TokenId, TokenId> > choices;
+    timeline.getOrderingChoices(query.getId(), choices);
+    CPPUNIT_ASSERT(choices.size() == 4);
+    for(unsigned int i = 0; i < choices.size(); i++){
+      CPPUNIT_ASSERT(choices[i].first == query.getId());
+      CPPUNIT_ASSERT(choices[i].second == tokens[21 + i]);
+    }
+
+    choices.clear();
+    timeline.getOrderingChoices(query.getId(), choices, 2);
+    CPPUNIT_ASSERT(choices.size() == 2);
+    CPPUNIT_ASSERT(choices[1].second == tokens[22]);
+
+    // Removing a token from the middle of the sequence joins the gaps either side of it
+    tokens[22]->cancel();
+    CPPUNIT_ASSERT(ce->propagate());
+    choices.clear();
+    timeline.getOrderingChoices(query.getId(), choices);
+    CPPUNIT_ASSERT(choices.size() == 3);
+    CPPUNIT_ASSERT(choices[0].second == tokens[21]);
+    CPPUNIT_ASSERT(choices[1].second == tokens[23]);
+    CPPUNIT_ASSERT(choices[2].second == tokens[24]);
+
+    // A single gap left
+    query.start()->restrictBaseDomain(IntervalIntDomain(220, 240));
+    query.end()->restrictBaseDomain(IntervalIntDomain(235, 250));
+    choices.clear();
+    timeline.getOrderingChoices(query.getId(), choices);
+    CPPUNIT_ASSERT(choices.size() == 1);
+    CPPUNIT_ASSERT(choices[0].second == tokens[24]);
+
+    for(unsigned int i = 0; i < tokens.size(); i++)
+      delete (Token*) tokens[i];
+
+    DEFAULT_TEARDOWN();
+    return true;
+  }
+
   static bool testAssignment(){
       DEFAULT_SETUP(ce, db, false);
     Timeline o1(db, LabelStr(DEFAULT_OBJECT_TYPE), "tl1");
@@ -3866,6 +4207,18 @@ private:
   }
 };
 
+class ExecutionCounter : public ConstraintEngineListener {
+public:
+  ExecutionCounter(const ConstraintEngineId ce) : ConstraintEngineListener(ce), m_executions(0), m_propagations(0) {}
+  void notifyExecuted(const ConstraintId) {++m_executions;}
+  void notifyPropagationCompleted() {++m_propagations;}
+  unsigned int executions() const {return m_executions;}
+  unsigned int propagations() const {return m_propagations;}
+private:
+  unsigned int m_executions;
+  unsigned int m_propagations;
+};
+
 class DbClientTest {
 public:
   static bool test(){
@@ -3873,6 +4226,9 @@ public:
     EUROPA_runTest(testBasicAllocation);
     EUROPA_runTest(testPathBasedRetrieval);
     EUROPA_runTest(testGlobalVariables);
+    EUROPA_runTest(testBinaryTransactionLog);
+    EUROPA_runTest(testCheckpoints);
+    EUROPA_runTest(testCheckpointedDomains);
     return true;
   }
 private:
@@ -3919,6 +4275,253 @@ private:
     return true;
   }
 
+  static bool testBinaryTransactionLog(){
+    const std::string fileName("binaryTransactions.log");
+
+    // Log the same transactions in both formats
+    std::string xml;
+    {
+      DEFAULT_SETUP(ce, db, false);
+      DbClientId client = db->getClient();
+      client->enableTransactionLogging();
+      std::ofstream binaryOut(fileName.c_str(), std::ios::out | std::ios::binary);
+      DbClientTransactionLog* binaryLog = new DbClientTransactionLog(client, binaryOut);
+      DbClientTransactionLog* xmlLog = new DbClientTransactionLog(client, false);
+
+      client->createObject(LabelStr(DEFAULT_OBJECT_TYPE).c_str(), "foo1");
+      TokenId token = client->createToken(LabelStr(DEFAULT_PREDICATE).c_str());
+      client->activate(token);
+      std::vector<ConstrainedVariableId> scope;
+      scope.push_back(token->start());
+      scope.push_back(token->duration());
+      client->createConstraint("eq", scope);
+      client->specify(token->duration(), 5);
+
+      delete binaryLog;
+      binaryOut.close();
+      std::ostringstream os;
+      xmlLog->flush(os);
+      xml = os.str();
+      delete xmlLog;
+      DEFAULT_TEARDOWN();
+    }
+
+    std::ifstream binaryIn(fileName.c_str(), std::ios::in | std::ios::binary);
+    std::string binary((std::istreambuf_iterator<char>(binaryIn)), std::istreambuf_iterator<char>());
+    CPPUNIT_ASSERT(!binary.empty() && binary.size() < xml.size());
+
+    // Each converts to the other
+    BinaryTransactionReader reader(fileName);
+    std::ostringstream convertedXml;
+    reader.toXml(convertedXml);
+    CPPUNIT_ASSERT(convertedXml.str() == xml);
+    std::istringstream xmlIn(xml);
+    std::ostringstream convertedBinary;
+    BinaryTransactionWriter::fromXml(xmlIn, convertedBinary);
+    CPPUNIT_ASSERT(convertedBinary.str() == binary);
+
+    // Replay into a new database
+    {
+      DEFAULT_SETUP(ce, db, false);
+      db->getClient()->enableTransactionLogging();
+      DbClientTransactionPlayer player(db->getClient());
+      BinaryTransactionReader replay(fileName);
+      player.play(replay);
+      CPPUNIT_ASSERT(db->getObject("foo1").isId());
+      CPPUNIT_ASSERT(db->getTokens().size() == 1);
+      TokenId token = *(db->getTokens().begin());
+      CPPUNIT_ASSERT(token->isActive());
+      CPPUNIT_ASSERT(token->duration()->lastDomain().isSingleton());
+      CPPUNIT_ASSERT(token->duration()->lastDomain().getSingletonValue() == 5);
+      CPPUNIT_ASSERT(token->start()->lastDomain().getSingletonValue() == 5);
+      DEFAULT_TEARDOWN();
+    }
+
+    // Names are written once, other values every time they occur
+    {
+      std::ofstream os(fileName.c_str(), std::ios::out | std::ios::binary);
+      BinaryTransactionWriter writer(os);
+      TiXmlElement tx("value");
+      tx.SetAttribute("type", "aTypeName");
+      tx.SetAttribute("value", "aValue");
+      writer.write(tx);
+      writer.write(tx);
+      tx.SetAttribute("value", "anotherValue");
+      writer.write(tx);
+    }
+    binaryIn.close();
+    binaryIn.open(fileName.c_str(), std::ios::in | std::ios::binary);
+    binary.assign(std::istreambuf_iterator<char>(binaryIn), std::istreambuf_iterator<char>());
+    CPPUNIT_ASSERT(occurrences(binary, "aTypeName") == 1);
+    CPPUNIT_ASSERT(occurrences(binary, "aValue") == 2);
+    CPPUNIT_ASSERT(occurrences(binary, "anotherValue") == 1);
+    {
+      BinaryTransactionReader reader(fileName);
+      std::vector<std::string> values;
+      for (;;) {
+        TiXmlElement tx("");
+        if (!reader.next(tx))
+          break;
+        CPPUNIT_ASSERT(std::string(tx.Value()) == "value");
+        CPPUNIT_ASSERT(std::string(tx.Attribute("type")) == "aTypeName");
+        values.push_back(tx.Attribute("value"));
+      }
+      CPPUNIT_ASSERT(values.size() == 3);
+      CPPUNIT_ASSERT(values[0] == "aValue" && values[1] == "aValue" && values[2] == "anotherValue");
+    }
+
+    std::remove(fileName.c_str());
+    return true;
+  }
+
+  static unsigned int occurrences(const std::string& str, const std::string& part) {
+    unsigned int count = 0;
+    for (std::string::size_type pos = str.find(part); pos != std::string::npos; pos = str.find(part, pos + 1))
+      count++;
+    return count;
+  }
+
+  static bool testCheckpoints(){
+    const std::string fileName("checkpoints.log");
+
+    {
+      DEFAULT_SETUP(ce, db, false);
+      DbClientId client = db->getClient();
+      client->enableTransactionLogging();
+      DbClientTransactionLog* txLog = new DbClientTransactionLog(client);
+      std::ofstream os(fileName.c_str(), std::ios::out | std::ios::binary);
+      BinaryTransactionWriter writer(os);
+
+      client->createObject(LabelStr(DEFAULT_OBJECT_TYPE).c_str(), "foo1");
+      ConstrainedVariableId g = client->createVariable("int", IntervalIntDomain(0, 100), "g");
+      TokenId t1 = client->createToken(LabelStr(DEFAULT_PREDICATE).c_str());
+      client->activate(t1);
+      TokenId t2 = client->createToken(LabelStr(DEFAULT_PREDICATE).c_str());
+      std::vector<ConstrainedVariableId> scope;
+      scope.push_back(t1->duration());
+      scope.push_back(t1->start());
+      client->createConstraint("eq", scope);
+      scope.clear();
+      scope.push_back(t1->start());
+      scope.push_back(g);
+      client->createConstraint("leq", scope);
+      client->specify(t1->duration(), 5);
+      CPPUNIT_ASSERT(client->propagate());
+      txLog->checkpoint(writer);
+
+      // Retract a checkpointed decision and make new ones
+      client->reset(t1->duration());
+      client->specify(t1->duration(), 7);
+      client->activate(t2);
+      client->restrict(t2->duration(), IntervalIntDomain(2, 4));
+      CPPUNIT_ASSERT(client->propagate());
+      txLog->checkpoint(writer);
+
+      os.close();
+      delete txLog;
+      DEFAULT_TEARDOWN();
+    }
+
+    {
+      DEFAULT_SETUP(ce, db, false);
+      db->getClient()->enableTransactionLogging();
+      DbClientTransactionPlayer player(db->getClient());
+      BinaryTransactionReader reader(fileName);
+      ExecutionCounter counter(ce);
+      player.restore(reader);
+      CPPUNIT_ASSERT(db->getObject("foo1").isId());
+      CPPUNIT_ASSERT(db->getTokens().size() == 2);
+      for (TokenSet::const_iterator it = db->getTokens().begin(); it != db->getTokens().end(); ++it)
+        CPPUNIT_ASSERT((*it)->isActive());
+      TokenId t1 = db->getClient()->getTokenByPath(std::vector<unsigned int>(1, 0));
+      TokenId t2 = db->getClient()->getTokenByPath(std::vector<unsigned int>(1, 1));
+      CPPUNIT_ASSERT(t1->duration()->isSpecified());
+      CPPUNIT_ASSERT(t1->duration()->getSpecifiedValue() == 7);
+      CPPUNIT_ASSERT(t2->duration()->baseDomain() == IntervalIntDomain(2, 4));
+
+      // Derived domains are restored as checkpointed, and then settled by a single propagation
+      // in which each constraint runs once, finding nothing to narrow
+      CPPUNIT_ASSERT(ce->constraintConsistent());
+      CPPUNIT_ASSERT(t1->start()->lastDomain() == IntervalIntDomain(7, 7));
+      CPPUNIT_ASSERT(db->getGlobalVariable("g")->lastDomain() == IntervalIntDomain(7, 100));
+      CPPUNIT_ASSERT(counter.propagations() == 1);
+      CPPUNIT_ASSERT(counter.executions() <= ce->getConstraints().size());
+      DEFAULT_TEARDOWN();
+    }
+
+    std::remove(fileName.c_str());
+    return true;
+  }
+
+  static bool testCheckpointedDomains(){
+    const std::string fileName("checkpointedDomains.log");
+
+    {
+      DEFAULT_SETUP(ce, db, false);
+      DbClientId client = db->getClient();
+      client->enableTransactionLogging();
+      DbClientTransactionLog* txLog = new DbClientTransactionLog(client);
+      std::ofstream os(fileName.c_str(), std::ios::out | std::ios::binary);
+      BinaryTransactionWriter writer(os);
+
+      std::vector<ConstrainedVariableId> globals;
+      for (int i = 0; i < 10; i++) {
+        std::stringstream name;
+        name << "g" << i;
+        globals.push_back(client->createVariable("int", IntervalIntDomain(0, 100), name.str().c_str()));
+      }
+      std::vector<ConstrainedVariableId> scope;
+      scope.push_back(globals[0]);
+      scope.push_back(globals[1]);
+      client->createConstraint("leq", scope);
+      CPPUNIT_ASSERT(client->propagate());
+      txLog->checkpoint(writer);
+
+      // Only the domains changed since the last checkpoint are written
+      client->restrict(globals[1], IntervalIntDomain(0, 50));
+      CPPUNIT_ASSERT(client->propagate());
+      txLog->checkpoint(writer);
+      txLog->checkpoint(writer);
+
+      os.close();
+      delete txLog;
+      DEFAULT_TEARDOWN();
+    }
+
+    std::vector<unsigned int> domainCounts;
+    {
+      BinaryTransactionReader reader(fileName);
+      for (;;) {
+        TiXmlElement tx("");
+        if (!reader.next(tx))
+          break;
+        if (std::string(tx.Value()) == "checkpoint")
+          domainCounts.push_back(0);
+        else if (std::string(tx.Value()) == "domain")
+          domainCounts.back()++;
+      }
+    }
+    CPPUNIT_ASSERT(domainCounts.size() == 3);
+    CPPUNIT_ASSERT(domainCounts[0] == 10);
+    CPPUNIT_ASSERT(domainCounts[1] == 2);
+    CPPUNIT_ASSERT(domainCounts[2] == 0);
+
+    {
+      DEFAULT_SETUP(ce, db, false);
+      db->getClient()->enableTransactionLogging();
+      DbClientTransactionPlayer player(db->getClient());
+      BinaryTransactionReader reader(fileName);
+      player.restore(reader);
+      CPPUNIT_ASSERT(db->getGlobalVariable("g0")->lastDomain() == IntervalIntDomain(0, 50));
+      CPPUNIT_ASSERT(db->getGlobalVariable("g1")->baseDomain() == IntervalIntDomain(0, 50));
+      CPPUNIT_ASSERT(db->getGlobalVariable("g2")->lastDomain() == IntervalIntDomain(0, 100));
+      DEFAULT_TEARDOWN();
+    }
+
+    std::remove(fileName.c_str());
+    return true;
+  }
+
   static bool testPathBasedRetrieval(){
       DEFAULT_SETUP(ce, db, false);
       unused(ObjectId timeline) = (new Timeline(db, LabelStr(DEFAULT_OBJECT_TYPE), "o2"))->getId();
@@ -21,6 +21,7 @@
 #include "CESchema.hh"
 
 #include <boost/cast.hpp>
+#include <cstdlib>
 
 namespace EUROPA {
 
@@ -45,7 +46,10 @@ namespace EUROPA {
 void ModuleResource::initialize(EngineId engine) {
   ConstraintEngine* ce = boost::polymorphic_cast<ConstraintEngine*>(engine->getComponent("ConstraintEngine"));
   Schema* schema = boost::polymorphic_cast<Schema*>(engine->getComponent("Schema"));
-  new ProfilePropagator("Resource", ce->getId());
+  ProfilePropagator* profilePropagator = new ProfilePropagator("Resource", ce->getId());
+  const std::string& recomputeThreads = engine->getConfig()->getProperty("Resource.recomputeThreads");
+  if (!recomputeThreads.empty())
+    profilePropagator->setRecomputeThreads(atoi(recomputeThreads.c_str()));
 
   ObjectTypeId objectOT = schema->getObjectType(Schema::rootObject());
   ObjectType* ot;
@@ -111,6 +115,8 @@ void ModuleResource::initialize(EngineId engine) {
   // REGISTER_PROFILE(pfm,FlowProfile, FlowProfile);
   // REGISTER_PROFILE(pfm,IncrementalFlowProfile, IncrementalFlowProfile );
   REGISTER_PROFILE(pfm,GroundedProfile, GroundedProfile );
+  REGISTER_PROFILE(pfm,IncrementalTimetableProfile, IncrementalTimetableProfile );
+  REGISTER_PROFILE(pfm,IncrementalGroundedProfile, IncrementalGroundedProfile );
 
   // Solver
   FactoryMgr* fvdfm = new FactoryMgr();
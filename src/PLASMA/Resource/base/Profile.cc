@@ -31,6 +31,8 @@ Profile::Profile(const PlanDatabaseId db, const FVDetectorId flawDetector)
     , m_removalListener()
     , m_instants()
     , m_recomputeInterval()
+    , m_staged()
+    , m_recomputeInterrupted(false)
     {
     	m_removalListener = (new ConstraintRemovalListener(db->getConstraintEngine(), m_id))->getId();
     }
@@ -543,21 +545,43 @@ void Profile::handleRecompute() {
   debugMsg("Profile:handleRecompute","Invoked");
   debugMsg("Profile:recompute:prePrint", std::endl << toString());
 
-  eint endTime = MINUS_INFINITY;
-  std::pair<edouble,edouble> endDiff(0.0,0.0);
+  stageRecompute();
+  commitRecompute();
+
+  debugMsg("Profile:recompute:postPrint", std::endl << toString());
+}
+
+Profile::StagedRecompute::StagedRecompute()
+    : valid(false), changeCount(0), fromStart(false), instants(), endTime(MINUS_INFINITY), endDiff(0.0,0.0) {}
 
-  if(!m_recomputeInterval->done()) {
+/**
+ * Records the recomputed Instants instead of passing them to the detector. The stored interval
+ * is left untouched, so that the profile can still be recomputed in full if the staged levels
+ * go unused.
+ */
+void Profile::stageRecompute() {
+  checkError(m_recomputeInterval.isValid(),
+             "Attempted to stage levels over an invalid interval.");
+
+  m_staged.valid = false;
+  m_staged.changeCount = m_changeCount;
+  m_staged.fromStart = false;
+  m_staged.instants.clear();
+  m_staged.endTime = MINUS_INFINITY;
+  m_staged.endDiff = std::make_pair(edouble(0.0), edouble(0.0));
+
+  ProfileIterator interval(m_id, m_recomputeInterval->getStartTime(), m_recomputeInterval->getEndTime());
+  if(!interval.done()) {
     InstantId prev = InstantId::noId();
-    bool violation = false;
-    endTime = m_recomputeInterval->getEndTime();
+    eint endTime = interval.getEndTime();
+    std::pair<edouble,edouble>& endDiff = m_staged.endDiff;
+    m_staged.endTime = endTime;
+    m_staged.fromStart = (interval.getInstant()->getTime() == m_instants.begin()->first);
 
-    //if there is no preceding instant, do a clean init
-    if(m_recomputeInterval->getInstant()->getTime() == m_instants.begin()->first) {
+    if(m_staged.fromStart)
       initRecompute();
-      m_detector->initialize();
-    }
     else {
-      InstantId inst = m_recomputeInterval->getInstant();
+      InstantId inst = interval.getInstant();
 
       if (inst->getTime() == endTime) {
         endDiff.first = inst->getLowerLevel();
@@ -565,7 +589,6 @@ void Profile::handleRecompute() {
       }
 
       initRecompute(inst);
-      m_detector->initialize(inst);
 
       if (inst->getTime() == endTime) {
         endDiff.first = inst->getLowerLevel() - endDiff.first;
@@ -573,51 +596,73 @@ void Profile::handleRecompute() {
       }
 
       std::map<eint, InstantId>::iterator it = getGreatestInstant(inst->getTime() - 1);
-      if(it != m_instants.end()) {
+      if(it != m_instants.end())
         prev = it->second;
-      }
-
-      // initRecompute(inst) above also recomputes the levels for the inst, so move forward:
-      // violation = m_detector->detect(inst);
-
-
-      // prev = inst;
-      // m_recomputeInterval->next();
     }
 
-    while(!m_recomputeInterval->done()
-          &&
-          !violation ) {
-      InstantId inst = m_recomputeInterval->getInstant();
+    for(; !interval.done(); interval.next()) {
+      InstantId inst = interval.getInstant();
+      debugMsg("Profile:recompute", "Recomputing levels at instant " << inst->getTime());
 
       if (inst->getTime() == endTime) {
         endDiff.first = inst->getLowerLevel();
         endDiff.second = inst->getUpperLevel();
       }
 
-      debugMsg("Profile:recompute", "Recomputing levels at instant " << inst->getTime());
-      check_error(inst.isValid());
-      recomputeLevels( prev, inst);
+      recomputeLevels(prev, inst);
 
       if (inst->getTime() == endTime) {
         endDiff.first = inst->getLowerLevel() - endDiff.first;
         endDiff.second = inst->getUpperLevel() - endDiff.second;
       }
 
-      violation = m_detector->detect(inst);
-
+      m_staged.instants.push_back(inst);
       prev = inst;
-      m_recomputeInterval->next();
     }
   }
 
-  debugMsg("Profile:recompute:postPrint", std::endl << toString());
+  m_staged.valid = true;
+}
+
+void Profile::commitRecompute() {
+  if(!m_staged.valid || m_staged.changeCount != m_changeCount) {
+    debugMsg("Profile:commitRecompute", "Staged levels are out of date. Recomputing.");
+    m_staged.valid = false;
+    recompute();
+    return;
+  }
+  m_staged.valid = false;
+
+  if(!needsRecompute())
+    return;
+
+  std::pair<edouble,edouble> endDiff(0.0,0.0);
+  bool interrupted = false;
+  if(!m_staged.instants.empty()) {
+    if(m_staged.fromStart)
+      m_detector->initialize();
+    else
+      m_detector->initialize(m_staged.instants.front());
+
+    // Detection stops at the first violation, and the change at the end of the interval is only
+    // carried forward if detection got that far.
+    bool violation = false;
+    std::vector<InstantId>::const_iterator it = m_staged.instants.begin();
+    for(; it != m_staged.instants.end() && !violation; ++it) {
+      if((*it)->getTime() == m_staged.endTime)
+        endDiff = m_staged.endDiff;
+      violation = m_detector->detect(*it);
+    }
+    interrupted = violation && it != m_staged.instants.end();
+  }
+
   debugMsg("Profile:handleRecompute", "Deleting profile iterator " << m_recomputeInterval->getId() );
   delete static_cast<ProfileIterator*>(m_recomputeInterval);
   m_recomputeInterval = ProfileIteratorId::noId();
   m_needsRecompute = false;
+  m_recomputeInterrupted = interrupted;
 
-  postHandleRecompute(endTime,endDiff);
+  postHandleRecompute(m_staged.endTime, endDiff);
 }
 
 void Profile::postHandleRecompute(const eint& endTime,
@@ -23,6 +23,7 @@
 
 #include <map>
 #include <utility>
+#include <vector>
 
 #include <boost/smart_ptr/shared_ptr.hpp>
 
@@ -193,6 +194,21 @@ class Profile : public FactoryObj {
   std::map<eint, InstantId> m_instants; /**< A map from times to Instants. */
   ProfileIteratorId m_recomputeInterval; /**< The stored interval of recomputation.*/
 
+  /**
+   * @brief Levels computed by stageRecompute(), waiting for detection.
+   */
+  struct StagedRecompute {
+    StagedRecompute();
+    bool valid; /**< False unless stageRecompute() completed and commitRecompute() has not run since. */
+    unsigned int changeCount; /**< m_changeCount at the time of staging. */
+    bool fromStart; /**< True if the interval began at the first Instant. */
+    std::vector<InstantId> instants; /**< The recomputed Instants, in time order. */
+    eint endTime;
+    std::pair<edouble,edouble> endDiff;
+  };
+  StagedRecompute m_staged;
+  bool m_recomputeInterrupted; /**< True if the last recomputation stopped at a violation before the end of its interval. */
+
   bool hasTransactions() {return !m_transactions.empty();}
 
   void transactionTimeChanged(const TransactionId e, const DomainListener::ChangeType& change);
@@ -208,8 +224,31 @@ class Profile : public FactoryObj {
    * @brief Recompute the profile.  Iterates over a stored interval of time.
    * It is expected that the first Instant in the interval actually precede the first change
    * so that the flaw and violation detector can be initialized.
+   * Runs stageRecompute() then commitRecompute(), so that the serial and concurrent recomputations share their code.
    */
   void handleRecompute();
+
+  /**
+   * @brief The first half of handleRecompute(): computes the levels over the stored interval of recomputation,
+   * without running the flaw and violation detector. Only safe to run alongside other profiles if
+   * canRecomputeConcurrently().
+   * @see commitRecompute()
+   */
+  void stageRecompute();
+
+  /**
+   * @brief The second half of handleRecompute(): runs the flaw and violation detector over the Instants computed by
+   * stageRecompute(). If the profile changed in between, recomputes it from scratch instead.
+   */
+  void commitRecompute();
+
+  /**
+   * @brief True if initRecompute() and recomputeLevels() only read the domains of the transactions and write this
+   * profile's own Instants, so that several profiles can be staged on different threads at once.
+   * @see ProfilePropagator::setRecomputeThreads()
+   */
+  virtual bool canRecomputeConcurrently() const {return false;}
+
   /**
    * @brief Hanlde invoked at the end of handleRecompute
    */
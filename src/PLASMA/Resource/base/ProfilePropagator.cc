@@ -3,11 +3,111 @@
 #include "Constraint.hh"
 #include "ConstraintEngine.hh"
 #include "Debug.hh"
+#include "Mutex.hh"
 #include "ResourceTokenRelation.hh"
 
 #include <numeric>
+#include <pthread.h>
 
 namespace EUROPA {
+
+/**
+ * @brief A fixed set of threads that stage profiles. The calling thread takes part as well, and
+ * run() returns once every profile has been staged.
+ */
+class ProfilePropagator::RecomputePool {
+private:
+  RecomputePool(const RecomputePool&);
+  RecomputePool& operator=(const RecomputePool&);
+ public:
+  RecomputePool(unsigned int workers);
+  ~RecomputePool();
+  void run(const std::vector<ProfileId>& profiles);
+ private:
+  static void* work(void* pool);
+  void stageAll();
+
+  pthread_mutex_t m_mutex; // Guards all of the below
+  pthread_cond_t m_wake;
+  pthread_cond_t m_done;
+  std::vector<pthread_t> m_threads;
+  const std::vector<ProfileId>* m_profiles;
+  unsigned int m_next;
+  unsigned int m_staged;
+  unsigned long m_round;
+  bool m_stop;
+};
+
+ProfilePropagator::RecomputePool::RecomputePool(unsigned int workers)
+    : m_threads(), m_profiles(NULL), m_next(0), m_staged(0), m_round(0), m_stop(false) {
+  pthread_mutex_init(&m_mutex, NULL);
+  pthread_cond_init(&m_wake, NULL);
+  pthread_cond_init(&m_done, NULL);
+  for(unsigned int i = 0; i < workers; i++) {
+    pthread_t thread;
+    if(pthread_create(&thread, NULL, work, this) == 0)
+      m_threads.push_back(thread);
+  }
+  debugMsg("ProfilePropagator:RecomputePool", "Started " << m_threads.size() << " worker threads");
+}
+
+ProfilePropagator::RecomputePool::~RecomputePool() {
+  {
+    MutexGrabber grabber(m_mutex);
+    m_stop = true;
+    pthread_cond_broadcast(&m_wake);
+  }
+  for(std::vector<pthread_t>::const_iterator it = m_threads.begin(); it != m_threads.end(); ++it)
+    pthread_join(*it, NULL);
+  pthread_cond_destroy(&m_done);
+  pthread_cond_destroy(&m_wake);
+  pthread_mutex_destroy(&m_mutex);
+}
+
+void ProfilePropagator::RecomputePool::run(const std::vector<ProfileId>& profiles) {
+  MutexGrabber grabber(m_mutex);
+  m_profiles = &profiles;
+  m_next = 0;
+  m_staged = 0;
+  m_round++;
+  pthread_cond_broadcast(&m_wake);
+  stageAll();
+  while(m_staged < profiles.size())
+    pthread_cond_wait(&m_done, &m_mutex);
+  m_profiles = NULL;
+}
+
+void* ProfilePropagator::RecomputePool::work(void* arg) {
+  RecomputePool* pool = static_cast<RecomputePool*>(arg);
+  MutexGrabber grabber(pool->m_mutex);
+  unsigned long round = 0;
+  for(;;) {
+    while(!pool->m_stop && pool->m_round == round)
+      pthread_cond_wait(&pool->m_wake, &pool->m_mutex);
+    if(pool->m_stop)
+      break;
+    round = pool->m_round;
+    pool->stageAll();
+  }
+  return NULL;
+}
+
+// Called with m_mutex held, which is released while a profile is staged.
+void ProfilePropagator::RecomputePool::stageAll() {
+  while(m_profiles != NULL && m_next < m_profiles->size()) {
+    ProfileId profile = (*m_profiles)[m_next++];
+    pthread_mutex_unlock(&m_mutex);
+    try {
+      profile->stageRecompute();
+    }
+    catch(...) {
+      // Left unstaged, so the merge recomputes it on the propagating thread
+    }
+    pthread_mutex_lock(&m_mutex);
+    if(++m_staged == m_profiles->size())
+      pthread_cond_signal(&m_done);
+  }
+}
   
 ProfilePropagator::ProfilePropagator(const std::string& name,
                                      const ConstraintEngineId constraintEngine)
@@ -17,10 +117,24 @@ ProfilePropagator::ProfilePropagator(const std::string& name,
     , m_updateRequired(false)
     , m_inBatchMode(false)
     , m_batchListener(NULL)
+    , m_recomputeThreads(1)
+    , m_recomputePool(NULL)
 {
 }
 
-ProfilePropagator::~ProfilePropagator(){}
+ProfilePropagator::~ProfilePropagator(){
+  delete m_recomputePool;
+}
+
+void ProfilePropagator::setRecomputeThreads(unsigned int threads) {
+  if(threads == 0)
+    threads = 1;
+  if(threads == m_recomputeThreads)
+    return;
+  delete m_recomputePool;
+  m_recomputePool = (threads > 1 ? new RecomputePool(threads - 1) : NULL);
+  m_recomputeThreads = threads;
+}
 
 void ProfilePropagator::addProfile(const ProfileId profile) {
   m_profiles.insert(profile);
@@ -91,19 +205,23 @@ void ProfilePropagator::execute() {
   //   m_profiles.insert(listener->getProfile());
   // }
 
-  for(std::set<ProfileId>::iterator it = m_profiles.begin(); it != m_profiles.end(); ++it) {
-    ProfileId profile = *it;
-    check_error(profile.isValid());
-    if( !getConstraintEngine()->provenInconsistent()
-        &&
-        profile->needsRecompute()) {
-      condDebugMsg(profile->getResource() != ResourceId::noId(),
-                   "ProfilePropagator:execute", 
-                   "Recomputing profile " << profile->getResource()->getName());
-      condDebugMsg(profile->getResource() == ResourceId::noId(),
-                   "ProfilePropagator:execute", 
-                   "Recomputing profile " << profile);
-      profile->recompute();
+  if(m_recomputePool != NULL)
+    recomputeProfiles();
+  else {
+    for(std::set<ProfileId>::iterator it = m_profiles.begin(); it != m_profiles.end(); ++it) {
+      ProfileId profile = *it;
+      check_error(profile.isValid());
+      if( !getConstraintEngine()->provenInconsistent()
+          &&
+          profile->needsRecompute()) {
+        condDebugMsg(profile->getResource() != ResourceId::noId(),
+                     "ProfilePropagator:execute", 
+                     "Recomputing profile " << profile->getResource()->getName());
+        condDebugMsg(profile->getResource() == ResourceId::noId(),
+                     "ProfilePropagator:execute", 
+                     "Recomputing profile " << profile);
+        profile->recompute();
+      }
     }
   }
 
@@ -111,6 +229,51 @@ void ProfilePropagator::execute() {
   debugMsg("ProfilePropagator:execute", "Executed ProfilePropagator");
 }
 
+/**
+ * Stages the levels of the profiles that allow it on the pool, then detects flaws and violations,
+ * and recomputes the remaining profiles, serially in the same order as a single threaded execution.
+ */
+void ProfilePropagator::recomputeProfiles() {
+  if(getConstraintEngine()->provenInconsistent())
+    return;
+
+  std::vector<ProfileId> staged;
+  for(std::set<ProfileId>::iterator it = m_profiles.begin(); it != m_profiles.end(); ++it) {
+    ProfileId profile = *it;
+    check_error(profile.isValid());
+    if(profile->needsRecompute() && profile->canRecomputeConcurrently())
+      staged.push_back(profile);
+  }
+
+  // Not worth waking the pool for a single profile
+  if(staged.size() > 1) {
+    debugMsg("ProfilePropagator:execute", "Staging " << staged.size() << " profiles on " << m_recomputeThreads << " threads");
+    m_recomputePool->run(staged);
+  }
+  else
+    staged.clear();
+
+  std::vector<ProfileId>::const_iterator next = staged.begin();
+  for(std::set<ProfileId>::iterator it = m_profiles.begin(); it != m_profiles.end(); ++it) {
+    ProfileId profile = *it;
+    bool isStaged = (next != staged.end() && *next == profile);
+    if(isStaged)
+      ++next;
+    if(getConstraintEngine()->provenInconsistent() || !profile->needsRecompute())
+      continue;
+    condDebugMsg(profile->getResource() != ResourceId::noId(),
+                 "ProfilePropagator:execute",
+                 "Recomputing profile " << profile->getResource()->getName());
+    condDebugMsg(profile->getResource() == ResourceId::noId(),
+                 "ProfilePropagator:execute",
+                 "Recomputing profile " << profile);
+    if(isStaged)
+      profile->commitRecompute();
+    else
+      profile->recompute();
+  }
+}
+
 void ProfilePropagator::execute(const ConstraintId) {
   // Propagator::execute(constraint);
   // if(constraint->getName() == Profile::VariableListener::CONSTRAINT_NAME()) {
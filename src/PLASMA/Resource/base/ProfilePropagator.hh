@@ -28,6 +28,16 @@ private:
   }
   void addProfile(const ProfileId profile);
   void removeProfile(const ProfileId profile);
+
+  /**
+   * @brief Sets the number of threads used to recompute profiles. With more than one, the levels of
+   * the profiles that support it are computed concurrently, and their flaws and violations are then
+   * detected one profile at a time, in the usual order. Defaults to the engine property
+   * Resource.recomputeThreads, or 1.
+   * @see Profile::canRecomputeConcurrently()
+   */
+  void setRecomputeThreads(unsigned int threads);
+  unsigned int getRecomputeThreads() const { return m_recomputeThreads; }
  protected:
   friend class Profile;
   void setUpdateRequired(const bool update) {m_updateRequired = update;}
@@ -37,12 +47,17 @@ private:
   bool updateRequired() const;
   void handleConstraintAdded(const ConstraintId constraint);
   void handleConstraintRemoved(const ConstraintId constraint);
+  void recomputeProfiles();
+
+  class RecomputePool;
 
   std::set<ProfileId> m_profiles;
   std::set<ConstraintId> m_newConstraints;
   bool m_updateRequired;
   bool m_inBatchMode;
   ConstraintEngineListener* m_batchListener;
+  unsigned int m_recomputeThreads;
+  RecomputePool* m_recomputePool;
 };
 }
 
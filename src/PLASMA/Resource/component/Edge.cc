@@ -20,7 +20,8 @@ namespace EUROPA
       m_Capacity( capacity ),
       m_Enabled( enabled ),
       m_Source( source ),
-      m_Target( target )
+      m_Target( target ),
+      m_FlowIndex( ~0u )
     {
       checkError( 0 != source, "Null not allowed as input for source" );
       checkError( 0 != target, "Null not allowed as input for target" );
@@ -20,6 +20,7 @@ private:
   Edge& operator=(const Edge&);
   friend class Graph;
   friend class Node;
+  friend class MaximumFlowAlgorithm;
  public:
   /**
    * @brief Constructor
@@ -95,6 +96,10 @@ private:
 
   Node* m_Source;
   Node* m_Target;
+  /**
+   * @brief Dense index of the invoking edge in the last maximum flow computation.
+   */
+  unsigned int m_FlowIndex;
 };
 
     std::ostream& operator<<( std::ostream& os, const Edge& fe );
@@ -10,6 +10,12 @@ namespace EUROPA {
 GroundedProfile::GroundedProfile(const PlanDatabaseId db, const FVDetectorId flawDetector)
 : TimetableProfile(db, flawDetector) {}
 
+GroundedProfile::GroundedProfile(const PlanDatabaseId db, const FVDetectorId flawDetector, bool incremental)
+: TimetableProfile(db, flawDetector, incremental) {}
+
+IncrementalGroundedProfile::IncrementalGroundedProfile(const PlanDatabaseId db, const FVDetectorId flawDetector)
+: GroundedProfile(db, flawDetector, true) {}
+
 
 void GroundedProfile::handleTransactionStart(bool isConsumer, const edouble & lb, const edouble & ub)
 {
@@ -55,11 +55,22 @@ public:
 	GroundedProfile(const PlanDatabaseId db, const FVDetectorId flawDetector);
 
 protected:
+	GroundedProfile(const PlanDatabaseId db, const FVDetectorId flawDetector, bool incremental);
 
 	// Slight variants on what is done in TimetableProfile:
 	void handleTransactionStart(bool isConsumer, const edouble & lb, const edouble & ub);
 	void handleTransactionEnd(bool isConsumer, const edouble & lb, const edouble & ub);
 };
+
+/**
+ * @class IncrementalGroundedProfile
+ * @brief A GroundedProfile that only recomputes the Instants affected by a change.
+ * @see IncrementalTimetableProfile
+ */
+class IncrementalGroundedProfile : public GroundedProfile {
+public:
+	IncrementalGroundedProfile(const PlanDatabaseId db, const FVDetectorId flawDetector);
+};
 }
 
 #endif
@@ -15,17 +15,30 @@
 
 namespace EUROPA
 {
+const unsigned int MaximumFlowAlgorithm::NO_INDEX;
+
 MaximumFlowAlgorithm::MaximumFlowAlgorithm( Graph* g, Node* source, Node* sink  ):
-    m_CurrentOutEdgeOnNode(),
-    m_EndOutEdgeOnNode(),
-    m_ExcessOnNode(),
-    m_DistanceOnNode(),
-    m_OnEdge(),
-    m_Nodes(),
     m_Graph( g ),
     m_Source( source ),
     m_Sink( sink ),
-    m_NodeListIterator( m_Nodes.end() )
+    m_SourceIndex( NO_INDEX ),
+    m_SinkIndex( NO_INDEX ),
+    m_RelabelsSinceGlobal( 0 ),
+    m_Nodes(),
+    m_FirstArc(),
+    m_CurrentArc(),
+    m_Label(),
+    m_Excess(),
+    m_IsActive(),
+    m_LabelCount(),
+    m_Active(),
+    m_ActiveHead( 0 ),
+    m_ActiveSize( 0 ),
+    m_Edges(),
+    m_Head(),
+    m_Reverse(),
+    m_Capacity(),
+    m_Flow()
 {
   checkError( g != 0, "Null not allowed as input for g" );
   checkError( source != 0, "Null not allowed as input for source" );
@@ -38,38 +51,402 @@ MaximumFlowAlgorithm::MaximumFlowAlgorithm( Graph* g, Node* source, Node* sink
              << *sink );
 }
 
-void MaximumFlowAlgorithm::print( std::ostream& ) const
+void MaximumFlowAlgorithm::print( std::ostream& os ) const
+{
+  for( unsigned int a = 0; a < m_Edges.size(); ++a )
+    os << *m_Edges[ a ] << " flow " << m_Flow[ a ] << std::endl;
+}
+
+edouble MaximumFlowAlgorithm::getMaxFlow() const
+{
+  if( m_SinkIndex == NO_INDEX )
+    return 0.0;
+
+  return m_Excess[ m_SinkIndex ];
+}
+
+edouble MaximumFlowAlgorithm::getFlow( Edge* edge ) const
+{
+  return m_Flow[ arcOf( edge ) ];
+}
+
+edouble MaximumFlowAlgorithm::getResidual( Edge* edge ) const
+{
+  return edge->getCapacity() - getFlow( edge );
+}
+
+unsigned int MaximumFlowAlgorithm::arcOf( Edge* edge ) const
+{
+  unsigned int arc = edge->m_FlowIndex;
+  checkError( arc < m_Edges.size() && m_Edges[ arc ] == edge,
+              "Failed to find flow for edge " << *edge );
+  return arc;
+}
+
+void MaximumFlowAlgorithm::execute( bool reset )
+{
+  graphDebug("Start execute, reset is " << std::boolalpha << reset );
+
+  checkError( m_Source->isEnabled(),"Source '" << *m_Source << "' is not enabled.");
+  checkError( m_Sink->isEnabled(),"Sink '" << *m_Sink << "' is not enabled." );
+
+  build( reset );
+  saturateSource();
+  globalRelabel();
+
+  for( unsigned int v = 0; v < m_Nodes.size(); ++v )
+    activate( v );
+
+  while( m_ActiveSize > 0 )
+  {
+    unsigned int v = m_Active[ m_ActiveHead ];
+    m_ActiveHead = ( m_ActiveHead + 1 ) % m_Active.size();
+    --m_ActiveSize;
+    m_IsActive[ v ] = false;
+
+    discharge( v );
+  }
+
+  graphDebug("End execute, max flow: "
+             << getMaxFlow() );
+}
+
+void MaximumFlowAlgorithm::build( bool reset )
+{
+  std::vector<Node*> oldNodes;
+  std::vector<edouble> oldExcess;
+  std::vector<Edge*> oldEdges;
+  std::vector<edouble> oldFlow;
+
+  oldNodes.swap( m_Nodes );
+  oldExcess.swap( m_Excess );
+  oldEdges.swap( m_Edges );
+  oldFlow.swap( m_Flow );
+
+  m_Nodes.clear();
+  m_Excess.clear();
+  m_Edges.clear();
+  m_Flow.clear();
+  m_FirstArc.clear();
+  m_Head.clear();
+  m_Capacity.clear();
+
+  const NodeIdentity2Node& nodes = m_Graph->getNodes();
+
+  for( NodeIdentity2Node::const_iterator nIte = nodes.begin(); nIte != nodes.end(); ++nIte )
+  {
+    Node* node = (*nIte).second;
+
+    if( !node->isEnabled() )
+      continue;
+
+    unsigned int old = node->m_FlowIndex;
+    node->m_FlowIndex = static_cast<unsigned int>( m_Nodes.size() );
+    m_Nodes.push_back( node );
+    m_Excess.push_back( old < oldNodes.size() && oldNodes[ old ] == node ? oldExcess[ old ] : edouble( 0.0 ) );
+  }
+
+  const unsigned int n = static_cast<unsigned int>( m_Nodes.size() );
+
+  for( unsigned int v = 0; v < n; ++v )
+  {
+    m_FirstArc.push_back( static_cast<unsigned int>( m_Head.size() ) );
+
+    const EdgeList& outEdges = m_Nodes[ v ]->getOutEdges();
+
+    for( EdgeList::const_iterator fIte = outEdges.begin(); fIte != outEdges.end(); ++fIte )
+    {
+      Edge* edge = *fIte;
+
+      if( !edge->isEnabled() )
+        continue;
+
+      unsigned int old = edge->m_FlowIndex;
+      edge->m_FlowIndex = static_cast<unsigned int>( m_Edges.size() );
+      m_Edges.push_back( edge );
+      m_Head.push_back( edge->getTarget()->m_FlowIndex );
+      m_Capacity.push_back( edge->getCapacity() );
+      m_Flow.push_back( old < oldEdges.size() && oldEdges[ old ] == edge ? oldFlow[ old ] : edouble( 0.0 ) );
+    }
+  }
+
+  m_FirstArc.push_back( static_cast<unsigned int>( m_Head.size() ) );
+
+  // Pair every arc with its reverse: while visiting v, arcTo[u] is the arc v->u,
+  // which is the reverse of each in-edge u->v.
+  m_Reverse.assign( m_Head.size(), NO_INDEX );
+  std::vector<unsigned int> arcTo( n, NO_INDEX );
+
+  for( unsigned int v = 0; v < n; ++v )
+  {
+    for( unsigned int a = m_FirstArc[ v ]; a < m_FirstArc[ v + 1 ]; ++a )
+      arcTo[ m_Head[ a ] ] = a;
+
+    const EdgeList& inEdges = m_Nodes[ v ]->getInEdges();
+
+    for( EdgeList::const_iterator fIte = inEdges.begin(); fIte != inEdges.end(); ++fIte )
+    {
+      Edge* edge = *fIte;
+      unsigned int a = edge->m_FlowIndex;
+
+      if( a < m_Edges.size() && m_Edges[ a ] == edge )
+        m_Reverse[ a ] = arcTo[ edge->getSource()->m_FlowIndex ];
+    }
+
+    for( unsigned int a = m_FirstArc[ v ]; a < m_FirstArc[ v + 1 ]; ++a )
+      arcTo[ m_Head[ a ] ] = NO_INDEX;
+  }
+
+  bool consistent = true;
+
+  for( unsigned int a = 0; a < m_Reverse.size(); ++a )
+  {
+    checkError( m_Reverse[ a ] != NO_INDEX,
+                "No (enabled) reverse edge for edge '" << *m_Edges[ a ] << "'");
+
+    if( m_Flow[ a ] > m_Capacity[ a ] || m_Flow[ a ] != -m_Flow[ m_Reverse[ a ] ] )
+      consistent = false;
+  }
+
+  // On a reset the flow kept on the surviving arcs is still a fine starting
+  // point as long as it is a preflow of the current graph, which is the case
+  // after transactions or orderings were only added. Excesses then follow
+  // from the flow alone.
+  if( reset && consistent )
+  {
+    for( unsigned int v = 0; v < n; ++v )
+    {
+      edouble excess = 0.0;
+
+      for( unsigned int a = m_FirstArc[ v ]; a < m_FirstArc[ v + 1 ]; ++a )
+        excess = excess - m_Flow[ a ];
+
+      m_Excess[ v ] = excess;
+
+      if( excess < 0 && m_Nodes[ v ] != m_Source )
+        consistent = false;
+    }
+  }
+
+  // Otherwise start over from the zero flow.
+  if( !consistent )
+  {
+    graphDebug("Kept flow is no longer feasible, resetting");
+    m_Flow.assign( m_Flow.size(), 0.0 );
+    m_Excess.assign( n, 0.0 );
+  }
+
+  m_SourceIndex = m_Source->m_FlowIndex;
+  m_SinkIndex = m_Sink->m_FlowIndex;
+
+  m_CurrentArc.assign( m_FirstArc.begin(), m_FirstArc.end() - 1 );
+  m_Label.assign( n, 0 );
+  m_IsActive.assign( n, false );
+  m_Active.assign( n, 0 );
+  m_ActiveHead = 0;
+  m_ActiveSize = 0;
+}
+
+void MaximumFlowAlgorithm::globalRelabel()
 {
+  const unsigned int n = static_cast<unsigned int>( m_Nodes.size() );
+  const unsigned int unreachable = 2 * n;
+
+  m_Label.assign( n, unreachable );
+  m_LabelCount.assign( unreachable + 1, 0 );
+
+  // Exact distances to the sink in the residual graph, and for nodes that
+  // cannot reach the sink, n plus their distance to the source.
+  const unsigned int roots[ 2 ] = { m_SinkIndex, m_SourceIndex };
+  std::vector<unsigned int> queue;
+  queue.reserve( n );
+
+  for( unsigned int r = 0; r < 2; ++r )
+  {
+    queue.clear();
+    m_Label[ roots[ r ] ] = r * n;
+    queue.push_back( roots[ r ] );
+
+    for( unsigned int i = 0; i < queue.size(); ++i )
+    {
+      unsigned int v = queue[ i ];
 
+      for( unsigned int b = m_FirstArc[ v ]; b < m_FirstArc[ v + 1 ]; ++b )
+      {
+        unsigned int w = m_Head[ b ];
+
+        if( m_Label[ w ] == unreachable && w != m_SourceIndex &&
+            residual( m_Reverse[ b ] ) > 0 )
+        {
+          m_Label[ w ] = m_Label[ v ] + 1;
+          queue.push_back( w );
+        }
+      }
+    }
+  }
+
+  for( unsigned int v = 0; v < n; ++v )
+  {
+    ++m_LabelCount[ m_Label[ v ] ];
+    m_CurrentArc[ v ] = m_FirstArc[ v ];
+  }
+
+  m_RelabelsSinceGlobal = 0;
 }
 
-eint MaximumFlowAlgorithm::distanceOnNode(Node* n) const {
-  Node2Long::const_iterator it = m_DistanceOnNode.find(n);
-  checkError(it != m_DistanceOnNode.end(), "Failed to find distance for " << *n);
-  return it->second;
+void MaximumFlowAlgorithm::saturateSource()
+{
+  for( unsigned int a = m_FirstArc[ m_SourceIndex ]; a < m_FirstArc[ m_SourceIndex + 1 ]; ++a )
+  {
+    edouble r = residual( a );
+
+    graphDebug("Initializing flow from source "
+               << *m_Source << " for edge "
+               << *m_Edges[ a ] << ", flow is "
+               << m_Flow[ a ] << " residual is "
+               << r );
+
+    if( r != 0 )
+    {
+      m_Flow[ a ] = m_Flow[ a ] + r;
+      m_Flow[ m_Reverse[ a ] ] = -m_Flow[ a ];
+      m_Excess[ m_Head[ a ] ] = m_Excess[ m_Head[ a ] ] + r;
+    }
+  }
 }
 
-//edouble MaximumFlowAlgorithm::flow(Edge* e) const {
-//}
+void MaximumFlowAlgorithm::activate( unsigned int v )
+{
+  if( m_IsActive[ v ] || v == m_SourceIndex || v == m_SinkIndex ||
+      !( m_Excess[ v ] > 0 ) || m_Label[ v ] >= 2 * m_Nodes.size() )
+    return;
 
-edouble MaximumFlowAlgorithm::getExcess(Node* n) const {
-  Node2Double::const_iterator it = m_ExcessOnNode.find(n);
-  checkError(it != m_ExcessOnNode.end(), "Failed to find excess for " << *n);
-  return it->second;
+  m_Active[ ( m_ActiveHead + m_ActiveSize ) % m_Active.size() ] = v;
+  ++m_ActiveSize;
+  m_IsActive[ v ] = true;
 }
 
-EdgeList::const_iterator MaximumFlowAlgorithm::currentOutEdgeOnNode(Node* n) const {
-  Node2EdgeListIteratorMap::const_iterator it = m_CurrentOutEdgeOnNode.find(n);
-  checkError(it != m_CurrentOutEdgeOnNode.end(), 
-             "Failed to find a current out-edge iterator for " << *n);
-  return it->second;
+void MaximumFlowAlgorithm::discharge( unsigned int v )
+{
+  graphDebug("Discharge invoked for node "
+             << *m_Nodes[ v ] << " witch excess "
+             << m_Excess[ v ] );
+
+  const unsigned int unreachable = 2 * static_cast<unsigned int>( m_Nodes.size() );
+
+  while( m_Excess[ v ] > 0 )
+  {
+    // Can reach neither sink nor source; happens only to excess stranded
+    // behind disabled nodes, which the profile has already accounted for.
+    if( m_Label[ v ] >= unreachable )
+      return;
+
+    unsigned int a = m_CurrentArc[ v ];
+
+    if( a == m_FirstArc[ v + 1 ] )
+      relabel( v );
+    else if( residual( a ) > 0 && m_Label[ v ] == m_Label[ m_Head[ a ] ] + 1 )
+      push( a );
+    else
+      m_CurrentArc[ v ] = a + 1;
+  }
 }
 
-EdgeList::const_iterator MaximumFlowAlgorithm::endOutEdgeOnNode(Node* n) const {
-  Node2EdgeListIteratorMap::const_iterator it = m_EndOutEdgeOnNode.find(n);
-  checkError(it != m_EndOutEdgeOnNode.end(), 
-             "Failed to find an end out-edge iterator for " << *n);
-  return it->second;
+void MaximumFlowAlgorithm::push( unsigned int a )
+{
+  unsigned int v = m_Head[ m_Reverse[ a ] ];
+  unsigned int w = m_Head[ a ];
+
+  edouble excess = m_Excess[ v ];
+  edouble r = residual( a );
+  edouble delta = ( excess > r ) ? r : excess;
+
+  m_Flow[ a ] = m_Flow[ a ] + delta;
+  m_Flow[ m_Reverse[ a ] ] = -m_Flow[ a ];
+
+  m_Excess[ w ] = m_Excess[ w ] + delta;
+  m_Excess[ v ] = excess - delta;
+
+  graphDebug("Pushed flow "
+             << delta << " on edge "
+             << *m_Edges[ a ] << " makes excess on node "
+             << *m_Nodes[ v ] << " "
+             << m_Excess[ v ] << " and on "
+             << *m_Nodes[ w ] << " "
+             << m_Excess[ w ] );
+
+  activate( w );
+}
+
+void MaximumFlowAlgorithm::relabel( unsigned int v )
+{
+  const unsigned int n = static_cast<unsigned int>( m_Nodes.size() );
+  unsigned int oldLabel = m_Label[ v ];
+  unsigned int newLabel = 2 * n;
+
+  m_CurrentArc[ v ] = m_FirstArc[ v ];
+
+  for( unsigned int a = m_FirstArc[ v ]; a < m_FirstArc[ v + 1 ]; ++a )
+  {
+    if( residual( a ) > 0 && m_Label[ m_Head[ a ] ] + 1 < newLabel )
+    {
+      newLabel = m_Label[ m_Head[ a ] ] + 1;
+      m_CurrentArc[ v ] = a;
+    }
+  }
+
+  graphDebug("(Re)labeled node "
+             << *m_Nodes[ v ] << " from " << oldLabel << " to " << newLabel );
+
+  --m_LabelCount[ oldLabel ];
+  m_Label[ v ] = newLabel;
+  ++m_LabelCount[ newLabel ];
+
+  if( m_LabelCount[ oldLabel ] == 0 && oldLabel < n )
+    gap( oldLabel );
+
+  if( ++m_RelabelsSinceGlobal >= n )
+    globalRelabel();
+}
+
+void MaximumFlowAlgorithm::gap( unsigned int label )
+{
+  // No node is left at this label, so nodes above it cannot reach the sink
+  // any more and have to return their excess to the source.
+  const unsigned int n = static_cast<unsigned int>( m_Nodes.size() );
+
+  for( unsigned int v = 0; v < n; ++v )
+  {
+    if( v != m_SourceIndex && m_Label[ v ] > label && m_Label[ v ] < n )
+    {
+      --m_LabelCount[ m_Label[ v ] ];
+      m_Label[ v ] = n + 1;
+      ++m_LabelCount[ n + 1 ];
+      m_CurrentArc[ v ] = m_FirstArc[ v ];
+    }
+  }
+}
+
+void MaximumFlowAlgorithm::pushFlowBack( Node* node )
+{
+  EdgeInIterator ite( *node );
+
+  for( ; ite.ok(); ++ite )
+  {
+    Edge* edge = *ite;
+    unsigned int a = arcOf( edge );
+
+    edouble flow_pushed_back = m_Flow[ a ];
+
+    if( flow_pushed_back > 0 && edge->getCapacity() != 0 )
+    {
+      unsigned int source = m_Head[ m_Reverse[ a ] ];
+
+      m_Excess[ source ] = m_Excess[ source ] + flow_pushed_back;
+      m_Flow[ a ] = 0.0;
+      m_Flow[ m_Reverse[ a ] ] = 0.0;
+    }
+  }
 }
 
 }
@@ -24,7 +24,8 @@ static const std::string PARAM_DETECTOR_TYPE("detectorType");
 
 namespace {
 bool isValidCombo(const std::string& profileName, const std::string& detectorName) {
-  if(profileName == "GroundedProfile" && detectorName != "GroundedFVDetector")
+  if((profileName == "GroundedProfile" || profileName == "IncrementalGroundedProfile") &&
+     detectorName != "GroundedFVDetector")
     return false;
 
   return true;
@@ -19,6 +19,7 @@ namespace EUROPA
     Node::Node( const NodeIdentity& identity ):
       m_Enabled( true ),
       m_Visit( -1 ),
+      m_FlowIndex( ~0u ),
       m_Identity( identity ),
       m_InEdges(),
       m_OutEdges()
@@ -22,6 +22,7 @@ namespace EUROPA
       friend class Graph;
       friend class EdgeIterator;
       friend class EdgeOutIterator;
+      friend class MaximumFlowAlgorithm;
     public:
       /**
        * @brief Constructor
@@ -67,6 +68,10 @@ namespace EUROPA
 
       bool m_Enabled;
       int m_Visit;
+      /**
+       * @brief Dense index of the invoking node in the last maximum flow computation.
+       */
+      unsigned int m_FlowIndex;
       NodeIdentity m_Identity;
       EdgeList m_InEdges;
       EdgeList m_OutEdges;
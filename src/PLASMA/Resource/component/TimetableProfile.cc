@@ -4,7 +4,212 @@
 #include "ConstrainedVariable.hh"
 #include "Debug.hh"
 
+#include <algorithm>
+
 namespace EUROPA {
+
+/**
+ * @class TimetableProfile::LevelTree
+ * @brief Sums of transaction contributions keyed by time, kept in a treap so that a prefix
+ * sum over time, and the addition or removal of a contribution, take logarithmic time.
+ *
+ * A transaction contributes at the lower bound of its time (what TimetableProfile adds when it
+ * starts) and at the upper bound (what it adds when it ends).  Every quantity the sweep
+ * accumulates is either a sum of these over the times not after an Instant, or over the
+ * times before it.
+ */
+class TimetableProfile::LevelTree {
+public:
+  enum Field {
+    LOWER_LEVEL_MIN = 0,
+    LOWER_LEVEL_MAX,
+    UPPER_LEVEL_MIN,
+    UPPER_LEVEL_MAX,
+    MAX_CONSUMPTION_STARTED, /**< Upper bound of the quantity of consumers, at their start. */
+    MAX_PRODUCTION_STARTED,
+    MIN_CONSUMPTION_ENDED, /**< Lower bound of the quantity of consumers, at their end. */
+    MAX_CONSUMPTION_ENDED,
+    MIN_PRODUCTION_ENDED,
+    MAX_PRODUCTION_ENDED,
+    MIN_CONSUMPTION_SINGULAR, /**< Lower bound of the quantity of consumers with a singleton time. */
+    MIN_PRODUCTION_SINGULAR,
+    FIELD_COUNT
+  };
+
+  struct Sums {
+    edouble v[FIELD_COUNT];
+    Sums() {std::fill(v, v + FIELD_COUNT, edouble(0));}
+    void add(const Sums& other, bool negate) {
+      for(int i = 0; i < FIELD_COUNT; i++) {
+        if(negate)
+          v[i] -= other.v[i];
+        else
+          v[i] += other.v[i];
+      }
+    }
+  };
+
+  LevelTree() : m_root(NULL), m_seed(1), m_contributions() {}
+  ~LevelTree() {clear(m_root);}
+
+  void insert(const TransactionId t, const eint start, const eint end, const Sums& atStart, const Sums& atEnd) {
+    check_error(m_contributions.find(t) == m_contributions.end());
+    Contribution& c = m_contributions[t];
+    c.start = start;
+    c.end = end;
+    c.atStart = atStart;
+    c.atEnd = atEnd;
+    add(m_root, start, atStart, false);
+    add(m_root, end, atEnd, false);
+  }
+
+  /**
+   * @brief Removes the contribution of a transaction.
+   * @return false if the transaction has none.
+   */
+  bool retract(const TransactionId t, eint& start, eint& end) {
+    std::map<TransactionId, Contribution>::iterator it = m_contributions.find(t);
+    if(it == m_contributions.end())
+      return false;
+    start = it->second.start;
+    end = it->second.end;
+    add(m_root, start, it->second.atStart, true);
+    add(m_root, end, it->second.atEnd, true);
+    m_contributions.erase(it);
+    return true;
+  }
+
+  /**
+   * @brief Gets the sums of the contributions before the given time and at it.
+   */
+  void query(const eint time, Sums& before, Sums& at) const {
+    for(Node* node = m_root; node != NULL;) {
+      if(time < node->time)
+        node = node->left;
+      else {
+        if(node->left != NULL)
+          before.add(node->left->total, false);
+        if(time == node->time) {
+          at.add(node->own, false);
+          break;
+        }
+        before.add(node->own, false);
+        node = node->right;
+      }
+    }
+  }
+
+private:
+  struct Node {
+    Node(const eint t, const unsigned int p)
+      : time(t), priority(p), count(0), own(), total(), left(NULL), right(NULL) {}
+    eint time;
+    unsigned int priority;
+    unsigned int count; /**< Contributions at this time.  The node is removed when it drops to 0. */
+    Sums own;
+    Sums total; /**< Sum of own over the subtree. */
+    Node* left;
+    Node* right;
+  };
+
+  struct Contribution {
+    eint start, end;
+    Sums atStart, atEnd;
+  };
+
+  // Deterministic, so that runs are repeatable.
+  unsigned int nextPriority() {
+    m_seed = m_seed * 1103515245u + 12345u;
+    return m_seed;
+  }
+
+  static void update(Node* node) {
+    node->total = node->own;
+    if(node->left != NULL)
+      node->total.add(node->left->total, false);
+    if(node->right != NULL)
+      node->total.add(node->right->total, false);
+  }
+
+  static void rotateRight(Node*& node) {
+    Node* left = node->left;
+    node->left = left->right;
+    left->right = node;
+    update(node);
+    update(left);
+    node = left;
+  }
+
+  static void rotateLeft(Node*& node) {
+    Node* right = node->right;
+    node->right = right->left;
+    right->left = node;
+    update(node);
+    update(right);
+    node = right;
+  }
+
+  static Node* merge(Node* left, Node* right) {
+    if(left == NULL)
+      return right;
+    if(right == NULL)
+      return left;
+    if(left->priority > right->priority) {
+      left->right = merge(left->right, right);
+      update(left);
+      return left;
+    }
+    right->left = merge(left, right->left);
+    update(right);
+    return right;
+  }
+
+  void add(Node*& node, const eint time, const Sums& delta, bool negate) {
+    if(node == NULL) {
+      checkError(!negate, "Retracting a contribution at " << time << " that was never made.");
+      node = new Node(time, nextPriority());
+    }
+    if(time < node->time) {
+      add(node->left, time, delta, negate);
+      if(node->left != NULL && node->left->priority > node->priority) {
+        rotateRight(node);
+        return;
+      }
+    }
+    else if(node->time < time) {
+      add(node->right, time, delta, negate);
+      if(node->right != NULL && node->right->priority > node->priority) {
+        rotateLeft(node);
+        return;
+      }
+    }
+    else {
+      node->own.add(delta, negate);
+      if(!negate)
+        node->count++;
+      else if(--node->count == 0) {
+        Node* old = node;
+        node = merge(node->left, node->right);
+        delete old;
+        return;
+      }
+    }
+    update(node);
+  }
+
+  static void clear(Node* node) {
+    if(node == NULL)
+      return;
+    clear(node->left);
+    clear(node->right);
+    delete node;
+  }
+
+  Node* m_root;
+  unsigned int m_seed;
+  std::map<TransactionId, Contribution> m_contributions;
+};
+
     TimetableProfile::TimetableProfile(const PlanDatabaseId db, const FVDetectorId flawDetector)
     	: Profile(db, flawDetector)
     	, m_lowerLevelMin(0)
@@ -15,11 +220,40 @@ namespace EUROPA {
     	, m_maxPrevConsumption(0)
     	, m_minPrevProduction(0)
     	, m_maxPrevProduction(0)
+    	, m_levels(NULL)
+    	, m_dirty(false)
+    	, m_dirtyStart(0)
+    	, m_dirtyEnd(0)
+    {
+    }
+
+    TimetableProfile::TimetableProfile(const PlanDatabaseId db, const FVDetectorId flawDetector, bool incremental)
+    	: Profile(db, flawDetector)
+    	, m_lowerLevelMin(0)
+    	, m_lowerLevelMax(0)
+    	, m_upperLevelMin(0)
+    	, m_upperLevelMax(0)
+    	, m_minPrevConsumption(0)
+    	, m_maxPrevConsumption(0)
+    	, m_minPrevProduction(0)
+    	, m_maxPrevProduction(0)
+    	, m_levels(incremental ? new LevelTree() : NULL)
+    	, m_dirty(false)
+    	, m_dirtyStart(0)
+    	, m_dirtyEnd(0)
     {
     }
 
+    TimetableProfile::~TimetableProfile() {
+      delete m_levels;
+    }
+
     void TimetableProfile::initRecompute(InstantId inst) {
       checkError(m_recomputeInterval.isValid(), "Attempted to initialize recomputation without a valid starting point!");
+      if(m_levels != NULL) {
+        recomputeLevels(InstantId::noId(), inst);
+        return;
+      }
       m_lowerLevelMin = inst->getLowerLevel();
       m_lowerLevelMax = inst->getLowerLevelMax();
       m_upperLevelMin = inst->getUpperLevelMin();
@@ -44,6 +278,30 @@ namespace EUROPA {
 void TimetableProfile::recomputeLevels( InstantId, InstantId inst) {
   check_error(inst.isValid());
 
+  if(m_levels != NULL) {
+    LevelTree::Sums before, at;
+    m_levels->query(inst->getTime(), before, at);
+    const edouble* b = before.v;
+    const edouble* a = at.v;
+    inst->update(getInitCapacityLb() + b[LevelTree::LOWER_LEVEL_MIN] + a[LevelTree::LOWER_LEVEL_MIN],
+                 getInitCapacityLb() + b[LevelTree::LOWER_LEVEL_MAX] + a[LevelTree::LOWER_LEVEL_MAX],
+                 getInitCapacityUb() + b[LevelTree::UPPER_LEVEL_MIN] + a[LevelTree::UPPER_LEVEL_MIN],
+                 getInitCapacityUb() + b[LevelTree::UPPER_LEVEL_MAX] + a[LevelTree::UPPER_LEVEL_MAX],
+                 a[LevelTree::MIN_CONSUMPTION_SINGULAR],
+                 b[LevelTree::MAX_CONSUMPTION_STARTED] + a[LevelTree::MAX_CONSUMPTION_STARTED] - b[LevelTree::MAX_CONSUMPTION_ENDED],
+                 a[LevelTree::MIN_PRODUCTION_SINGULAR],
+                 b[LevelTree::MAX_PRODUCTION_STARTED] + a[LevelTree::MAX_PRODUCTION_STARTED] - b[LevelTree::MAX_PRODUCTION_ENDED],
+                 b[LevelTree::MIN_CONSUMPTION_ENDED] + a[LevelTree::MIN_CONSUMPTION_ENDED],
+                 b[LevelTree::MAX_CONSUMPTION_STARTED] + a[LevelTree::MAX_CONSUMPTION_STARTED],
+                 b[LevelTree::MIN_PRODUCTION_ENDED] + a[LevelTree::MIN_PRODUCTION_ENDED],
+                 b[LevelTree::MAX_PRODUCTION_STARTED] + a[LevelTree::MAX_PRODUCTION_STARTED],
+                 b[LevelTree::MIN_CONSUMPTION_ENDED], b[LevelTree::MAX_CONSUMPTION_ENDED],
+                 b[LevelTree::MIN_PRODUCTION_ENDED], b[LevelTree::MAX_PRODUCTION_ENDED]);
+    debugMsg("TimetableProfile:recomputeLevels", "Looked up levels at " << inst->getTime() << ": [" <<
+             inst->getLowerLevel() << " " << inst->getUpperLevel() << "]");
+    return;
+  }
+
   edouble maxInstantProduction(0), minInstantProduction(0), maxInstantConsumption(0), minInstantConsumption(0);
   edouble maxCumulativeProduction(m_maxPrevProduction), minCumulativeProduction(m_minPrevProduction);
   edouble maxCumulativeConsumption(m_maxPrevConsumption), minCumulativeConsumption(m_minPrevConsumption);
@@ -150,4 +408,192 @@ void TimetableProfile::recomputeLevels( InstantId, InstantId inst) {
 			m_lowerLevelMax += ub;
 		}
 	}
+
+    bool TimetableProfile::updateLevels(const TransactionId t, eint& start, eint& end) {
+      check_error(m_levels != NULL);
+      bool changed = m_levels->retract(t, start, end);
+      if(m_transactions.find(t) == m_transactions.end() ||
+         t->time()->lastDomain().isEmpty() || t->quantity()->lastDomain().isEmpty())
+        return changed;
+
+      eint newStart = static_cast<eint>(t->time()->lastDomain().getLowerBound());
+      eint newEnd = static_cast<eint>(t->time()->lastDomain().getUpperBound());
+      edouble lb, ub;
+      t->quantity()->lastDomain().getBounds(lb, ub);
+      bool isConsumer = t->isConsumer();
+
+      // The level deltas are whatever the sweep would apply, so subclasses get the same levels either way.
+      edouble lowerLevelMin = m_lowerLevelMin, lowerLevelMax = m_lowerLevelMax;
+      edouble upperLevelMin = m_upperLevelMin, upperLevelMax = m_upperLevelMax;
+      LevelTree::Sums atStart, atEnd;
+      m_lowerLevelMin = m_lowerLevelMax = m_upperLevelMin = m_upperLevelMax = 0;
+      handleTransactionStart(isConsumer, lb, ub);
+      atStart.v[LevelTree::LOWER_LEVEL_MIN] = m_lowerLevelMin;
+      atStart.v[LevelTree::LOWER_LEVEL_MAX] = m_lowerLevelMax;
+      atStart.v[LevelTree::UPPER_LEVEL_MIN] = m_upperLevelMin;
+      atStart.v[LevelTree::UPPER_LEVEL_MAX] = m_upperLevelMax;
+      m_lowerLevelMin = m_lowerLevelMax = m_upperLevelMin = m_upperLevelMax = 0;
+      handleTransactionEnd(isConsumer, lb, ub);
+      atEnd.v[LevelTree::LOWER_LEVEL_MIN] = m_lowerLevelMin;
+      atEnd.v[LevelTree::LOWER_LEVEL_MAX] = m_lowerLevelMax;
+      atEnd.v[LevelTree::UPPER_LEVEL_MIN] = m_upperLevelMin;
+      atEnd.v[LevelTree::UPPER_LEVEL_MAX] = m_upperLevelMax;
+      m_lowerLevelMin = lowerLevelMin;
+      m_lowerLevelMax = lowerLevelMax;
+      m_upperLevelMin = upperLevelMin;
+      m_upperLevelMax = upperLevelMax;
+
+      if(isConsumer) {
+        atStart.v[LevelTree::MAX_CONSUMPTION_STARTED] = ub;
+        atEnd.v[LevelTree::MIN_CONSUMPTION_ENDED] = lb;
+        atEnd.v[LevelTree::MAX_CONSUMPTION_ENDED] = ub;
+        if(newStart == newEnd)
+          atStart.v[LevelTree::MIN_CONSUMPTION_SINGULAR] = lb;
+      }
+      else {
+        atStart.v[LevelTree::MAX_PRODUCTION_STARTED] = ub;
+        atEnd.v[LevelTree::MIN_PRODUCTION_ENDED] = lb;
+        atEnd.v[LevelTree::MAX_PRODUCTION_ENDED] = ub;
+        if(newStart == newEnd)
+          atStart.v[LevelTree::MIN_PRODUCTION_SINGULAR] = lb;
+      }
+      m_levels->insert(t, newStart, newEnd, atStart, atEnd);
+
+      if(changed) {
+        start = std::min(start, newStart);
+        end = std::max(end, newEnd);
+      }
+      else {
+        start = newStart;
+        end = newEnd;
+      }
+      return true;
+    }
+
+    void TimetableProfile::noteChange(const eint start, const eint end) {
+      if(!m_dirty) {
+        m_dirty = true;
+        m_dirtyStart = start;
+        m_dirtyEnd = end;
+      }
+      else {
+        m_dirtyStart = std::min(m_dirtyStart, start);
+        m_dirtyEnd = std::max(m_dirtyEnd, end);
+      }
+      resetRecomputeInterval();
+    }
+
+    void TimetableProfile::resetRecomputeInterval() {
+      if(m_recomputeInterval.isValid()) {
+        debugMsg("TimetableProfile:resetRecomputeInterval", "Deleting profile iterator " << m_recomputeInterval->getId());
+        delete static_cast<ProfileIterator*>(m_recomputeInterval);
+        m_recomputeInterval = ProfileIteratorId::noId();
+      }
+
+      if(m_instants.empty()) {
+        m_recomputeInterval = (new ProfileIterator(getId()))->getId();
+        return;
+      }
+
+      // Start at the Instant preceding the change, so that the detector is initialized from unchanged levels.
+      // With nothing changed, recompute just the last Instant, which is cheap and keeps the interval valid.
+      std::map<eint, InstantId>::const_iterator first = m_instants.end(), last = m_instants.end();
+      --last;
+      if(m_dirty) {
+        first = m_instants.lower_bound(m_dirtyStart);
+        if(first != m_instants.begin())
+          --first;
+        std::map<eint, InstantId>::const_iterator it = m_instants.upper_bound(m_dirtyEnd);
+        if(it != m_instants.begin() && (--it)->first >= first->first)
+          last = it;
+        else
+          last = first;
+      }
+      else
+        first = last;
+      debugMsg("TimetableProfile:resetRecomputeInterval", "Recomputing over [" << first->first << " " << last->first << "]");
+      m_recomputeInterval = (new ProfileIterator(getId(), first->first, last->first))->getId();
+    }
+
+    void TimetableProfile::handleTransactionAdded(const TransactionId e) {
+      if(m_levels == NULL) {
+        Profile::handleTransactionAdded(e);
+        return;
+      }
+      eint start, end;
+      if(updateLevels(e, start, end))
+        noteChange(start, PLUS_INFINITY);
+      else
+        resetRecomputeInterval();
+    }
+
+    void TimetableProfile::handleTransactionRemoved(const TransactionId e) {
+      if(m_levels == NULL) {
+        Profile::handleTransactionRemoved(e);
+        return;
+      }
+      eint start, end;
+      if(updateLevels(e, start, end))
+        noteChange(start, PLUS_INFINITY);
+      else
+        resetRecomputeInterval();
+    }
+
+    void TimetableProfile::handleTransactionTimeChanged(const TransactionId e, const DomainListener::ChangeType& change) {
+      if(m_levels == NULL) {
+        Profile::handleTransactionTimeChanged(e, change);
+        return;
+      }
+      // Once a transaction has both started and ended its contribution doesn't depend on when,
+      // so only the span of its old and new times needs recomputing.
+      eint start, end;
+      if(updateLevels(e, start, end))
+        noteChange(start, end);
+      else
+        resetRecomputeInterval();
+    }
+
+    void TimetableProfile::handleTransactionQuantityChanged(const TransactionId e, const DomainListener::ChangeType& change) {
+      if(m_levels == NULL) {
+        Profile::handleTransactionQuantityChanged(e, change);
+        return;
+      }
+      eint start, end;
+      if(updateLevels(e, start, end))
+        noteChange(start, PLUS_INFINITY);
+      else
+        resetRecomputeInterval();
+    }
+
+    void TimetableProfile::handleTemporalConstraintAdded(const TransactionId predecessor, const unsigned int preArgIndex,
+                                                         const TransactionId successor, const unsigned int sucArgIndex) {
+      // Timetable levels don't depend on the order of transactions.
+      if(m_levels == NULL)
+        Profile::handleTemporalConstraintAdded(predecessor, preArgIndex, successor, sucArgIndex);
+      else
+        resetRecomputeInterval();
+    }
+
+    void TimetableProfile::handleTemporalConstraintRemoved(const TransactionId predecessor, const unsigned int preArgIndex,
+                                                           const TransactionId successor, const unsigned int sucArgIndex) {
+      if(m_levels == NULL)
+        Profile::handleTemporalConstraintRemoved(predecessor, preArgIndex, successor, sucArgIndex);
+      else
+        resetRecomputeInterval();
+    }
+
+    void TimetableProfile::postHandleRecompute(const eint& endTime, const std::pair<edouble,edouble>& endDiff) {
+      // Levels past the interval are already up to date, so there is no difference to carry forward.
+      if(m_levels == NULL) {
+        Profile::postHandleRecompute(endTime, endDiff);
+        return;
+      }
+      // Detection stopped at a violation, so Instants past it may be stale.
+      m_dirty = m_recomputeInterrupted;
+      m_dirtyStart = MINUS_INFINITY;
+      m_dirtyEnd = PLUS_INFINITY;
+    }
+
+    IncrementalTimetableProfile::IncrementalTimetableProfile(const PlanDatabaseId db, const FVDetectorId flawDetector)
+      : TimetableProfile(db, flawDetector, true) {}
 }
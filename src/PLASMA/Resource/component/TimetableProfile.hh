@@ -10,9 +10,17 @@ namespace EUROPA {
     class TimetableProfile : public Profile {
     public:
       TimetableProfile(const PlanDatabaseId db, const FVDetectorId flawDetector);
+      virtual ~TimetableProfile();
 
       void getTransactionsToOrder(const InstantId inst, std::vector<TransactionId>& results);
     protected:
+      /**
+       * @brief Constructor for subclasses.
+       * @param incremental If true, the contribution of each transaction is kept in a search tree over time, so
+       * that a change to a transaction costs a logarithmic update and only the Instants in the interval it
+       * affects are recomputed.  Otherwise every recomputation sweeps the profile from its first Instant.
+       */
+      TimetableProfile(const PlanDatabaseId db, const FVDetectorId flawDetector, bool incremental);
 
     	/**
     	 * @brief Compute level changes when transaction starts at the current instant.
@@ -30,11 +38,63 @@ namespace EUROPA {
       edouble m_minPrevProduction, m_maxPrevProduction;
 
     private:
+      class LevelTree;
+
       void initRecompute(InstantId inst);
       void initRecompute();
 
+      /**
+       * @brief Replaces the contribution of the transaction in the level tree with one computed from its current domains.
+       * @param start Set to the earliest time at which the old or new contribution changes the levels.
+       * @param end Set to the latest such time.  Past it the levels are unchanged if the quantity was not.
+       * @return false if the transaction contributes nothing either before or after the update.
+       */
+      bool updateLevels(const TransactionId t, eint& start, eint& end);
+
+      /**
+       * @brief Extends the interval over which levels must be recomputed.
+       */
+      void noteChange(const eint start, const eint end);
+
+      /**
+       * @brief Replaces the stored interval of recomputation with one over the out of date levels, or over
+       * the last Instant if none are.
+       */
+      void resetRecomputeInterval();
+
+      void handleTransactionAdded(const TransactionId e);
+      void handleTransactionRemoved(const TransactionId e);
+      void handleTransactionTimeChanged(const TransactionId e, const DomainListener::ChangeType& change);
+      void handleTransactionQuantityChanged(const TransactionId e, const DomainListener::ChangeType& change);
+      void handleTemporalConstraintAdded(const TransactionId predecessor, const unsigned int preArgIndex,
+                                         const TransactionId successor, const unsigned int sucArgIndex);
+      void handleTemporalConstraintRemoved(const TransactionId predecessor, const unsigned int preArgIndex,
+                                           const TransactionId successor, const unsigned int sucArgIndex);
+      void postHandleRecompute(const eint& endTime, const std::pair<edouble,edouble>& endDiff);
+
+      LevelTree* m_levels; /**< Contributions of the transactions, if incremental. */
+      bool m_dirty; /**< True if levels in [m_dirtyStart, m_dirtyEnd] are out of date. */
+      eint m_dirtyStart, m_dirtyEnd;
+
     protected:
       virtual void recomputeLevels( InstantId prev, InstantId inst);
+
+      /**
+       * @brief Levels are swept from the transaction domains alone.
+       */
+      virtual bool canRecomputeConcurrently() const {return true;}
+    };
+
+    /**
+     * @class IncrementalTimetableProfile
+     * @brief A TimetableProfile that only recomputes the Instants affected by a change.
+     *
+     * Levels are the same as those of TimetableProfile.  Suited to long horizons with many Instants, where
+     * sweeping the whole profile after every change becomes the bottleneck of a search.
+     */
+    class IncrementalTimetableProfile : public TimetableProfile {
+    public:
+      IncrementalTimetableProfile(const PlanDatabaseId db, const FVDetectorId flawDetector);
     };
 }
 
@@ -12,6 +12,8 @@
 #include "ClosedWorldFVDetector.hh"
 #include "BoostFlowProfile.hh"
 #include "BoostFlowProfileGraph.hh"
+#include "Graph.hh"
+#include "MaxFlow.hh"
 
 #include "Debug.hh"
 #include "Engine.hh"
@@ -1505,6 +1507,222 @@ private:
   }
 };
 
+/**
+ * @brief Tests MaximumFlowAlgorithm directly on small graphs with known maximum flows.
+ */
+class MaxFlowTest {
+public:
+  static bool test() {
+    EUROPA_runTest(testKnownFlow);
+    EUROPA_runTest(testWarmStart);
+    EUROPA_runTest(testGap);
+    return true;
+  }
+private:
+  /**
+   * @brief A graph whose nodes are identified by dummy transactions, like the ones
+   * FlowProfile uses for its source and sink.
+   */
+  class Network {
+  public:
+    Network(ConstraintEngine& ce, unsigned int nodeCount)
+      : m_time(ce.getId(), IntervalIntDomain(0, 0)),
+        m_quantity(ce.getId(), IntervalDomain(0, 0)),
+        m_transactions(), m_graph() {
+      for (unsigned int i = 0; i < nodeCount; i++) {
+        m_transactions.push_back(new Transaction(m_time.getId(), m_quantity.getId(), false, EntityId::noId()));
+        m_graph.createNode(m_transactions.back()->getId());
+      }
+    }
+    ~Network() {
+      for (std::vector<Transaction*>::const_iterator it = m_transactions.begin(); it != m_transactions.end(); ++it)
+        delete *it;
+    }
+    Graph* graph() {return &m_graph;}
+    Node* node(unsigned int i) const {return m_graph.getNode(m_transactions[i]->getId());}
+    Edge* edge(unsigned int i, unsigned int j) const {return m_graph.getEdge(node(i), node(j));}
+    /**
+     * @brief Adds an edge from i to j, and a reverse edge without capacity unless there is one already.
+     */
+    void arc(unsigned int i, unsigned int j, edouble capacity) {
+      m_graph.createEdge(m_transactions[i]->getId(), m_transactions[j]->getId(), capacity);
+      if (edge(j, i) == 0)
+        m_graph.createEdge(m_transactions[j]->getId(), m_transactions[i]->getId(), 0);
+    }
+  private:
+    Variable<IntervalIntDomain> m_time;
+    Variable<IntervalDomain> m_quantity;
+    std::vector<Transaction*> m_transactions;
+    Graph m_graph;
+  };
+
+  /**
+   * @brief Checks capacities, skew symmetry and conservation at every node but source and sink.
+   */
+  static bool isFlow(const MaximumFlowAlgorithm& maxFlow) {
+    const NodeIdentity2Node& nodes = maxFlow.getGraph()->getNodes();
+    for (NodeIdentity2Node::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+      Node* node = it->second;
+      edouble out = 0;
+      for (EdgeOutIterator ite(*node); ite.ok(); ++ite) {
+        Edge* edge = *ite;
+        Edge* reverse = maxFlow.getGraph()->getEdge(edge->getTarget(), edge->getSource());
+        if (maxFlow.getFlow(edge) > edge->getCapacity() ||
+            maxFlow.getFlow(edge) != -maxFlow.getFlow(reverse))
+          return false;
+        out += maxFlow.getFlow(edge);
+      }
+      if (node != maxFlow.getSource() && node != maxFlow.getSink() && out != 0)
+        return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief The network from Cormen et al., figure 26.1, with maximum flow 23.
+   */
+  static void buildCormen(Network& net) {
+    const unsigned int s = 0, v1 = 1, v2 = 2, v3 = 3, v4 = 4, t = 5;
+    net.arc(s, v1, 16);
+    net.arc(s, v2, 13);
+    net.arc(v1, v2, 10);
+    net.arc(v2, v1, 4);
+    net.arc(v1, v3, 12);
+    net.arc(v3, v2, 9);
+    net.arc(v2, v4, 14);
+    net.arc(v4, v3, 7);
+    net.arc(v3, t, 20);
+    net.arc(v4, t, 4);
+  }
+
+  static bool testKnownFlow() {
+    RESOURCE_DEFAULT_SETUP(ce, db, false);
+    {
+      Network net(ce, 6);
+      buildCormen(net);
+
+      MaximumFlowAlgorithm maxFlow(net.graph(), net.node(0), net.node(5));
+      maxFlow.execute();
+      CPPUNIT_ASSERT(maxFlow.getMaxFlow() == 23);
+      CPPUNIT_ASSERT(isFlow(maxFlow));
+      // The minimum cut is {s, v1, v2, v4}, so every edge across it is saturated.
+      CPPUNIT_ASSERT(maxFlow.getResidual(net.edge(1, 3)) == 0);
+      CPPUNIT_ASSERT(maxFlow.getResidual(net.edge(4, 3)) == 0);
+      CPPUNIT_ASSERT(maxFlow.getResidual(net.edge(4, 5)) == 0);
+
+      // Executing again from the kept flow changes nothing.
+      maxFlow.execute();
+      CPPUNIT_ASSERT(maxFlow.getMaxFlow() == 23);
+      CPPUNIT_ASSERT(isFlow(maxFlow));
+    }
+    RESOURCE_DEFAULT_TEARDOWN();
+    return true;
+  }
+
+  /**
+   * @brief Each execution after an edge change must give the same maximum flow as a fresh
+   * algorithm on the changed graph, whether the kept flow is still a preflow or not.
+   */
+  static bool testWarmStart() {
+    RESOURCE_DEFAULT_SETUP(ce, db, false);
+    {
+      Network net(ce, 6);
+      buildCormen(net);
+
+      MaximumFlowAlgorithm maxFlow(net.graph(), net.node(0), net.node(5));
+      maxFlow.execute();
+      CPPUNIT_ASSERT(maxFlow.getMaxFlow() == 23);
+
+      // Raising a capacity keeps the flow feasible, so it is the starting point.
+      // The minimum cut moves to {s, v1, v2}: 12 + 14.
+      net.edge(4, 5)->setCapacity(10);
+      maxFlow.execute();
+      CPPUNIT_ASSERT(maxFlow.getMaxFlow() == 26);
+      CPPUNIT_ASSERT(isFlow(maxFlow));
+      {
+        MaximumFlowAlgorithm fresh(net.graph(), net.node(0), net.node(5));
+        fresh.execute();
+        CPPUNIT_ASSERT(fresh.getMaxFlow() == 26);
+      }
+
+      // Lowering a capacity below its flow makes the kept flow infeasible, so the
+      // algorithm has to start over. The minimum cut is {t}: 5 + 10.
+      net.edge(3, 5)->setCapacity(5);
+      maxFlow.execute();
+      CPPUNIT_ASSERT(maxFlow.getMaxFlow() == 15);
+      CPPUNIT_ASSERT(isFlow(maxFlow));
+
+      // Disabling v4 -> v3, which carries flow, and its reverse. v4 now only reaches
+      // t directly, and the minimum cut is still {t}.
+      net.edge(4, 3)->setDisabled();
+      net.edge(3, 4)->setDisabled();
+      maxFlow.execute();
+      CPPUNIT_ASSERT(maxFlow.getMaxFlow() == 15);
+      CPPUNIT_ASSERT(isFlow(maxFlow));
+
+      // Raising capacities keeps the flow feasible again. v2 -> v3 was only the
+      // reverse of v3 -> v2 so far.
+      net.arc(2, 3, 3);
+      net.edge(4, 5)->setCapacity(20);
+      maxFlow.execute();
+      {
+        MaximumFlowAlgorithm fresh(net.graph(), net.node(0), net.node(5));
+        fresh.execute();
+        CPPUNIT_ASSERT(maxFlow.getMaxFlow() == fresh.getMaxFlow());
+      }
+      // The minimum cut is {s, v1, v2, v3}: v3 -> t 5 and v2 -> v4 14.
+      CPPUNIT_ASSERT(maxFlow.getMaxFlow() == 19);
+      CPPUNIT_ASSERT(isFlow(maxFlow));
+    }
+    RESOURCE_DEFAULT_TEARDOWN();
+    return true;
+  }
+
+  /**
+   * @brief s -> a -> b -> t with a bottleneck into t. Once b has pushed what t takes it is
+   * the only node at its label, so relabeling it leaves a gap, and both a and b have to
+   * return the rest of the excess to the source.
+   */
+  static bool testGap() {
+    RESOURCE_DEFAULT_SETUP(ce, db, false);
+    {
+      const unsigned int s = 0, a = 1, b = 2, t = 3;
+      Network net(ce, 4);
+      net.arc(s, a, 10);
+      net.arc(a, b, 10);
+      net.arc(b, t, 1);
+
+      MaximumFlowAlgorithm maxFlow(net.graph(), net.node(s), net.node(t));
+      maxFlow.execute();
+      CPPUNIT_ASSERT(maxFlow.getMaxFlow() == 1);
+      CPPUNIT_ASSERT(isFlow(maxFlow));
+      CPPUNIT_ASSERT(maxFlow.getFlow(net.edge(s, a)) == 1);
+      CPPUNIT_ASSERT(maxFlow.getFlow(net.edge(a, b)) == 1);
+      CPPUNIT_ASSERT(maxFlow.getFlow(net.edge(b, t)) == 1);
+
+      // The same chain next to an unconstrained one, s -> c -> d -> t: the gap must
+      // only lift the nodes that are cut off.
+      const unsigned int c = 3, d = 4, t2 = 5;
+      Network net2(ce, 6);
+      net2.arc(s, a, 10);
+      net2.arc(a, b, 10);
+      net2.arc(b, t2, 1);
+      net2.arc(s, c, 5);
+      net2.arc(c, d, 5);
+      net2.arc(d, t2, 5);
+
+      MaximumFlowAlgorithm maxFlow2(net2.graph(), net2.node(s), net2.node(t2));
+      maxFlow2.execute();
+      CPPUNIT_ASSERT(maxFlow2.getMaxFlow() == 6);
+      CPPUNIT_ASSERT(isFlow(maxFlow2));
+      CPPUNIT_ASSERT(maxFlow2.getFlow(net2.edge(s, a)) == 1);
+      CPPUNIT_ASSERT(maxFlow2.getFlow(net2.edge(d, t2)) == 5);
+    }
+    RESOURCE_DEFAULT_TEARDOWN();
+    return true;
+  }
+};
+
 class FVDetectorTest {
 public:
   static bool test() {
@@ -1571,6 +1789,11 @@ void FlowProfileModuleTests::flowProfileTests(void)
   FlowProfileTest::test();
 }
 
+void FlowProfileModuleTests::maxFlowTests(void)
+{
+  MaxFlowTest::test();
+}
+
 void FlowProfileModuleTests::FVDetectorTests(void)
 {
   FVDetectorTest::test();
@@ -6,25 +6,27 @@
 #include <cppunit/extensions/HelperMacros.h>
 
 class FlowProfileModuleTests : public CppUnit::TestFixture {
-  CPPUNIT_TEST_SUITE(FlowProfileModuleTests);
+  CPPUNIT_TEST_SUITE(FlowProfileModuleTests);
   // CPPUNIT_TEST(defaultSetupTests);
   CPPUNIT_TEST(flowProfileTests);
+  CPPUNIT_TEST(maxFlowTests);
   // CPPUNIT_TEST(FVDetectorTests);
-  CPPUNIT_TEST_SUITE_END();
+  CPPUNIT_TEST_SUITE_END();
 
-public:
-  void setUp()
+public:
+  void setUp()
   {
-    FlowProfileModuleTests::cppSetup();
-  }
-
-  void tearDown()
+    FlowProfileModuleTests::cppSetup();
+  }
+
+  void tearDown()
   {
-  }
-
+  }
+
   void cppSetup(void);
   void defaultSetupTests(void);
   void flowProfileTests(void);
+  void maxFlowTests(void);
   void FVDetectorTests(void);
 };
 
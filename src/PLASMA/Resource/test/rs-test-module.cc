@@ -257,6 +257,8 @@ public:
     EUROPA_runTest(testCorrectTransactionAllocation);
     EUROPA_runTest(testLevelCalculation);
     EUROPA_runTest(testTransactionUpdates);
+    EUROPA_runTest(testParallelRecompute);
+    EUROPA_runTest(testIncrementalLevelCalculation);
     //testTransactionRemoval only relevent for tokens--use to test reservoir
     EUROPA_runTest(testIntervalCapacityValues);
     //violation tests
@@ -288,6 +290,45 @@ private:
     return true;
   }
 
+  static void checkSameLevels(ProfileId expected, ProfileId actual) {
+    expected->recompute();
+    actual->recompute();
+    CPPUNIT_ASSERT(expected->getInstants().size() == actual->getInstants().size());
+    ProfileIterator it2(actual);
+    for(ProfileIterator it1(expected); !it1.done(); it1.next(), it2.next()) {
+      InstantId i1 = it1.getInstant();
+      InstantId i2 = it2.getInstant();
+      CPPUNIT_ASSERT(i1->getTime() == i2->getTime());
+      CPPUNIT_ASSERT(i1->getLowerLevel() == i2->getLowerLevel());
+      CPPUNIT_ASSERT(i1->getLowerLevelMax() == i2->getLowerLevelMax());
+      CPPUNIT_ASSERT(i1->getUpperLevelMin() == i2->getUpperLevelMin());
+      CPPUNIT_ASSERT(i1->getUpperLevel() == i2->getUpperLevel());
+      CPPUNIT_ASSERT(i1->getMaxInstantConsumption() == i2->getMaxInstantConsumption());
+      CPPUNIT_ASSERT(i1->getMinInstantProduction() == i2->getMinInstantProduction());
+      CPPUNIT_ASSERT(i1->getMaxCumulativeConsumption() == i2->getMaxCumulativeConsumption());
+      CPPUNIT_ASSERT(i1->getMinCumulativeProduction() == i2->getMinCumulativeProduction());
+      CPPUNIT_ASSERT(i1->getMaxPrevConsumption() == i2->getMaxPrevConsumption());
+    }
+  }
+  /**
+   * @brief Builds a profile over copies of the transactions of the given one and recomputes it on this
+   * thread, without propagation, then checks that the levels of both are the same.
+   */
+  static void checkSameAsSerial(const PlanDatabaseId db, const FVDetectorId detector, ProfileId prof) {
+    std::set<TransactionId> transactions;
+    for(ProfileIterator it(prof); !it.done(); it.next())
+      transactions.insert(it.getInstant()->getTransactions().begin(), it.getInstant()->getTransactions().end());
+
+    TimetableProfile serial(db, detector);
+    BareTransactionDeleter deleter(serial);
+    std::vector<TransactionPtr> copies;
+    for(std::set<TransactionId>::const_iterator it = transactions.begin(); it != transactions.end(); ++it) {
+      copies.push_back(TransactionPtr(new Transaction((*it)->time(), (*it)->quantity(), (*it)->isConsumer(),
+                                                      EntityId::noId()), deleter));
+      serial.addTransaction(copies.back()->getId());
+    }
+    checkSameLevels(serial.getId(), prof);
+  }
   static edouble checkLevelArea(ProfileId prof) {
     prof->recompute();
     edouble area = 0;
@@ -681,6 +722,110 @@ private:
     return(true);
   }
 
+  static bool testParallelRecompute()
+  {
+    RESOURCE_DEFAULT_SETUP(ce,db,false);
+
+    ProfilePropagator* propagator =
+      id_cast<ProfilePropagator>(ce.getPropagatorByName(ProfilePropagator::PROPAGATOR_NAME()));
+    propagator->setRecomputeThreads(3);
+    CPPUNIT_ASSERT(propagator->getRecomputeThreads() == 3);
+
+    DummyDetector detector(ResourceId::noId());
+    TimetableProfile r1(db.getId(), detector.getId());
+    TimetableProfile r2(db.getId(), detector.getId());
+    BareTransactionDeleter deleter1(r1);
+    BareTransactionDeleter deleter2(r2);
+
+    Variable<IntervalIntDomain> t1(ce.getId(), IntervalIntDomain(0, 1));
+    Variable<IntervalDomain> q1(ce.getId(), IntervalDomain(1, 1));
+    TransactionPtr trans1(new Transaction(t1.getId(), q1.getId(), false, EntityId::noId()), deleter1);
+    r1.addTransaction(trans1->getId());
+    Variable<IntervalIntDomain> t2(ce.getId(), IntervalIntDomain(1, 3));
+    Variable<IntervalDomain> q2(ce.getId(), IntervalDomain(4, 4));
+    TransactionPtr trans2(new Transaction(t2.getId(), q2.getId(), true, EntityId::noId()), deleter1);
+    r1.addTransaction(trans2->getId());
+
+    Variable<IntervalIntDomain> t3(ce.getId(), IntervalIntDomain(2, 4));
+    Variable<IntervalDomain> q3(ce.getId(), IntervalDomain(8, 8));
+    TransactionPtr trans3(new Transaction(t3.getId(), q3.getId(), false, EntityId::noId()), deleter2);
+    r2.addTransaction(trans3->getId());
+    Variable<IntervalIntDomain> t4(ce.getId(), IntervalIntDomain(3, 6));
+    Variable<IntervalDomain> q4(ce.getId(), IntervalDomain(2, 2));
+    TransactionPtr trans4(new Transaction(t4.getId(), q4.getId(), false, EntityId::noId()), deleter2);
+    r2.addTransaction(trans4->getId());
+
+    // Both profiles are staged on the pool and must come out as if recomputed one by one
+    ce.propagate();
+    checkSameAsSerial(db.getId(), detector.getId(), r1.getId());
+    checkSameAsSerial(db.getId(), detector.getId(), r2.getId());
+    CPPUNIT_ASSERT(checkLevelArea(r1.getId()) == (1 + 4*2));
+
+    t3.restrictBaseDomain(IntervalIntDomain(2, 2));
+    ce.propagate();
+    checkSameAsSerial(db.getId(), detector.getId(), r1.getId());
+    checkSameAsSerial(db.getId(), detector.getId(), r2.getId());
+
+    propagator->setRecomputeThreads(1);
+    RESOURCE_DEFAULT_TEARDOWN();
+    return(true);
+  }
+
+  static bool testIncrementalLevelCalculation()
+  {
+    RESOURCE_DEFAULT_SETUP(ce,db,false);
+
+    DummyDetector detector(ResourceId::noId());
+    TimetableProfile r1(db.getId(), detector.getId());
+    IncrementalTimetableProfile r2(db.getId(), detector.getId());
+    BareTransactionDeleter deleter1(r1);
+    BareTransactionDeleter deleter2(r2);
+
+    Variable<IntervalIntDomain> t1(ce.getId(), IntervalIntDomain(0, 5));
+    Variable<IntervalDomain> q1(ce.getId(), IntervalDomain(1, 3));
+    Variable<IntervalIntDomain> t2(ce.getId(), IntervalIntDomain(2, 8));
+    Variable<IntervalDomain> q2(ce.getId(), IntervalDomain(4, 4));
+    Variable<IntervalIntDomain> t3(ce.getId(), IntervalIntDomain(4, 4));
+    Variable<IntervalDomain> q3(ce.getId(), IntervalDomain(2, 6));
+    Transaction trans1(t1.getId(), q1.getId(), false, EntityId::noId());
+    Transaction trans2(t2.getId(), q2.getId(), true, EntityId::noId());
+    Transaction trans3(t3.getId(), q3.getId(), true, EntityId::noId());
+    r1.addTransaction(trans1.getId());
+    r1.addTransaction(trans2.getId());
+    r1.addTransaction(trans3.getId());
+    r2.addTransaction(trans1.getId());
+    r2.addTransaction(trans2.getId());
+    r2.addTransaction(trans3.getId());
+    ce.propagate();
+    checkSameLevels(r1.getId(), r2.getId());
+
+    t2.specify(6);
+    ce.propagate();
+    checkSameLevels(r1.getId(), r2.getId());
+
+    q1.specify(2);
+    t1.restrictBaseDomain(IntervalIntDomain(3, 5));
+    ce.propagate();
+    checkSameLevels(r1.getId(), r2.getId());
+
+    t2.reset();
+    q1.reset();
+    ce.propagate();
+    checkSameLevels(r1.getId(), r2.getId());
+
+    r1.removeTransaction(trans3.getId());
+    r2.removeTransaction(trans3.getId());
+    ce.propagate();
+    checkSameLevels(r1.getId(), r2.getId());
+
+    r1.removeTransaction(trans1.getId());
+    r1.removeTransaction(trans2.getId());
+    r2.removeTransaction(trans1.getId());
+    r2.removeTransaction(trans2.getId());
+    RESOURCE_DEFAULT_TEARDOWN();
+    return(true);
+  }
+
   static bool testTransactionUpdates()
   {
     RESOURCE_DEFAULT_SETUP(ce,db,false);
@@ -38,9 +38,9 @@ void ModuleRulesEngine::initialize(EngineId engine) {
   RulesEngine* re = new RulesEngine(rs->getId(),pdb->getId());
   engine->addComponent("RulesEngine",re);
 
-  // Allocate an instance of Default Propagator to handle rule related constraint propagation.
+  // Allocate an agenda propagator (as configured) to handle rule related constraint propagation.
   // Will be cleaned up automatically by the ConstraintEngine
-  new DefaultPropagator("RulesEngine", pdb->getConstraintEngine(), SYSTEM_PRIORITY);
+  createAgendaPropagator(*engine->getConfig(), "RulesEngine", pdb->getConstraintEngine(), SYSTEM_PRIORITY);
 
   CESchema* ces = boost::polymorphic_cast<CESchema*>(engine->getComponent("CESchema"));
   REGISTER_SYSTEM_CONSTRAINT(ces,ProxyVariableRelation, "proxyRelation", "Default");
@@ -11,6 +11,7 @@
 #include "Debug.hh"
 #include "ProxyVariableRelation.hh"
 #include "Domains.hh"
+#include <algorithm>
 #include <sstream>
 
 #include <boost/algorithm/string.hpp>
@@ -22,7 +23,7 @@ RuleInstance::RuleInstance(const RuleId rule, const TokenId token,
       m_parent(), m_guards(),
       m_guardDomain(0), m_guardListener(), m_isExecuted(false), m_isPositive(true),
       m_constraints(), m_childRules(), m_variables(), m_slaves(), 
-      m_variablesByName(), m_slavesByName(),
+      m_variablesByName(), m_variableBindings(), m_slavesByName(), m_slaveBindings(),
       m_constraintsByName() {
   check_error(rule.isValid(), "Parent must be a valid rule id.");
   check_error(isValid());
@@ -35,8 +36,8 @@ RuleInstance::RuleInstance(const RuleId rule, const TokenId token,
     : m_id(this), m_rule(rule), m_token(token), m_planDb(planDb), m_rulesEngine(),
       m_parent(), m_guards(),
       m_guardDomain(0), m_guardListener(), m_isExecuted(false), m_isPositive(true),
-      m_constraints(), m_childRules(), m_variables(), m_slaves(), m_variablesByName(),
-      m_slavesByName(), m_constraintsByName() {
+      m_constraints(), m_childRules(), m_variables(), m_slaves(), m_variablesByName(), m_variableBindings(),
+      m_slavesByName(), m_slaveBindings(), m_constraintsByName() {
   check_error(isValid());
   setGuard(guards);
   commonInit();
@@ -48,8 +49,8 @@ RuleInstance::RuleInstance(const RuleId rule, const TokenId token,
     : m_id(this), m_rule(rule), m_token(token), m_planDb(planDb), m_rulesEngine(),
       m_parent(), m_guards(),
       m_guardDomain(0), m_guardListener(), m_isExecuted(false), m_isPositive(true),
-      m_constraints(), m_childRules(), m_variables(), m_slaves(), m_variablesByName(), 
-      m_slavesByName(), m_constraintsByName() {
+      m_constraints(), m_childRules(), m_variables(), m_slaves(), m_variablesByName(), m_variableBindings(), 
+      m_slavesByName(), m_slaveBindings(), m_constraintsByName() {
   check_error(isValid());
   setGuard(guard, domain);
   commonInit();
@@ -64,7 +65,7 @@ RuleInstance::RuleInstance(const RuleInstanceId parent,
       m_planDb(parent->getPlanDatabase()),m_rulesEngine() , m_parent(parent), 
       m_guards(), m_guardDomain(0), m_guardListener(), m_isExecuted(false),
       m_isPositive(true), m_constraints(), m_childRules(), m_variables(), m_slaves(), 
-      m_variablesByName(), m_slavesByName(), m_constraintsByName() {
+      m_variablesByName(), m_variableBindings(), m_slavesByName(), m_slaveBindings(), m_constraintsByName() {
   check_error(isValid());
   setGuard(guards);
 }
@@ -79,7 +80,7 @@ RuleInstance::RuleInstance(const RuleInstanceId parent,
       m_planDb(parent->getPlanDatabase()), m_rulesEngine(), m_parent(parent), 
       m_guards(), m_guardDomain(0), m_guardListener(), m_isExecuted(false),
       m_isPositive(positive), m_constraints(), m_childRules(), m_variables(),
-      m_slaves(), m_variablesByName(), m_slavesByName(), m_constraintsByName() {
+      m_slaves(), m_variablesByName(), m_variableBindings(), m_slavesByName(), m_slaveBindings(), m_constraintsByName() {
   check_error(isValid());
   setGuard(guards);
 }
@@ -93,7 +94,7 @@ RuleInstance::RuleInstance(const RuleInstanceId parent,
       m_planDb(parent->getPlanDatabase()), m_rulesEngine(), m_parent(parent),
       m_guards(), m_guardDomain(0), m_guardListener(), m_isExecuted(false),
       m_isPositive(true), m_constraints(), m_childRules(), m_variables(), m_slaves(),
-      m_variablesByName(), m_slavesByName(), m_constraintsByName() {
+      m_variablesByName(), m_variableBindings(), m_slavesByName(), m_slaveBindings(), m_constraintsByName() {
   check_error(isValid());
   setGuard(guard, domain);
 }
@@ -108,7 +109,7 @@ RuleInstance::RuleInstance(const RuleInstanceId parent,
       m_planDb(parent->getPlanDatabase()), m_rulesEngine(), m_parent(parent), 
       m_guards(), m_guardDomain(0), m_guardListener(), m_isExecuted(false),
       m_isPositive(positive), m_constraints(), m_childRules(), m_variables(), 
-      m_slaves(), m_variablesByName(), m_slavesByName(), m_constraintsByName() {
+      m_slaves(), m_variablesByName(), m_variableBindings(), m_slavesByName(), m_slaveBindings(), m_constraintsByName() {
   check_error(isValid());
   setGuard(guard, domain);
 }
@@ -121,7 +122,7 @@ RuleInstance::RuleInstance(const RuleInstanceId parent,
       m_planDb(parent->getPlanDatabase()), m_rulesEngine(), m_parent(parent), 
       m_guards(), m_guardDomain(0), m_guardListener(), m_isExecuted(false),
       m_isPositive(positive), m_constraints(), m_childRules(), m_variables(), 
-      m_slaves(), m_variablesByName(), m_slavesByName(), m_constraintsByName() {
+      m_slaves(), m_variablesByName(), m_variableBindings(), m_slavesByName(), m_slaveBindings(), m_constraintsByName() {
   check_error(isValid());
   setGuard(guard, domain, guardComponents);
 }
@@ -287,14 +288,14 @@ void RuleInstance::undo() {
 
   if(!Entity::isPurging()){
     m_rulesEngine->notifyUndone(getId());
-    // Clear slave lookups
-    m_slavesByName.clear();
+    // Clear slave lookups. The names keep their slots, in case the rule fires again
+    std::fill(m_slaveBindings.begin(), m_slaveBindings.end(), TokenId::noId());
 
     // Clear variable lookups - may include token variables so we have to be careful
     for(std::vector<ConstrainedVariableId>::const_iterator it = m_variables.begin(); it != m_variables.end(); ++it){
       ConstrainedVariableId var = *it;
       checkError(var.isValid(), var);
-      m_variablesByName.erase(var->getName());
+      unbindVariable(var->getName());
     }
 
     // Copy collection to avoid iterator changing due to call back
@@ -407,16 +408,13 @@ ConstrainedVariableId RuleInstance::addVariable( const Domain& baseDomain,
   // looping construct used to implement the 'foreach' semantics. Therefore, we overwrite the old
   // value with the new value.
   if(!getVariable(name).isNoId()) {
-    m_variablesByName.erase(name);
+    unbindVariable(name);
 
     // Also erase all variables that may be derived from the variable we're removing
     std::string prefix = name + ".";
-    std::map<std::string,ConstrainedVariableId>::iterator it = m_variablesByName.begin();
-    while (it != m_variablesByName.end()) {
-      std::string varName = it->first;
-      ++it;
-      if (varName.find(prefix)==0)
-        m_variablesByName.erase(varName);
+    for(std::map<std::string, unsigned int>::const_iterator it = m_variablesByName.begin(); it != m_variablesByName.end(); ++it) {
+      if (it->first.find(prefix)==0)
+        m_variableBindings[it->second] = ConstrainedVariableId::noId();
     }
   }
 
@@ -436,28 +434,44 @@ ConstrainedVariableId RuleInstance::addVariable( const Domain& baseDomain,
 
   void RuleInstance::addVariable(const ConstrainedVariableId var, const std::string& name){
     check_error(var.isValid(), "Tried to add invalid variable " + name);
-    m_variablesByName.insert(std::make_pair(name, var));
+    bindVariable(name, var);
     getToken()->addLocalVariable(var);
   }
 
+  /**
+   * @brief Bind a name that is not bound yet. A name that is keeps its variable, as with
+   * inserting into a map.
+   */
+void RuleInstance::bindVariable(const std::string& name, const ConstrainedVariableId var) {
+  std::pair<std::map<std::string, unsigned int>::iterator, bool> result =
+      m_variablesByName.insert(std::make_pair(name, static_cast<unsigned int>(m_variableBindings.size())));
+  if(result.second)
+    m_variableBindings.push_back(var);
+  else if(m_variableBindings[result.first->second].isNoId())
+    m_variableBindings[result.first->second] = var;
+}
+
+void RuleInstance::unbindVariable(const std::string& name) {
+  std::map<std::string, unsigned int>::const_iterator it = m_variablesByName.find(name);
+  if(it != m_variablesByName.end())
+    m_variableBindings[it->second] = ConstrainedVariableId::noId();
+}
+
   /**
    * This is going to be slow as we iterate over a load of variables and do string manipulate in them. Could optimize
    * if this seems a problem.
    */
 void RuleInstance::clearLoopVar(const std::string& loopVarName){
-  std::map<std::string, ConstrainedVariableId>::iterator it = m_variablesByName.begin();
-  while (it != m_variablesByName.end()){
+  for(std::map<std::string, unsigned int>::const_iterator it = m_variablesByName.begin(); it != m_variablesByName.end(); ++it){
     const std::string& name = it->first;
-    const ConstrainedVariableId var = it->second;
+    const ConstrainedVariableId var = m_variableBindings[it->second];
     // If we get a match straight away, remove the entry.
-    if(var->parent() == getId() &&
+    if(var.isId() && var->parent() == getId() &&
        (name == loopVarName ||
         //(name.countElements(".") > 0 && loopVarName == name.getElement(0, "."))
         (name.find('.') != std::string::npos && loopVarName == name.substr(0, name.find('.')))
         ))
-      m_variablesByName.erase(it++);
-    else
-      ++it;
+      m_variableBindings[it->second] = ConstrainedVariableId::noId();
   }
 }
 
@@ -474,9 +488,12 @@ void RuleInstance::clearLoopVar(const std::string& loopVarName){
 
     // As with adding variables, we have to handle case of re-use of name when executing the inner
     // loop of 'foreach'
-    m_slavesByName.erase(name);
-
-    m_slavesByName.insert(std::make_pair(name, slave->getId()));
+    std::pair<std::map<std::string, unsigned int>::iterator, bool> result =
+        m_slavesByName.insert(std::make_pair(name, static_cast<unsigned int>(m_slaveBindings.size())));
+    if(result.second)
+      m_slaveBindings.push_back(slave->getId());
+    else
+      m_slaveBindings[result.first->second] = slave->getId();
     return addSlave(slave);
   }
 
@@ -513,12 +530,9 @@ void RuleInstance::addConstraint(const ConstraintId constr){
   }
 
 ConstrainedVariableId RuleInstance::getVariable(const std::string& name) const {
-  std::map<std::string, ConstrainedVariableId>::const_iterator it =
-      m_variablesByName.find(name);
-  if(it != m_variablesByName.end())
-    return it->second;
-  else if (!m_parent.isNoId())
-    return m_parent->getVariable(name);
+  unsigned int depth, slot;
+  if(resolveVariable(name, depth, slot))
+    return getVariable(depth, slot);
   else if(getPlanDatabase()->isGlobalVariable(name))
     return getPlanDatabase()->getGlobalVariable(name);
   else
@@ -531,15 +545,60 @@ TokenId RuleInstance::getSlave(const std::string& name) const {
   if(name == sl_this)
     return m_token;
 
-  std::map<std::string, TokenId>::const_iterator it = m_slavesByName.find(name);
-  if(it != m_slavesByName.end())
-    return it->second;
-  else if (!m_parent.isNoId())
-    return m_parent->getSlave(name);
+  unsigned int depth, slot;
+  if(resolveSlave(name, depth, slot))
+    return getSlave(depth, slot);
   else
     return TokenId::noId();
 }
 
+bool RuleInstance::resolveVariable(const std::string& name, unsigned int& depth, unsigned int& slot) const {
+  depth = 0;
+  for(const RuleInstance* instance = this; instance != NULL; depth++) {
+    std::map<std::string, unsigned int>::const_iterator it = instance->m_variablesByName.find(name);
+    if(it != instance->m_variablesByName.end() && instance->m_variableBindings[it->second].isId()) {
+      slot = it->second;
+      return true;
+    }
+    instance = (instance->m_parent.isNoId() ? NULL : static_cast<const RuleInstance*>(instance->m_parent));
+  }
+  return false;
+}
+
+bool RuleInstance::resolveSlave(const std::string& name, unsigned int& depth, unsigned int& slot) const {
+  depth = 0;
+  for(const RuleInstance* instance = this; instance != NULL; depth++) {
+    std::map<std::string, unsigned int>::const_iterator it = instance->m_slavesByName.find(name);
+    if(it != instance->m_slavesByName.end() && instance->m_slaveBindings[it->second].isId()) {
+      slot = it->second;
+      return true;
+    }
+    instance = (instance->m_parent.isNoId() ? NULL : static_cast<const RuleInstance*>(instance->m_parent));
+  }
+  return false;
+}
+
+const RuleInstance* RuleInstance::getAncestor(unsigned int depth) const {
+  const RuleInstance* instance = this;
+  for(; instance != NULL && depth > 0; depth--)
+    instance = (instance->m_parent.isNoId() ? NULL : static_cast<const RuleInstance*>(instance->m_parent));
+  return instance;
+}
+
+ConstrainedVariableId RuleInstance::getVariable(unsigned int depth, unsigned int slot) const {
+  const RuleInstance* instance = getAncestor(depth);
+  if(instance == NULL || slot >= instance->m_variableBindings.size())
+    return ConstrainedVariableId::noId();
+  return instance->m_variableBindings[slot];
+}
+
+TokenId RuleInstance::getSlave(unsigned int depth, unsigned int slot) const {
+  const RuleInstance* instance = getAncestor(depth);
+  if(instance == NULL || slot >= instance->m_slaveBindings.size())
+    return TokenId::noId();
+  return instance->m_slaveBindings[slot];
+}
+
 
 ConstraintId RuleInstance::getConstraint(const std::string& name) const {
   std::map<std::string, ConstraintId>::const_iterator it = m_constraintsByName.find(name);
@@ -560,7 +619,7 @@ void RuleInstance::commonInit() {
   const std::vector<ConstrainedVariableId>& vars = m_token->getVariables();
   for(std::vector<ConstrainedVariableId>::const_iterator it = vars.begin(); it != vars.end(); ++it){
     ConstrainedVariableId var = *it;
-    m_variablesByName.insert(std::make_pair(var->getName(), var));
+    bindVariable(var->getName(), var);
   }
 }
 
@@ -791,10 +850,11 @@ std::string RuleInstance::ruleExecutionContext() const {
     ss << "No Slaves" << std::endl;
   else {
     ss << "Slaves: " << std::endl;
-    for(std::map<std::string, TokenId>::const_iterator it = m_slavesByName.begin(); it != m_slavesByName.end(); ++it){
+    for(std::map<std::string, unsigned int>::const_iterator it = m_slavesByName.begin(); it != m_slavesByName.end(); ++it){
       std::string name(it->first);
-      TokenId token = it->second;
-      ss << TAB_DELIMITER << name << "==" << token->toString() << std::endl;
+      TokenId token = m_slaveBindings[it->second];
+      if(token.isId())
+        ss << TAB_DELIMITER << name << "==" << token->toString() << std::endl;
     }
   }
 
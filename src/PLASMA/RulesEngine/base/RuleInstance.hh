@@ -127,6 +127,24 @@ namespace EUROPA{
     TokenId getSlave(const std::string& name) const;
     ConstraintId getConstraint(const std::string& name) const;
 
+    /**
+     * @brief Find where getVariable or getSlave would find a name bound in this instance or an
+     * ancestor: depth counts parents up from this instance, and slot indexes the names bound in
+     * the instance at that depth. A name keeps its slot for the life of the instance, even when
+     * undo or a loop rebinds it.
+     * @return false if no instance from here up binds the name
+     */
+    bool resolveVariable(const std::string& name, unsigned int& depth, unsigned int& slot) const;
+    bool resolveSlave(const std::string& name, unsigned int& depth, unsigned int& slot) const;
+
+    /**
+     * @brief Lookups by the coordinates of resolveVariable and resolveSlave, which index straight
+     * into the instance holding the name.
+     * @return noId if there is no such slot, or the name held there is not bound at the moment
+     */
+    ConstrainedVariableId getVariable(unsigned int depth, unsigned int slot) const;
+    TokenId getSlave(unsigned int depth, unsigned int slot) const;
+
     /************** Call-backs from the rule variable listener **************/
 
     /**
@@ -291,6 +309,11 @@ namespace EUROPA{
     Domain* m_guardDomain; /*!< If an explicit equality test, will ahve this be non-null */
     ConstraintId m_guardListener; /*!< If guarded, listener is a constraint */
 
+  private:
+    const RuleInstance* getAncestor(unsigned int depth) const;
+    void bindVariable(const std::string& name, const ConstrainedVariableId var);
+    void unbindVariable(const std::string& name);
+
   protected:
     bool m_isExecuted; /*!< Indicates if the rule has been fired */
     bool m_isPositive; /*!< If this is false, the rule's guard is on a negative test. */
@@ -298,8 +321,10 @@ namespace EUROPA{
     std::vector<RuleInstanceId> m_childRules; /*!< Child rules introduced through rule execution */
     std::vector<ConstrainedVariableId> m_variables; /*!< Local variables introduced through rule execution */
     std::vector<TokenId> m_slaves; /*!< Slaves introduced through rule execution */
-    std::map<std::string, ConstrainedVariableId> m_variablesByName; /*!< Context lookup */
-    std::map<std::string, TokenId> m_slavesByName; /*!< Context lookup */
+    std::map<std::string, unsigned int> m_variablesByName; /*!< Slot of each name ever bound, for resolution and debugging */
+    std::vector<ConstrainedVariableId> m_variableBindings; /*!< Context lookup by slot, noId while a name is unbound */
+    std::map<std::string, unsigned int> m_slavesByName; /*!< Slot of each name ever bound, for resolution and debugging */
+    std::vector<TokenId> m_slaveBindings; /*!< Context lookup by slot, noId while a name is unbound */
     std::map<std::string, ConstraintId> m_constraintsByName; /*!< Context lookup */
   };
 }
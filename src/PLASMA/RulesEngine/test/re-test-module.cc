@@ -23,6 +23,7 @@
 #include "ModulePlanDatabase.hh"
 #include "ModuleRulesEngine.hh"
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <boost/cast.hpp>
@@ -211,6 +212,71 @@ void LocalVariableGuard_0_0::handleExecute(){
   addSlave(new IntervalToken(m_token, "any", "AllObjects.Predicate"));
 }
 
+/*
+  AllObjects::Predicate {
+    int b;
+    met_by(AllObjects.Predicate s);
+    if(b == 5) {
+      int c;
+      met_by(AllObjects.Predicate t);
+    }
+  }
+ */
+
+class SlotRule_0: public Rule {
+public:
+  SlotRule_0();
+  RuleInstanceId createInstance(const TokenId token, const PlanDatabaseId planDb,
+                                const RulesEngineId &rulesEngine) const;
+};
+
+class SlotRule_0_Root: public RuleInstance{
+public:
+  SlotRule_0_Root(const RuleId rule, const TokenId token, const PlanDatabaseId planDb)
+    : RuleInstance(rule, token, planDb){}
+  void handleExecute();
+  static RuleInstanceId s_instance;
+  static ConstrainedVariableId s_b;
+};
+
+class SlotRule_0_0: public RuleInstance{
+public:
+  SlotRule_0_0(const RuleInstanceId parentInstance, const ConstrainedVariableId guard, const Domain& domain)
+    : RuleInstance(parentInstance, guard, domain){}
+  void handleExecute();
+  static RuleInstanceId s_instance;
+};
+
+RuleInstanceId SlotRule_0_Root::s_instance;
+ConstrainedVariableId SlotRule_0_Root::s_b;
+RuleInstanceId SlotRule_0_0::s_instance;
+
+SlotRule_0::SlotRule_0()
+    : Rule("AllObjects.Predicate")
+{
+}
+
+RuleInstanceId SlotRule_0::createInstance(const TokenId token,
+                                          const PlanDatabaseId planDb,
+                                          const RulesEngineId &rulesEngine) const{
+  RuleInstanceId rootInstance = (new SlotRule_0_Root(m_id, token, planDb))->getId();
+  rootInstance->setRulesEngine(rulesEngine);
+  return rootInstance;
+}
+
+void SlotRule_0_Root::handleExecute(){
+  s_instance = m_id;
+  s_b = addVariable(IntervalIntDomain(0, 10), true, "b");
+  addSlave(new IntervalToken(m_token, "met_by", "AllObjects.Predicate"), "s");
+  addChildRule(new SlotRule_0_0(m_id, s_b, IntervalIntDomain(5, 5)));
+}
+
+void SlotRule_0_0::handleExecute(){
+  s_instance = m_id;
+  addVariable(IntervalIntDomain(0, 10), true, "c");
+  addSlave(new IntervalToken(m_token, "met_by", "AllObjects.Predicate"), "t");
+}
+
 class RETestEngine : public EngineBase
 {
   public:
@@ -315,6 +381,7 @@ public:
     EUROPA_runTest(testPurge);
     EUROPA_runTest(testGNATS_3157);
     EUROPA_runTest(testProxyVariableRelation);
+    EUROPA_runTest(testRuleInstanceSlots);
     return true;
   }
 private:
@@ -689,6 +756,72 @@ private:
 
     return true;
   }
+
+  static bool testRuleInstanceSlots(){
+    RE_DEFAULT_SETUP(ce, db, false);
+    db->close();
+
+    re->getRuleSchema()->registerRule((new SlotRule_0())->getId());
+
+    IntervalToken t0(db,
+		     "AllObjects.Predicate",
+		     true,
+		     false,
+		     IntervalIntDomain(0, 1000),
+		     IntervalIntDomain(0, 1000),
+		     IntervalIntDomain(1, 1000));
+    t0.activate();
+    ce->propagate();
+
+    // The token's variables are bound first, in order, then what the rule adds
+    RuleInstanceId root = SlotRule_0_Root::s_instance;
+    CPPUNIT_ASSERT(root.isValid());
+    const unsigned int startSlot = static_cast<unsigned int>(
+        std::find(t0.getVariables().begin(), t0.getVariables().end(), t0.start()) - t0.getVariables().begin());
+    unsigned int depth = 0, slot = 0;
+    CPPUNIT_ASSERT(root->resolveVariable("start", depth, slot) && depth == 0 && slot == startSlot);
+    CPPUNIT_ASSERT(root->getVariable(depth, slot) == t0.start());
+    CPPUNIT_ASSERT(root->resolveVariable("b", depth, slot) && depth == 0 && slot == t0.getVariables().size());
+    CPPUNIT_ASSERT(root->getVariable(depth, slot) == SlotRule_0_Root::s_b);
+    CPPUNIT_ASSERT(!root->resolveVariable("c", depth, slot));
+
+    // The child finds what its parent binds one level up
+    SlotRule_0_Root::s_b->specify(5);
+    ce->propagate();
+    RuleInstanceId child = SlotRule_0_0::s_instance;
+    CPPUNIT_ASSERT(child.isValid() && child->isExecuted());
+    CPPUNIT_ASSERT(child->resolveVariable("start", depth, slot) && depth == 1 && slot == startSlot);
+    CPPUNIT_ASSERT(child->getVariable(depth, slot) == t0.start());
+    CPPUNIT_ASSERT(child->resolveSlave("s", depth, slot) && depth == 1 && slot == 0);
+    CPPUNIT_ASSERT(child->getSlave(depth, slot) == root->getSlave("s"));
+    CPPUNIT_ASSERT(child->resolveSlave("t", depth, slot) && depth == 0 && slot == 0);
+    CPPUNIT_ASSERT(child->getSlave(depth, slot) == child->getSlave("t"));
+    CPPUNIT_ASSERT(child->resolveVariable("c", depth, slot) && depth == 0 && slot == 0);
+    const ConstrainedVariableId c = child->getVariable("c");
+    CPPUNIT_ASSERT(c.isValid() && child->getVariable(depth, slot) == c);
+    CPPUNIT_ASSERT(child->getVariable(2, 0).isNoId());
+    CPPUNIT_ASSERT(child->getVariable(0, 1).isNoId());
+    CPPUNIT_ASSERT(child->getSlave("this") == t0.getId());
+
+    // Undoing the child unbinds its names, which keep their slots when it fires again
+    SlotRule_0_Root::s_b->reset();
+    ce->propagate();
+    CPPUNIT_ASSERT(!child->isExecuted());
+    CPPUNIT_ASSERT(child->getVariable(0, 0).isNoId());
+    CPPUNIT_ASSERT(child->getSlave(0, 0).isNoId());
+    CPPUNIT_ASSERT(!child->resolveVariable("c", depth, slot));
+    CPPUNIT_ASSERT(child->getVariable("c").isNoId());
+
+    SlotRule_0_Root::s_b->specify(5);
+    ce->propagate();
+    CPPUNIT_ASSERT(child->isExecuted());
+    CPPUNIT_ASSERT(child->resolveVariable("c", depth, slot) && depth == 0 && slot == 0);
+    CPPUNIT_ASSERT(child->getVariable(depth, slot) == child->getVariable("c"));
+    CPPUNIT_ASSERT(child->resolveSlave("t", depth, slot) && depth == 0 && slot == 0);
+
+    RE_DEFAULT_TEARDOWN();
+    return true;
+  }
 };
 
 /*void RulesEngineModuleTests::runTests(std::string path)
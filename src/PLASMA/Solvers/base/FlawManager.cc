@@ -43,7 +43,7 @@ class FlawManager::Listener : public ConstraintEngineListener {
 };
 
   
-FlawManager::FlawManager(const TiXmlElement& configData)
+FlawManager::FlawManager(const TiXmlElement& configData, bool queueFlaws)
     : Component(configData) 
     , m_db()
     , m_parent()
@@ -56,6 +56,11 @@ FlawManager::FlawManager(const TiXmlElement& configData)
     , m_timestamp(0)
     , m_context()
     , m_ceListener()
+    , m_queueFlaws(queueFlaws)
+    , m_queuedFlaws()
+    , m_flawPriorities()
+    , m_flawQueue()
+    , m_unscoredFlaws()
 {
 }
 
@@ -223,6 +228,7 @@ FlawManager::FlawManager(const TiXmlElement& configData)
 
       condDebugMsg(m_dynamicFiltersByKey.find(var->getKey()) != m_dynamicFiltersByKey.end(), "FlawManager:erase:dynamic", " [" << __FILE__ << ":" << __LINE__ << "] removing entries with key " << var->getKey() << " from m_dynamicFiltersByKey");
       m_dynamicFiltersByKey.erase(var->getKey());
+      dequeueFlaw(var);
 
       // Handle a guard variable getting removed before the flawed variable does.
       for(std::multimap<eint, boost::shared_ptr<FlawHandler::VariableListener> >::iterator it = m_flawHandlerGuards.begin(); it != m_flawHandlerGuards.end();) {
@@ -246,6 +252,7 @@ FlawManager::FlawManager(const TiXmlElement& configData)
                 if(eit->second == listener->getHandler()) {
                   debugMsg("FlawManager:notifyRemoved", getId() << " Removing " << eit->second->toString() << " from flaw handler entry for " << targetKey);
                   entry.erase(eit);
+                  rescoreFlaw(targetKey);
                   break;
                 }
               }
@@ -287,6 +294,7 @@ FlawManager::FlawManager(const TiXmlElement& configData)
 
         condDebugMsg(m_dynamicFiltersByKey.find(var->parent()->getKey()) != m_dynamicFiltersByKey.end(), "FlawManager:erase:dynamic", " [" << __FILE__ << ":" << __LINE__ << "] removing entries with key " << var->parent()->getKey() << " from m_dynamicFiltersByKey");
         m_dynamicFiltersByKey.erase(var->parent()->getKey());
+        dequeueFlaw(var->parent());
       }
       condDebugMsg(!isValid(), "FlawManager:isValid", "Invalid datastructures in flaw manger.");
     }
@@ -321,6 +329,7 @@ FlawManager::FlawManager(const TiXmlElement& configData)
 
       condDebugMsg(m_dynamicFiltersByKey.find(token->getKey()) != m_dynamicFiltersByKey.end(), "FlawManager:erase:dynamic", " [" << __FILE__ << ":" << __LINE__ << "] removing entries with key " << token->getKey() << " from m_dynamicFiltersByKey");
       m_dynamicFiltersByKey.erase(token->getKey());
+      dequeueFlaw(token);
 
       condDebugMsg(!isValid(), "FlawManager:isValid", getId() << " Invalid datastructures in flaw manager.");
     }
@@ -330,12 +339,19 @@ FlawManager::FlawManager(const TiXmlElement& configData)
     }
 
     DecisionPointId FlawManager::next(Priority& bestPriority){
-      EntityId flawToResolve;
-
       // Cannot do better if we already have a best case priority
       if(bestPriority == getBestCasePriority())
         return DecisionPointId::noId();
 
+      if(m_queueFlaws)
+        return nextQueued(bestPriority);
+
+      return nextScanned(bestPriority);
+    }
+
+    DecisionPointId FlawManager::nextScanned(Priority& bestPriority){
+      EntityId flawToResolve;
+
       // Initialize the prority to beat
       Priority bestP =  bestPriority - (2 * cast_double(EPSILON));
       IteratorId it = createIterator();
@@ -402,6 +418,135 @@ FlawManager::FlawManager(const TiXmlElement& configData)
       return decision;
     }
 
+    /**
+     * The queue holds every candidate the iterator would visit, ordered by its last computed
+     * priority, so the search can stop at the first flaw that can neither beat nor tie the
+     * best found so far. Candidates are still subject to dynamic filtering as they are visited.
+     */
+    DecisionPointId FlawManager::nextQueued(Priority& bestPriority){
+      synchronize();
+      scoreFlaws();
+
+      EntityId flawToResolve;
+      Priority bestP =  bestPriority - (2 * cast_double(EPSILON));
+      std::string explanation = "unknown";
+      const bool tiesByKey = breaksTiesByKey();
+
+      for(std::map<FlawRank, EntityId>::const_iterator it = m_flawQueue.begin(); it != m_flawQueue.end(); ++it){
+        const EntityId candidate = it->second;
+        Priority priority = it->first.first;
+        Priority priorityDiff = bestP - priority;
+
+        // Everything further on is at least as bad as this one
+        if(priorityDiff <= -EPSILON)
+          break;
+
+        checkError(candidate.isValid(), "Invalid flaw in the queue with key " << it->first.second);
+        if(dynamicMatch(candidate))
+          continue;
+
+        debugMsg("FlawManager:next", "Evaluating " << candidate->toString() << " with priority " << priority << " to beat " << bestP);
+
+        if(priorityDiff >= EPSILON)
+          explanation = "priority";
+        else if(!betterThan(candidate, flawToResolve, explanation))
+          continue;
+
+        flawToResolve = candidate;
+        bestP = priority;
+        debugMsg("FlawManager:next", "Updating flaw to resolve " << candidate->getKey() << ") " << candidate->toString());
+
+        // Ties are queued in key order, so the first one is the one betterThan would choose
+        if(tiesByKey || bestP == getBestCasePriority())
+          break;
+      }
+
+      DecisionPointId decision;
+      if(flawToResolve.isId()){
+        bestPriority = bestP;
+        decision = allocateDecisionPoint(flawToResolve, explanation);
+      }
+
+      condDebugMsg(!isValid(), "FlawManager:isValid", "Invalid datastructures in flaw manger.");
+      return decision;
+    }
+
+    void FlawManager::queueFlaw(const EntityId entity){
+      checkError(m_queueFlaws, "Flaws are only queued by flaw managers constructed to do so.");
+      eint key = entity->getKey();
+      m_queuedFlaws[key] = entity;
+      unrankFlaw(key);
+      m_unscoredFlaws.insert(key);
+    }
+
+    void FlawManager::dequeueFlaw(const EntityId entity){
+      eint key = entity->getKey();
+      if(m_queuedFlaws.erase(key) == 0)
+        return;
+      unrankFlaw(key);
+      m_unscoredFlaws.erase(key);
+    }
+
+    void FlawManager::rescoreFlaw(const eint key){
+      if(m_queuedFlaws.find(key) == m_queuedFlaws.end())
+        return;
+      unrankFlaw(key);
+      m_unscoredFlaws.insert(key);
+    }
+
+    void FlawManager::unrankFlaw(const eint key){
+      std::map<eint, Priority>::iterator it = m_flawPriorities.find(key);
+      if(it == m_flawPriorities.end())
+        return;
+      m_flawQueue.erase(FlawRank(it->second, breaksTiesByKey() ? -key : key));
+      m_flawPriorities.erase(it);
+    }
+
+    /**
+     * Obtaining a flaw handler may post guards and propagate, which can enter, remove or
+     * re-score other flaws, so we go round until every flaw we have not yet looked at has
+     * been considered. Dynamically excluded flaws are left unscored, as the iterator would
+     * never have scored them, and are looked at again on the next call.
+     */
+    void FlawManager::scoreFlaws(){
+      std::set<eint> excluded;
+      for(;;){
+        std::vector<eint> keys;
+        for(std::set<eint>::const_iterator it = m_unscoredFlaws.begin(); it != m_unscoredFlaws.end(); ++it)
+          if(excluded.find(*it) == excluded.end())
+            keys.push_back(*it);
+
+        if(keys.empty())
+          break;
+
+        for(std::vector<eint>::const_iterator it = keys.begin(); it != keys.end(); ++it){
+          eint key = *it;
+          std::map<eint, EntityId>::const_iterator entry = m_queuedFlaws.find(key);
+          if(entry == m_queuedFlaws.end() || m_unscoredFlaws.find(key) == m_unscoredFlaws.end())
+            continue;
+
+          EntityId entity = entry->second;
+          checkError(entity.isValid(), "Invalid flaw in the queue with key " << key);
+          if(dynamicMatch(entity)){
+            excluded.insert(key);
+            continue;
+          }
+
+          m_unscoredFlaws.erase(key);
+          Priority priority = getPriority(entity);
+
+          // Propagation in getPriority may have removed or re-entered it
+          if(m_queuedFlaws.find(key) == m_queuedFlaws.end() || m_unscoredFlaws.find(key) != m_unscoredFlaws.end())
+            continue;
+
+          unrankFlaw(key);
+          m_flawPriorities.insert(std::make_pair(key, priority));
+          m_flawQueue.insert(std::make_pair(FlawRank(priority, breaksTiesByKey() ? -key : key), entity));
+          debugMsg("FlawManager:scoreFlaws", "Queued " << key << " with priority " << priority);
+        }
+      }
+    }
+
     bool FlawManager::inScope(const EntityId entity) {
       checkError(m_db->getConstraintEngine()->constraintConsistent(), 
                  "Assumes the database is constraint consistent but it is not.");
@@ -557,7 +702,7 @@ FlawManager::FlawManager(const TiXmlElement& configData)
 
     std::map<eint, FlawHandlerEntry >::const_iterator it = m_activeFlawHandlersByKey.find(entity->getKey());
     if(it != m_activeFlawHandlersByKey.end()){
-      FlawHandlerEntry entry = it->second;
+      const FlawHandlerEntry& entry = it->second;
       FlawHandlerEntry::const_iterator entryIt = entry.end();
       FlawHandlerId flawHandler = (--entryIt)->second;
 
@@ -639,6 +784,7 @@ FlawManager::FlawManager(const TiXmlElement& configData)
                  "We should have at least one entry for a standard handler for entity " << target->getKey() << " handler " << flawHandler->toString());
       FlawHandlerEntry& entry = it->second;
       entry.insert(std::pair<double, FlawHandlerId>(flawHandler->getWeight(),flawHandler ));
+      rescoreFlaw(target->getKey());
       debugMsg("FlawManager:notifyActivated", "Added active FlawHandler " << flawHandler->toString() << std::endl << " for entity " << target->getKey());
       condDebugMsg(!isValid(), "FlawManager:isValid", "Invalid datastructures in flaw manger.");
     }
@@ -654,6 +800,7 @@ FlawManager::FlawManager(const TiXmlElement& configData)
       for(FlawHandlerEntry::iterator handlerIt = entry.begin(); handlerIt != entry.end(); ++handlerIt){
         if(handlerIt->second == flawHandler){
           entry.erase(handlerIt);
+          rescoreFlaw(target->getKey());
           condDebugMsg(!isValid(), "FlawManager:isValid", "Invalid datastructures in flaw manger.");
           return;
         }
@@ -163,7 +163,31 @@ class ConstraintEngineListener;
 
     protected:
 
-      FlawManager(const TiXmlElement& configData);
+      /**
+       * @brief Constructor
+       * @param queueFlaws If true, next() searches a priority queue of the flaws entered
+       * with queueFlaw instead of the iterator, so the derived class must keep that queue
+       * in step with its candidate set.
+       */
+      FlawManager(const TiXmlElement& configData, bool queueFlaws = false);
+
+      /**
+       * @brief Enters a flaw candidate in the priority queue. Its priority is computed
+       * on the next call to next(). Entering a flaw again causes it to be re-scored.
+       */
+      void queueFlaw(const EntityId entity);
+
+      /**
+       * @brief Removes a flaw candidate from the priority queue, if present.
+       */
+      void dequeueFlaw(const EntityId entity);
+
+      /**
+       * @brief True if betterThan prefers the higher key among flaws of equal priority, as
+       * the default does. Lets next() take the first flaw of the best priority in the queue
+       * rather than compare all of them.
+       */
+      virtual bool breaksTiesByKey() const {return true;}
 
       /**
        * @brief Factory method to allocate instance for selected decision point
@@ -177,6 +201,12 @@ class ConstraintEngineListener;
 
       virtual bool betterThan(const EntityId a, const EntityId b, std::string& explanation);
 
+      /**
+       * @brief Implementation of next() over the iterator, scoring every candidate. Flaw
+       * managers that queue their flaws must still choose the same flaw this way.
+       */
+      DecisionPointId nextScanned(Priority& bestPriority);
+
       PlanDatabaseId m_db;
 
     private:
@@ -185,6 +215,29 @@ class ConstraintEngineListener;
       bool staticallyExcluded(const EntityId entity) const;
       bool isValid() const;
 
+      /**
+       * @brief Implementation of next() over the priority queue.
+       */
+      DecisionPointId nextQueued(Priority& bestPriority);
+
+      /**
+       * @brief Computes priorities for queued flaws that have none, skipping those that
+       * are currently excluded by dynamic filters.
+       */
+      void scoreFlaws();
+
+      /**
+       * @brief Marks a queued flaw for re-scoring, as when its active flaw handlers change.
+       */
+      void rescoreFlaw(const eint key);
+      void unrankFlaw(const eint key);
+
+      /**
+       * @brief Position in the priority queue: by priority, then by key in the order
+       * betterThan would visit them.
+       */
+      typedef std::pair<Priority, eint> FlawRank;
+
       FlawManagerId m_parent;
       MatchingEngineId m_flawFilters;
       MatchingEngineId m_flawHandlers;
@@ -196,6 +249,11 @@ class ConstraintEngineListener;
       unsigned int m_timestamp; /*!< Used for testing for stale iterators */
       ContextId m_context;
       boost::shared_ptr<ConstraintEngineListener> m_ceListener;
+      const bool m_queueFlaws; /*!< True if next() uses the priority queue below */
+      std::map<eint, EntityId> m_queuedFlaws; /*!< All flaws in the queue, by key */
+      std::map<eint, Priority> m_flawPriorities; /*!< Priority of each scored flaw, by key */
+      std::map<FlawRank, EntityId> m_flawQueue; /*!< Scored flaws, best first */
+      std::set<eint> m_unscoredFlaws; /*!< Queued flaws whose priority has to be (re)computed */
       //static const Priority BEST_CASE_PRIORITY = 0;
     };
 
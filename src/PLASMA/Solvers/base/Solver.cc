@@ -10,6 +10,10 @@
 #include "PlanDatabaseWriter.hh"
 #include "FlawHandler.hh"
 #include "Context.hh"
+#include "DbClientTransactionLog.hh"
+#include "DbClientTransactionPlayer.hh"
+#include "BinaryTransactionLog.hh"
+#include "Token.hh"
 #include "tinyxml.h"
 #include <bitset>
 
@@ -67,6 +71,15 @@ Solver::Solver(const PlanDatabaseId db, const TiXmlElement& configData)
   m_decisionStack(),
   m_lastExecutedDecision(),
   m_listeners(),
+  m_useTrail(db->getEngine()->getConfig()->getProperty("Solver.useTrail") == "true"),
+  m_backjumping(db->getEngine()->getConfig()->getProperty("Solver.backjump") == "true"),
+  m_recording(false),
+  m_decisionEntities(),
+  m_decisionConflicts(),
+  m_activeEntities(),
+  m_activeConflicts(),
+  m_blameFloor(0),
+  m_checkpointedDecisions(),
   m_ceListener(db->getConstraintEngine(), *this),
       m_dbListener(db, *this) {
   checkError(strcmp(configData.Value(), "Solver") == 0,
@@ -183,6 +196,196 @@ const std::string& Solver::getName() const { return m_name;}
 
     void Solver::setMaxDepth(const unsigned int depth) {m_maxDepth = depth;}
 
+    void Solver::setUseTrail(bool useTrail) {
+      // Decisions already on the stack have no trail level to pop
+      if(useTrail != m_useTrail)
+        m_db->getConstraintEngine()->clearTrail();
+      m_useTrail = useTrail;
+    }
+
+    void Solver::setBackjumping(bool backjumping) {
+      // Nothing is known of what the decisions already made depend on, so they are blamed for every failure
+      if(backjumping && !m_backjumping)
+        m_blameFloor = m_decisionStack.size();
+      m_backjumping = backjumping;
+      m_decisionEntities.assign(m_decisionStack.size(), EntityKeys());
+      m_decisionConflicts.assign(m_decisionStack.size(), DecisionLevels());
+      m_activeEntities.clear();
+      m_activeConflicts.clear();
+      if(m_backjumping && m_activeDecision.isId())
+        blameAllDecisions();
+    }
+
+    namespace {
+      /**
+       * @brief A decision read back from a checkpoint. Its choices are the transactions recorded for it, the first
+       * of which is already in force when it is restored.
+       */
+      class RestoredDecisionPoint : public DecisionPoint {
+      public:
+        RestoredDecisionPoint(const DbClientId client, eint entityKey, const std::vector<TiXmlElement*>& choices)
+          : DecisionPoint(client, entityKey, "restored"), m_player(client), m_choices(choices), m_index(0),
+            m_inForce(true) {}
+
+        ~RestoredDecisionPoint() {
+          for(std::vector<TiXmlElement*>::const_iterator it = m_choices.begin(); it != m_choices.end(); ++it)
+            delete *it;
+        }
+
+        std::string toString() const {
+          std::stringstream os;
+          os << "RESTORED(" << m_entityKey << "): ";
+          if(m_index < m_choices.size())
+            os << *m_choices[m_index];
+          else
+            os << "no choices left";
+          return os.str();
+        }
+
+        std::string toShortString() const {return toString();}
+
+      private:
+        void handleInitialize() {}
+
+        bool hasNext() const {return m_index < m_choices.size();}
+
+        void handleExecute() {
+          if(m_inForce)
+            m_inForce = false;
+          else
+            m_player.playTransaction(*m_choices[m_index]);
+        }
+
+        void handleUndo() {
+          m_player.playInverse(*m_choices[m_index]);
+          m_index++;
+        }
+
+        DbClientTransactionPlayer m_player;
+        std::vector<TiXmlElement*> m_choices;
+        unsigned long m_index; /*!< The choice in force, or to be made next */
+        bool m_inForce; /*!< True until the restored choice is first executed */
+      };
+    }
+
+    void Solver::checkpoint(BinaryTransactionWriter& writer) {
+      checkError(m_activeDecision.isNoId(), "Can only checkpoint between steps.");
+      const DbClientId client = m_db->getClient();
+
+      // Decisions moved on to another choice since have been undone and executed again
+      unsigned long kept = 0;
+      while(kept < m_checkpointedDecisions.size() && kept < m_decisionStack.size() &&
+            m_checkpointedDecisions[kept].first == m_decisionStack[kept]->getKey() &&
+            m_checkpointedDecisions[kept].second == m_decisionStack[kept]->getExecutionCount())
+        kept++;
+
+      std::vector<TiXmlElement*> decisions;
+      for(unsigned long i = kept; i < m_decisionStack.size(); i++){
+        const DecisionPointId decision = m_decisionStack[i];
+        std::vector<TiXmlElement*> choices;
+        if(!decision->getChoices(choices)){
+          for(std::vector<TiXmlElement*>::const_iterator it = decisions.begin(); it != decisions.end(); ++it)
+            delete *it;
+          checkRuntimeError(ALWAYS_FAILS, "Cannot checkpoint the choices of " << decision->toString());
+        }
+
+        TiXmlElement* element = new TiXmlElement("decision");
+        const EntityId entity = Entity::getEntity(decision->getFlawedEntityKey());
+        checkError(entity.isId(), "No flawed entity for " << decision->toString());
+        if(TokenId::convertable(entity))
+          element->LinkEndChild(DbClientTransactionLog::tokenAsXml(client, entity));
+        else
+          element->LinkEndChild(DbClientTransactionLog::variableAsXml(client, entity));
+        for(std::vector<TiXmlElement*>::const_iterator it = choices.begin(); it != choices.end(); ++it)
+          element->LinkEndChild(*it);
+        decisions.push_back(element);
+      }
+
+      TiXmlElement marker("decisions");
+      marker.SetAttribute("version", DbClientTransactionLog::CHECKPOINT_VERSION());
+      marker.SetAttribute("retract", static_cast<int>(m_checkpointedDecisions.size() - kept));
+      writer.write(marker);
+      for(std::vector<TiXmlElement*>::const_iterator it = decisions.begin(); it != decisions.end(); ++it){
+        writer.write(**it);
+        delete *it;
+      }
+      writer.flush();
+
+      debugMsg("Solver:checkpoint", "Retracted " << m_checkpointedDecisions.size() - kept << " and wrote " <<
+               decisions.size() << " decisions");
+      m_checkpointedDecisions.resize(kept);
+      for(unsigned long i = kept; i < m_decisionStack.size(); i++)
+        m_checkpointedDecisions.push_back(std::make_pair(m_decisionStack[i]->getKey(),
+                                                         m_decisionStack[i]->getExecutionCount()));
+    }
+
+    void Solver::restore(BinaryTransactionReader& reader) {
+      checkError(m_activeDecision.isNoId() && m_decisionStack.empty(),
+                 "Can only restore decisions onto an empty stack.");
+
+      std::vector<TiXmlElement*> decisions; // Net of those retracted by later checkpoints
+      for(;;){
+        TiXmlElement* record = new TiXmlElement("");
+        if(!reader.next(*record)){
+          delete record;
+          break;
+        }
+
+        if(strcmp(record->Value(), "decision") == 0){
+          checkRuntimeError(record->FirstChildElement() != NULL, "No flawed entity in " << *record);
+          decisions.push_back(record);
+          continue;
+        }
+
+        checkRuntimeError(strcmp(record->Value(), "decisions") == 0, "Unexpected " << *record << " in a solver checkpoint.");
+        int version = 0;
+        int retract = 0;
+        record->Attribute("version", &version);
+        record->Attribute("retract", &retract);
+        delete record;
+        checkRuntimeError(version == DbClientTransactionLog::CHECKPOINT_VERSION(),
+                          "Checkpoint format version " << version << " is not " <<
+                          DbClientTransactionLog::CHECKPOINT_VERSION() << ".");
+        checkRuntimeError(retract >= 0 && static_cast<unsigned int>(retract) <= decisions.size(),
+                          "Checkpoint retracts " << retract << " of " << decisions.size() << " decisions.");
+        for( ; retract > 0; retract--){
+          delete decisions.back();
+          decisions.pop_back();
+        }
+      }
+
+      DbClientTransactionPlayer player(m_db->getClient());
+      for(std::vector<TiXmlElement*>::const_iterator it = decisions.begin(); it != decisions.end(); ++it){
+        const TiXmlElement* address = (*it)->FirstChildElement();
+        EntityId entity;
+        if(strcmp(address->Value(), "token") == 0)
+          entity = player.xmlAsToken(*address);
+        else
+          entity = player.xmlAsVariable(*address);
+        checkRuntimeError(entity.isId(), "Cannot find the flawed entity of " << **it);
+
+        std::vector<TiXmlElement*> choices;
+        for(const TiXmlElement* choice = address->NextSiblingElement(); choice != NULL; choice = choice->NextSiblingElement())
+          choices.push_back(choice->Clone()->ToElement());
+        checkRuntimeError(!choices.empty(), "No choice in force in " << **it);
+
+        DecisionPointId decision = (new RestoredDecisionPoint(m_db->getClient(), entity->getKey(), choices))->getId();
+        decision->setContext(m_context);
+        decision->initialize();
+        decision->execute();
+        m_decisionStack.push_back(decision);
+        delete *it;
+      }
+
+      debugMsg("Solver:restore", "Restored " << m_decisionStack.size() << " decisions");
+      // Nothing is known of what the restored decisions depend on
+      if(m_backjumping){
+        m_blameFloor = m_decisionStack.size();
+        m_decisionEntities.assign(m_decisionStack.size(), EntityKeys());
+        m_decisionConflicts.assign(m_decisionStack.size(), DecisionLevels());
+      }
+    }
+
     /**
      * @brief Provides baseline implementation for chosing the next flaw and allocating the next decision.
      *
@@ -315,9 +518,23 @@ const std::string& Solver::getName() const { return m_name;}
       m_noFlawsFound = false;
 
       // If we have no active decision to work on, we get one
-      if(m_activeDecision.isNoId())
+      if(m_activeDecision.isNoId()) {
         allocateNewDecisionPoint();
 
+        // The choices of a variable depend on its domain. For other flaws, any prior decision may have narrowed them.
+        if(m_backjumping && m_activeDecision.isId()) {
+          m_activeConflicts.clear();
+          EntityId entity = Entity::getEntity(m_activeDecision->getFlawedEntityKey());
+          if(entity.isId() && ConstrainedVariableId::convertable(entity)) {
+            ConstrainedVariableSet seeds;
+            seeds.insert(ConstrainedVariableId(entity));
+            blameDecisions(seeds);
+          }
+          else
+            blameAllDecisions();
+        }
+      }
+
       if(m_activeDecision.isNoId()){
         m_noFlawsFound = true;
         publish(notifyCompleted);
@@ -340,21 +557,34 @@ const std::string& Solver::getName() const { return m_name;}
 
       if(!m_activeDecision->cut() && m_activeDecision->hasNext()){
         m_lastExecutedDecision = m_activeDecision->toString();
+        if(m_useTrail)
+          m_db->getConstraintEngine()->pushTrail();
+        m_activeEntities.clear();
+        m_recording = m_backjumping;
         m_activeDecision->execute();
         m_db->getClient()->propagate();
+        m_recording = false;
         m_stepCount++;
 
         if(conflictLevelOk()){
           m_decisionStack.push_back(m_activeDecision);
+          if(m_backjumping) {
+            m_decisionEntities.push_back(m_activeEntities);
+            m_decisionConflicts.push_back(m_activeConflicts);
+            m_activeEntities.clear();
+            m_activeConflicts.clear();
+          }
           publish(notifyStepSucceeded,m_activeDecision);
           m_activeDecision = DecisionPointId::noId();
-          debugMsg("Solver:printPlan:infrequent", std::endl << PlanDatabaseWriter::toString(m_db));
+          debugMsg("Solver:printPlan:infrequent", std::endl << PlanDatabaseWriter::Plan(m_db));
           return;
         }
         else {
           publish(notifyStepFailed,m_activeDecision);
           debugMsg("Solver:backtrack",
                    "Backtracking because of constraint inconsistency due to " << m_lastExecutedDecision);
+          if(m_backjumping)
+            blameDecisions(m_db->getConstraintEngine()->getEmptyVariables());
         }
       }
       else {
@@ -386,6 +616,10 @@ const std::string& Solver::getName() const { return m_name;}
         if(m_activeDecision.isNoId() && !m_decisionStack.empty()){
           m_activeDecision = m_decisionStack.back();
           m_decisionStack.pop_back();
+          if(m_backjumping) {
+            m_activeConflicts = m_decisionConflicts.back();
+            trimProvenance();
+          }
           debugMsg("Solver:backtrack", "Retrieving closed decision. Depth is:" << m_decisionStack.size());
         }
 
@@ -394,10 +628,9 @@ const std::string& Solver::getName() const { return m_name;}
 	// as expected !
         debugMsg("Solver:backtrack", "Backtracking decision " << (m_db->getClient()->propagate() ? m_activeDecision->toString() : "No data"));
 
-        // If the active decision is executed, undo it
+        // If the active decision is executed, undo it.
         if(m_activeDecision->isExecuted()) {
-          m_activeDecision->undo();
-          publish(notifyUndone,m_activeDecision);
+          undoDecision(m_activeDecision);
           //debugMsg("Solver:printPlan", std::endl << PlanDatabaseWriter::toString(m_db));
         }
 
@@ -410,6 +643,8 @@ const std::string& Solver::getName() const { return m_name;}
           publish(notifyDeleted,m_activeDecision);
           delete static_cast<DecisionPoint*>(m_activeDecision);
           m_activeDecision = DecisionPointId::noId();
+          if(m_backjumping)
+            jumpBack();
         }
         else {
           publish(notifyRetractSucceeded,m_activeDecision);
@@ -418,6 +653,112 @@ const std::string& Solver::getName() const { return m_name;}
       return backtracking;
     }
 
+    /**
+     * @brief With a trail, every executed decision opened a level.
+     */
+    void Solver::undoDecision(const DecisionPointId decision){
+      ConstraintEngineId ce = m_db->getConstraintEngine();
+      bool trailed = m_useTrail && ce->getTrailDepth() > 0;
+      if(trailed)
+        ce->retractTrail();
+      decision->undo();
+      if(trailed)
+        ce->popTrail();
+      publish(notifyUndone,decision);
+    }
+
+    namespace {
+      bool intersects(const std::set<eint>& a, const std::set<eint>& b){
+        const std::set<eint>& smaller = (a.size() < b.size() ? a : b);
+        const std::set<eint>& larger = (a.size() < b.size() ? b : a);
+        for(std::set<eint>::const_iterator it = smaller.begin(); it != smaller.end(); ++it)
+          if(larger.find(*it) != larger.end())
+            return true;
+        return false;
+      }
+    }
+
+    /**
+     * @brief Collects the variables and constraints connected to the seeds, and blames the decisions that restricted
+     * or created any of them. A variable still at its base domain carries no restriction from one of its constraints
+     * to another, so the search does not continue past it.
+     */
+    void Solver::blameDecisions(const ConstrainedVariableSet& seeds){
+      if(seeds.empty()){
+        blameAllDecisions();
+        return;
+      }
+
+      EntityKeys reached;
+      std::vector<ConstrainedVariableId> agenda(seeds.begin(), seeds.end());
+      for(ConstrainedVariableSet::const_iterator it = seeds.begin(); it != seeds.end(); ++it)
+        reached.insert((*it)->getKey());
+
+      while(!agenda.empty()){
+        ConstrainedVariableId var = agenda.back();
+        agenda.pop_back();
+        if(seeds.find(var) == seeds.end() && var->lastDomain() == var->baseDomain())
+          continue;
+
+        ConstraintSet constraints;
+        var->constraints(constraints);
+        for(ConstraintSet::const_iterator it = constraints.begin(); it != constraints.end(); ++it){
+          ConstraintId constraint = *it;
+          if(!reached.insert(constraint->getKey()).second)
+            continue;
+          const std::vector<ConstrainedVariableId>& scope = constraint->getScope();
+          for(std::vector<ConstrainedVariableId>::const_iterator v = scope.begin(); v != scope.end(); ++v)
+            if(reached.insert((*v)->getKey()).second)
+              agenda.push_back(*v);
+        }
+      }
+
+      for(unsigned long level = 1; level <= m_decisionStack.size(); level++)
+        if(level <= m_blameFloor || intersects(m_decisionEntities[level - 1], reached))
+          m_activeConflicts.insert(level);
+
+      debugMsg("Solver:backjump", "Conflict set of " << m_activeDecision->toShortString() << " has " <<
+               m_activeConflicts.size() << " of " << m_decisionStack.size() << " decisions");
+    }
+
+    void Solver::blameAllDecisions(){
+      for(unsigned long level = 1; level <= m_decisionStack.size(); level++)
+        m_activeConflicts.insert(level);
+    }
+
+    void Solver::jumpBack(){
+      unsigned long target = (m_activeConflicts.empty() ? 0 : *m_activeConflicts.rbegin());
+      checkError(target <= m_decisionStack.size(),
+                 "Conflict set refers to level " << target << " beyond depth " << m_decisionStack.size());
+      debugMsg("Solver:backjump", "Jumping back from depth " << m_decisionStack.size() << " to " << target);
+
+      // Nothing in between contributed, so their remaining choices would fail in the same way
+      while(m_decisionStack.size() > target){
+        DecisionPointId node = m_decisionStack.back();
+        m_decisionStack.pop_back();
+        undoDecision(node);
+        publish(notifyDeleted,node);
+        delete static_cast<DecisionPoint*>(node);
+      }
+      trimProvenance();
+
+      // The target is to blame for the failures of the exhausted decision along with the rest of its conflict set
+      if(target > 0){
+        m_activeConflicts.erase(target);
+        m_decisionConflicts[target - 1].insert(m_activeConflicts.begin(), m_activeConflicts.end());
+      }
+      m_activeConflicts.clear();
+    }
+
+    void Solver::trimProvenance(){
+      if(m_decisionEntities.size() > m_decisionStack.size()){
+        m_decisionEntities.resize(m_decisionStack.size());
+        m_decisionConflicts.resize(m_decisionStack.size());
+      }
+      if(m_blameFloor > m_decisionStack.size())
+        m_blameFloor = m_decisionStack.size();
+    }
+
     void Solver::reset(){
       reset(m_decisionStack.size());
     }
@@ -425,6 +766,10 @@ const std::string& Solver::getName() const { return m_name;}
     void Solver::reset(unsigned long depth){
       checkError(depth <= getDepth(), "Cannot reset past current depth: " << depth << " exceeds " << getDepth());
 
+      // Fall back to relaxation, since the network may have been changed outside the search
+      if(m_useTrail)
+        m_db->getConstraintEngine()->clearTrail();
+
       if(m_activeDecision.isId()){
         if(m_activeDecision->canUndo()) {
           publish(notifyUndone,m_activeDecision);
@@ -461,6 +806,7 @@ const std::string& Solver::getName() const { return m_name;}
         delete static_cast<DecisionPoint*>(node);
         depth--;
       }
+      trimProvenance();
 
       m_stepCount = 0;
       m_noFlawsFound = false;
@@ -469,6 +815,9 @@ const std::string& Solver::getName() const { return m_name;}
     }
 
     bool Solver::backjump(unsigned long stepCount){
+      if(m_useTrail)
+        m_db->getConstraintEngine()->clearTrail();
+
       // If we have an active decision, then reset it
       if(m_activeDecision.isId()){
         if(m_activeDecision->canUndo()) {
@@ -509,12 +858,16 @@ const std::string& Solver::getName() const { return m_name;}
     }
 
     void Solver::cleanupDecisions(){
+      if(m_useTrail && !Entity::isPurging())
+        m_db->getConstraintEngine()->clearTrail();
+
       if(m_activeDecision.isId()){
         delete static_cast<DecisionPoint*>(m_activeDecision);
         m_activeDecision = DecisionPointId::noId();
       }
 
       cleanup(m_decisionStack);
+      trimProvenance();
     }
 
     void Solver::cleanup(DecisionStack& decisionStack){
@@ -609,9 +962,17 @@ Solver::FlawIterator::FlawIterator(const FlawManagers& flawManagers)
       notify(notifyRemoved(variable));
     }
 
+    void Solver::notifyAdded(const ConstrainedVariableId variable){
+      if(m_recording)
+        m_activeEntities.insert(variable->getKey());
+    }
+
 void Solver::notifyChanged(const ConstrainedVariableId variable,
                            const DomainListener::ChangeType& changeType){
 
+  if(m_recording)
+    m_activeEntities.insert(variable->getKey());
+
   switch(changeType){
     case DomainListener::UPPER_BOUND_DECREASED:
     case DomainListener::LOWER_BOUND_INCREASED:
@@ -632,6 +993,8 @@ void Solver::notifyChanged(const ConstrainedVariableId variable,
 }
 
     void Solver::notifyAdded(const ConstraintId constraint){
+      if(m_recording)
+        m_activeEntities.insert(constraint->getKey());
       notify(notifyAdded(constraint));
     }
 
@@ -757,6 +1120,10 @@ void Solver::notifyChanged(const ConstrainedVariableId variable,
     Solver::CeListener::CeListener(const ConstraintEngineId ce, Solver& solver)
       : ConstraintEngineListener(ce), m_solver(solver) {}
 
+    void Solver::CeListener::notifyAdded(const ConstrainedVariableId variable){
+      m_solver.notifyAdded(variable);
+    }
+
     void Solver::CeListener::notifyRemoved(const ConstrainedVariableId variable){
       m_solver.notifyRemoved(variable);
     }
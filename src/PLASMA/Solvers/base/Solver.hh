@@ -17,13 +17,17 @@
 #include "PlanDatabaseListener.hh"
 
 namespace EUROPA {
+class BinaryTransactionWriter;
+class BinaryTransactionReader;
+
 namespace SOLVERS {
 
 /**
  * @brief Defines the main solver interface for identification and resolution of flaws on a plan database.
  *
  * A solver may or may not do planning i.e. goal decomposition. Most generally, it will process a set of flaws in a partial plan until
- * there are no more in scope.The Solver is a mediator between Flaw Managers and Decision Points. This solver provides a chronological backtracking search.
+ * there are no more in scope.The Solver is a mediator between Flaw Managers and Decision Points. This solver provides a chronological backtracking search,
+ * optionally with conflict-directed backjumping.
  *
  * @see FlawManager, DecisionPoint
  */
@@ -154,6 +158,53 @@ class Solver {
    */
   void setMaxDepth(const unsigned int depth);
 
+  /**
+   * @brief Backtrack by restoring domains from the constraint engine's trail, rather than by relaxing and
+   * repropagating. Only chronological backtracking uses the trail; reset(), backjump() and clear() discard it.
+   * Defaults to the engine property Solver.useTrail.
+   * @see ConstraintEngine::pushTrail()
+   */
+  void setUseTrail(bool useTrail);
+
+  bool getUseTrail() const {return m_useTrail;}
+
+  /**
+   * @brief When a decision runs out of choices, jump back to the deepest decision the failures depend on rather than
+   * to the previous one, discarding the decisions in between. Defaults to the engine property Solver.backjump.
+   *
+   * A decision is taken to be involved in a failure if, while it was executed, it restricted or created a variable or
+   * constraint connected to an emptied variable through the constraint network. Connections are not followed through
+   * variables still at their base domain. If no variable was emptied, e.g. because violations are allowed, every
+   * decision is involved and the search is chronological.
+   * @see backtrack()
+   */
+  void setBackjumping(bool backjumping);
+
+  bool getBackjumping() const {return m_backjumping;}
+
+  /**
+   * @brief Write the decisions made since the last checkpoint to a binary log, from which restore rebuilds the
+   * decision stack. Checkpoint the DbClientTransactionLog of the database at the same time, to its own log.
+   *
+   * A checkpoint starts with a "decisions" element carrying the number of decisions of earlier checkpoints
+   * since retracted. It goes on with a "decision" element per decision made or moved on to another choice since,
+   * holding the address of the flawed entity followed by the choice in force and the choices still to come,
+   * as transactions. Only the choices within the cutoff of a decision are written. A decision backtracked out of
+   * and not yet executed again is not written, and is formulated anew after a restore.
+   * @note Fails for decisions which cannot describe their choices as transactions.
+   * @see DecisionPoint::getChoices, DbClientTransactionLog::checkpoint
+   */
+  void checkpoint(BinaryTransactionWriter& writer);
+
+  /**
+   * @brief Rebuild the decision stack as of the last checkpoint in a binary log, once the database has been
+   * restored from its own log. The choice in force of each decision is already in the database, so nothing is
+   * played until the search backtracks into the restored decisions, which then move on to their remaining choices.
+   * With backjumping, the restored decisions are involved in every failure.
+   * @see checkpoint, DbClientTransactionPlayer::restore
+   */
+  void restore(BinaryTransactionReader& reader);
+
   /**
    * @brief Create an iterator over the set of flaws.
    */
@@ -223,6 +274,34 @@ class Solver {
    */
   void cleanupDecisions();
 
+  /**
+   * @brief Undoes an executed decision, popping its trail level if it has one.
+   */
+  void undoDecision(const DecisionPointId decision);
+
+  /**
+   * @brief Adds the decisions involved in a failure, or in restricting the choices of the active decision, to the
+   * conflict set of the active decision.
+   * @param seeds The variables to search from through the constraint network.
+   */
+  void blameDecisions(const ConstrainedVariableSet& seeds);
+
+  /**
+   * @brief Adds all decisions on the stack to the conflict set of the active decision.
+   */
+  void blameAllDecisions();
+
+  /**
+   * @brief Discards the decisions above the deepest one in the conflict set of the exhausted active decision,
+   * and passes the rest of that conflict set on to it.
+   */
+  void jumpBack();
+
+  /**
+   * @brief Drops the provenance kept for decisions no longer on the stack.
+   */
+  void trimProvenance();
+
   void notifyAdded(const TokenId token);
 
   void notifyRemoved(const TokenId token);
@@ -272,6 +351,21 @@ class Solver {
   DecisionStack m_decisionStack; /*!< Stack of decisions made */
   std::string m_lastExecutedDecision; /*!< Kept for debugging and UI purposes */
   std::list<SearchListenerId> m_listeners; /*!< The set of listeners for the search */
+  bool m_useTrail; /*!< True if each executed decision opens a level on the constraint engine trail */
+
+  typedef std::set<eint> EntityKeys;
+  typedef std::set<unsigned long> DecisionLevels; /*!< 1 based positions on the decision stack */
+
+  bool m_backjumping; /*!< True if exhausted decisions jump back to the deepest decision in their conflict set */
+  bool m_recording; /*!< True while the active decision is executed and propagated */
+  std::vector<EntityKeys> m_decisionEntities; /*!< Per decision on the stack, the variables it restricted and the
+                                                variables and constraints it created */
+  std::vector<DecisionLevels> m_decisionConflicts; /*!< Per decision on the stack, the conflict set of its failed choices */
+  EntityKeys m_activeEntities; /*!< Provenance of the active decision, while it is executed */
+  DecisionLevels m_activeConflicts; /*!< Conflict set of the active decision */
+  unsigned long m_blameFloor; /*!< Decisions up to this level predate backjumping and are involved in every failure */
+  std::vector<std::pair<eint, unsigned int> > m_checkpointedDecisions; /*!< Key and execution count of each decision
+                                                                        on the stack as of the last checkpoint */
 
   class FlawIterator : public Iterator {
    public:
@@ -295,7 +389,7 @@ class Solver {
    public:
     CeListener(const ConstraintEngineId ce, Solver& dm);
 
-    void notifyAdded(const ConstrainedVariableId variable) {ConstraintEngineListener::notifyAdded(variable);}
+    void notifyAdded(const ConstrainedVariableId variable);
     void notifyRemoved(const ConstrainedVariableId variable);
     void notifyChanged(const ConstrainedVariableId variable, const DomainListener::ChangeType& changeType);
     void notifyAdded(const ConstraintId constraint);
@@ -305,6 +399,7 @@ class Solver {
     Solver& m_solver;
   };
 
+  void notifyAdded(const ConstrainedVariableId variable);
   void notifyRemoved(const ConstrainedVariableId variable);
   void notifyChanged(const ConstrainedVariableId variable, const DomainListener::ChangeType& changeType);
   void notifyAdded(const ConstraintId constraint);
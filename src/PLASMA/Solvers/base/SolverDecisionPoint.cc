@@ -3,6 +3,7 @@
 #include "PlanDatabase.hh"
 #include "DbClient.hh"
 #include "Solver.hh"
+#include "tinyxml.h"
 
 namespace EUROPA {
 namespace SOLVERS {
@@ -45,6 +46,29 @@ DecisionPoint::DecisionPoint(const DbClientId client, eint entityKey,
 
     bool DecisionPoint::cut() const {return m_maxChoices > 0 && m_counter >= m_maxChoices;}
 
+    bool DecisionPoint::getChoices(std::vector<TiXmlElement*>& choices) const {
+      checkError(isExecuted(), "Only an executed decision has a choice in force:" << toString());
+      checkError(choices.empty(), "Expected no choices yet.");
+      if(!handleGetChoices(choices)){
+        for(std::vector<TiXmlElement*>::const_iterator it = choices.begin(); it != choices.end(); ++it)
+          delete *it;
+        choices.clear();
+        return false;
+      }
+
+      // The choice in force, and as many more as the cutoff allows
+      if(m_maxChoices > 0){
+        const unsigned int allowed = 1 + (m_maxChoices > m_counter ? m_maxChoices - m_counter : 0);
+        while(choices.size() > allowed){
+          delete choices.back();
+          choices.pop_back();
+        }
+      }
+      return true;
+    }
+
+    bool DecisionPoint::handleGetChoices(std::vector<TiXmlElement*>&) const {return false;}
+
     bool DecisionPoint::isExecuted() const {return m_isExecuted;}
 
     bool DecisionPoint::canUndo() const{
@@ -110,6 +110,20 @@ namespace EUROPA {
        */
       bool cut() const;
 
+      /**
+       * @brief The number of times the decision has been executed.
+       */
+      unsigned int getExecutionCount() const {return m_counter;}
+
+      /**
+       * @brief Describe the choice in force and the choices still to come as transactions, in the order
+       * they would be made. Choices beyond the cutoff are left out.
+       * @param choices Receives the transactions, the choice in force first. The caller owns them.
+       * @return false if the decision cannot describe its choices as transactions.
+       * @see handleGetChoices, DbClientTransactionLog
+       */
+      bool getChoices(std::vector<TiXmlElement*>& choices) const;
+
       /**
        * @brief Implement this method to construct the set of choices in the
        * required order on demand.
@@ -134,6 +148,13 @@ namespace EUROPA {
        */
       virtual void handleUndo() = 0;
 
+      /**
+       * @brief Implement this method to append the choice in force, then the remaining choices, as
+       * transactions. By default a decision cannot describe its choices.
+       * @see getChoices
+       */
+      virtual bool handleGetChoices(std::vector<TiXmlElement*>& choices) const;
+
       const DbClientId m_client;
       const eint m_entityKey; /*!< The Key of underlying flawed entity. Store instead of ID so we can test it. */
 
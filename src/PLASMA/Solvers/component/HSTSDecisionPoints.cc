@@ -88,6 +88,12 @@ bool ValueEnum::hasNext() const {
   return m_choiceIndex < m_choices->getCount();
 }
 
+bool ValueEnum::getRemainingValues(std::vector<edouble>& values) const {
+  for(unsigned long i = m_choiceIndex; i < m_choices->getCount(); i++)
+    values.push_back(m_choices->getValue(i));
+  return true;
+}
+
 //accepted choice options: mergeFirst, activateFirst, mergeOnly, activateOnly
 //accepted order options (only for merge): early, late, near, far
 OpenConditionDecisionPoint::OpenConditionDecisionPoint(const DbClientId client, 
@@ -26,6 +26,8 @@ namespace EUROPA {
                   const TiXmlElement& configData, const std::string& explanation = "unknown");
         edouble getNext();
         bool hasNext() const;
+      protected:
+        bool getRemainingValues(std::vector<edouble>& values) const;
       private:
         edouble readValue(const TiXmlElement& value) const;
         unsigned int m_choiceIndex;
@@ -3,6 +3,7 @@
 #include "Token.hh"
 #include "TokenVariable.hh"
 #include "ConstrainedVariable.hh"
+#include "DbClientTransactionLog.hh"
 
 // TODO: move this to the appropriate place
 #ifdef _MSC_VER
@@ -142,6 +143,20 @@ bool OpenConditionDecisionPoint::hasNext() const {
   return m_choiceIndex < m_choiceCount;
 }
 
+bool OpenConditionDecisionPoint::handleGetChoices(std::vector<TiXmlElement*>& choices) const {
+  for(unsigned long i = m_choiceIndex; i < m_choiceCount; i++) {
+    if(m_choices[i] == Token::MERGED) {
+      for(unsigned long j = (i == m_choiceIndex ? m_mergeIndex : 0); j < m_mergeCount; j++)
+        choices.push_back(DbClientTransactionLog::mergeAsXml(m_client, m_flawedToken, m_compatibleTokens[j]));
+    }
+    else if(m_choices[i] == Token::ACTIVE)
+      choices.push_back(DbClientTransactionLog::activateAsXml(m_client, m_flawedToken));
+    else
+      choices.push_back(DbClientTransactionLog::rejectAsXml(m_client, m_flawedToken));
+  }
+  return true;
+}
+
 std::string OpenConditionDecisionPoint::toShortString() const{
   // This returns the last executed choice
   unsigned long idx = m_choiceIndex;
@@ -417,17 +432,6 @@ SupportToken::~SupportToken() {}
  * 2. Activate each action only once and only change which effect is merged into token
  */
 
-namespace {
-std::string autoName(const std::string& prefix) {
-  static int i=0;
-  std::stringstream os;
-
-  os << prefix << "-" << (i++);
-
-  return os.str();
-}
-}
-
 void SupportToken::init()
 {
   SchemaId schema = m_dbClient->getSchema();
@@ -474,7 +478,7 @@ void SupportToken::execute()
   // 2. Activate candidate supporting action
   m_action = m_dbClient->createToken(
       actionType->getSignature().c_str(), // TODO: getSignature() should be getQualifiedName(), or something like that
-      autoName(actionType->getName()).c_str(),
+      m_token->getPlanDatabase()->makeAutoName(actionType->getName() + "-").c_str(),
       false, //isRejectable
       false //isFact
                                      );
@@ -64,6 +64,7 @@ namespace EUROPA {
       virtual void handleUndo();
       virtual bool hasNext() const;
       virtual bool canUndo() const;
+      virtual bool handleGetChoices(std::vector<TiXmlElement*>& choices) const;
 
       const TokenId m_flawedToken; /*!< The token to be resolved. */
       std::vector<LabelStr> m_choices; /*!< The sequences list of states to choose. */
@@ -3,6 +3,7 @@
 #include "TokenVariable.hh"
 #include "Object.hh"
 #include "DbClient.hh"
+#include "DbClientTransactionLog.hh"
 #include "Debug.hh"
 #include "PlanDatabase.hh"
 
@@ -64,6 +65,17 @@ namespace EUROPA {
       return m_index < m_choiceCount;
     }
 
+    bool ThreatDecisionPoint::handleGetChoices(std::vector<TiXmlElement*>& choices) const {
+      for(unsigned long i = m_index; i < m_choiceCount; i++){
+        ObjectId object;
+        TokenId predecessor;
+        TokenId successor;
+        extractParts(i, object, predecessor, successor);
+        choices.push_back(DbClientTransactionLog::constrainAsXml(m_client, object, predecessor, successor));
+      }
+      return true;
+    }
+
     class ObjectComparator {
     public:
       bool operator() (const std::pair<ObjectId, std::pair<TokenId, TokenId> >& p1,
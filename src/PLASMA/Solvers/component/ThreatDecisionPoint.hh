@@ -42,6 +42,8 @@ class ThreatDecisionPoint: public DecisionPoint {
   /** Main Interface for the solver **/
   bool hasNext() const;
 
+  bool handleGetChoices(std::vector<TiXmlElement*>& choices) const;
+
   const TokenId m_tokenToOrder; /*!< The token that must be ordered */
   std::vector< std::pair<ObjectId, std::pair<TokenId, TokenId> > > m_choices; /*!< Choices across all objects */
   unsigned long m_choiceCount; /*!< Stored choice count - size of m_orderingChoices */
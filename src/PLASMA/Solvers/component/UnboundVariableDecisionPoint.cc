@@ -1,6 +1,7 @@
 #include "UnboundVariableDecisionPoint.hh"
 #include "ConstrainedVariable.hh"
 #include "DbClient.hh"
+#include "DbClientTransactionLog.hh"
 #include "Domain.hh"
 #include "Debug.hh"
 #include "ValueSource.hh"
@@ -61,6 +62,20 @@ namespace EUROPA {
       m_client->reset(m_flawedVariable);
     }
 
+    bool UnboundVariableDecisionPoint::handleGetChoices(std::vector<TiXmlElement*>& choices) const {
+      std::vector<edouble> values;
+      if(!getRemainingValues(values))
+        return false;
+      checkError(m_flawedVariable->isSpecified(), "Expected " << m_flawedVariable->toString() << " to be specified.");
+      choices.push_back(DbClientTransactionLog::specifyAsXml(m_client, m_flawedVariable,
+                                                             m_flawedVariable->getSpecifiedValue()));
+      for(std::vector<edouble>::const_iterator it = values.begin(); it != values.end(); ++it)
+        choices.push_back(DbClientTransactionLog::specifyAsXml(m_client, m_flawedVariable, *it));
+      return true;
+    }
+
+    bool UnboundVariableDecisionPoint::getRemainingValues(std::vector<edouble>&) const {return false;}
+
     std::string UnboundVariableDecisionPoint::toShortString() const{
       return toString();
     }
@@ -80,6 +95,12 @@ namespace EUROPA {
 
     edouble MinValue::getNext(){return m_choices->getValue(m_choiceIndex++);}
 
+    bool MinValue::getRemainingValues(std::vector<edouble>& values) const {
+      for(unsigned long i = m_choiceIndex; i < m_choices->getCount(); i++)
+        values.push_back(m_choices->getValue(i));
+      return true;
+    }
+
     /** MAX VALUE **/
     MaxValue::MaxValue(const DbClientId client, const ConstrainedVariableId flawedVariable, const TiXmlElement& configData, const std::string& explanation)
       : UnboundVariableDecisionPoint(client, flawedVariable, configData, explanation),
@@ -89,6 +110,12 @@ namespace EUROPA {
 
     edouble MaxValue::getNext(){return m_choices->getValue(--m_choiceIndex);}
 
+    bool MaxValue::getRemainingValues(std::vector<edouble>& values) const {
+      for(unsigned long i = m_choiceIndex; i > 0; i--)
+        values.push_back(m_choices->getValue(i - 1));
+      return true;
+    }
+
     /** RANDOM VALUE **/
   RandomValue::RandomValue(const DbClientId client, 
                            const ConstrainedVariableId flawedVariable, 
@@ -153,5 +180,12 @@ namespace EUROPA {
 
       return value;
     }
+
+    bool RandomValue::getRemainingValues(std::vector<edouble>& values) const {
+      for(unsigned long i = 0; i < m_choices->getCount(); i++)
+        if(m_usedIndices.find(i) == m_usedIndices.end())
+          values.push_back(m_choices->getValue(i));
+      return true;
+    }
   }
 }
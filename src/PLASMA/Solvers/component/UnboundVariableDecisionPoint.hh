@@ -73,6 +73,18 @@ class UnboundVariableDecisionPoint: public DecisionPoint {
    * on the representation of choices in the derived class.
    */
   virtual edouble getNext() = 0;
+
+  /**
+   * @brief Appends the specified value, then the values getNext would still return, as specify transactions.
+   */
+  virtual bool handleGetChoices(std::vector<TiXmlElement*>& choices) const;
+
+  /**
+   * @brief Retrieves the values getNext would still return, in the order it would return them. By default
+   * they are unknown.
+   * @return false if the values cannot be listed.
+   */
+  virtual bool getRemainingValues(std::vector<edouble>& values) const;
 private:
   UnboundVariableDecisionPoint(const UnboundVariableDecisionPoint&);
   UnboundVariableDecisionPoint& operator=(const UnboundVariableDecisionPoint&);
@@ -88,6 +100,9 @@ private:
       bool hasNext() const;
       edouble getNext();
 
+    protected:
+      bool getRemainingValues(std::vector<edouble>& values) const;
+
     private:
 
       unsigned long m_choiceIndex; /*!< The current position in the list of choices. */
@@ -103,6 +118,9 @@ private:
       bool hasNext() const;
       edouble getNext();
 
+    protected:
+      bool getRemainingValues(std::vector<edouble>& values) const;
+
     private:
 
       unsigned long m_choiceIndex; /*!< The current position in the list of choices. */
@@ -123,6 +141,12 @@ private:
     protected:
       enum Distribution {UNIFORM, NORMAL};
 
+      /**
+       * @brief The values not drawn yet, in ascending order of their index. The order they would be drawn
+       * in is not known until they are.
+       */
+      bool getRemainingValues(std::vector<edouble>& values) const;
+
     private:
 
       std::set<unsigned long> m_usedIndices; /*!< The set of used choices so far. Each is the index of the choice
@@ -27,7 +27,7 @@ namespace SOLVERS {
  * @see ComponentFactory
  */
 UnboundVariableManager::UnboundVariableManager(const TiXmlElement& configData)
-    : FlawManager(configData), m_flawCandidates() {}
+    : FlawManager(configData, true), m_flawCandidates() {}
 
     void UnboundVariableManager::handleInitialize(){
 
@@ -82,6 +82,7 @@ UnboundVariableManager::UnboundVariableManager(const TiXmlElement& configData)
     void UnboundVariableManager::updateFlaw(const ConstrainedVariableId var){
       debugMsg("UnboundVariableManager:updateFlaw", var->toLongString());
       m_flawCandidates.erase(var);
+      dequeueFlaw(var);
 
       if(variableOfNonActiveToken(var) || !var->canBeSpecified() || var->isSpecified() || staticMatch(var)){
         debugMsg("UnboundVariableManager:updateFlaw", "Excluding  " << var->toLongString());
@@ -95,6 +96,7 @@ UnboundVariableManager::UnboundVariableManager(const TiXmlElement& configData)
 	       "Including " << var->getKey() << ". " << var->toString() << " as a candidate flaw.");
 
       m_flawCandidates.insert(var);
+      queueFlaw(var);
     }
 
     void UnboundVariableManager::removeFlaw(const ConstrainedVariableId var){
@@ -103,6 +105,7 @@ UnboundVariableManager::UnboundVariableManager(const TiXmlElement& configData)
 		   "Removing " << var->getKey() << ". " << var->toString() << " as a flaw.");
 
       m_flawCandidates.erase(var);
+      dequeueFlaw(var);
     }
 
     bool UnboundVariableManager::variableOfNonActiveToken(const ConstrainedVariableId var){
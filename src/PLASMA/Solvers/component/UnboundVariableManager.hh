@@ -37,6 +37,7 @@ class UnboundVariableManager: public FlawManager {
   void removeFlaw(const ConstrainedVariableId var);
   void updateFlaw(const ConstrainedVariableId var);
   bool betterThan(const EntityId a, const EntityId b, std::string& explanation);
+  bool breaksTiesByKey() const {return false;}
 
   /**
    * @brief Utility to test if the given variable is part of a token that is merged, rejected or inactive.
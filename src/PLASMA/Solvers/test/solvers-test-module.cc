@@ -25,6 +25,8 @@
 #include "Context.hh"
 #include "STNTemporalAdvisor.hh"
 #include "DbClientTransactionPlayer.hh"
+#include "DbClientTransactionLog.hh"
+#include "BinaryTransactionLog.hh"
 #include "TemporalPropagator.hh"
 #include "CESchema.hh"
 #include "tinyxml.h"
@@ -38,6 +40,7 @@
 #include "ModuleNddl.hh"
 
 #include <fstream>
+#include <cstdio>
 
 #include <boost/scoped_ptr.hpp>
 #include <boost/algorithm/string/predicate.hpp>
@@ -1609,6 +1612,7 @@ public:
     EUROPA_runTest(testMinValuesSimpleCSP);
     EUROPA_runTest(testSuccessfulSearch);
     EUROPA_runTest(testExhaustiveSearch);
+    EUROPA_runTest(testBackjumping);
     EUROPA_runTest(testSimpleActivation);
     EUROPA_runTest(testSimpleRejection);
     EUROPA_runTest(testMultipleSearch);
@@ -1621,10 +1625,158 @@ public:
     EUROPA_runTest(testDeleteAfterCommit);
     EUROPA_runTest(testSingleonGuardLoop);
     EUROPA_runTest(testNoMoreFlawsAfterAddition);
+    EUROPA_runTest(testTrailedBacktracking);
+    EUROPA_runTest(testCheckpoints);
     return true;
   }
 
 private:
+  /**
+   * @brief The values of the global variables, by name, so plans from different engines can be compared.
+   */
+  static std::string globalValues(const PlanDatabaseId db) {
+    std::map<std::string, std::string> values;
+    const ConstrainedVariableSet& allVars = db->getGlobalVariables();
+    for(ConstrainedVariableSet::const_iterator it = allVars.begin(); it != allVars.end(); ++it)
+      values[(*it)->getName()] = (*it)->lastDomain().toString();
+
+    std::ostringstream os;
+    for(std::map<std::string, std::string>::const_iterator it = values.begin(); it != values.end(); ++it)
+      os << it->first << "=" << it->second << ";";
+    return os.str();
+  }
+
+  /**
+   * @brief Undoing decisions by restoring trailed domains must search exactly as relaxing and
+   * repropagating does, through chronological backtracking, backjumps and partial resets.
+   */
+  static bool testTrailedBacktracking(){
+    std::vector<std::string> plans[2];
+    std::vector<unsigned long> steps[2];
+    for(unsigned int i = 0; i < 2; i++){
+      {
+        TestEngine testEngine;
+        TiXmlElement* root = initXml((getTestLoadLibraryPath() + "/SolverTests.xml").c_str(), "BackjumpingSolver");
+        CPPUNIT_ASSERT(testEngine.playTransactions((getTestLoadLibraryPath() + "/Backjumping.nddl").c_str()));
+        Solver solver(testEngine.getPlanDatabase(), *(root->FirstChildElement()));
+        solver.setUseTrail(i == 1);
+        CPPUNIT_ASSERT(solver.getUseTrail() == (i == 1));
+        CPPUNIT_ASSERT(!solver.solve());
+        steps[i].push_back(solver.getStepCount());
+
+        solver.reset();
+        solver.setBackjumping(true);
+        CPPUNIT_ASSERT(!solver.solve());
+        steps[i].push_back(solver.getStepCount());
+      }
+      {
+        TestEngine testEngine;
+        TiXmlElement* root = initXml((getTestLoadLibraryPath() + "/SolverTests.xml").c_str(), "SimpleCSPSolver");
+        CPPUNIT_ASSERT(testEngine.playTransactions((getTestLoadLibraryPath() + "/StaticCSP.nddl").c_str()));
+        Solver solver(testEngine.getPlanDatabase(), *(root->FirstChildElement()));
+        solver.setUseTrail(i == 1);
+        CPPUNIT_ASSERT(solver.solve());
+        plans[i].push_back(globalValues(testEngine.getPlanDatabase()));
+
+        // Retract the last decision repeatedly to walk through further solutions
+        for(unsigned int j = 0; j < 10 && !solver.isExhausted(); j++){
+          solver.backjump(1);
+          if(solver.solve())
+            plans[i].push_back(globalValues(testEngine.getPlanDatabase()));
+          steps[i].push_back(solver.getStepCount());
+          steps[i].push_back(solver.getDepth());
+        }
+
+        solver.reset(2);
+        CPPUNIT_ASSERT(solver.solve());
+        plans[i].push_back(globalValues(testEngine.getPlanDatabase()));
+        steps[i].push_back(solver.getStepCount());
+      }
+    }
+
+    CPPUNIT_ASSERT(plans[0].size() > 2);
+    CPPUNIT_ASSERT(plans[0] == plans[1]);
+    CPPUNIT_ASSERT(steps[0] == steps[1]);
+    return true;
+  }
+
+  /**
+   * @brief A decision stack restored from a checkpoint must search on exactly as the one it was checkpointed from.
+   */
+  static bool testCheckpoints(){
+    const std::string dbFileName("db-checkpoints.log");
+    const std::string solverFileName("solver-checkpoints.log");
+    std::string values;
+    unsigned long depth = 0;
+    unsigned int remainingSteps = 0;
+
+    {
+      TestEngine testEngine;
+      TiXmlElement* root = initXml((getTestLoadLibraryPath() + "/SolverTests.xml").c_str(), "BackjumpingSolver");
+      DbClientId client = testEngine.getPlanDatabase()->getClient();
+      client->enableTransactionLogging();
+      DbClientTransactionLog* txLog = new DbClientTransactionLog(client);
+      CPPUNIT_ASSERT(testEngine.playTransactions((getTestLoadLibraryPath() + "/Backjumping.nddl").c_str()));
+      std::ofstream dbStream(dbFileName.c_str(), std::ios::out | std::ios::binary);
+      std::ofstream solverStream(solverFileName.c_str(), std::ios::out | std::ios::binary);
+      BinaryTransactionWriter dbWriter(dbStream);
+      BinaryTransactionWriter solverWriter(solverStream);
+      Solver solver(testEngine.getPlanDatabase(), *(root->FirstChildElement()));
+
+      // Checkpoint twice, the second time after backtracking through decisions of the first,
+      // each time right after a successful step so that no decision is pending
+      unsigned int checkpoints = 0;
+      unsigned long previousDepth = 0;
+      while(checkpoints < 2 && !solver.isExhausted()){
+        solver.step();
+        bool succeeded = (solver.getDepth() == previousDepth + 1);
+        previousDepth = solver.getDepth();
+        if(succeeded && solver.getStepCount() >= 15 * (1 + 2 * checkpoints)){
+          CPPUNIT_ASSERT(client->propagate());
+          txLog->checkpoint(dbWriter);
+          solver.checkpoint(solverWriter);
+          checkpoints++;
+        }
+      }
+      CPPUNIT_ASSERT(checkpoints == 2);
+      values = globalValues(testEngine.getPlanDatabase());
+      depth = solver.getDepth();
+      CPPUNIT_ASSERT(depth > 1);
+
+      unsigned int stepCount = solver.getStepCount();
+      while(!solver.solve() && solver.isTimedOut()) {}
+      CPPUNIT_ASSERT(solver.isExhausted());
+      remainingSteps = solver.getStepCount() - stepCount;
+
+      dbStream.close();
+      solverStream.close();
+      delete txLog;
+    }
+
+    {
+      TestEngine testEngine;
+      TiXmlElement* root = initXml((getTestLoadLibraryPath() + "/SolverTests.xml").c_str(), "BackjumpingSolver");
+      testEngine.getPlanDatabase()->getClient()->enableTransactionLogging();
+      DbClientTransactionPlayer player(testEngine.getPlanDatabase()->getClient());
+      BinaryTransactionReader dbReader(dbFileName);
+      player.restore(dbReader);
+      Solver solver(testEngine.getPlanDatabase(), *(root->FirstChildElement()));
+      BinaryTransactionReader solverReader(solverFileName);
+      solver.restore(solverReader);
+      CPPUNIT_ASSERT(solver.getDepth() == depth);
+      CPPUNIT_ASSERT(globalValues(testEngine.getPlanDatabase()) == values);
+
+      // Backtracking into the restored decisions moves them on to the choices they had left
+      while(!solver.solve() && solver.isTimedOut()) {}
+      CPPUNIT_ASSERT(solver.isExhausted());
+      CPPUNIT_ASSERT(solver.getStepCount() == remainingSteps);
+    }
+
+    std::remove(dbFileName.c_str());
+    std::remove(solverFileName.c_str());
+    return true;
+  }
+
   static bool testNoMoreFlawsAfterAddition() {
     TestEngine testEngine;
     TiXmlElement* root = initXml( (getTestLoadLibraryPath() + "/SolverTests.xml").c_str(), "SingletonLoop");
@@ -1744,6 +1896,31 @@ private:
     return true;
   }
 
+  /**
+   * @brief The all-different constraint on v0, v3 and v4 cannot be satisfied. Backjumping should not
+   * revisit v1 and v2, which are decided in between and play no part in the conflict.
+   */
+  static bool testBackjumping(){
+    TestEngine testEngine;
+    TiXmlElement* root = initXml((getTestLoadLibraryPath() + "/SolverTests.xml").c_str(), "BackjumpingSolver");
+    TiXmlElement* child = root->FirstChildElement();
+    {
+      CPPUNIT_ASSERT(testEngine.playTransactions((getTestLoadLibraryPath() + "/Backjumping.nddl").c_str()));
+      Solver solver(testEngine.getPlanDatabase(), *child);
+      CPPUNIT_ASSERT(!solver.getBackjumping());
+      CPPUNIT_ASSERT(!solver.solve());
+      CPPUNIT_ASSERT_MESSAGE(toString(solver.getStepCount()), solver.getStepCount() == 2 + 20 + 200 + 400 + 800);
+
+      // Per value of v0: one step each for v0, v1 and v2, then both values of v3 with both values of v4 under each
+      solver.reset();
+      solver.setBackjumping(true);
+      CPPUNIT_ASSERT(!solver.solve());
+      CPPUNIT_ASSERT(solver.isExhausted());
+      CPPUNIT_ASSERT_MESSAGE(toString(solver.getStepCount()), solver.getStepCount() == 2 * (3 + 2 * 3));
+    }
+    return true;
+  }
+
   static bool testSimpleActivation() {
     TestEngine testEngine;
     TiXmlElement* root = initXml((getTestLoadLibraryPath() + "/SolverTests.xml").c_str(), "SimpleActivationSolver");
@@ -2020,6 +2197,9 @@ public:
     EUROPA_runTest(testUnboundVariableFlawIteration);
     EUROPA_runTest(testThreatFlawIteration);
     EUROPA_runTest(testOpenConditionFlawIteration);
+    EUROPA_runTest(testQueuedFlawSelection);
+    EUROPA_runTest(testQueuedVariableFlawOrder);
+    EUROPA_runTest(testQueuedOpenConditionOrder);
     //EUROPA_runTest(testSolverIteration);
     return true;
   }
@@ -2094,6 +2274,212 @@ private:
     return true;
   }
 
+  /**
+   * Exposes the scan over all candidates that flaw managers with a priority queue replace.
+   */
+  template <class Manager>
+  class RescanningManager : public Manager {
+  public:
+    RescanningManager(const TiXmlElement& configData) : Manager(configData) {}
+    DecisionPointId rescan(Priority& bestPriority) {return this->nextScanned(bestPriority);}
+  };
+
+  /**
+   * Asserts that the queue and a full rescan choose the same flaw with the same priority,
+   * and returns the decision from the queue.
+   */
+  template <class Manager>
+  static DecisionPointId nextAsRescan(RescanningManager<Manager>& fm) {
+    Priority queued = getWorstCasePriority();
+    DecisionPointId fromQueue = fm.next(queued);
+    Priority scanned = getWorstCasePriority();
+    DecisionPointId fromScan = fm.rescan(scanned);
+    CPPUNIT_ASSERT(fromQueue.isId() == fromScan.isId());
+    if(fromScan.isId()) {
+      CPPUNIT_ASSERT_MESSAGE(toString(fromQueue->getFlawedEntityKey()) + " vs " + toString(fromScan->getFlawedEntityKey()),
+                             fromQueue->getFlawedEntityKey() == fromScan->getFlawedEntityKey());
+      CPPUNIT_ASSERT(queued == scanned);
+      delete static_cast<DecisionPoint*>(fromScan);
+    }
+    return fromQueue;
+  }
+
+  static eint nextKeyAsRescan(RescanningManager<OpenConditionManager>& fm) {
+    DecisionPointId dp = nextAsRescan(fm);
+    CPPUNIT_ASSERT(dp.isId());
+    eint key = dp->getFlawedEntityKey();
+    delete static_cast<DecisionPoint*>(dp);
+    return key;
+  }
+
+  /**
+   * Resolves variable flaws in the order the queue gives them, then undoes the decisions so
+   * the flaws come back, checking every choice against a full rescan.
+   */
+  static bool testQueuedVariableFlawOrder() {
+    TestEngine testEngine;
+    boost::scoped_ptr<TiXmlElement> root(initXml( (getTestLoadLibraryPath() + "/FlawHandlerTests.xml").c_str(), "HeuristicVariableOrdering"));
+    TiXmlElement* child = root->FirstChildElement()->FirstChildElement("UnboundVariableManager");
+    CPPUNIT_ASSERT(testEngine.playTransactions( (getTestLoadLibraryPath() + "/StaticCSP.nddl").c_str()));
+    PlanDatabaseId db = testEngine.getPlanDatabase();
+    Context ctx("");
+    ctx.put("horizonStart", 0);
+    ctx.put("horizonEnd", 1000);
+    RescanningManager<UnboundVariableManager> fm(*child);
+    fm.initialize(*child, db, ctx.getId());
+    CPPUNIT_ASSERT(db->getConstraintEngine()->propagate());
+
+    std::list<DecisionPointId> decisions;
+    for(DecisionPointId dp = nextAsRescan(fm); dp.isId(); dp = nextAsRescan(fm)) {
+      dp->initialize();
+      dp->execute();
+      CPPUNIT_ASSERT(db->getConstraintEngine()->propagate());
+      decisions.push_front(dp);
+      CPPUNIT_ASSERT(decisions.size() < 10);
+
+      // A new flaw in the middle of it
+      if(decisions.size() == 2)
+        db->getClient()->createVariable("int", IntervalIntDomain(0, 10), "v5");
+    }
+    CPPUNIT_ASSERT(!decisions.empty());
+
+    while(!decisions.empty()) {
+      decisions.front()->undo();
+      delete static_cast<DecisionPoint*>(decisions.front());
+      decisions.pop_front();
+      CPPUNIT_ASSERT(db->getConstraintEngine()->propagate());
+
+      DecisionPointId dp = nextAsRescan(fm);
+      CPPUNIT_ASSERT(dp.isId());
+      delete static_cast<DecisionPoint*>(dp);
+    }
+
+    return true;
+  }
+
+  /**
+   * Open conditions enter and leave the queue as tokens are activated and cancelled, and are
+   * re-scored as guards of their flaw handlers are met. Every choice must match a full rescan.
+   */
+  static bool testQueuedOpenConditionOrder() {
+    TestEngine testEngine(true);
+    boost::scoped_ptr<TiXmlElement> root(initXml( (getTestLoadLibraryPath() + "/FlawHandlerTests.xml").c_str(), "TestDynamicFlaws"));
+    TiXmlElement* child = root->FirstChildElement()->FirstChildElement("OpenConditionManager");
+    PlanDatabaseId db = testEngine.getPlanDatabase();
+    Object o2(db, "D", "o2");
+    Object o5(db, "D", "o5");
+    db->close();
+    Context ctx("");
+    ctx.put("horizonStart", 0);
+    ctx.put("horizonEnd", 1000);
+    RescanningManager<OpenConditionManager> fm(*child);
+    fm.initialize(*child, db, ctx.getId());
+
+    TokenId master1 = db->getClient()->createToken("D.predicateF", "", false);
+    boost::shared_ptr<Token> ptr1(&*master1, NukeToken(db->getClient()));
+    TokenId master2 = db->getClient()->createToken("D.predicateF", "", false);
+    boost::shared_ptr<Token> ptr2(&*master2, NukeToken(db->getClient()));
+    CPPUNIT_ASSERT(db->getConstraintEngine()->propagate());
+    nextKeyAsRescan(fm);
+
+    // Activation replaces each master by its slaves
+    master1->activate();
+    CPPUNIT_ASSERT(db->getConstraintEngine()->propagate());
+    CPPUNIT_ASSERT(nextKeyAsRescan(fm) != master1->getKey());
+    master2->activate();
+    CPPUNIT_ASSERT(db->getConstraintEngine()->propagate());
+    nextKeyAsRescan(fm);
+
+    // Meeting the guards of the prioritized handlers moves the slave to the front
+    TokenId slave = master1->getSlave(1);
+    CPPUNIT_ASSERT(slave->getPredicateName() == "D.predicateC");
+    slave->start()->specify(10);
+    CPPUNIT_ASSERT(db->getConstraintEngine()->propagate());
+    CPPUNIT_ASSERT(nextKeyAsRescan(fm) == slave->getKey());
+    slave->end()->specify(20);
+    CPPUNIT_ASSERT(db->getConstraintEngine()->propagate());
+    CPPUNIT_ASSERT(nextKeyAsRescan(fm) == slave->getKey());
+
+    // and activating it takes it out of the queue until it is cancelled again
+    slave->activate();
+    CPPUNIT_ASSERT(db->getConstraintEngine()->propagate());
+    CPPUNIT_ASSERT(nextKeyAsRescan(fm) != slave->getKey());
+    slave->cancel();
+    CPPUNIT_ASSERT(db->getConstraintEngine()->propagate());
+    CPPUNIT_ASSERT(nextKeyAsRescan(fm) == slave->getKey());
+
+    // Unmet guards put it back at the default priority
+    slave->end()->reset();
+    slave->start()->reset();
+    CPPUNIT_ASSERT(db->getConstraintEngine()->propagate());
+    nextKeyAsRescan(fm);
+
+    master2->cancel();
+    CPPUNIT_ASSERT(db->getConstraintEngine()->propagate());
+    nextKeyAsRescan(fm);
+
+    return true;
+  }
+
+  /**
+   * The flaw chosen from the priority queue must follow changes in priorities and candidates,
+   * and agree with a scan of the iterator.
+   */
+  static bool testQueuedFlawSelection() {
+    TestEngine testEngine;
+    boost::scoped_ptr<TiXmlElement> root(initXml( (getTestLoadLibraryPath() + "/FlawHandlerTests.xml").c_str(), "HeuristicVariableOrdering"));
+    TiXmlElement* child = root->FirstChildElement()->FirstChildElement("UnboundVariableManager");
+    CPPUNIT_ASSERT(testEngine.playTransactions( (getTestLoadLibraryPath() + "/StaticCSP.nddl").c_str()));
+    PlanDatabaseId db = testEngine.getPlanDatabase();
+    Context ctx("");
+    ctx.put("horizonStart", 0);
+    ctx.put("horizonEnd", 1000);
+    UnboundVariableManager fm(*child);
+    fm.initialize(*child, db, ctx.getId());
+    CPPUNIT_ASSERT(db->getConstraintEngine()->propagate());
+
+    ConstrainedVariableId v1 = db->getGlobalVariable("v1");
+    ConstrainedVariableId v2 = db->getGlobalVariable("v2");
+
+    // v2 has the best priority, then v1
+    Priority priority = getWorstCasePriority();
+    DecisionPointId dp = fm.next(priority);
+    CPPUNIT_ASSERT(dp.isId() && dp->getFlawedEntityKey() == v2->getKey());
+    CPPUNIT_ASSERT(priority == 0);
+    delete static_cast<DecisionPoint*>(dp);
+
+    v2->specify(0);
+    CPPUNIT_ASSERT(db->getConstraintEngine()->propagate());
+    priority = getWorstCasePriority();
+    dp = fm.next(priority);
+    CPPUNIT_ASSERT(dp.isId() && dp->getFlawedEntityKey() == v1->getKey());
+    CPPUNIT_ASSERT(priority == 1);
+    delete static_cast<DecisionPoint*>(dp);
+
+    // The rest share the default priority and are told apart by betterThan
+    v1->specify(1);
+    CPPUNIT_ASSERT(db->getConstraintEngine()->propagate());
+    ConstrainedVariableId best;
+    IteratorId flawIterator = fm.createIterator();
+    while(!flawIterator->done()) {
+      ConstrainedVariableId var = flawIterator->next();
+      CPPUNIT_ASSERT(fm.getPriority(var) == 100);
+      if(best.isNoId() || var->lastDomain().getSize() < best->lastDomain().getSize())
+        best = var;
+    }
+    delete static_cast<Iterator*>(flawIterator);
+    CPPUNIT_ASSERT(best.isId());
+
+    priority = getWorstCasePriority();
+    dp = fm.next(priority);
+    CPPUNIT_ASSERT(dp.isId());
+    CPPUNIT_ASSERT_MESSAGE(toString(dp->getFlawedEntityKey()) + " vs " + toString(best->getKey()),
+                           dp->getFlawedEntityKey() == best->getKey());
+    delete static_cast<DecisionPoint*>(dp);
+
+    return true;
+  }
+
   static bool testThreatFlawIteration() {
     TiXmlElement* root = initXml((getTestLoadLibraryPath() + "/FlawFilterTests.xml" ).c_str(), "ThreatManager");
 
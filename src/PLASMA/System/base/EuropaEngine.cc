@@ -105,7 +105,7 @@ const RulesEngine*      EuropaEngine::getRulesEnginePtr()      const { return st
       if(!playTransactions(txSource, language))
         return false;
 
-      debugMsg("EuropaEngine:plan", "Initial state: " << std::endl << PlanDatabaseWriter::toString(getPlanDatabase()))
+      debugMsg("EuropaEngine:plan", "Initial state: " << std::endl << PlanDatabaseWriter::Plan(getPlanDatabase()))
       //LOGGER << Logger::DEBUG << "plan: Initial state: " << Logger::eol << PlanDatabaseWriter::toString(getPlanDatabase());
       LOGGER_DEBUG_MSG( DEBUG, "Initial state: " << LOGGER_ENDL << PlanDatabaseWriter::toString(getPlanDatabase()) )
 
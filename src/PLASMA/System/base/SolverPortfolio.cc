@@ -0,0 +1,223 @@
+#include "SolverPortfolio.hh"
+#include "EuropaEngine.hh"
+#include "ConstraintEngine.hh"
+#include "PlanDatabase.hh"
+#include "Solver.hh"
+#include "Context.hh"
+#include "Mutex.hh"
+#include "Debug.hh"
+#include "Error.hh"
+#include "tinyxml.h"
+
+/**
+ * @file SolverPortfolio.cc
+ * @brief Provides the implementation for SolverPortfolio.
+ */
+
+namespace EUROPA {
+
+  /**
+   * @brief Records the search of a worker in its stats, and stops the search once another worker
+   * has claimed the result by dropping its step limit so that the solver times out on its next step.
+   */
+  class SolverPortfolio::WorkerListener : public SOLVERS::SearchListener {
+  public:
+    WorkerListener(SolverPortfolio& portfolio, SOLVERS::Solver& solver, WorkerStats& stats)
+      : m_portfolio(portfolio), m_solver(solver), m_stats(stats) {}
+
+    void notifyStepSucceeded(SOLVERS::DecisionPointId) {check();}
+    void notifyStepFailed(SOLVERS::DecisionPointId) {m_stats.failedSteps++; check();}
+    void notifyRetractSucceeded(SOLVERS::DecisionPointId) {m_stats.retractions++; check();}
+    void notifyRetractNotDone(SOLVERS::DecisionPointId) {m_stats.retractions++; check();}
+    void notifyCompleted() {m_stats.solved = true; done();}
+    void notifyExhausted() {m_stats.exhausted = true; done();}
+    void notifyTimedOut() {m_stats.timedOut = !m_stats.cancelled; done();}
+
+  private:
+    void check() {
+      if(!m_stats.cancelled && m_portfolio.isDecided()) {
+        m_solver.setMaxSteps(0);
+        m_stats.cancelled = true;
+      }
+    }
+
+    void done() {
+      m_stats.stepCount = m_solver.getStepCount();
+      m_stats.depth = m_solver.getDepth();
+    }
+
+    SolverPortfolio& m_portfolio;
+    SOLVERS::Solver& m_solver;
+    WorkerStats& m_stats;
+  };
+
+  struct SolverPortfolio::Task {
+    SolverPortfolio* portfolio;
+    unsigned int worker;
+  };
+
+  SolverPortfolio::WorkerStats::WorkerStats()
+    : solved(false), exhausted(false), timedOut(false), cancelled(false),
+      stepCount(0), depth(0), failedSteps(0), retractions(0), error() {}
+
+  SolverPortfolio::SolverPortfolio(const std::string& language, const std::string& initialState, bool isFile)
+    : m_language(language), m_initialState(initialState), m_isFile(isFile),
+      m_workers(), m_stats(), m_run(false), m_winner(-1) {
+    pthread_mutex_init(&m_mutex, NULL);
+  }
+
+  SolverPortfolio::~SolverPortfolio() {
+    releaseEngines(false);
+    pthread_mutex_destroy(&m_mutex);
+  }
+
+  unsigned int SolverPortfolio::addWorker(const std::string& solverConfig,
+                                          eint::basis_type horizonStart,
+                                          eint::basis_type horizonEnd,
+                                          unsigned int maxSteps,
+                                          unsigned int maxDepth) {
+    checkError(!m_run, "Cannot add workers to a portfolio that has been run.");
+    Worker worker;
+    worker.solverConfig = solverConfig;
+    worker.horizonStart = horizonStart;
+    worker.horizonEnd = horizonEnd;
+    worker.maxSteps = maxSteps;
+    worker.maxDepth = maxDepth;
+    worker.engine = NULL;
+    m_workers.push_back(worker);
+    m_stats.push_back(WorkerStats());
+    return static_cast<unsigned int>(m_workers.size() - 1);
+  }
+
+  /**
+   * Engines are started here rather than on the workers since module initialization registers
+   * with process-wide tables, and shut down here after all workers are done since shutting an
+   * engine down purges entities process-wide.
+   */
+  bool SolverPortfolio::solve() {
+    checkError(!m_workers.empty(), "A portfolio needs at least one worker.");
+    checkError(!m_run, "A portfolio can only be run once.");
+    m_run = true;
+
+    for(unsigned int i = 0; i < m_workers.size(); i++) {
+      m_workers[i].engine = new EuropaEngine();
+      configureEngine(i, *m_workers[i].engine);
+      m_workers[i].engine->doStart();
+    }
+
+    std::vector<Task> tasks(m_workers.size());
+    std::vector<pthread_t> threads(m_workers.size());
+    std::vector<bool> started(m_workers.size(), false);
+    for(unsigned int i = 0; i < m_workers.size(); i++) {
+      tasks[i].portfolio = this;
+      tasks[i].worker = i;
+      started[i] = (pthread_create(&threads[i], NULL, runWorker, &tasks[i]) == 0);
+      if(!started[i])
+        run(i);
+    }
+
+    for(unsigned int i = 0; i < m_workers.size(); i++)
+      if(started[i])
+        pthread_join(threads[i], NULL);
+
+    debugMsg("SolverPortfolio:solve", "Finished with winner " << m_winner);
+
+    // Keep only the engine holding the plan
+    releaseEngines(true);
+    return m_winner >= 0;
+  }
+
+  int SolverPortfolio::getWinner() const {return m_winner;}
+
+  EuropaEngine* SolverPortfolio::getWinningEngine() const {
+    return (m_winner < 0 ? NULL : m_workers[m_winner].engine);
+  }
+
+  void SolverPortfolio::configureEngine(unsigned int, EuropaEngine&) {}
+
+  SOLVERS::SearchListener* SolverPortfolio::createListener(unsigned int) {return NULL;}
+
+  void* SolverPortfolio::runWorker(void* arg) {
+    Task* task = static_cast<Task*>(arg);
+    task->portfolio->run(task->worker);
+    return NULL;
+  }
+
+  void SolverPortfolio::run(unsigned int i) {
+    Worker& worker = m_workers[i];
+    WorkerStats& stats = m_stats[i];
+    SOLVERS::SearchListener* listener = NULL;
+    SOLVERS::SolverId solver;
+
+    try {
+      std::string errors = worker.engine->executeScript(m_language, m_initialState, m_isFile);
+      checkRuntimeError(errors.empty(), "Failed to load " << m_initialState << ": " << errors);
+      checkRuntimeError(worker.engine->getConstraintEngine()->constraintConsistent(),
+                        "Initial state " << m_initialState << " is inconsistent");
+
+      TiXmlDocument doc(worker.solverConfig.c_str());
+      doc.LoadFile();
+      checkRuntimeError(!doc.Error(), worker.solverConfig << ": " << doc.ErrorDesc());
+
+      solver = (new SOLVERS::Solver(worker.engine->getPlanDatabase(), *doc.RootElement()))->getId();
+      solver->getContext()->put("horizonStart", static_cast<double>(worker.horizonStart));
+      solver->getContext()->put("horizonEnd", static_cast<double>(worker.horizonEnd));
+
+      WorkerListener recorder(*this, *solver, stats);
+      solver->addListener(recorder.getId());
+      listener = createListener(i);
+      if(listener != NULL)
+        solver->addListener(listener->getId());
+
+      // Another worker may have finished while this one was loading
+      if(isDecided())
+        stats.cancelled = true;
+      else if(solver->solve(worker.maxSteps, worker.maxDepth))
+        claim(i);
+
+      debugMsg("SolverPortfolio:run", "Worker " << i << " (" << worker.solverConfig << ") " <<
+               (stats.solved ? "solved" : "did not solve") << " the problem in " << stats.stepCount <<
+               " steps at depth " << stats.depth <<
+               " with " << stats.failedSteps << " failed steps and " << stats.retractions << " retractions");
+
+      solver->removeListener(recorder.getId());
+      if(listener != NULL)
+        solver->removeListener(listener->getId());
+    }
+    catch(const Error& e) {
+      stats.error = e.getMsg();
+      debugMsg("SolverPortfolio:run", "Worker " << i << " failed: " << stats.error);
+    }
+    catch(...) {
+      // Nothing may escape the thread
+      stats.error = "Unexpected exception";
+      debugMsg("SolverPortfolio:run", "Worker " << i << " failed with an unexpected exception");
+    }
+
+    if(solver.isId())
+      delete static_cast<SOLVERS::Solver*>(solver);
+    delete listener;
+  }
+
+  bool SolverPortfolio::claim(unsigned int worker) {
+    MutexGrabber grabber(m_mutex);
+    if(m_winner < 0)
+      m_winner = static_cast<int>(worker);
+    return m_winner == static_cast<int>(worker);
+  }
+
+  bool SolverPortfolio::isDecided() {
+    MutexGrabber grabber(m_mutex);
+    return m_winner >= 0;
+  }
+
+  void SolverPortfolio::releaseEngines(bool keepWinner) {
+    for(unsigned int i = 0; i < m_workers.size(); i++) {
+      if(m_workers[i].engine == NULL || (keepWinner && static_cast<int>(i) == m_winner))
+        continue;
+      m_workers[i].engine->doShutdown();
+      delete m_workers[i].engine;
+      m_workers[i].engine = NULL;
+    }
+  }
+}
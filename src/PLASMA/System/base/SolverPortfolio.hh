@@ -0,0 +1,144 @@
+#ifndef H_SolverPortfolio
+#define H_SolverPortfolio
+
+/**
+ * @file SolverPortfolio.hh
+ * @brief Runs several solver configurations on the same problem in parallel.
+ */
+
+#include "SolverDefs.hh"
+#include "SearchListener.hh"
+
+#include <limits>
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+namespace EUROPA {
+
+  class EuropaEngine;
+
+  /**
+   * @brief Runs a portfolio of solvers in parallel, each on its own EuropaEngine loaded with the
+   * same model and initial state, and keeps the first plan found.
+   *
+   * Every worker differs only in its solver configuration and limits. Engines are created and
+   * started on the calling thread; loading the initial state and searching happen on one thread
+   * per worker. When a worker finds a plan it claims the result, and the others stop at their
+   * next search step. The engine holding the plan is kept until the portfolio is deleted; the
+   * others are shut down once all workers have finished.
+   */
+  class SolverPortfolio {
+  public:
+    /**
+     * @brief Outcome of the search of one worker, recorded from the notifications of its solver.
+     */
+    struct WorkerStats {
+      WorkerStats();
+      bool solved; /*!< A plan was found, whether or not it was the first */
+      bool exhausted;
+      bool timedOut;
+      bool cancelled; /*!< Stopped because another worker found a plan first */
+      unsigned int stepCount;
+      unsigned long depth;
+      unsigned int failedSteps; /*!< Decisions whose choice was inconsistent */
+      unsigned int retractions; /*!< Decisions retracted while backtracking */
+      std::string error; /*!< Set if loading or searching failed with an error */
+    };
+
+    /**
+     * @brief Constructor
+     * @param language The language of the initial state, e.g. "nddl".
+     * @param initialState The model and initial state, loaded into each engine.
+     * @param isFile True if initialState is a file name rather than the script itself.
+     */
+    SolverPortfolio(const std::string& language, const std::string& initialState, bool isFile = true);
+
+    virtual ~SolverPortfolio();
+
+    /**
+     * @brief Adds a worker running the solver configured in the given file.
+     * @return The index of the worker.
+     */
+    unsigned int addWorker(const std::string& solverConfig,
+                           eint::basis_type horizonStart,
+                           eint::basis_type horizonEnd,
+#ifdef _MSC_VER
+                           unsigned int maxSteps = UINT_MAX,
+                           unsigned int maxDepth = UINT_MAX);
+#else
+                           unsigned int maxSteps = std::numeric_limits<unsigned int>::max(),
+                           unsigned int maxDepth = std::numeric_limits<unsigned int>::max());
+#endif
+
+    /**
+     * @brief Runs all workers until one finds a plan or all have given up.
+     * @return true if a plan was found.
+     */
+    bool solve();
+
+    /**
+     * @brief The index of the worker whose plan was kept, or -1 if none was found.
+     */
+    int getWinner() const;
+
+    /**
+     * @brief The engine holding the plan that was found, if any.
+     */
+    EuropaEngine* getWinningEngine() const;
+
+    const std::vector<WorkerStats>& getWorkerStats() const {return m_stats;}
+
+  protected:
+    /**
+     * @brief Hook to configure a worker's engine, e.g. the include path, before it is started.
+     */
+    virtual void configureEngine(unsigned int worker, EuropaEngine& engine);
+
+    /**
+     * @brief Hook to listen to a worker's search. Called on the worker's thread; the listener is
+     * only notified from that thread and is deleted by the portfolio when the worker finishes.
+     * @return A new listener, or NULL for none.
+     */
+    virtual SOLVERS::SearchListener* createListener(unsigned int worker);
+
+  private:
+    SolverPortfolio(const SolverPortfolio&);
+    SolverPortfolio& operator=(const SolverPortfolio&);
+
+    struct Worker {
+      std::string solverConfig;
+      eint::basis_type horizonStart;
+      eint::basis_type horizonEnd;
+      unsigned int maxSteps;
+      unsigned int maxDepth;
+      EuropaEngine* engine;
+    };
+
+    class WorkerListener;
+    friend class WorkerListener;
+    struct Task;
+    static void* runWorker(void* task);
+
+    void run(unsigned int worker);
+
+    /**
+     * @brief Records the given worker as the winner unless another one already is.
+     * @return true if the worker is the winner.
+     */
+    bool claim(unsigned int worker);
+    bool isDecided();
+    void releaseEngines(bool keepWinner);
+
+    const std::string m_language;
+    const std::string m_initialState;
+    const bool m_isFile;
+    std::vector<Worker> m_workers;
+    std::vector<WorkerStats> m_stats;
+    bool m_run;
+    int m_winner;
+    pthread_mutex_t m_mutex; /*!< Guards m_winner while workers run */
+  };
+}
+
+#endif
@@ -0,0 +1,132 @@
+/**
+ * @file numbers-benchmark.cc
+ * @brief Times planning on the system test models, to compare a build with
+ * EUROPA_FAST_NUMERICS against one without.
+ *
+ * Usage: numbers-benchmark <planner config> <repetitions> <model>... [-baseline <file>]
+ *
+ * Prints the arithmetic policy of the build, then the best time over the
+ * repetitions for each model. Given the output of a run of the other build as
+ * a baseline, also prints the speedup over it for each model.
+ */
+
+#include "EuropaEngine.hh"
+#include "DataTypes.hh"
+#include "Debug.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/time.h>
+
+using namespace EUROPA;
+
+namespace {
+
+class BenchmarkEngine : public EuropaEngine {
+public:
+  BenchmarkEngine() {
+    m_config->setProperty("nddl.includePath","../../NDDL/test/nddl:../../NDDL/base:../../NDDL/nddl:../../NDDL:../../Resource/component/NDDL:../../Resource");
+    doStart();
+  }
+
+  ~BenchmarkEngine() {
+    doShutdown();
+  }
+};
+
+double now() {
+  timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+const char* policy() {
+#ifdef EUROPA_FAST_NUMERICS
+  return "fast";
+#else
+  return "checked";
+#endif
+}
+
+/**
+ * @brief Reads the times of a previous run, keyed by model.
+ */
+std::map<std::string, double> readBaseline(const char* fileName, std::string& baselinePolicy) {
+  std::map<std::string, double> times;
+  std::ifstream in(fileName);
+  std::string key;
+  in >> key >> baselinePolicy;
+  std::string model;
+  double seconds;
+  while(in >> model >> seconds)
+    times[model] = seconds;
+  return times;
+}
+
+}
+
+int main(int argc, const char** argv) {
+  if(argc < 4) {
+    std::cout << "usage: numbers-benchmark <planner config> <repetitions> <model>... [-baseline <file>]" << std::endl;
+    return 1;
+  }
+
+  const char* plannerConfig = argv[1];
+  const int repetitions = std::max(1, atoi(argv[2]));
+  std::vector<const char*> models;
+  const char* baselineFile = NULL;
+  for(int i = 3; i < argc; i++) {
+    if(strcmp(argv[i], "-baseline") == 0 && i + 1 < argc)
+      baselineFile = argv[++i];
+    else
+      models.push_back(argv[i]);
+  }
+
+  VoidDT::instance();
+  BoolDT::instance();
+  IntDT::instance();
+  FloatDT::instance();
+  StringDT::instance();
+  SymbolDT::instance();
+
+  std::string baselinePolicy;
+  std::map<std::string, double> baseline;
+  if(baselineFile != NULL)
+    baseline = readBaseline(baselineFile, baselinePolicy);
+
+  std::cout << "policy " << policy() << std::endl;
+  double total = 0, baselineTotal = 0;
+  bool ok = true;
+  for(std::vector<const char*>::const_iterator it = models.begin(); it != models.end(); ++it) {
+    double best = -1;
+    for(int r = 0; r < repetitions; r++) {
+      BenchmarkEngine engine;
+      double start = now();
+      bool solved = engine.plan(*it, plannerConfig, "nddl");
+      double seconds = now() - start;
+      ok = ok && solved;
+      if(best < 0 || seconds < best)
+        best = seconds;
+    }
+    total += best;
+    std::cout << *it << " " << best;
+    std::map<std::string, double>::const_iterator b = baseline.find(*it);
+    if(b != baseline.end() && best > 0) {
+      baselineTotal += b->second;
+      std::cout << " (" << b->second / best << "x over " << baselinePolicy << ")";
+    }
+    std::cout << std::endl;
+  }
+  std::cout << "total " << total;
+  if(baselineTotal > 0 && total > 0)
+    std::cout << " (" << baselineTotal / total << "x over " << baselinePolicy << ")";
+  std::cout << std::endl;
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,153 @@
+/**
+ * @file portfolio-test.cc
+ * @brief Runs a SolverPortfolio on a model and checks the plan of the winning worker.
+ *
+ * Usage: portfolio-test <model> <planner config> <planner config>...
+ *
+ * Plans the model once with each configuration on its own, then runs a portfolio with a worker
+ * for each configuration. The plan kept by the portfolio must be the plan found on its own with
+ * the configuration of the winner, and the stats of the winner must match that search.
+ */
+
+#include "SolverPortfolio.hh"
+#include "EuropaEngine.hh"
+#include "PlanDatabase.hh"
+#include "PlanDatabaseWriter.hh"
+#include "DataTypes.hh"
+#include "Debug.hh"
+
+#include <iostream>
+#include <list>
+#include <string>
+#include <vector>
+
+using namespace EUROPA;
+
+namespace {
+
+const char* includePath() {
+  return "../../NDDL/test/nddl:../../NDDL/base:../../NDDL/nddl:../../NDDL:../../Resource/component/NDDL:../../Resource";
+}
+
+class TestEngine : public EuropaEngine {
+public:
+  TestEngine() {
+    m_config->setProperty("nddl.includePath", includePath());
+    doStart();
+  }
+
+  ~TestEngine() {
+    doShutdown();
+  }
+};
+
+class TestPortfolio : public SolverPortfolio {
+public:
+  TestPortfolio(const std::string& model) : SolverPortfolio("nddl", model) {}
+
+protected:
+  void configureEngine(unsigned int, EuropaEngine& engine) {
+    engine.getConfig()->setProperty("nddl.includePath", includePath());
+  }
+};
+
+/**
+ * @brief The outcome of planning with one configuration on its own.
+ */
+struct Reference {
+  std::string plan;
+  unsigned long steps;
+  eint::basis_type horizonStart;
+  eint::basis_type horizonEnd;
+  unsigned int maxSteps;
+  unsigned int maxDepth;
+};
+
+bool plan(const char* model, const char* plannerConfig, Reference& reference) {
+  TestEngine engine;
+  if(!engine.plan(model, plannerConfig, "nddl"))
+    return false;
+
+  // The limits the engine read from the PlannerConfig instance of the model
+  std::list<ObjectId> configObjects;
+  engine.getPlanDatabase()->getObjectsByType("PlannerConfig", configObjects);
+  const std::vector<ConstrainedVariableId>& variables = configObjects.front()->getVariables();
+  reference.horizonStart = cast_int(variables[0]->baseDomain().getSingletonValue());
+  reference.horizonEnd = cast_int(variables[1]->baseDomain().getSingletonValue());
+  reference.maxSteps = static_cast<unsigned int>(cast_int(variables[2]->baseDomain().getSingletonValue()));
+  reference.maxDepth = static_cast<unsigned int>(cast_int(variables[3]->baseDomain().getSingletonValue()));
+
+  reference.plan = PlanDatabaseWriter::toString(engine.getPlanDatabase(), false);
+  reference.steps = engine.getTotalNodesSearched();
+  return true;
+}
+
+bool check(bool condition, const std::string& message) {
+  if(!condition)
+    std::cout << "FAILED: " << message << std::endl;
+  return condition;
+}
+
+}
+
+int main(int argc, const char** argv) {
+  if(argc < 4) {
+    std::cout << "usage: portfolio-test <model> <planner config> <planner config>..." << std::endl;
+    return 1;
+  }
+
+  const char* model = argv[1];
+
+  // Init data types so that id counts don't fail
+  VoidDT::instance();
+  BoolDT::instance();
+  IntDT::instance();
+  FloatDT::instance();
+  StringDT::instance();
+  SymbolDT::instance();
+
+  std::vector<Reference> references(argc - 2);
+  for(int i = 2; i < argc; i++) {
+    if(!check(plan(model, argv[i], references[i - 2]),
+              std::string("no plan for ") + model + " with " + argv[i]))
+      return 1;
+  }
+
+  bool ok = true;
+  {
+    TestPortfolio portfolio(model);
+    for(int i = 2; i < argc; i++) {
+      const Reference& reference = references[i - 2];
+      portfolio.addWorker(argv[i], reference.horizonStart, reference.horizonEnd,
+                          reference.maxSteps, reference.maxDepth);
+    }
+
+    ok = check(portfolio.solve(), "the portfolio found no plan");
+    const std::vector<SolverPortfolio::WorkerStats>& stats = portfolio.getWorkerStats();
+    for(unsigned int i = 0; i < stats.size(); i++) {
+      std::cout << "Worker " << i << " (" << argv[i + 2] << "): " <<
+          (stats[i].solved ? "solved" : stats[i].cancelled ? "cancelled" : "did not solve") <<
+          " in " << stats[i].stepCount << " steps at depth " << stats[i].depth << ", " <<
+          stats[i].failedSteps << " failed steps, " << stats[i].retractions << " retractions" << std::endl;
+      ok = check(stats[i].error.empty(), "worker failed with " + stats[i].error) && ok;
+      ok = check(stats[i].solved || stats[i].cancelled, "worker neither solved nor was cancelled") && ok;
+    }
+
+    if(ok) {
+      const int winner = portfolio.getWinner();
+      const Reference& reference = references[winner];
+      std::cout << "Winner: " << winner << std::endl;
+      ok = check(stats[winner].solved, "the winner did not solve the problem") && ok;
+      ok = check(stats[winner].stepCount == reference.steps,
+                 "the winner took a different number of steps than on its own") && ok;
+      ok = check(PlanDatabaseWriter::toString(portfolio.getWinningEngine()->getPlanDatabase(), false) ==
+                 reference.plan,
+                 "the plan of the winner differs from the plan found on its own") && ok;
+    }
+  }
+
+  if(!ok)
+    return 1;
+  std::cout << "Finished" << std::endl;
+  return 0;
+}
@@ -44,11 +44,14 @@ void ModuleTemporalNetwork::initialize(EngineId engine) {
 
   PropagatorId temporalPropagator;
   if (engine->getConfig()->getProperty("TemporalNetwork.useTemporalPropagator") != "N") {
-    temporalPropagator = (new TemporalPropagator("Temporal", ce->getId()))->getId();
+    TemporalPropagator* tp = new TemporalPropagator("Temporal", ce->getId());
+    if (engine->getConfig()->getProperty("TemporalNetwork.distanceCache") == "true")
+      tp->setDistanceCaching(true);
+    temporalPropagator = tp->getId();
     pdb->setTemporalAdvisor((new STNTemporalAdvisor(temporalPropagator))->getId());
   }
   else {
-    temporalPropagator = (new DefaultPropagator("Temporal", ce->getId()))->getId();
+    temporalPropagator = createAgendaPropagator(*engine->getConfig(), "Temporal", ce->getId());
     pdb->setTemporalAdvisor((new DefaultTemporalAdvisor(ce->getId()))->getId());
   }
 }
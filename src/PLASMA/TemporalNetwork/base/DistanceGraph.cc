@@ -51,7 +51,8 @@ void deleteIfEqual(std::vector<ELEMENT>& elements, ELEMENT element){
 // Global value overridden only for Rax-derived system test.
 // Bool IsOkToRemoveConstraintTwice = false;
 
-DistanceGraph::DistanceGraph() : edges(), dijkstraGeneration(0), nodes(),
+DistanceGraph::DistanceGraph() : edges(), dijkstraGeneration(0), relaxedEdges(0),
+                                 edgeGeneration(0), nodes(),
                                  dqueue(new Dqueue()),
                                  bqueue(new BucketQueue(100)), edgeNogoodList()
 {
@@ -83,40 +84,62 @@ DnodeId DistanceGraph::createNode()
   return node;
 }
 
-Void DistanceGraph::attachEdge(std::vector<Dedge*>& edgeArray, Int& size, Int& count,
-                               Dedge& edge) {
-  check_error(!(count > size), "Corrupted edge-array in TemporalNetwork",
+Void DistanceGraph::attachEdge(std::vector<Dedge*>& edgeArray, Int& count,
+                               Dedge& edge, unsigned int Dedge::* slot) {
+  check_error(!(count > static_cast<Int>(edgeArray.size())), "Corrupted edge-array in TemporalNetwork",
               TempNetErr::TempNetInternalError());
 
+  edge.*slot = edgeArray.size();
   edgeArray.push_back(&edge);
-  count = edgeArray.size();
-  size = edgeArray.capacity();
+  count++;
 }
 
 
 Void DistanceGraph::detachEdge(std::vector<Dedge*>& edgeArray, Int& count,
-                               const Dedge& edge)
+                               const Dedge& edge, unsigned int Dedge::* slot)
 {
-  edgeArray.erase(std::find(edgeArray.begin(), edgeArray.end(), &edge));
-  count = edgeArray.size();
+  check_error(edge.*slot < edgeArray.size() && edgeArray[edge.*slot] == &edge,
+              "Corrupted edge-array in TemporalNetwork",
+              TempNetErr::TempNetInternalError());
+  edgeArray[edge.*slot] = NULL;
+  count--;
+
+  if (2 * static_cast<unsigned long>(count) < edgeArray.size()) {
+    unsigned int live = 0;
+    for (unsigned int i = 0; i < edgeArray.size(); i++) {
+      Dedge* e = edgeArray[i];
+      if (e == NULL)
+        continue;
+      e->*slot = live;
+      edgeArray[live++] = e;
+    }
+    edgeArray.resize(live);
+  }
 }
 
 Void DistanceGraph::deleteNode(Dnode& node)
 {
   check_error(isValid(node), "node is not defined in this graph");
 
-  for (Int i=0; i < node.outCount; i++) {
+  for (unsigned int i=0; i < node.outArray.size(); i++) {
     Dedge* edge = node.outArray[i];
-    detachEdge(edge->to.inArray, edge->to.inCount, *edge);
+    if (edge == NULL)
+      continue;
+    detachEdge(edge->to.inArray, edge->to.inCount, *edge, &Dedge::inSlot);
     eraseEdge(*edge);
   }
-  for (Int j=0; j < node.inCount; j++) {
+  for (unsigned int j=0; j < node.inArray.size(); j++) {
     Dedge* edge = node.inArray[j];
-    detachEdge(edge->from.outArray, edge->from.outCount, *edge);
+    if (edge == NULL)
+      continue;
+    detachEdge(edge->from.outArray, edge->from.outCount, *edge, &Dedge::outSlot);
     eraseEdge(*edge);
   }
+  node.outArray.clear();
+  node.inArray.clear();
   node.inCount = node.outCount = 0;
   node.potential = 99;  // A clue for debugging purposes
+  ++edgeGeneration;
   nodes.erase(std::remove_if(nodes.begin(), nodes.end(), ptr_compare<Dnode>(&node)),
               nodes.end());
 }
@@ -126,19 +149,21 @@ Dedge* DistanceGraph::findEdge(Dnode& from, Dnode& to)
  check_error(isValid(from), "node is not defined in this graph");
  check_error(isValid(to),   "node is not defined in this graph");
 
-  // Cache node vars -- Chucko 22 Apr 2002 
-  Int fromOutCount = from.outCount; 
-  if (fromOutCount > 0) {
-    /*
-    DedgeId* fromOutArray = from->outArray;
-    for (Int i=0; i < fromOutCount; i++) {
-      DedgeId edge = fromOutArray[i];
-      if (to == edge->to)
-	return edge;
+  // Scan whichever adjacency array is shorter; the reference timepoint
+  // has an edge to nearly every node, but its neighbours have few.
+  if (from.outArray.size() <= to.inArray.size()) {
+    for (unsigned int i=0; i < from.outArray.size(); i++) {
+      Dedge* edge = from.outArray[i];
+      if (edge != NULL && &edge->to == &to)
+        return edge;
+    }
+  }
+  else {
+    for (unsigned int i=0; i < to.inArray.size(); i++) {
+      Dedge* edge = to.inArray[i];
+      if (edge != NULL && &edge->from == &from)
+        return edge;
     }
-    */
-    // PHM 06/20/2007 Speedup by using map instead.
-    return from.edgemap[&to];
   }
   return NULL;//DedgeId();
 }
@@ -155,9 +180,8 @@ Dedge* DistanceGraph::createEdge(Dnode& from, Dnode& to, Time length) {
 
   edge->length = length;
   this->edges.insert(edge);
-  attachEdge (from.outArray, from.outArraySize, from.outCount, *edge.get());
-  attachEdge (to.inArray, to.inArraySize, to.inCount, *edge.get());
-  from.edgemap[&to] = edge.get();
+  attachEdge (from.outArray, from.outCount, *edge.get(), &Dedge::outSlot);
+  attachEdge (to.inArray, to.inCount, *edge.get(), &Dedge::inSlot);
   return edge.get();
 }
 
@@ -165,9 +189,8 @@ void DistanceGraph::handleNodeUpdate(const Dnode&) {}
 
 Void DistanceGraph::deleteEdge(Dedge& edge)
 {
-  detachEdge (edge.from.outArray, edge.from.outCount, edge);
-  detachEdge (edge.to.inArray, edge.to.inCount, edge);
-  edge.from.edgemap.erase(&edge.to);
+  detachEdge (edge.from.outArray, edge.from.outCount, edge, &Dedge::outSlot);
+  detachEdge (edge.to.inArray, edge.to.inCount, edge, &Dedge::inSlot);
   eraseEdge(edge);
 }
 
@@ -193,6 +216,7 @@ Void DistanceGraph::addEdgeSpec(Dnode& from, Dnode& to, Time length)
   edge->lengthSpecs.push_back(length);
   if (length < edge->length)
     edge->length = length;
+  ++edgeGeneration;
 }
 
 Void DistanceGraph::removeEdgeSpec(Dnode& from, Dnode& to, Time length)
@@ -218,6 +242,7 @@ Void DistanceGraph::removeEdgeSpec(Dnode& from, Dnode& to, Time length)
   else {
     edge->length = *std::min_element(lengthSpecs.begin(), lengthSpecs.end());
   }  
+  ++edgeGeneration;
 }
 
 Bool DistanceGraph::bellmanFord()
@@ -244,9 +269,11 @@ Bool DistanceGraph::bellmanFord()
     if (nodeOutCount > 0) {
       std::vector<Dedge*>& nodeOutArray = node->outArray;
       Time nodePotential = node->potential;
-      for (Int i=0; i< nodeOutCount; i++) {
+      relaxedEdges += nodeOutCount;
+      for (unsigned int i=0; i< nodeOutArray.size(); i++) {
 	Dedge* edge = nodeOutArray[i];
-	check_error(edge); 
+	if (edge == NULL)
+	  continue;
 	Dnode& next = edge->to;
 	Time potential = nodePotential + edge->length;
 	if (potential < next.potential) {
@@ -289,9 +316,11 @@ Bool DistanceGraph::incBellmanFord()
     if (nodeOutCount > 0) {
       std::vector<Dedge*>& nodeOutArray = node->outArray;
       Time nodePotential = node->potential;
-      for (Int i=0; i< nodeOutCount; i++) {
+      relaxedEdges += nodeOutCount;
+      for (unsigned int i=0; i< nodeOutArray.size(); i++) {
 	Dedge* edge = nodeOutArray[i];
-	check_error(edge);
+	if (edge == NULL)
+	  continue;
 	Dnode& next = edge->to;
 	Time potential = nodePotential + edge->length;
 
@@ -331,6 +360,16 @@ Bool DistanceGraph::incBellmanFord()
 }
 
 Void DistanceGraph::dijkstra(Dnode& source, Dnode* destination)
+{
+  directedDijkstra(source, destination, +1);
+}
+
+Void DistanceGraph::dijkstraBackward(Dnode& target)
+{
+  directedDijkstra(target, NULL, -1);
+}
+
+Void DistanceGraph::directedDijkstra(Dnode& source, Dnode* destination, int direction)
 {
  check_error(isValid(source), "node is not defined in this graph");
 
@@ -349,7 +388,10 @@ Void DistanceGraph::dijkstra(Dnode& source, Dnode* destination)
   Int generation = ++(this->dijkstraGeneration);
   source.generation = generation;
   BucketQueue& queue = initializeBqueue();
-  queue.insertInQueue(&source);
+  if (direction > 0)
+    queue.insertInQueue(&source);
+  else
+    queue.insertInQueue(&source, source.distance + source.potential);
 #ifndef EUROPA_FAST
   Int BFbound = static_cast<Int>(this->nodes.size());
 #endif
@@ -359,13 +401,18 @@ Void DistanceGraph::dijkstra(Dnode& source, Dnode* destination)
     if (node == NULL || node == destination)
       return;
     // Cache node vars -- Chucko 22 Apr 2002
-    Int nodeOutCount = node->outCount;
+    // Backward search follows incoming edges; distances are then
+    // distances *to* the source.
+    Int nodeOutCount = (direction > 0 ? node->outCount : node->inCount);
     if (nodeOutCount > 0) {
-      std::vector<Dedge*>& nodeOutArray = node->outArray;
+      std::vector<Dedge*>& nodeOutArray = (direction > 0 ? node->outArray : node->inArray);
       Time nodeDistance = node->distance;
-      for (Int i=0; i< nodeOutCount; i++) {
+      relaxedEdges += nodeOutCount;
+      for (unsigned int i=0; i< nodeOutArray.size(); i++) {
 	Dedge* edge = nodeOutArray[i];
-	Dnode& next = edge->to;
+	if (edge == NULL)
+	  continue;
+	Dnode& next = (direction > 0 ? edge->to : edge->from);
 	Time newDistance = nodeDistance + edge->length;
 	/*
 	condDebugMsg(next->generation >= generation, 
@@ -387,7 +434,12 @@ Void DistanceGraph::dijkstra(Dnode& source, Dnode* destination)
                 TempNetErr::TempNetInternalError());
 	  next.distance = newDistance;
 	  next.predecessor = edge;
-	  queue.insertInQueue (&next);
+	  // Reduced edge lengths are non-negative under the potentials in
+	  // either direction, with the sign of the potential flipped.
+	  if (direction > 0)
+	    queue.insertInQueue (&next);
+	  else
+	    queue.insertInQueue (&next, next.distance + next.potential);
 	  //debugMsg("DistanceGraph:dijkstra", "New distance of " << newDistance << " through node " << next);
 	  handleNodeUpdate(next);
 	}
@@ -451,8 +503,10 @@ Bool DistanceGraph::isAllZeroPropagationPath(Dnode& node, Dnode& targ,
   Int nodeOutCount = node.outCount;
   if (nodeOutCount > 0) {
     std::vector<Dedge*>& nodeOutArray = node.outArray;
-    for (int i=0; i< nodeOutCount; i++) {
+    for (unsigned int i=0; i< nodeOutArray.size(); i++) {
       Dedge* edge = nodeOutArray[i];
+      if (edge == NULL)
+        continue;
       Time length = edge->length;
       if (length == 0)
 	if (isAllZeroPropagationPath(edge->to, targ, potential))
@@ -482,13 +536,13 @@ Bool DistanceGraph::isPropagationPath(Dnode& src, Dnode& targ, Time pot) {
   propQ->link = NULL;
   while (propQ != NULL) {
     Dnode* node = propQ; propQ = propQ->link;
-    // Cache node vars -- Chucko 22 Apr 2002
-    Int nodeOutCount = node->outCount;
     std::vector<Dedge*>& nodeOutArray = node->outArray;
     // We iterate downwards to simulate the behavior of the previous
     // recursive version of this function (to satisfy make tests).
-    for (int i=nodeOutCount-1; i>=0 ; i--) {
+    for (int i=static_cast<int>(nodeOutArray.size())-1; i>=0 ; i--) {
       Dedge* edge = nodeOutArray[i];
+      if (edge == NULL)
+        continue;
       Dnode& next = edge->to;
       if (next.isMarked())
         continue;
@@ -628,8 +682,11 @@ Void DistanceGraph::boundedDijkstra (Dnode& source,
     if (nodeCount > 0) {
       std::vector<Dedge*>& nodeArray = (direction == -1) ? node->inArray : node->outArray;
       Time nodeDistance = node->distance;
-      for (Int i=0; i< nodeCount; i++) {
+      relaxedEdges += nodeCount;
+      for (unsigned int i=0; i< nodeArray.size(); i++) {
         Dedge* edge = nodeArray[i];
+        if (edge == NULL)
+          continue;
         Dnode& next = (direction == -1) ? edge->from : edge->to;
         Time newDistance = nodeDistance + edge->length;
 
@@ -97,13 +97,25 @@ class DistanceGraph {
   std::set<DedgeId> edges;
   Int dijkstraGeneration;
 protected:
+  unsigned long relaxedEdges; // Edges examined by propagation, for benchmarking.
+  unsigned long edgeGeneration; // Bumped whenever an edge or its length changes.
   std::vector<DnodeId> nodes; //TODO: should this be a ptr_container instead?
   boost::scoped_ptr<Dqueue> dqueue;
   boost::scoped_ptr<BucketQueue> bqueue;
   std::list<Dedge*> edgeNogoodList;
 
-  Void attachEdge(std::vector<Dedge*>& edgeArray, Int& size, Int& count, Dedge& edge);
-  Void detachEdge(std::vector<Dedge*>& edgeArray, Int& count, const Dedge& edge);
+  /**
+   * @brief Append edge to an adjacency array, recording its slot in edge.*slot.
+   */
+  Void attachEdge(std::vector<Dedge*>& edgeArray, Int& count, Dedge& edge,
+                  unsigned int Dedge::* slot);
+
+  /**
+   * @brief Leave a tombstone (null) in the edge's slot. The array is compacted,
+   * preserving edge order, once tombstones outnumber live edges.
+   */
+  Void detachEdge(std::vector<Dedge*>& edgeArray, Int& count, const Dedge& edge,
+                  unsigned int Dedge::* slot);
 
 public:
 
@@ -185,6 +197,14 @@ public:
    */
   Void dijkstra(Dnode& source, Dnode* destination = NULL);
 
+   /**
+   * @brief Shortest paths from all nodes to a single target, following
+   *        edges in reverse. Afterwards getDistance(node) is the distance
+   *        from node to target.
+   * @param target terminal node
+   */
+  Void dijkstraBackward(Dnode& target);
+
    /**
    * @brief Incremental version of Dijkstra's algorithum
    */
@@ -207,6 +227,8 @@ public:
     boundedDijkstra (source, bound, maxPotential, -1);
   }
 private:
+  Void directedDijkstra(Dnode& source, Dnode* destination, int direction);
+
   Void boundedDijkstra (Dnode& source,
                         Time bound,
                         Time destPotential,
@@ -241,6 +263,17 @@ public:
    */
   std::string toString() const;
 
+  /**
+   * @brief Number of edges examined by propagation since construction.
+   */
+  unsigned long getRelaxedEdgeCount() const { return relaxedEdges; }
+
+  /**
+   * @brief Counter that changes whenever the edge set or an edge length
+   * changes, so derived distance information can be invalidated.
+   */
+  unsigned long getEdgeGeneration() const { return edgeGeneration; }
+
 protected:
 
   /**
@@ -319,16 +352,12 @@ class Dnode : public Entity {
 
 protected:
 
-  // std::vector<DedgeId> inArray;
+  // Adjacency arrays. Removed edges leave null tombstones, so loops over
+  // these arrays must skip null entries; the counts are of live edges.
   std::vector<Dedge*> inArray;
-  Int inArraySize;
   Int inCount;
-  // std::vector<DedgeId> outArray;
   std::vector<Dedge*> outArray;
-  Int outArraySize;
   Int outCount;
-  // std::map<DnodeId,DedgeId> edgemap;
-  std::map<Dnode*, Dedge*> edgemap;  //TODO: Why is this at the node level and not in the graph?
   Time distance;      // Distance from any source of propagation.
   Time potential;     // Distance from Johnson-type external source.
   Int depth;  // Depth of propagation for testing against the BF limit.
@@ -347,8 +376,8 @@ private:
   Int generation;     // Used for obsoleting Dijkstra-calculated distances.
 public:
 
-  Dnode() : inArray(), inArraySize(0), inCount(0), outArray(),
-            outArraySize(0), outCount(0), edgemap(), distance(0), potential(0), depth(0),
+  Dnode() : inArray(), inCount(0), outArray(),
+            outCount(0), distance(0), potential(0), depth(0),
             key(0), link(), predecessor(), markLocal(0), generation(0) {
   }
   virtual ~Dnode() {
@@ -379,6 +408,8 @@ public:
 class Dedge {
   friend class DistanceGraph;
   std::vector<Time> lengthSpecs;
+  unsigned int outSlot; // Position in from.outArray
+  unsigned int inSlot;  // Position in to.inArray
 
 public:
   Dnode& from;
@@ -387,7 +418,8 @@ public:
   /**
    * @brief constructor
    */
-  Dedge (Dnode& _from, Dnode& _to):lengthSpecs(), from(_from), to(_to), length(0) {}
+  Dedge (Dnode& _from, Dnode& _to)
+    : lengthSpecs(), outSlot(0), inSlot(0), from(_from), to(_to), length(0) {}
   /**
    * @brief destructor
    */
@@ -418,7 +450,7 @@ class BucketComparator
 public:
 	bool operator()(const Bucket& lhs,const Bucket& rhs) const
 	{
-		return lhs.key < rhs.key;
+		return lhs.key > rhs.key; // Lowest key at the top
 	}
 };
 
@@ -429,16 +461,31 @@ typedef std::priority_queue<Bucket,std::vector<Bucket>,BucketComparator> DnodePr
  * @class  BucketQueue
  * @author Paul H. Morris (with mods by Conor McGann)
  * @date   Mon Dec 27 2004
- * @brief  Utility class. An ordered linked-list of buckets
+ * @brief  Utility class. A radix heap of buckets
  * designed to give an efficient implementation of Dijkstra's algorithum for
  * finding the shortest path between nodes (where all weights are non negative).
+ *
+ * Bucket i > 0 holds keys whose highest bit differing from the last popped
+ * key is bit i-1; bucket 0 holds keys equal to it. Dijkstra never inserts a
+ * key below the last one popped, so each entry moves down at most once per
+ * bit. Bellman-Ford does, and such keys go to a binary heap that is always
+ * drained first, since every key in it is below every key in the buckets.
  * @ingroup TemporalNetwork
 */
 class BucketQueue {
 private:
   BucketQueue(const BucketQueue&);
   BucketQueue& operator=(const BucketQueue&);
-  DnodePriorityQueue buckets;
+
+  static const unsigned int RADIX_BUCKETS = sizeof(Time) * CHAR_BIT + 1;
+
+  unsigned int bucketIndex(Time key) const;
+  Bool isCurrent(const Bucket& b) const;
+
+  std::vector<Bucket> buckets[RADIX_BUCKETS];
+  DnodePriorityQueue overflow; // Keys below last
+  Time last;                   // Last key popped from the buckets
+  unsigned long entries;       // Including entries superseded by a later insertion
 public:
 
   /**
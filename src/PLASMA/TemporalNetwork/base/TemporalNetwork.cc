@@ -50,7 +50,10 @@ bool TemporalNetwork::hasEdgeToOrigin(Timepoint& timepoint) {
 TemporalNetwork::TemporalNetwork() : consistent(true), 
                                      hasDeletions(false), nodeCounter(0),
                                      incrementalSource(), m_constraints(), m_id(this),
-                                     m_refpoint(), m_updatedTimepoints() {
+                                     m_refpoint(), m_distanceCaching(false),
+                                     m_distanceGeneration(0), m_distancesFrom(),
+                                     m_distancesTo(), m_scratchRow(),
+                                     m_updatedTimepoints() {
 
   addTimepoint();
   fullPropagate();
@@ -131,6 +134,9 @@ Time TemporalNetwork::getUpperTimepointBound(const Timepoint& id) {
     check_error(this->consistent,
                 "TemporalNetwork: Checking distance in inconsistent network",
                 TempNetErr::TempNetInconsistentError());
+    Time distance;
+    if (lookupDistance(from, to, distance))
+      return distance < bound;
     return DistanceGraph::isDistanceLessThan(from, to, bound);
     // DistanceGraph* graph = boost::polymorphic_cast<DistanceGraph*>(this);
     // return graph->isDistanceLessThan(from, to, bound);
@@ -251,6 +257,11 @@ Void TemporalNetwork::calcDistanceBounds(Timepoint& src, Timepoint& targ,
     //      }
   }
 
+  if (lookupDistance(src, targ, ub) && lookupDistance(targ, src, lb)) {
+    lb = -lb;
+    return;
+  }
+
   // Otherwise calculate from two single-source propagations
   dijkstra(src,&targ);
   ub = getDistance(targ);
@@ -301,6 +312,96 @@ Void TemporalNetwork::calcDistanceBounds(Timepoint& src,
   return;
 }
 
+Void TemporalNetwork::calcDistancesFrom(Timepoint& src,
+                                        const std::vector<Timepoint*>& targs,
+                                        std::vector<Time>& dists) {
+  propagate();
+
+  checkError(this->consistent, "TemporalNetwork: calcDistancesFrom in inconsistent network");
+
+  const DistanceRow& row = computeDistanceRow(src, true);
+  dists.clear();
+  for (unsigned i=0; i<targs.size(); i++) {
+    DistanceRow::const_iterator it = row.find(targs[i]);
+    dists.push_back(it == row.end() ? POS_INFINITY : it->second);
+  }
+}
+
+Void TemporalNetwork::calcDistancesTo(Timepoint& targ,
+                                      const std::vector<Timepoint*>& srcs,
+                                      std::vector<Time>& dists) {
+  propagate();
+
+  checkError(this->consistent, "TemporalNetwork: calcDistancesTo in inconsistent network");
+
+  const DistanceRow& row = computeDistanceRow(targ, false);
+  dists.clear();
+  for (unsigned i=0; i<srcs.size(); i++) {
+    DistanceRow::const_iterator it = row.find(srcs[i]);
+    dists.push_back(it == row.end() ? POS_INFINITY : it->second);
+  }
+}
+
+void TemporalNetwork::setDistanceCaching(bool enabled) {
+  m_distanceCaching = enabled;
+  m_distancesFrom.clear();
+  m_distancesTo.clear();
+}
+
+void TemporalNetwork::validateDistanceCache() {
+  if (m_distanceGeneration == getEdgeGeneration())
+    return;
+  m_distancesFrom.clear();
+  m_distancesTo.clear();
+  m_distanceGeneration = getEdgeGeneration();
+}
+
+const TemporalNetwork::DistanceRow&
+TemporalNetwork::computeDistanceRow(Timepoint& node, bool forwards) {
+  validateDistanceCache();
+  DistanceRows& rows = (forwards ? m_distancesFrom : m_distancesTo);
+  if (m_distanceCaching) {
+    DistanceRows::const_iterator it = rows.find(&node);
+    if (it != rows.end())
+      return it->second;
+  }
+
+  if (forwards)
+    dijkstra(node);
+  else
+    dijkstraBackward(node);
+
+  DistanceRow& row = (m_distanceCaching ? rows[&node] : m_scratchRow);
+  row.clear();
+  for (std::vector<DnodeId>::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+    Time distance = getDistance(**it);
+    if (distance != POS_INFINITY)
+      row.insert(std::make_pair(static_cast<const Timepoint*>(it->get()), distance));
+  }
+  debugMsg("TemporalNetwork:computeDistanceRow",
+           (forwards ? "from " : "to ") << &node << ": " << row.size() << " reachable");
+  return row;
+}
+
+bool TemporalNetwork::lookupDistance(const Timepoint& from, const Timepoint& to,
+                                     Time& dist) {
+  if (!m_distanceCaching)
+    return false;
+  validateDistanceCache();
+
+  DistanceRows::const_iterator it = m_distancesFrom.find(&from);
+  const Timepoint* key = &to;
+  if (it == m_distancesFrom.end()) {
+    it = m_distancesTo.find(&to);
+    key = &from;
+    if (it == m_distancesTo.end())
+      return false;
+  }
+  DistanceRow::const_iterator entry = it->second.find(key);
+  dist = (entry == it->second.end() ? POS_INFINITY : entry->second);
+  return true;
+}
+
 Void TemporalNetwork::calcDistanceSigns(Timepoint& src,
                                         const std::vector<Timepoint*>&
                                         targs,
@@ -770,8 +871,11 @@ Void TemporalNetwork::incDijkstraForward() {
     if (node == NULL)
       return;
 
-    for (int i=0; i< node->outCount; i++) {
+    relaxedEdges += node->outCount;
+    for (unsigned int i=0; i< node->outArray.size(); i++) {
       Dedge* edge = node->outArray[i];
+      if (edge == NULL)
+        continue;
       Timepoint& next = dynamic_cast<Timepoint&>(edge->to);
       Time newDistance = node->upperBound + edge->length;
       if (newDistance < next.upperBound) {
@@ -804,8 +908,11 @@ Void TemporalNetwork::incDijkstraBackward() {
     if(node == NULL)
       return;
 
-    for (int i=0; i< node->inCount; i++) {
+    relaxedEdges += node->inCount;
+    for (unsigned int i=0; i< node->inArray.size(); i++) {
       Dedge* edge = node->inArray[i];
+      if (edge == NULL)
+        continue;
       Timepoint& next = dynamic_cast<Timepoint&>(edge->from);
       Time newDistance = -(node->lowerBound) + edge->length;
       if (newDistance < -(next.lowerBound)) {
@@ -840,8 +947,11 @@ Void TemporalNetwork::incDijkstraBackward() {
       if (node == NULL)
 	return;
 
-      for (int i=0; i< node->outCount; i++) {
+      relaxedEdges += node->outCount;
+      for (unsigned int i=0; i< node->outArray.size(); i++) {
 	Dedge* edge = node->outArray[i];
+	if (edge == NULL)
+	  continue;
 	Timepoint& next = dynamic_cast<Timepoint&>(edge->to);
 	Time newDistance = node->reftime + edge->length;
 	if (newDistance < next.reftime) {
@@ -874,8 +984,11 @@ Void TemporalNetwork::incDijkstraBackward() {
       Timepoint* node = dynamic_cast<Timepoint*>(queue.popMinFromQueue());
       if(node == NULL)
 	return;
-      for (int i=0; i< node->inCount; i++) {
+      relaxedEdges += node->inCount;
+      for (unsigned int i=0; i< node->inArray.size(); i++) {
 	Dedge* edge = node->inArray[i];
+	if (edge == NULL)
+	  continue;
 	Timepoint& next = dynamic_cast<Timepoint&>(edge->from);
 	Time newDistance = -(node->reftime) + edge->length;
 	if (newDistance < -(next.reftime)) {
@@ -924,9 +1037,10 @@ std::vector<Timepoint*> TemporalNetwork::getRingPredecessors(const Timepoint& tp
   // Might be possible to cache these too.
 
   std::vector<Timepoint*> ans;
-  int numedges = tpt->outCount;
-  for (int i=0; i<numedges; i++) {
+  for (unsigned int i=0; i<tpt->outArray.size(); i++) {
     Dedge* e = tpt->outArray[i];
+    if (e == NULL)
+      continue;
     Time length = e->length;
     Timepoint& next = dynamic_cast<Tnode&>(e->to);
     if (length < 0)   // Negative predecessors are enabling.
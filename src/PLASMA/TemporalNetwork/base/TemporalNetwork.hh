@@ -17,6 +17,7 @@
 #include "DistanceGraph.hh"
 #include "Error.hh"
 #include <list>
+#include <map>
 
 namespace EUROPA {
 
@@ -180,6 +181,38 @@ namespace EUROPA {
                            const std::vector<Timepoint*>& targs,
                            std::vector<Time>& lbs, std::vector<Time>& ubs);
 
+    /**
+     * @brief Calculate the exact distances from one timepoint to others with a
+     * single Dijkstra search. Unreachable targets get POS_INFINITY.
+     * @param src the start node in the network.
+     * @param targs the end nodes in the network.
+     * @param dists returns distance(src, targs[i]).
+     */
+    Void calcDistancesFrom(Timepoint& src,
+                           const std::vector<Timepoint*>& targs,
+                           std::vector<Time>& dists);
+
+    /**
+     * @brief Calculate the exact distances from several timepoints to one
+     * with a single backward Dijkstra search.
+     * @param targ the end node in the network.
+     * @param srcs the start nodes in the network.
+     * @param dists returns distance(srcs[i], targ).
+     */
+    Void calcDistancesTo(Timepoint& targ,
+                         const std::vector<Timepoint*>& srcs,
+                         std::vector<Time>& dists);
+
+    /**
+     * @brief Turn the distance cache on or off.  When on, calcDistancesFrom and
+     * calcDistancesTo keep the full distance row they compute, and
+     * isDistanceLessThan and calcDistanceBounds answer exactly from a cached
+     * row when one covers the pair.  The cache is dropped whenever an edge
+     * changes.  Off by default.
+     */
+    void setDistanceCaching(bool enabled);
+    bool isDistanceCaching() const { return m_distanceCaching; }
+
 
     /**
      * @brief Identify the timepoints that mark the head and foot of a temporal constraint.
@@ -425,6 +458,26 @@ namespace EUROPA {
 
     Void cleanupTEQ(Timepoint& tpt);
 
+    typedef std::map<const Timepoint*, Time> DistanceRow;
+    typedef std::map<const Timepoint*, DistanceRow> DistanceRows;
+
+    /**
+     * @brief Drop cached distances if the edges changed since they were computed.
+     */
+    void validateDistanceCache();
+
+    /**
+     * @brief Run a full Dijkstra search from (forwards) or to (backwards)
+     * node and, when caching, store the finite distances found.
+     */
+    const DistanceRow& computeDistanceRow(Timepoint& node, bool forwards);
+
+    /**
+     * @brief Look up distance(from, to) in the cached rows.
+     * @return true iff a cached row covers the pair.
+     */
+    bool lookupDistance(const Timepoint& from, const Timepoint& to, Time& dist);
+
     /**
      * @brief check if node is valid
      * @return true iff node is valid.
@@ -461,6 +514,17 @@ namespace EUROPA {
      */
     Timepoint* m_refpoint;
 
+    /**
+     * @brief Distance cache. m_distancesFrom[src][targ] and
+     * m_distancesTo[targ][src] both hold distance(src, targ); a row holds
+     * only the finite distances of its search.
+     */
+    bool m_distanceCaching;
+    unsigned long m_distanceGeneration;
+    DistanceRows m_distancesFrom;
+    DistanceRows m_distancesTo;
+    DistanceRow m_scratchRow;
+
    protected:                          // Overridden virtual functions
 
    /**
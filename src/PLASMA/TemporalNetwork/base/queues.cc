@@ -73,7 +73,8 @@ Bool Dqueue::isEmpty()
 /* BucketQueue functions */
 
 
-BucketQueue::BucketQueue (int) : buckets() {
+BucketQueue::BucketQueue (int) : buckets(), overflow(),
+                                  last(std::numeric_limits<Time>::min()), entries(0) {
 }
 
 BucketQueue::~BucketQueue ()
@@ -82,25 +83,86 @@ BucketQueue::~BucketQueue ()
 
 void BucketQueue::reset()
 {
-  buckets = DnodePriorityQueue();
+  for (unsigned int i = 0; i < RADIX_BUCKETS; i++)
+    buckets[i].clear();
+  overflow = DnodePriorityQueue();
+  last = std::numeric_limits<Time>::min();
+  entries = 0;
   Dnode::unmarkAll();
 }
 
+unsigned int BucketQueue::bucketIndex(Time key) const
+{
+  // Flip the sign bit so that unsigned order matches signed order.
+  const unsigned long sign = 1UL << (sizeof(Time) * CHAR_BIT - 1);
+  unsigned long diff = (static_cast<unsigned long>(key) ^ sign) ^
+    (static_cast<unsigned long>(last) ^ sign);
+  if (diff == 0)
+    return 0;
+#ifdef __GNUC__
+  return sizeof(Time) * CHAR_BIT - __builtin_clzl(diff);
+#else
+  unsigned int bits = 0;
+  for ( ; diff != 0; diff >>= 1)
+    bits++;
+  return bits;
+#endif
+}
+
+Bool BucketQueue::isCurrent(const Bucket& b) const
+{
+  // Reinsertion with a lower key leaves the earlier entry behind.
+  return b.node->markLocal == Dnode::markGlobal && b.node->key == b.key;
+}
+
 Dnode* BucketQueue::popMinFromQueue()
 {
-  Dnode* node = NULL;
-	
-  while (!buckets.empty()){
-    const Bucket& b = buckets.top();
-    node = const_cast<Dnode*>(b.node);
-    buckets.pop();
-
-    if (node->isMarked()){
+  while (entries > 0) {
+    if (!overflow.empty()) {
+      Bucket b = overflow.top();
+      overflow.pop();
+      entries--;
+      if (isCurrent(b)) {
+        Dnode* node = const_cast<Dnode*>(b.node);
+        node->unmark();
+        return node;
+      }
+      continue;
+    }
+
+    if (buckets[0].empty()) {
+      // Move the lowest non-empty bucket down, around its minimum key.
+      unsigned int i = 1;
+      while (buckets[i].empty())
+        i++;
+      std::vector<Bucket> moving;
+      moving.swap(buckets[i]);
+      Time min = std::numeric_limits<Time>::max();
+      for (std::vector<Bucket>::const_iterator it = moving.begin(); it != moving.end(); ++it)
+        if (isCurrent(*it) && it->key < min)
+          min = it->key;
+      entries -= moving.size();
+      if (min == std::numeric_limits<Time>::max())
+        continue; // Nothing current in this bucket
+      last = min;
+      for (std::vector<Bucket>::const_iterator it = moving.begin(); it != moving.end(); ++it) {
+        if (isCurrent(*it)) {
+          buckets[bucketIndex(it->key)].push_back(*it);
+          entries++;
+        }
+      }
+    }
+
+    Bucket b = buckets[0].back();
+    buckets[0].pop_back();
+    entries--;
+    if (isCurrent(b)) {
+      Dnode* node = const_cast<Dnode*>(b.node);
       node->unmark();
       return node;
     }
   }
-	
+
   return NULL;
 }
 
@@ -109,15 +171,21 @@ void BucketQueue::insertInQueue(Dnode* node, eint::basis_type key)
 	if(node == NULL)
 		return;
 
-	if(node->isMarked() && node->getKey() > -key )
+	if(node->isMarked() && node->getKey() <= key)
 		return;
 
-	node->setKey(-key); // Reverse since we want effective lowest priority first
+	node->setKey(key);
 	node->mark();
-	Bucket b(node,-key);
-	this->buckets.push(b);
-
-	//debugMsg("BucketQueue:insertInQueue", "Enqueueing " << node << " with key " << -key);
+	Bucket b(node,key);
+	if (entries == 0)
+	  last = key;
+	if (key < last)
+	  overflow.push(b);
+	else
+	  buckets[bucketIndex(key)].push_back(b);
+	entries++;
+
+	//debugMsg("BucketQueue:insertInQueue", "Enqueueing " << node << " with key " << key);
 }
 
 void BucketQueue::insertInQueue(Dnode* node)
@@ -128,4 +196,9 @@ void BucketQueue::insertInQueue(Dnode* node)
   insertInQueue(node, node->distance - node->potential);
 }
 
+Bool BucketQueue::isEmpty()
+{
+  return entries == 0;
+}
+
 } /* namespace Europa */
@@ -29,12 +29,50 @@ namespace EUROPA {
     return m_propagator->canPrecede(first, second);
   }
 
+  /**
+   * @brief canPrecede(token, x) measures distances from token's end and
+   * canPrecede(x, token) distances to token's start; one search in each
+   * direction then covers every position on a timeline.
+   */
+  void STNTemporalAdvisor::cacheOrderingDistances(const TokenId token) {
+    if (!m_propagator->isDistanceCaching())
+      return;
+    m_propagator->cacheDistancesFrom(token->end());
+    m_propagator->cacheDistancesTo(token->start());
+  }
+
   bool STNTemporalAdvisor::canFitBetween(const TokenId token, const TokenId predecessor, const TokenId successor){
     if (!DefaultTemporalAdvisor::canFitBetween(token, predecessor, successor))
       return false;
     return m_propagator->canFitBetween(token->start(), token->end(), predecessor->end(), successor->start());
   }
 
+  /**
+   * @brief Gaps that pass the bounds test of DefaultTemporalAdvisor are tested in the distance
+   * graph together, so that the duration bounds of token are read once.
+   */
+  void STNTemporalAdvisor::canFitBetweenEach(const TokenId token,
+                                             const std::vector<std::pair<TokenId, TokenId> >& gaps,
+                                             std::vector<bool>& results) {
+    check_error(results.empty());
+    results.reserve(gaps.size());
+    std::vector<std::pair<ConstrainedVariableId, ConstrainedVariableId> > open;
+    for (std::vector<std::pair<TokenId, TokenId> >::const_iterator it = gaps.begin(); it != gaps.end(); ++it) {
+      results.push_back(DefaultTemporalAdvisor::canFitBetween(token, it->first, it->second));
+      if (results.back())
+        open.push_back(std::make_pair(it->first->end(), it->second->start()));
+    }
+    if (open.empty())
+      return;
+
+    std::vector<bool> fits;
+    m_propagator->canFitBetweenEach(token->start(), token->end(), open, fits);
+    std::vector<bool>::const_iterator fit = fits.begin();
+    for (std::vector<bool>::iterator it = results.begin(); it != results.end(); ++it)
+      if (*it)
+        *it = *(fit++);
+  }
+
   /**
    * @brief 2 tokens can be concurrent if the temporal distance between them can be 0
    */
@@ -24,8 +24,12 @@ namespace EUROPA{
 
     virtual bool canPrecede(const TokenId first, const TokenId second);
     virtual bool canPrecede(const TimeVarId first, const TimeVarId second);
+    virtual void cacheOrderingDistances(const TokenId token);
     virtual bool canFitBetween(const TokenId token, const TokenId predecessor,
 			       const TokenId successor);
+    virtual void canFitBetweenEach(const TokenId token,
+                                   const std::vector<std::pair<TokenId, TokenId> >& gaps,
+                                   std::vector<bool>& results);
     virtual bool canBeConcurrent(const TokenId first, const TokenId second);
     virtual const IntervalIntDomain getTemporalDistanceDomain(const TimeVarId first, 
 							      const TimeVarId second,
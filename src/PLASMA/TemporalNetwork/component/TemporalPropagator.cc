@@ -701,6 +701,36 @@ void TemporalPropagator::updateCnet() {
     return !result;
   }
 
+  void TemporalPropagator::cacheDistancesFrom(const ConstrainedVariableId var) {
+    check_error(!updateRequired());
+    if (!m_tnet->isDistanceCaching())
+      return;
+    Timepoint* const tp = getTimepoint(var);
+    check_error(tp);
+    std::vector<Timepoint*> targs;
+    std::vector<Time> dists;
+    m_tnet->calcDistancesFrom(*tp, targs, dists);
+  }
+
+  void TemporalPropagator::cacheDistancesTo(const ConstrainedVariableId var) {
+    check_error(!updateRequired());
+    if (!m_tnet->isDistanceCaching())
+      return;
+    Timepoint* const tp = getTimepoint(var);
+    check_error(tp);
+    std::vector<Timepoint*> srcs;
+    std::vector<Time> dists;
+    m_tnet->calcDistancesTo(*tp, srcs, dists);
+  }
+
+  void TemporalPropagator::setDistanceCaching(bool enabled) {
+    m_tnet->setDistanceCaching(enabled);
+  }
+
+  bool TemporalPropagator::isDistanceCaching() const {
+    return m_tnet->isDistanceCaching();
+  }
+
   bool TemporalPropagator::canFitBetween(const ConstrainedVariableId start, const ConstrainedVariableId end,
                                          const ConstrainedVariableId predend, const ConstrainedVariableId succstart) {
     check_error(!updateRequired());
@@ -736,6 +766,39 @@ void TemporalPropagator::updateCnet() {
     return (!m_tnet->isDistanceLessThan(*pend,*sstart,minDuration));
   }
 
+  /**
+   * canFitBetween reads the bounds of start and end before and after propagation. Its first distance
+   * test propagates the network, so both reads see the same bounds and one test against the minimum
+   * duration suffices. The minimum duration does not depend on the gap, so it is computed once here.
+   */
+  void TemporalPropagator::canFitBetweenEach(const ConstrainedVariableId start, const ConstrainedVariableId end,
+                                             const std::vector<std::pair<ConstrainedVariableId, ConstrainedVariableId> >& gaps,
+                                             std::vector<bool>& results) {
+    check_error(!updateRequired());
+    check_error(results.empty());
+    Timepoint* const tstart = getTimepoint(start);
+    Timepoint* const tend = getTimepoint(end);
+    check_error(tstart);
+    check_error(tend);
+
+    Time slb, sub;
+    m_tnet->getTimepointBounds(*tstart, slb, sub);
+    Time elb, eub;
+    m_tnet->getTimepointBounds(*tend, elb, eub);
+    const Time minDuration = elb-sub;
+
+    results.reserve(gaps.size());
+    for (std::vector<std::pair<ConstrainedVariableId, ConstrainedVariableId> >::const_iterator it = gaps.begin();
+         it != gaps.end(); ++it) {
+      Timepoint* const pend = getTimepoint(it->first);
+      Timepoint* const sstart = getTimepoint(it->second);
+      check_error(pend);
+      check_error(sstart);
+      results.push_back(!m_tnet->isDistanceLessThan(*pend,*sstart,1) &&
+                        !m_tnet->isDistanceLessThan(*pend,*sstart,minDuration));
+    }
+  }
+
   bool TemporalPropagator::canBeConcurrent(const ConstrainedVariableId first, const ConstrainedVariableId second) {
     Timepoint* const _first = getTimepoint(first);
     Timepoint* const _second = getTimepoint(second);
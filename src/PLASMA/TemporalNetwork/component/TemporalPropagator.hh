@@ -38,6 +38,31 @@ namespace EUROPA {
     bool canFitBetween(const ConstrainedVariableId start, const ConstrainedVariableId end,
 		       const ConstrainedVariableId predend, const ConstrainedVariableId succstart);
 
+    /**
+     * @brief canFitBetween for one interval and several gaps, each a pair of predecessor end and
+     * successor start. The bounds on the duration of the interval are read once for all gaps.
+     * @param results Output parameter, initially empty. Holds the canFitBetween test of each gap, in order.
+     * @see TemporalAdvisor::canFitBetweenEach
+     */
+    void canFitBetweenEach(const ConstrainedVariableId start, const ConstrainedVariableId end,
+                           const std::vector<std::pair<ConstrainedVariableId, ConstrainedVariableId> >& gaps,
+                           std::vector<bool>& results);
+
+    /**
+     * @brief Precompute exact distances from (resp. to) var, so that later
+     * canPrecede and canFitBetween queries starting (resp. ending) at var are
+     * answered without a search. Only has an effect when distance caching is on.
+     * @see TemporalAdvisor::cacheOrderingDistances
+     */
+    void cacheDistancesFrom(const ConstrainedVariableId var);
+    void cacheDistancesTo(const ConstrainedVariableId var);
+
+    /**
+     * @see TemporalNetwork::setDistanceCaching
+     */
+    void setDistanceCaching(bool enabled);
+    bool isDistanceCaching() const;
+
     /**
      * @see TemporalAdvisor::canBeConcurrent
      */
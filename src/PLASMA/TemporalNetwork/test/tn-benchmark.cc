@@ -0,0 +1,92 @@
+/**
+ * @file tn-benchmark.cc
+ * @brief Times incremental propagation and distance queries on a synthetic
+ * temporal network, reporting edges relaxed per second.
+ *
+ * Usage: tn-benchmark [timepoints] [rounds]
+ */
+
+#include "TemporalNetwork.hh"
+#include "DataTypes.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <sys/time.h>
+
+using namespace EUROPA;
+
+namespace {
+
+double now() {
+  timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+void report(const char* phase, unsigned long relaxed, double seconds) {
+  std::cout << phase << ": " << relaxed << " edges relaxed in " << seconds << "s";
+  if (seconds > 0)
+    std::cout << " (" << static_cast<unsigned long>(relaxed / seconds) << " edges/s)";
+  std::cout << std::endl;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  VoidDT::instance();
+  BoolDT::instance();
+  IntDT::instance();
+  FloatDT::instance();
+  StringDT::instance();
+  SymbolDT::instance();
+
+  const unsigned int timepointCount = (argc > 1 ? atoi(argv[1]) : 2000);
+  const unsigned int rounds = (argc > 2 ? atoi(argv[2]) : 200);
+  srand(1);
+
+  TemporalNetwork tn;
+  Timepoint& origin = tn.getOrigin();
+  std::vector<Timepoint*> timepoints;
+  unsigned long relaxed = tn.getRelaxedEdgeCount();
+  double start = now();
+
+  // A bundle of chains anchored at the origin, with random forward
+  // cross links, roughly the shape of a plan of activities on timelines.
+  for (unsigned int i = 0; i < timepointCount; i++) {
+    Timepoint& tp = tn.addTimepoint();
+    tn.addTemporalConstraint(origin, tp, 0, 100000);
+    if (i >= 10)
+      tn.addTemporalConstraint(*timepoints[i - 10], tp, 1, 50);
+    if (i >= 50 && rand() % 3 == 0)
+      tn.addTemporalConstraint(*timepoints[rand() % (i - 40)], tp, 0, 100000);
+    timepoints.push_back(&tp);
+  }
+
+  tn.propagate();
+  report("construction", tn.getRelaxedEdgeCount() - relaxed, now() - start);
+
+  // Tighten and relax a constraint in the middle of the network.
+  relaxed = tn.getRelaxedEdgeCount();
+  start = now();
+  for (unsigned int r = 0; r < rounds; r++) {
+    unsigned int i = timepointCount / 4 + rand() % (timepointCount / 2);
+    TemporalConstraint* c = tn.addTemporalConstraint(*timepoints[i], *timepoints[i + 1], 0, 1);
+    tn.propagate();
+    tn.removeTemporalConstraint(*c);
+    tn.propagate();
+  }
+  report("incremental propagation", tn.getRelaxedEdgeCount() - relaxed, now() - start);
+
+  // Pairwise distance queries, which use bounded Dijkstra.
+  relaxed = tn.getRelaxedEdgeCount();
+  start = now();
+  for (unsigned int r = 0; r < rounds; r++) {
+    Time lb(0), ub(0);
+    tn.calcDistanceBounds(*timepoints[rand() % timepointCount],
+                          *timepoints[rand() % timepointCount], lb, ub);
+  }
+  report("distance queries", tn.getRelaxedEdgeCount() - relaxed, now() - start);
+  return 0;
+}
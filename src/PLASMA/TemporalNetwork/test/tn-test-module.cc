@@ -110,6 +110,7 @@ public:
     EUROPA_runTest(testFixForReversingEndpoints);
     EUROPA_runTest(testMemoryCleanups);
     EUROPA_runTest(testMemoryCleanupSimple);
+    EUROPA_runTest(testDistanceCache);
     return true;
   }
 
@@ -228,6 +229,55 @@ private:
     tn.calcDistanceBounds(x, y, delta, epsilon);
     return true;
   }
+
+  static bool testDistanceCache() {
+    TemporalNetwork tn;
+    Timepoint& origin = tn.getOrigin();
+    std::vector<Timepoint*> tps;
+    srand(7);
+    for (int i = 0; i < 40; i++) {
+      Timepoint& tp = tn.addTimepoint();
+      tn.addTemporalConstraint(origin, tp, 0, 1000);
+      if (i >= 3)
+        tn.addTemporalConstraint(*tps[i - 3], tp, 1, 20);
+      if (i >= 10 && rand() % 2 == 0)
+        tn.addTemporalConstraint(*tps[rand() % (i - 5)], tp, -5, 500);
+      tps.push_back(&tp);
+    }
+    CPPUNIT_ASSERT(tn.propagate());
+
+    // Bulk distances agree with pairwise ones, with and without the cache.
+    for (int pass = 0; pass < 2; pass++) {
+      tn.setDistanceCaching(pass == 1);
+      for (unsigned int i = 0; i < tps.size(); i += 7) {
+        std::vector<Time> from, to;
+        tn.calcDistancesFrom(*tps[i], tps, from);
+        tn.calcDistancesTo(*tps[i], tps, to);
+        for (unsigned int j = 0; j < tps.size(); j++) {
+          Time lb, ub;
+          tn.calcDistanceBounds(*tps[i], *tps[j], lb, ub);
+          CPPUNIT_ASSERT(from[j] == ub);
+          CPPUNIT_ASSERT(to[j] == -lb);
+        }
+      }
+    }
+
+    // A cached row is dropped once the network changes.
+    Time lb, ub;
+    tn.calcDistanceBounds(*tps[0], *tps[39], lb, ub);
+    CPPUNIT_ASSERT(lb < ub);
+    std::vector<Time> dists;
+    tn.calcDistancesFrom(*tps[0], tps, dists);
+    CPPUNIT_ASSERT(!tn.isDistanceLessThan(*tps[0], *tps[39], ub));
+    TemporalConstraint* c = tn.addTemporalConstraint(*tps[0], *tps[39], lb, ub - 1);
+    CPPUNIT_ASSERT(tn.propagate());
+    CPPUNIT_ASSERT(tn.isDistanceLessThan(*tps[0], *tps[39], ub));
+    tn.calcDistancesTo(*tps[39], tps, dists);
+    CPPUNIT_ASSERT(dists[0] == ub - 1);
+    tn.removeTemporalConstraint(*c);
+    CPPUNIT_ASSERT(!tn.isDistanceLessThan(*tps[0], *tps[39], ub));
+    return true;
+  }
 };
 
 class TemporalPropagatorTest {
@@ -237,6 +287,7 @@ public:
     EUROPA_runTest(testTemporalPropagation);
     EUROPA_runTest(testCanPrecede);
     EUROPA_runTest(testCanFitBetween);
+    EUROPA_runTest(testCanFitBetweenEach);
     EUROPA_runTest(testCanBeConcurrent);
     EUROPA_runTest(testTemporalDistance);
     EUROPA_runTest(testTokenStateChangeSynchronization);
@@ -483,6 +534,61 @@ private:
     return true;
   }
 
+  static bool testCanFitBetweenEach() {
+    CD_DEFAULT_SETUP(ce,db,false);
+
+    ObjectId timeline = (new Timeline(db.getId(), "Objects", "o2"))->getId();
+    CPPUNIT_ASSERT(!timeline.isNoId());
+
+    db.close();
+
+    IntervalToken token(db.getId(), "Objects.Predicate", true, false,
+                        IntervalIntDomain(0, 10), IntervalIntDomain(20, 100), IntervalIntDomain(10, 1000));
+    IntervalToken a(db.getId(), "Objects.Predicate", true, false,
+                    IntervalIntDomain(0, 100), IntervalIntDomain(0, 100), IntervalIntDomain(1, 1000));
+    IntervalToken b(db.getId(), "Objects.Predicate", true, false,
+                    IntervalIntDomain(0, 100), IntervalIntDomain(0, 100), IntervalIntDomain(1, 1000));
+    IntervalToken c(db.getId(), "Objects.Predicate", true, false,
+                    IntervalIntDomain(0, 100), IntervalIntDomain(0, 100), IntervalIntDomain(1, 1000));
+    IntervalToken d(db.getId(), "Objects.Predicate", true, false,
+                    IntervalIntDomain(0, 5), IntervalIntDomain(0, 100), IntervalIntDomain(1, 1000));
+
+    // At most 3 between a and b, which only the distance graph knows; b precedes c, so c cannot come before b
+    Variable<IntervalIntDomain> distance(ce.getId(), IntervalIntDomain(0, 3));
+    std::vector<ConstrainedVariableId> scope;
+    scope.push_back(a.end());
+    scope.push_back(distance.getId());
+    scope.push_back(b.start());
+    ConstraintId shortGap = ce.createConstraint("temporalDistance", scope);
+    scope.clear();
+    scope.push_back(b.end());
+    scope.push_back(c.start());
+    ConstraintId before = ce.createConstraint("precedes", scope);
+    CPPUNIT_ASSERT(ce.propagate());
+
+    // The last gap fails on bounds alone, as d must start by 5
+    std::vector<std::pair<TokenId, TokenId> > gaps;
+    gaps.push_back(std::make_pair(a.getId(), b.getId()));
+    gaps.push_back(std::make_pair(b.getId(), c.getId()));
+    gaps.push_back(std::make_pair(c.getId(), b.getId()));
+    gaps.push_back(std::make_pair(a.getId(), d.getId()));
+
+    std::vector<bool> fits;
+    db.getTemporalAdvisor()->canFitBetweenEach(token.getId(), gaps, fits);
+    CPPUNIT_ASSERT(fits.size() == gaps.size());
+    CPPUNIT_ASSERT(!fits[0]);
+    CPPUNIT_ASSERT(fits[1]);
+    CPPUNIT_ASSERT(!fits[2]);
+    CPPUNIT_ASSERT(!fits[3]);
+    for (unsigned int i = 0; i < gaps.size(); i++)
+      CPPUNIT_ASSERT(fits[i] == db.getTemporalAdvisor()->canFitBetween(token.getId(), gaps[i].first, gaps[i].second));
+
+    delete static_cast<Constraint*>(before);
+    delete static_cast<Constraint*>(shortGap);
+    TN_DEFAULT_TEARDOWN();
+    return true;
+  }
+
   static bool testCanBeConcurrent() {
     CD_DEFAULT_SETUP(ce,db,false);
 
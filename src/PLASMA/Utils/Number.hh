@@ -335,6 +335,56 @@ namespace EUROPA {
 }
 #else
 #define op(type, a, x, b) return (a) x (b)
+#endif
+
+  /**
+   * Arithmetic policy.  By default every operation tests its operands for infinities and then
+   * checks the result for overflow, throwing if it passes infinity.  Building with
+   * EUROPA_FAST_NUMERICS instead computes the raw result and saturates it at the infinities,
+   * with the same algebra on infinite operands, using selects rather than branches so that
+   * loops over numbers can be vectorized.  The policies differ only on overflow, which
+   * saturates rather than throwing, and on division by zero, which yields an infinity.
+   */
+#ifndef EUROPA_FAST_NUMERICS
+#define arith_add(type, a, b) {handle_inf_add(type, a, b); op(type, a, +, b);}
+#define arith_sub(type, a, b) {handle_inf_sub(type, a, b); op(type, a, -, b);}
+#define arith_mul(type, a, b) {handle_inf_mul(type, a, b); op(type, a, *, b);}
+#define arith_div(type, a, b) {handle_inf_div(type, a, b); op(type, a, /, b);}
+#else
+#define saturate(r, inf) ((r) > (inf) ? (inf) : ((r) < -(inf) ? -(inf) : (r)))
+
+#define arith_add(type, v1, v2) {                                       \
+  const double inf = cast_double(std::numeric_limits<type>::infinity()); \
+  const double a = static_cast<double>(v1), b = static_cast<double>(v2); \
+  const bool pinf = (a >= inf) | (b >= inf), minf = (a <= -inf) | (b <= -inf); \
+  double r = saturate(a + b, inf);                                      \
+  r = (pinf & !minf) ? inf : r;                                         \
+  r = (minf & !pinf) ? -inf : r;                                        \
+  return type(static_cast<type::basis_type>(r), true);                  \
+}
+
+#define arith_sub(type, v1, v2) arith_add(type, v1, -static_cast<double>(v2))
+
+#define arith_mul(type, v1, v2) {                                       \
+  const double inf = cast_double(std::numeric_limits<type>::infinity()); \
+  const double a = static_cast<double>(v1), b = static_cast<double>(v2); \
+  const bool anyInf = (a >= inf) | (a <= -inf) | (b >= inf) | (b <= -inf); \
+  double r = saturate(a * b, inf);                                      \
+  r = (anyInf & (r > 0)) ? inf : r;                                     \
+  r = (anyInf & (r < 0)) ? -inf : r;                                    \
+  return type(static_cast<type::basis_type>(r), true);                  \
+}
+
+#define arith_div(type, v1, v2) {                                       \
+  const double inf = cast_double(std::numeric_limits<type>::infinity()); \
+  const double a = static_cast<double>(v1), b = static_cast<double>(v2); \
+  const bool aInf = (a >= inf) | (a <= -inf), bInf = (b >= inf) | (b <= -inf); \
+  double r = saturate(a / b, inf);                                      \
+  r = (bInf & !aInf) ? 0.0 : r;                                         \
+  r = (aInf & !bInf & (r > 0)) ? inf : r;                               \
+  r = (aInf & !bInf & (r < 0)) ? -inf : r;                              \
+  return type(static_cast<type::basis_type>(r), true);                  \
+}
 #endif
 
   //it feels a bit dirty doing this this way.  I don't want to make this code un-readable because of all the macros, but I also
@@ -441,21 +491,21 @@ namespace EUROPA {
     inline eint operator++(int) {handle_inf_unary(eint, m_v); return eint(m_v++, true);}
     inline eint& operator--() {handle_inf_unary_self(eint, m_v); --m_v; return *this;}
     inline eint operator--(int) {handle_inf_unary(eint, m_v); return eint(m_v--, true);}
-    inline eint operator+(const int o) const {handle_inf_add(eint, m_v, o); op(eint, m_v, +, o);}
-    inline eint operator+(const unsigned long o) const {handle_inf_add(eint, m_v, o); op(eint, m_v, +, o);}
-    inline eint operator+(const basis_type o) const {handle_inf_add(eint, m_v, o); op(eint, m_v, +, o);}
+    inline eint operator+(const int o) const {arith_add(eint, m_v, o);}
+    inline eint operator+(const unsigned long o) const {arith_add(eint, m_v, o);}
+    inline eint operator+(const basis_type o) const {arith_add(eint, m_v, o);}
     inline eint operator+(const eint o) const {return operator+(o.m_v);}
-    inline eint operator-(const int o) const {handle_inf_sub(eint, m_v, o); op(eint, m_v, -, o);}
-    inline eint operator-(const unsigned long o) const {handle_inf_sub(eint, m_v, o); op(eint, m_v, -, o);}
-    inline eint operator-(const basis_type o) const {handle_inf_sub(eint, m_v, o); op(eint, m_v, -, o);}
+    inline eint operator-(const int o) const {arith_sub(eint, m_v, o);}
+    inline eint operator-(const unsigned long o) const {arith_sub(eint, m_v, o);}
+    inline eint operator-(const basis_type o) const {arith_sub(eint, m_v, o);}
     inline eint operator-(const eint o) const {return operator-(o.m_v);}
-    inline eint operator*(const int o) const {handle_inf_mul(eint, m_v, o); op(eint, m_v, *, o);}
-    inline eint operator*(const unsigned long o) const {handle_inf_mul(eint, m_v, o); op(eint, m_v, *, o);}
-    inline eint operator*(const basis_type o) const {handle_inf_mul(eint, m_v, o); op(eint, m_v, *, o);}
+    inline eint operator*(const int o) const {arith_mul(eint, m_v, o);}
+    inline eint operator*(const unsigned long o) const {arith_mul(eint, m_v, o);}
+    inline eint operator*(const basis_type o) const {arith_mul(eint, m_v, o);}
     inline eint operator*(const eint o) const {return operator*(o.m_v);}
-    inline eint operator/(const int o) const {handle_inf_div(eint, m_v, o); op(eint, m_v, /, o);}
-    inline eint operator/(const unsigned long o) const {handle_inf_mul(eint, m_v, o); op(eint, m_v, *, o);}
-    inline eint operator/(const basis_type o) const {handle_inf_div(eint, m_v, o); op(eint, m_v, /, o);}
+    inline eint operator/(const int o) const {arith_div(eint, m_v, o);}
+    inline eint operator/(const unsigned long o) const {arith_div(eint, m_v, o);}
+    inline eint operator/(const basis_type o) const {arith_div(eint, m_v, o);}
     inline eint operator/(const eint o) const {return operator/(o.m_v);}
 
     //have to special-case this, since % isn't defined on doubles
@@ -557,10 +607,10 @@ namespace EUROPA {
     long m_v;
   };  //class eint
 
-  inline eint operator+(const long o, const eint e) {handle_inf_add(eint, o, e.m_v); op(eint, o, +, e.m_v);}
-  inline eint operator-(const long o, const eint e) {handle_inf_sub(eint, o, e.m_v); op(eint, o, -, e.m_v);}
-  inline eint operator*(const long o, const eint e) {handle_inf_mul(eint, o, e.m_v); op(eint, o, *, e.m_v);}
-  inline eint operator/(const long o, const eint e) {handle_inf_div(eint, o, e.m_v); op(eint, o, /, e.m_v);}
+  inline eint operator+(const long o, const eint e) {arith_add(eint, o, e.m_v);}
+  inline eint operator-(const long o, const eint e) {arith_sub(eint, o, e.m_v);}
+  inline eint operator*(const long o, const eint e) {arith_mul(eint, o, e.m_v);}
+  inline eint operator/(const long o, const eint e) {arith_div(eint, o, e.m_v);}
   inline eint operator%(const long o, const eint e) {
     handle_inf_mod(eint, o, e.m_v);
     return eint(o % e.m_v, true);
@@ -601,10 +651,10 @@ namespace EUROPA {
     inline edouble operator++(int) {handle_inf_unary(edouble, m_v); return edouble(m_v++, true);}
     inline edouble& operator--() {handle_inf_unary_self(edouble, m_v); --m_v; return *this;}
     inline edouble operator--(int) {handle_inf_unary(edouble, m_v); return edouble(m_v--, true);}
-    inline edouble operator+(const edouble o) const {handle_inf_add(edouble, m_v, o.m_v); op(edouble, m_v, +, o.m_v);}
-    inline edouble operator-(const edouble o) const {handle_inf_sub(edouble, m_v, o.m_v); op(edouble, m_v, -, o.m_v);}
-    inline edouble operator*(const edouble o) const {handle_inf_mul(edouble, m_v, o.m_v); op(edouble, m_v, *, o.m_v);}
-    inline edouble operator/(const edouble o) const {handle_inf_div(edouble, m_v, o.m_v); op(edouble, m_v, /, o.m_v);}
+    inline edouble operator+(const edouble o) const {arith_add(edouble, m_v, o.m_v);}
+    inline edouble operator-(const edouble o) const {arith_sub(edouble, m_v, o.m_v);}
+    inline edouble operator*(const edouble o) const {arith_mul(edouble, m_v, o.m_v);}
+    inline edouble operator/(const edouble o) const {arith_div(edouble, m_v, o.m_v);}
     inline edouble operator+=(const edouble o) {(*this) = operator+(o); return edouble(m_v, true);}
     inline edouble operator-=(const edouble o) {(*this) = operator-(o); return edouble(m_v, true);}
     inline edouble operator*=(const edouble o) {(*this) = operator*(o); return edouble(m_v, true);}
@@ -673,14 +723,14 @@ namespace EUROPA {
     double m_v;
   };
 
-edouble eint::operator+(const edouble o) const {handle_inf_add(edouble, m_v, o.m_v); op(edouble, static_cast<double>(m_v), +, o.m_v);}
-edouble eint::operator-(const edouble o) const {handle_inf_sub(edouble, m_v, o.m_v); op(edouble, static_cast<double>(m_v), -, o.m_v);}
-edouble eint::operator*(const edouble o) const {handle_inf_mul(edouble, m_v, o.m_v); op(edouble, static_cast<double>(m_v), *, o.m_v);}
-edouble eint::operator/(const edouble o) const {handle_inf_div(edouble, m_v, o.m_v); op(edouble, static_cast<double>(m_v), /, o.m_v);}
-edouble eint::operator+(const double o) const {handle_inf_add(edouble, m_v, o); op(edouble, static_cast<double>(m_v), +, o);}
-edouble eint::operator-(const double o) const {handle_inf_sub(edouble, m_v, o); op(edouble, static_cast<double>(m_v), -, o);}
-edouble eint::operator*(const double o) const {handle_inf_mul(edouble, m_v, o); op(edouble, static_cast<double>(m_v), *, o);}
-edouble eint::operator/(const double o) const {handle_inf_div(edouble, m_v, o); op(edouble, static_cast<double>(m_v), /, o);}
+edouble eint::operator+(const edouble o) const {arith_add(edouble, static_cast<double>(m_v), o.m_v);}
+edouble eint::operator-(const edouble o) const {arith_sub(edouble, static_cast<double>(m_v), o.m_v);}
+edouble eint::operator*(const edouble o) const {arith_mul(edouble, static_cast<double>(m_v), o.m_v);}
+edouble eint::operator/(const edouble o) const {arith_div(edouble, static_cast<double>(m_v), o.m_v);}
+edouble eint::operator+(const double o) const {arith_add(edouble, static_cast<double>(m_v), o);}
+edouble eint::operator-(const double o) const {arith_sub(edouble, static_cast<double>(m_v), o);}
+edouble eint::operator*(const double o) const {arith_mul(edouble, static_cast<double>(m_v), o);}
+edouble eint::operator/(const double o) const {arith_div(edouble, static_cast<double>(m_v), o);}
 bool eint::operator<(const edouble o) const {return m_v < o.m_v;}
 bool eint::operator<=(const edouble o) const {return m_v <= o.m_v;}
 bool eint::operator==(const edouble o) const {return m_v == o.m_v;}
@@ -695,10 +745,10 @@ bool eint::operator!=(const edouble o) const {return m_v != o.m_v;}
   bool eint::operator>(const double o) const {return m_v > o;}
   bool eint::operator!=(const double o) const {return m_v != o;}
 
-  inline edouble operator+(const double o, const edouble e) {handle_inf_add(edouble, o, e.m_v); op(edouble, o, +, e.m_v);}
-  inline edouble operator-(const double o, const edouble e) {handle_inf_sub(edouble, o, e.m_v); op(edouble, o, -, e.m_v);}
-  inline edouble operator*(const double o, const edouble e) {handle_inf_mul(edouble, o, e.m_v); op(edouble, o, *, e.m_v);}
-  inline edouble operator/(const double o, const edouble e) {handle_inf_div(edouble, o, e.m_v); op(edouble, o, /, e.m_v);}
+  inline edouble operator+(const double o, const edouble e) {arith_add(edouble, o, e.m_v);}
+  inline edouble operator-(const double o, const edouble e) {arith_sub(edouble, o, e.m_v);}
+  inline edouble operator*(const double o, const edouble e) {arith_mul(edouble, o, e.m_v);}
+  inline edouble operator/(const double o, const edouble e) {arith_div(edouble, o, e.m_v);}
 
   GEN_FRIEND_COMPARISONS(int, edouble);
   GEN_FRIEND_COMPARISONS(long, edouble);
@@ -801,6 +851,13 @@ inline EUROPA::edouble fmod(const EUROPA::edouble a, const EUROPA::edouble b) {r
 #undef handle_inf_add
 #undef handle_inf_unary
 #undef op
+#undef arith_add
+#undef arith_sub
+#undef arith_mul
+#undef arith_div
+#ifdef EUROPA_FAST_NUMERICS
+#undef saturate
+#endif
 
 /**
  * @def MAX_PRECISION
@@ -14,10 +14,12 @@
 #include "IdTable.hh"
 #include "CommonDefs.hh"
 #include "Debug.hh"
-#include "LabelStr.hh"
 #include "Mutex.hh"
 #include "Entity.hh"
 
+#include <algorithm>
+#include <map>
+
 /**
  * @file IdTable.cc
  * @author Conor McGann
@@ -28,6 +30,8 @@
  * @li Use the output function to display pointer address and key pairs that have not been deallocated.
  * @li Use debug messages this information in conjunction with the output.
  * @li A dangling pointer failure can be traced by looking for the removal event for a given <pointer, key> pair.
+ * @li Shards never share entries, so each is guarded by its own mutex. The type name table has a
+ * separate lock, taken only the first time a shard sees a given type name.
  * @date  July, 2003
  * @see Id<T>
  */
@@ -35,95 +39,259 @@
 namespace EUROPA {
 
 namespace {
-unsigned int getEntryKey(std::pair<unsigned int,edouble>& entry) {
-    return entry.first;
+pthread_mutex_t& IdTypeMutex() {
+  static pthread_mutex_t sl_mutex = PTHREAD_MUTEX_INITIALIZER;
+  return sl_mutex;
 }
 
-LabelStr getEntryType(std::pair<unsigned int,edouble>& entry) {
-    return LabelStr(entry.second);
+/**
+ * @brief Spread the bits of an address so that aligned pointers fill a power-of-two table.
+ */
+inline unsigned long hashAddress(unsigned long id) {
+  id ^= id >> 16;
+  id *= 0x45d9f3bUL;
+  id ^= id >> 16;
+  return id;
 }
 
-pthread_mutex_t& IdTableMutex() {
-  static pthread_mutex_t sl_mutex = PTHREAD_MUTEX_INITIALIZER;
-  return sl_mutex;
+/**
+ * @brief Open-addressing (linear probing) table keyed by a non-zero address.
+ * Removal shifts the following entries back so no tombstones are needed.
+ */
+class AddressTable {
+public:
+  struct Entry {
+    unsigned long id;
+    unsigned int key;
+    unsigned int type;
+  };
+
+  AddressTable() : m_entries(NULL), m_mask(0), m_count(0) {}
+  ~AddressTable() { delete[] m_entries; }
+
+  unsigned long size() const { return m_count; }
+
+  Entry* find(unsigned long id) const {
+    if(id == 0 || m_entries == NULL)
+      return NULL;
+    for(unsigned long i = hashAddress(id) & m_mask; m_entries[i].id != 0; i = (i + 1) & m_mask)
+      if(m_entries[i].id == id)
+        return &m_entries[i];
+    return NULL;
+  }
+
+  /**
+   * @brief Insert id, which must not be present. Returns the new entry.
+   */
+  Entry* insert(unsigned long id) {
+    if(2 * (m_count + 1) > m_mask + 1)
+      grow();
+    unsigned long i = hashAddress(id) & m_mask;
+    while(m_entries[i].id != 0)
+      i = (i + 1) & m_mask;
+    m_entries[i].id = id;
+    m_count++;
+    return &m_entries[i];
+  }
+
+  void remove(Entry* entry) {
+    unsigned long i = entry - m_entries;
+    unsigned long j = i;
+    for(;;) {
+      j = (j + 1) & m_mask;
+      if(m_entries[j].id == 0)
+        break;
+      unsigned long home = hashAddress(m_entries[j].id) & m_mask;
+      // Move j into the hole at i unless its home slot lies cyclically in (i, j].
+      bool stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+      if(!stays) {
+        m_entries[i] = m_entries[j];
+        i = j;
+      }
+    }
+    m_entries[i].id = 0;
+    m_count--;
+  }
+
+  template<class F>
+  void forEach(F& f) const {
+    for(unsigned long i = 0; m_entries != NULL && i <= m_mask; i++)
+      if(m_entries[i].id != 0)
+        f(m_entries[i]);
+  }
+
+private:
+  void grow() {
+    Entry* old = m_entries;
+    unsigned long oldCapacity = (old == NULL ? 0 : m_mask + 1);
+    unsigned long capacity = (oldCapacity == 0 ? 64 : 2 * oldCapacity);
+    m_entries = new Entry[capacity];
+    for(unsigned long i = 0; i < capacity; i++)
+      m_entries[i].id = 0;
+    m_mask = capacity - 1;
+    for(unsigned long i = 0; i < oldCapacity; i++) {
+      if(old[i].id == 0)
+        continue;
+      unsigned long j = hashAddress(old[i].id) & m_mask;
+      while(m_entries[j].id != 0)
+        j = (j + 1) & m_mask;
+      m_entries[j] = old[i];
+    }
+    delete[] old;
+  }
+
+  AddressTable(const AddressTable&);
+  AddressTable& operator=(const AddressTable&);
+
+  Entry* m_entries;
+  unsigned long m_mask;
+  unsigned long m_count;
+};
+
+struct CollectEntries {
+  std::vector<AddressTable::Entry> entries;
+  void operator()(const AddressTable::Entry& e) { entries.push_back(e); }
+};
+
+bool lessAddress(const AddressTable::Entry& a, const AddressTable::Entry& b) {
+  return a.id < b.id;
 }
 }
 
-IdTable::IdTable() : m_collection(), m_typeCnts() {}
+/**
+ * @brief One independently locked part of the table. Keys are drawn from a per-shard sequence
+ * interleaved with the other shards', so they stay unique without a shared counter.
+ */
+class IdTable::Shard {
+public:
+  Shard(unsigned int index) : m_nextKey(index + 1), m_collection(), m_typeCache(), m_typeCnts() {
+    pthread_mutex_init(&m_mutex, NULL);
+  }
+
+  ~Shard() {
+    pthread_mutex_destroy(&m_mutex);
+  }
+
+  pthread_mutex_t m_mutex;
+  unsigned int m_nextKey;
+  AddressTable m_collection; /**< Map from pointers to keys and type indices */
+  AddressTable m_typeCache; /**< Map from type name pointers to type indices */
+  std::vector<unsigned int> m_typeCnts; /**< Live instances, indexed by type */
+};
+
+IdTable::IdTable() : m_typeNames() {
+  for(unsigned int i = 0; i < EUROPA_ID_TABLE_SHARDS; i++)
+    m_shards[i] = new Shard(i);
+}
 
   IdTable::~IdTable() {
+    for(unsigned int i = 0; i < EUROPA_ID_TABLE_SHARDS; i++)
+      delete m_shards[i];
   }
 
   IdTable& IdTable::getInstance() {
     static IdTable sl_instance;
     return(sl_instance);
   }
+
+  IdTable::Shard* IdTable::getShard(unsigned long int id) {
+    return m_shards[(hashAddress(id) >> 8) % EUROPA_ID_TABLE_SHARDS];
+  }
+
+  unsigned int IdTable::internType(const char* baseType) {
+    MutexGrabber mg(IdTypeMutex());
+    for(unsigned int i = 0; i < m_typeNames.size(); i++)
+      if(m_typeNames[i] == baseType)
+        return i;
+    m_typeNames.push_back(baseType);
+    return m_typeNames.size() - 1;
+  }
+
+  std::string IdTable::getTypeName(unsigned int type) {
+    MutexGrabber mg(IdTypeMutex());
+    return m_typeNames[type];
+  }
+
 unsigned long IdTable::size() {
-  MutexGrabber mg(IdTableMutex());
-  return(getInstance().m_collection.size());
+  unsigned long count = 0;
+  for(unsigned int i = 0; i < EUROPA_ID_TABLE_SHARDS; i++) {
+    Shard* shard = getInstance().m_shards[i];
+    MutexGrabber mg(shard->m_mutex);
+    count += shard->m_collection.size();
+  }
+  return(count);
 }
 
   bool IdTable::allocated(unsigned long int id) {
-    MutexGrabber mg(IdTableMutex());
-    return(getInstance().m_collection.find(id) != getInstance().m_collection.end());
+    Shard* shard = getInstance().getShard(id);
+    MutexGrabber mg(shard->m_mutex);
+    return(shard->m_collection.find(id) != NULL);
   }
 
   unsigned int IdTable::getKey(unsigned long int id) {
-    MutexGrabber mg(IdTableMutex());
+    Shard* shard = getInstance().getShard(id);
+    MutexGrabber mg(shard->m_mutex);
     debugMsg("IdTable:getKey", "Searching for key for " << std::hex << id << std::dec);
-    std::map<unsigned long int, std::pair<unsigned int,edouble> >::iterator it = getInstance().m_collection.find(id);
-    if (it != getInstance().m_collection.end())
-      return getEntryKey(it->second);
-    else
-      return(0);
+    AddressTable::Entry* entry = shard->m_collection.find(id);
+    return(entry != NULL ? entry->key : 0);
   }
 
   unsigned int IdTable::insert(unsigned long int id, const char* baseType) {
-    MutexGrabber mg(IdTableMutex());
-    static unsigned int sl_nextId(1);
-    debugMsg("IdTable:insert", "id,key:" << std::hex << id << std::dec << ", " << sl_nextId << ")");
+    Shard* shard = getInstance().getShard(id);
+    MutexGrabber mg(shard->m_mutex);
+    debugMsg("IdTable:insert", "id,key:" << std::hex << id << std::dec << ", " << shard->m_nextKey << ")");
 
-    std::map<unsigned long int, std::pair<unsigned int,edouble> >::iterator it =
-      getInstance().m_collection.find(id);
-
-    if (it != getInstance().m_collection.end())
+    if (shard->m_collection.find(id) != NULL)
       return(0); /* Already in table. */
 
-    getInstance().m_collection.insert(std::make_pair(id, std::make_pair(sl_nextId,LabelStr(baseType))));
-
-    std::map<std::string, unsigned int>::iterator tCit = getInstance().m_typeCnts.find(baseType);
-    if (tCit == getInstance().m_typeCnts.end())
-      getInstance().m_typeCnts.insert(std::pair<std::string, unsigned int>(baseType, 1));
-    else
-      tCit->second++;
+    unsigned long typeAddress = reinterpret_cast<unsigned long>(baseType);
+    AddressTable::Entry* cached = shard->m_typeCache.find(typeAddress);
+    if (cached == NULL) {
+      cached = shard->m_typeCache.insert(typeAddress);
+      cached->type = getInstance().internType(baseType);
+      if (shard->m_typeCnts.size() <= cached->type)
+        shard->m_typeCnts.resize(cached->type + 1, 0);
+    }
+    unsigned int type = cached->type;
+    shard->m_typeCnts[type]++;
 
-    return(sl_nextId++);
+    AddressTable::Entry* entry = shard->m_collection.insert(id);
+    entry->key = shard->m_nextKey;
+    entry->type = type;
+    shard->m_nextKey += EUROPA_ID_TABLE_SHARDS;
+    return(entry->key);
   }
 
   void IdTable::remove(unsigned long int id) {
-    MutexGrabber mg(IdTableMutex());
-    static unsigned int sl_key;
-    std::map<unsigned long int, std::pair<unsigned int,edouble> >::iterator it = getInstance().m_collection.find(id);    
-
-    sl_key = getEntryKey(it->second);
-    std::string type = getEntryType(it->second).toString();
+    Shard* shard = getInstance().getShard(id);
+    MutexGrabber mg(shard->m_mutex);
+    AddressTable::Entry* entry = shard->m_collection.find(id);
     debugMsg("IdTable:remove",
-             "<" << std::hex << id << std::dec << ", " << sl_key << "," <<
-             type << ">");
-
-
-    debugMsg("IdTable:remove", "<" << id << ", " << sl_key << "," << type << ">");
-    std::map<std::string, unsigned int>::iterator tCit = getInstance().m_typeCnts.find(type);
-    tCit->second--;
-
-    getInstance().m_collection.erase(id);
+             "<" << std::hex << id << std::dec << ", " << entry->key << "," <<
+             getInstance().getTypeName(entry->type) << ">");
+    shard->m_typeCnts[entry->type]--;
+    shard->m_collection.remove(entry);
   }
 
   void IdTable::printTypeCnts(std::ostream& os) {
-    MutexGrabber mg(IdTableMutex());
+    IdTable& table = getInstance();
+    std::vector<unsigned int> counts;
+    for(unsigned int i = 0; i < EUROPA_ID_TABLE_SHARDS; i++) {
+      MutexGrabber mg(table.m_shards[i]->m_mutex);
+      const std::vector<unsigned int>& shardCounts = table.m_shards[i]->m_typeCnts;
+      if (counts.size() < shardCounts.size())
+        counts.resize(shardCounts.size(), 0);
+      for(unsigned int type = 0; type < shardCounts.size(); type++)
+        counts[type] += shardCounts[type];
+    }
+
+    MutexGrabber mg(IdTypeMutex());
+    std::map<std::string, unsigned int> byName;
+    for(unsigned int type = 0; type < counts.size(); type++)
+      byName[table.m_typeNames[type]] = counts[type];
     os << "Id instances by type:\n";
-    for (std::map<std::string, unsigned int>::iterator it = getInstance().m_typeCnts.begin();
-         it != getInstance().m_typeCnts.end();
+    for (std::map<std::string, unsigned int>::iterator it = byName.begin();
+         it != byName.end();
          ++it)
       os << "  " << it->second << "  " << it->first << '\n';
     os << std::endl;
@@ -131,13 +299,21 @@ unsigned long IdTable::size() {
 
   void IdTable::output(std::ostream& os) {
     printTypeCnts(os);
-    MutexGrabber mg(IdTableMutex());
+    IdTable& table = getInstance();
+    CollectEntries collect;
+    for(unsigned int i = 0; i < EUROPA_ID_TABLE_SHARDS; i++) {
+      MutexGrabber mg(table.m_shards[i]->m_mutex);
+      table.m_shards[i]->m_collection.forEach(collect);
+    }
+    std::sort(collect.entries.begin(), collect.entries.end(), lessAddress);
+
+    MutexGrabber mg(IdTypeMutex());
     os << "Id Contents:";
-    for (std::map<unsigned long int, std::pair<unsigned int,edouble> >::iterator it = getInstance().m_collection.begin();
-         it != getInstance().m_collection.end();
+    for (std::vector<AddressTable::Entry>::const_iterator it = collect.entries.begin();
+         it != collect.entries.end();
          ++it)
-      os << " (" << std::hex << it->first << std::dec << ", " << getEntryKey(it->second) << "," <<
-        getEntryType(it->second).toString() << ')';
+      os << " (" << std::hex << it->id << std::dec << ", " << it->key << "," <<
+        table.m_typeNames[it->type] << ')';
     os << std::endl;
   }
 
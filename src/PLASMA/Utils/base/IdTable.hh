@@ -14,12 +14,21 @@
 #ifndef H_IdTable
 #define H_IdTable
 
-#include <map>
 #include <iosfwd>
 #include <string>
+#include <vector>
 #include "Number.hh"
 
 
+/**
+ * @def EUROPA_ID_TABLE_SHARDS
+ * @brief Number of independently locked tables the IdTable is split into. Entries are assigned
+ * to a shard by hashing their address, so threads running separate engines rarely contend.
+ */
+#ifndef EUROPA_ID_TABLE_SHARDS
+#define EUROPA_ID_TABLE_SHARDS 1
+#endif
+
 /**
  * @author Conor McGann
  * @brief Defines a singleton class managing allocation and deallocation of ids for pointers.
@@ -33,8 +42,10 @@ namespace EUROPA {
    * @class IdTable
    * @brief Provides a singleton which manages <pointer,key> pairs.
    *
-   * Main data structure is a map of integer pairs. The map is accessed
-   * by an integer which should be the address of an object managed by an Id. A key is used to
+   * Main data structure is an open-addressing hash table of <pointer, key, type> entries, split
+   * into EUROPA_ID_TABLE_SHARDS shards. The table is accessed
+   * by an integer which should be the address of an object managed by an Id. Type names are
+   * interned to small integers so counting instances by type needs no string operations. A key is used to
    * check for allocations of an Id to a previously allocated address. This is necessary so that dangling
    * Ids can be detected even if the address has been recycled.
    * @see Id
@@ -60,9 +71,19 @@ namespace EUROPA {
   protected:
     IdTable();
     static IdTable& getInstance();
-    
-    std::map<unsigned long int, std::pair<unsigned int,edouble> > m_collection; /**< Map from pointers to keys */
-    std::map<std::string, unsigned int> m_typeCnts;
+
+    class Shard;
+
+    /**
+     * @brief Intern a type name, returning its index in m_typeNames.
+     */
+    unsigned int internType(const char* baseType);
+    std::string getTypeName(unsigned int type);
+
+    Shard* getShard(unsigned long int id);
+
+    Shard* m_shards[EUROPA_ID_TABLE_SHARDS]; /**< Hash tables from pointers to keys and type indices */
+    std::vector<std::string> m_typeNames; /**< Interned type names, indexed by type */
   };
 }
 
@@ -20,29 +20,248 @@ namespace EUROPA {
 //     return(sl_stringFromKeys);
 //   }
 
-  std::map<std::string, edouble>& LabelStr::keysFromString() {
-    static std::map<std::string, edouble> sl_keysFromString;
-    return sl_keysFromString;
+namespace {
+
+/**
+ * @brief The string table is split into stripes by hash, each with its own lock for insertion.
+ * Lookups of labels that already exist take no lock at all: slot tables and the nodes they hold
+ * are immutable once published, and a stripe that grows publishes a new slot table while keeping
+ * the old one alive for readers that may still be probing it.
+ */
+const unsigned int LABEL_STRIPES = 16;
+const unsigned long FIRST_SEGMENT = 1024; /**< Size of the first segment of the key index */
+const unsigned int MAX_SEGMENTS = 32;
+
+struct LabelNode {
+  LabelNode(const std::string& l, unsigned long h, unsigned long i)
+    : label(l), hash(h), index(i) {}
+  const std::string label;
+  const unsigned long hash;
+  const unsigned long index;
+};
+
+struct LabelSlots {
+  LabelSlots(unsigned long capacity) : mask(capacity - 1), nodes(new LabelNode*[capacity]) {
+    for(unsigned long i = 0; i < capacity; i++)
+      nodes[i] = NULL;
+  }
+  ~LabelSlots() { delete[] nodes; }
+  const unsigned long mask;
+  LabelNode** const nodes;
+};
+
+template<class T>
+inline T load(T const& location) {
+  return __atomic_load_n(&location, __ATOMIC_ACQUIRE);
+}
+
+template<class T>
+inline void publish(T& location, T value) {
+  __atomic_store_n(&location, value, __ATOMIC_RELEASE);
+}
+
+unsigned long hashLabel(const std::string& label) {
+  unsigned long h = 2166136261UL;
+  for(std::string::size_type i = 0; i < label.size(); i++)
+    h = (h ^ static_cast<unsigned char>(label[i])) * 16777619UL;
+  return h ^ (h >> 15);
+}
+
+/**
+ * @brief Keys are spaced by 2*EPSILON starting at EPSILON, so the key of the ith string
+ * can be computed, and inverted, without a lookup.
+ */
+edouble keyForIndex(unsigned long index) {
+  return (2.0 * index + 1.0) * cast_double(EPSILON);
+}
+
+class LabelStripe {
+public:
+  LabelStripe() : m_slots(new LabelSlots(64)), m_count(0), m_contention(0), m_retired() {
+    pthread_mutex_init(&m_mutex, NULL);
+  }
+
+  ~LabelStripe() {
+    for(unsigned long i = 0; i <= m_slots->mask; i++)
+      delete m_slots->nodes[i];
+    delete m_slots;
+    for(std::vector<LabelSlots*>::const_iterator it = m_retired.begin(); it != m_retired.end(); ++it)
+      delete *it;
+    pthread_mutex_destroy(&m_mutex);
+  }
+
+  LabelNode* find(const std::string& label, unsigned long hash) const {
+    const LabelSlots* slots = load(m_slots);
+    for(unsigned long i = hash & slots->mask; ; i = (i + 1) & slots->mask) {
+      LabelNode* node = load(slots->nodes[i]);
+      if(node == NULL)
+        return NULL;
+      if(node->hash == hash && node->label == label)
+        return node;
+    }
+  }
+
+  /**
+   * @brief Called with m_mutex held, once find() has failed under the lock.
+   */
+  void insert(LabelNode* node) {
+    if(2 * (m_count + 1) > m_slots->mask + 1)
+      grow();
+    place(m_slots, node);
+    m_count++;
+  }
+
+  pthread_mutex_t m_mutex;
+  LabelSlots* m_slots; /**< Current slot table, replaced (never modified in place) on growth */
+  unsigned long m_count;
+  unsigned long m_contention; /**< Number of insertions that had to wait for m_mutex */
+
+private:
+  static void place(LabelSlots* slots, LabelNode* node) {
+    unsigned long i = node->hash & slots->mask;
+    while(slots->nodes[i] != NULL)
+      i = (i + 1) & slots->mask;
+    publish(slots->nodes[i], node);
+  }
+
+  void grow() {
+    LabelSlots* slots = new LabelSlots(2 * (m_slots->mask + 1));
+    for(unsigned long i = 0; i <= m_slots->mask; i++)
+      if(m_slots->nodes[i] != NULL)
+        place(slots, m_slots->nodes[i]);
+    m_retired.push_back(m_slots);
+    publish(m_slots, slots);
+  }
+
+  std::vector<LabelSlots*> m_retired; /**< Old slot tables, which lock-free readers may still hold */
+};
+
+/**
+ * @brief Like MutexGrabber, but records whether the stripe lock was already held by another thread.
+ */
+class StripeLock {
+public:
+  StripeLock(LabelStripe& stripe) : m_stripe(stripe) {
+    if(pthread_mutex_trylock(&m_stripe.m_mutex) != 0) {
+      pthread_mutex_lock(&m_stripe.m_mutex);
+      m_stripe.m_contention++;
+    }
+  }
+  ~StripeLock() { pthread_mutex_unlock(&m_stripe.m_mutex); }
+private:
+  StripeLock(const StripeLock&);
+  StripeLock& operator=(const StripeLock&);
+  LabelStripe& m_stripe;
+};
+
+/**
+ * @brief Interned strings, striped by hash for insertion, plus an append-only index from key
+ * to string. The index is a list of segments of doubling size, allocated on demand.
+ */
+class LabelTable {
+public:
+  LabelTable() : m_nextIndex(0), m_size(0) {
+    for(unsigned int i = 0; i < MAX_SEGMENTS; i++)
+      m_segments[i] = NULL;
+  }
+
+  ~LabelTable() {
+    for(unsigned int i = 0; i < MAX_SEGMENTS; i++)
+      delete[] m_segments[i];
   }
 
-  std::map< edouble, std::string>& LabelStr::stringFromKeys() {
-    static std::map<edouble, std::string> sl_stringFromKeys;
-    return(sl_stringFromKeys);
+  LabelNode* find(const std::string& label) const {
+    unsigned long hash = hashLabel(label);
+    return m_stripes[hash % LABEL_STRIPES].find(label, hash);
   }
 
+  LabelNode* intern(const std::string& label) {
+    unsigned long hash = hashLabel(label);
+    LabelStripe& stripe = m_stripes[hash % LABEL_STRIPES];
+    LabelNode* node = stripe.find(label, hash);
+    if(node != NULL)
+      return node;
+
+    StripeLock lock(stripe);
+
+    node = stripe.find(label, hash);
+    if(node != NULL)
+      return node;
+
+    node = new LabelNode(label, hash, __atomic_fetch_add(&m_nextIndex, 1, __ATOMIC_RELAXED));
+    debugMsg("LabelStr:insert", " " << keyForIndex(node->index) << " -> " << label);
+    publish(*slot(node->index, true), node);
+    stripe.insert(node);
+    __atomic_fetch_add(&m_size, 1, __ATOMIC_RELAXED);
+    return node;
+  }
+
+  /**
+   * @brief The node for the given key, or NULL if the key does not denote a string.
+   */
+  LabelNode* at(edouble key) const {
+    double n = (cast_double(key) / cast_double(EPSILON) - 1.0) / 2.0;
+    if(!(n >= 0.0 && n < load(m_nextIndex)))
+      return NULL;
+    unsigned long index = static_cast<unsigned long>(n + 0.5);
+    if(cast_double(keyForIndex(index)) != cast_double(key))
+      return NULL;
+    LabelNode** s = slot(index, false);
+    return (s == NULL ? NULL : load(*s));
+  }
+
+  unsigned long size() const {
+    return __atomic_load_n(&m_size, __ATOMIC_RELAXED);
+  }
+
+  unsigned long contention() const {
+    unsigned long count = 0;
+    for(unsigned int i = 0; i < LABEL_STRIPES; i++)
+      count += __atomic_load_n(&m_stripes[i].m_contention, __ATOMIC_RELAXED);
+    return count;
+  }
+
+private:
+  LabelNode** slot(unsigned long index, bool create) const {
+    unsigned long q = index / FIRST_SEGMENT + 1;
+    unsigned int s = 0;
+    while((q >> (s + 1)) != 0)
+      s++;
+    check_error(s < MAX_SEGMENTS, "Too many labels.");
+    LabelNode** segment = load(m_segments[s]);
+    if(segment == NULL) {
+      if(!create)
+        return NULL;
+      unsigned long length = FIRST_SEGMENT << s;
+      LabelNode** fresh = new LabelNode*[length];
+      for(unsigned long i = 0; i < length; i++)
+        fresh[i] = NULL;
+      if(__atomic_compare_exchange_n(&m_segments[s], &segment, fresh, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        segment = fresh;
+      else
+        delete[] fresh; // Another stripe allocated it first; segment now holds theirs.
+    }
+    return &segment[index - FIRST_SEGMENT * ((1UL << s) - 1)];
+  }
+
+  mutable LabelNode** m_segments[MAX_SEGMENTS];
+  unsigned long m_nextIndex;
+  unsigned long m_size;
+  mutable LabelStripe m_stripes[LABEL_STRIPES];
+};
+
+LabelTable& labelTable() {
+  static LabelTable sl_table;
+  return sl_table;
+}
+}
+
 LabelStr::LabelStr() : m_key(0) {
   std::string empty("");
   m_key = getKey(empty);
 }
 
-namespace {
-pthread_mutex_t& LabelStrMutex() {
-  static pthread_mutex_t sl_mutex = PTHREAD_MUTEX_INITIALIZER;
-  return sl_mutex;      
-}
-}
-  
-  
   /**
    * Construction must obtain a key that is efficient to use for later
    * calculations in the domain and must maintain the ordering defined
@@ -100,55 +319,29 @@ LabelStr::LabelStr(edouble key)
   }
 
   unsigned long LabelStr::getSize() {
-    check_error(keysFromString().size() == stringFromKeys().size());
-    return keysFromString().size();
+    return labelTable().size();
   }
 
-  edouble LabelStr::getKey(const std::string& label) {
-    MutexGrabber mg(LabelStrMutex());
-    
-    static edouble sl_counter = EPSILON;
-
-    std::map<std::string, edouble>::iterator it = 
-      keysFromString().find(label);
-
-    if (it != keysFromString().end()) {
-      edouble toRet = it->second;
-      return toRet; // Found it; return the key.
-    }
-
-    // Given label not found, so allocate it.
-    edouble key = sl_counter;
-    sl_counter = sl_counter + 2*EPSILON;
-
-    handleInsertion(key, label);
-    return(key);
+  unsigned long LabelStr::getContentionCount() {
+    return labelTable().contention();
   }
 
-  void LabelStr::handleInsertion(edouble key, const std::string& label) {
-    debugMsg("LabelStr:insert", " " << key << " -> " << label);
-    keysFromString().insert(std::make_pair(label, key));
-    stringFromKeys().insert(std::make_pair(key, label));
+  edouble LabelStr::getKey(const std::string& label) {
+    return keyForIndex(labelTable().intern(label)->index);
   }
 
   const std::string& LabelStr::getString(edouble key){
-    MutexGrabber mg(LabelStrMutex());
-    std::map< edouble, std::string >::const_iterator it = stringFromKeys().find(key);
-    check_error(it != stringFromKeys().end());
-    const std::string& toRet = it->second;
-    return toRet;
+    LabelNode* node = labelTable().at(key);
+    check_error(node != NULL);
+    return node->label;
   }
 
   bool LabelStr::isString(edouble key) {
-    MutexGrabber mg(LabelStrMutex());
-    bool toRet = (stringFromKeys().find(key) != stringFromKeys().end());
-    return toRet;
+    return labelTable().at(key) != NULL;
   }
 
   bool LabelStr::isString(const std::string& candidate){
-    MutexGrabber mg(LabelStrMutex());
-    bool toRet = (keysFromString().find(candidate) != keysFromString().end());
-    return toRet;
+    return labelTable().find(candidate) != NULL;
   }
 
   bool LabelStr::contains(const LabelStr& lblStr) const{
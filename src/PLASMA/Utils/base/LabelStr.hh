@@ -158,6 +158,12 @@ namespace EUROPA {
      */
     static unsigned long getSize();
 
+    /**
+     * @brief Return the number of times a thread adding a new string had to wait for another.
+     * @note Lookups of existing strings never wait, so only insertions are counted.
+     */
+    static unsigned long getContentionCount();
+
     /**
      * @brief Obtain the key for the given string and possibly conducting an insertion into keysFromString.
      * @param label The string to be added or found in the store of all strings in use.
@@ -179,34 +185,17 @@ namespace EUROPA {
     /**
      * @brief The key value used as a proxy for the original string.
      * @note The only instance data.
-     * @see handleInsertion.
+     * @see getKey(const std::string&)
      */
     edouble m_key;
 
-    /**
-     * @brief Constructs an entry in stringFromKeys to allow lookup of strings from a key.
-     * @todo This optimization may not be that significant. Should explore storing the strings in the instance
-     * for such retrieval. It will increase the memeory per instance and hurt on copying or assignment but would provide
-     * faster access to implement toString().
-     * @param key The double value encoding for the given string
-     * @param label the string for which the key has been encoded.
-     * @see s_stringFromKeys, getString()
-     */
-    static void handleInsertion(edouble key, const std::string& label);
-
     /**
      * @brief Obtain the string from the key.
      * @param key The double valued encoding of the string
      * @return a reference to the original string held in the string store.
-     * @see s_stringFromKeys
      */
     static const std::string& getString(edouble key);
 
-    /*static std::map< std::string, double>& keysFromString();*/ /**< Map strings to keys for key allocation on construction. */
-    /*static std::map< double, std::string>& stringFromKeys();*/ /**< Map keys to strings for string retrieval - i.e. toString(). */
-    static std::map<std::string, edouble>& keysFromString();
-    static std::map<edouble, std::string>& stringFromKeys();
-
   };
 }
 #endif
@@ -0,0 +1,374 @@
+#include "MemoryPool.hh"
+#include "Mutex.hh"
+#include "Error.hh"
+#include "Debug.hh"
+
+#include <cstdlib>
+#include <new>
+
+namespace EUROPA {
+
+  /**
+   * @brief Header at the start of each chunk. Chunks are aligned to their size, so the chunk of a
+   * cell is found by masking its address.
+   */
+  struct MemoryPool::Chunk {
+    size_t index;       /*!< Of the size class */
+    size_t cellSize;
+    unsigned int live;  /*!< Cells in use, counting those freed by other threads until collected */
+    unsigned int capacity;
+    char* unused;       /*!< Cells past here have never been allocated */
+    void* freeCells;    /*!< Cells freed, linked through their first word */
+    Chunk* prev;        /*!< Links among the available chunks of the size class in the heap */
+    Chunk* next;
+    Heap* heap;         /*!< The owner, or NULL while a spare */
+    void* remoteCells;  /*!< Cells freed by other threads, under the pool lock */
+    unsigned int remoteCount;
+    Chunk* nextRemote;  /*!< Links among the chunks of the heap with remote cells, under the pool lock */
+  };
+
+  /**
+   * @brief The chunks of one thread. Only the thread touches its available chunks and its counts,
+   * except once it has exited.
+   */
+  struct MemoryPool::Heap {
+    Heap(MemoryPool& p)
+      : pool(p), stats(), remote(NULL), remoteObjects(0), remoteBytes(0), chunkCount(0), exited(false) {
+      for (size_t i = 0; i < SIZE_CLASS_COUNT; i++)
+        available[i] = NULL;
+    }
+
+    MemoryPool& pool;
+    Chunk* available[SIZE_CLASS_COUNT]; /*!< Chunks with at least one free cell, by size class */
+    Stats stats;                  /*!< Counts not yet moved to the pool. Live counts may wrap below zero. */
+    Chunk* remote;                /*!< Chunks with cells freed by other threads, under the pool lock */
+    unsigned long remoteObjects;  /*!< Objects freed by other threads, under the pool lock */
+    unsigned long remoteBytes;
+    unsigned int chunkCount;      /*!< Under the pool lock */
+    bool exited;                  /*!< Under the pool lock */
+  };
+
+  MemoryPool::Stats::Stats()
+    : allocations(0), recycled(0), liveObjects(0), liveBytes(0), reservedBytes(0) {}
+
+  MemoryPool::MemoryPool(const std::string& name)
+    : m_name(name), m_stats() {
+    for (size_t i = 0; i < SIZE_CLASS_COUNT; i++)
+      m_spares[i] = NULL;
+    checkRuntimeError(pthread_key_create(&m_heapKey, releaseHeap) == 0,
+                      "Failed to create the thread key of pool " << name);
+    pthread_mutex_init(&m_mutex, NULL);
+    MutexGrabber grabber(registryMutex());
+    registry().push_back(this);
+  }
+
+  MemoryPool::~MemoryPool() {
+    pthread_mutex_destroy(&m_mutex);
+    pthread_key_delete(m_heapKey);
+  }
+
+  pthread_mutex_t& MemoryPool::registryMutex() {
+    static pthread_mutex_t sl_mutex = PTHREAD_MUTEX_INITIALIZER;
+    return sl_mutex;
+  }
+
+  std::vector<MemoryPool*>& MemoryPool::registry() {
+    static std::vector<MemoryPool*>* sl_pools = new std::vector<MemoryPool*>();
+    return *sl_pools;
+  }
+
+  MemoryPool::Chunk* MemoryPool::chunkOf(void* ptr) {
+    return reinterpret_cast<Chunk*>(reinterpret_cast<size_t>(ptr) & ~(CHUNK_SIZE - 1));
+  }
+
+  MemoryPool::Heap* MemoryPool::currentHeap() const {
+    return static_cast<Heap*>(pthread_getspecific(m_heapKey));
+  }
+
+  void* MemoryPool::allocate(size_t size) {
+    if (size > MAX_CELL_SIZE || size == 0) {
+      MutexGrabber grabber(m_mutex);
+      m_stats.allocations++;
+      m_stats.liveObjects++;
+      m_stats.liveBytes += size;
+      m_stats.reservedBytes += size;
+      grabber.release();
+      return ::operator new(size);
+    }
+
+    const size_t index = (size - 1) / CELL_ALIGNMENT;
+    Heap* heap = currentHeap();
+    if (heap == NULL) {
+      heap = new Heap(*this);
+      pthread_setspecific(m_heapKey, heap);
+    }
+
+    Chunk* chunk = heap->available[index];
+    if (chunk == NULL) {
+      MutexGrabber grabber(m_mutex);
+      chunk = acquireChunk(*heap, index);
+    }
+
+    void* cell = NULL;
+    if (chunk->freeCells != NULL) {
+      cell = chunk->freeCells;
+      chunk->freeCells = *reinterpret_cast<void**>(cell);
+      heap->stats.recycled++;
+    }
+    else {
+      cell = chunk->unused;
+      chunk->unused += chunk->cellSize;
+    }
+    chunk->live++;
+    if (chunk->live == chunk->capacity)
+      unlinkAvailable(heap->available[index], chunk);
+
+    heap->stats.allocations++;
+    heap->stats.liveObjects++;
+    heap->stats.liveBytes += size;
+    return cell;
+  }
+
+  void MemoryPool::deallocate(void* ptr, size_t size) {
+    if (ptr == NULL)
+      return;
+
+    if (size > MAX_CELL_SIZE || size == 0) {
+      MutexGrabber grabber(m_mutex);
+      m_stats.liveObjects--;
+      m_stats.liveBytes -= size;
+      m_stats.reservedBytes -= size;
+      grabber.release();
+      ::operator delete(ptr);
+      return;
+    }
+
+    Chunk* chunk = chunkOf(ptr);
+    checkError(chunk->index == (size - 1) / CELL_ALIGNMENT,
+               "Freeing " << size << " bytes to pool " << m_name << " in a chunk of " << chunk->cellSize << " byte cells.");
+    Heap* heap = currentHeap();
+    if (chunk->heap != heap) {
+      MutexGrabber grabber(m_mutex);
+      deallocateRemote(chunk, ptr, size);
+      return;
+    }
+
+    if (chunk->live == chunk->capacity) {
+      // Full until now, so not among the available chunks
+      linkAvailable(heap->available[chunk->index], chunk);
+    }
+    *reinterpret_cast<void**>(ptr) = chunk->freeCells;
+    chunk->freeCells = ptr;
+    chunk->live--;
+
+    heap->stats.liveObjects--;
+    heap->stats.liveBytes -= size;
+
+    if (chunk->live == 0) {
+      MutexGrabber grabber(m_mutex);
+      flushStats(*heap);
+      reclaimChunk(chunk);
+    }
+  }
+
+  void MemoryPool::deallocateRemote(Chunk* chunk, void* ptr, size_t size) {
+    Heap* heap = chunk->heap;
+    if (!heap->exited) {
+      // Left for the owner to collect, since only it may touch the free cells of the chunk
+      *reinterpret_cast<void**>(ptr) = chunk->remoteCells;
+      chunk->remoteCells = ptr;
+      if (chunk->remoteCount++ == 0) {
+        chunk->nextRemote = heap->remote;
+        heap->remote = chunk;
+      }
+      heap->remoteObjects++;
+      heap->remoteBytes += size;
+      return;
+    }
+
+    if (chunk->live == chunk->capacity)
+      linkAvailable(heap->available[chunk->index], chunk);
+    *reinterpret_cast<void**>(ptr) = chunk->freeCells;
+    chunk->freeCells = ptr;
+    chunk->live--;
+
+    m_stats.liveObjects--;
+    m_stats.liveBytes -= size;
+
+    if (chunk->live == 0) {
+      reclaimChunk(chunk);
+      if (heap->chunkCount == 0)
+        delete heap;
+    }
+  }
+
+  void MemoryPool::trim() {
+    MutexGrabber grabber(m_mutex);
+    Heap* heap = currentHeap();
+    if (heap != NULL) {
+      collectRemoteCells(*heap);
+      flushStats(*heap);
+    }
+    for (size_t i = 0; i < SIZE_CLASS_COUNT; i++) {
+      if (m_spares[i] != NULL) {
+        releaseChunk(m_spares[i]);
+        m_spares[i] = NULL;
+      }
+    }
+    debugMsg("MemoryPool:trim",
+             m_name << " holds " << m_stats.reservedBytes << " bytes for " << m_stats.liveObjects << " objects");
+  }
+
+  MemoryPool::Stats MemoryPool::getStats() const {
+    MutexGrabber grabber(m_mutex);
+    Stats stats = m_stats;
+    const Heap* heap = currentHeap();
+    if (heap != NULL) {
+      stats.allocations += heap->stats.allocations;
+      stats.recycled += heap->stats.recycled;
+      stats.liveObjects += heap->stats.liveObjects;
+      stats.liveBytes += heap->stats.liveBytes;
+    }
+    return stats;
+  }
+
+  void MemoryPool::trimAll() {
+    MutexGrabber grabber(registryMutex());
+    for (std::vector<MemoryPool*>::const_iterator it = registry().begin(); it != registry().end(); ++it)
+      (*it)->trim();
+  }
+
+  void MemoryPool::getAllStats(std::vector<std::pair<std::string, Stats> >& results) {
+    MutexGrabber grabber(registryMutex());
+    for (std::vector<MemoryPool*>::const_iterator it = registry().begin(); it != registry().end(); ++it)
+      results.push_back(std::make_pair((*it)->getName(), (*it)->getStats()));
+  }
+
+  MemoryPool::Chunk* MemoryPool::acquireChunk(Heap& heap, size_t index) {
+    collectRemoteCells(heap);
+    flushStats(heap);
+    Chunk* chunk = heap.available[index];
+    if (chunk != NULL)
+      return chunk;
+
+    if (m_spares[index] != NULL) {
+      chunk = m_spares[index];
+      m_spares[index] = NULL;
+    }
+    else
+      chunk = newChunk(index);
+    chunk->heap = &heap;
+    heap.chunkCount++;
+    linkAvailable(heap.available[index], chunk);
+    return chunk;
+  }
+
+  void MemoryPool::reclaimChunk(Chunk* chunk) {
+    check_error(chunk->live == 0 && chunk->remoteCount == 0);
+    Heap* heap = chunk->heap;
+    unlinkAvailable(heap->available[chunk->index], chunk);
+    chunk->heap = NULL;
+    heap->chunkCount--;
+    if (m_spares[chunk->index] == NULL)
+      m_spares[chunk->index] = chunk;
+    else
+      releaseChunk(chunk);
+  }
+
+  void MemoryPool::collectRemoteCells(Heap& heap) {
+    while (heap.remote != NULL) {
+      Chunk* chunk = heap.remote;
+      heap.remote = chunk->nextRemote;
+      chunk->nextRemote = NULL;
+
+      if (chunk->live == chunk->capacity)
+        linkAvailable(heap.available[chunk->index], chunk);
+      while (chunk->remoteCells != NULL) {
+        void* cell = chunk->remoteCells;
+        chunk->remoteCells = *reinterpret_cast<void**>(cell);
+        *reinterpret_cast<void**>(cell) = chunk->freeCells;
+        chunk->freeCells = cell;
+      }
+      chunk->live -= chunk->remoteCount;
+      chunk->remoteCount = 0;
+
+      if (chunk->live == 0)
+        reclaimChunk(chunk);
+    }
+
+    m_stats.liveObjects -= heap.remoteObjects;
+    m_stats.liveBytes -= heap.remoteBytes;
+    heap.remoteObjects = 0;
+    heap.remoteBytes = 0;
+  }
+
+  void MemoryPool::flushStats(Heap& heap) {
+    // Unsigned arithmetic, so a heap that freed more than it allocated since the last flush still adds up
+    m_stats.allocations += heap.stats.allocations;
+    m_stats.recycled += heap.stats.recycled;
+    m_stats.liveObjects += heap.stats.liveObjects;
+    m_stats.liveBytes += heap.stats.liveBytes;
+    heap.stats = Stats();
+  }
+
+  void MemoryPool::releaseHeap(void* arg) {
+    Heap* heap = static_cast<Heap*>(arg);
+    MemoryPool& pool = heap->pool;
+    MutexGrabber grabber(pool.m_mutex);
+    pool.collectRemoteCells(*heap);
+    pool.flushStats(*heap);
+    heap->exited = true;
+    debugMsg("MemoryPool:releaseHeap",
+             "A thread exited holding " << heap->chunkCount << " chunks of " << pool.m_name);
+    if (heap->chunkCount == 0)
+      delete heap;
+  }
+
+  MemoryPool::Chunk* MemoryPool::newChunk(size_t index) {
+    void* memory = NULL;
+    if (posix_memalign(&memory, CHUNK_SIZE, CHUNK_SIZE) != 0)
+      throw std::bad_alloc();
+
+    Chunk* chunk = static_cast<Chunk*>(memory);
+    chunk->index = index;
+    chunk->cellSize = (index + 1) * CELL_ALIGNMENT;
+    const size_t header = ((sizeof(Chunk) + CELL_ALIGNMENT - 1) / CELL_ALIGNMENT) * CELL_ALIGNMENT;
+    chunk->capacity = static_cast<unsigned int>((CHUNK_SIZE - header) / chunk->cellSize);
+    chunk->live = 0;
+    chunk->unused = static_cast<char*>(memory) + header;
+    chunk->freeCells = NULL;
+    chunk->prev = NULL;
+    chunk->next = NULL;
+    chunk->heap = NULL;
+    chunk->remoteCells = NULL;
+    chunk->remoteCount = 0;
+    chunk->nextRemote = NULL;
+    m_stats.reservedBytes += CHUNK_SIZE;
+    return chunk;
+  }
+
+  void MemoryPool::releaseChunk(Chunk* chunk) {
+    check_error(chunk->live == 0);
+    m_stats.reservedBytes -= CHUNK_SIZE;
+    free(chunk);
+  }
+
+  void MemoryPool::linkAvailable(Chunk*& available, Chunk* chunk) {
+    chunk->prev = NULL;
+    chunk->next = available;
+    if (available != NULL)
+      available->prev = chunk;
+    available = chunk;
+  }
+
+  void MemoryPool::unlinkAvailable(Chunk*& available, Chunk* chunk) {
+    if (chunk->prev != NULL)
+      chunk->prev->next = chunk->next;
+    else
+      available = chunk->next;
+    if (chunk->next != NULL)
+      chunk->next->prev = chunk->prev;
+    chunk->prev = NULL;
+    chunk->next = NULL;
+  }
+}
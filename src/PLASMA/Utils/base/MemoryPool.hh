@@ -0,0 +1,168 @@
+#ifndef H_MemoryPool
+#define H_MemoryPool
+
+/**
+ * @file MemoryPool.hh
+ * @brief Pooled allocation for classes whose instances are created and deleted in large numbers.
+ * @ingroup Utils
+ */
+
+#include <pthread.h>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace EUROPA {
+
+  /**
+   * @class MemoryPool
+   * @brief Allocates small objects in cells carved from large aligned chunks, one free list per size of cell.
+   *
+   * A freed cell is recycled by the next allocation of its size. A chunk whose cells are all free is
+   * returned to the system, except for one kept for each size so that a pool which is repeatedly filled
+   * and emptied does not thrash. trim() releases those too. Requests larger than the largest cell go
+   * straight to the global allocator.
+   *
+   * Each thread allocates from chunks of its own, so allocation and deallocation of small objects
+   * take no lock. The pool lock is only taken to exchange chunks with the pool, to allocate large
+   * objects, and when a thread frees an object from the chunk of another thread. Such cells are
+   * handed back to the owner the next time it runs out of cells, or freed at once if the owner has
+   * exited.
+   *
+   * Pools live for the life of the process, since objects may be deleted during static destruction.
+   * @see DECLARE_POOLED_ALLOCATION
+   */
+  class MemoryPool {
+  public:
+    struct Stats {
+      Stats();
+      unsigned long allocations;   /*!< Allocations over the life of the pool */
+      unsigned long recycled;      /*!< Allocations satisfied by a freed cell */
+      unsigned long liveObjects;   /*!< Objects allocated and not yet freed */
+      unsigned long liveBytes;     /*!< Bytes requested by the live objects */
+      unsigned long reservedBytes; /*!< Bytes held from the system, whether in use or not */
+    };
+
+    MemoryPool(const std::string& name);
+
+    const std::string& getName() const {return m_name;}
+
+    void* allocate(size_t size);
+
+    /**
+     * @param size Must be the size passed to allocate.
+     */
+    void deallocate(void* ptr, size_t size);
+
+    /**
+     * @brief Return every chunk with no live objects to the system.
+     */
+    void trim();
+
+    /**
+     * @brief Counts of other threads are included up to their last exchange of chunks with the pool.
+     */
+    Stats getStats() const;
+
+    /**
+     * @brief Trim all pools.
+     */
+    static void trimAll();
+
+    /**
+     * @brief Statistics of all pools, by name.
+     */
+    static void getAllStats(std::vector<std::pair<std::string, Stats> >& results);
+
+  private:
+    MemoryPool(const MemoryPool&);
+    MemoryPool& operator=(const MemoryPool&);
+    ~MemoryPool();
+
+    struct Chunk;
+    struct Heap;
+
+    static const size_t CELL_ALIGNMENT = 16;
+    static const size_t MAX_CELL_SIZE = 512;
+    static const size_t CHUNK_SIZE = 64 * 1024;
+    static const size_t SIZE_CLASS_COUNT = MAX_CELL_SIZE / CELL_ALIGNMENT;
+
+    static Chunk* chunkOf(void* ptr);
+
+    /**
+     * @brief The heap of the calling thread, or NULL if it has not allocated from this pool.
+     */
+    Heap* currentHeap() const;
+
+    /**
+     * @brief Give the heap a chunk with a free cell of the size class. Requires the pool lock.
+     */
+    Chunk* acquireChunk(Heap& heap, size_t index);
+
+    /**
+     * @brief Take a chunk with no live objects back from its heap. Requires the pool lock.
+     */
+    void reclaimChunk(Chunk* chunk);
+
+    /**
+     * @brief Free the cells other threads freed in the chunks of the heap. Requires the pool lock.
+     */
+    void collectRemoteCells(Heap& heap);
+
+    /**
+     * @brief Move the counts of the heap into the pool. Requires the pool lock.
+     */
+    void flushStats(Heap& heap);
+
+    /**
+     * @brief Free a cell from a chunk of another heap. Requires the pool lock.
+     */
+    void deallocateRemote(Chunk* chunk, void* ptr, size_t size);
+
+    /**
+     * @brief Called when a thread with a heap exits.
+     */
+    static void releaseHeap(void* heap);
+
+    Chunk* newChunk(size_t index);
+    void releaseChunk(Chunk* chunk);
+    static void linkAvailable(Chunk*& available, Chunk* chunk);
+    static void unlinkAvailable(Chunk*& available, Chunk* chunk);
+
+    static pthread_mutex_t& registryMutex();
+    static std::vector<MemoryPool*>& registry();
+
+    const std::string m_name;
+    Chunk* m_spares[SIZE_CLASS_COUNT]; /*!< A chunk with no live objects for each size, kept for reuse */
+    Stats m_stats;
+    pthread_key_t m_heapKey;
+    mutable pthread_mutex_t m_mutex;
+  };
+
+}
+
+/**
+ * @def DECLARE_POOLED_ALLOCATION
+ * @brief Declares class specific operators new and delete, in the body of a class with a virtual
+ * destructor, which allocate the class and its subclasses from a MemoryPool of their own.
+ * Define with DEFINE_POOLED_ALLOCATION in the implementation file. Building with
+ * EUROPA_NO_MEMORY_POOLS leaves allocation to the global operators, as memory checkers prefer.
+ */
+#ifndef EUROPA_NO_MEMORY_POOLS
+#define DECLARE_POOLED_ALLOCATION \
+  static EUROPA::MemoryPool& memoryPool(); \
+  static void* operator new(size_t size) {return memoryPool().allocate(size);} \
+  static void operator delete(void* ptr, size_t size) {memoryPool().deallocate(ptr, size);}
+
+#define DEFINE_POOLED_ALLOCATION(type) \
+  EUROPA::MemoryPool& type::memoryPool() { \
+    static EUROPA::MemoryPool* sl_pool = new EUROPA::MemoryPool(#type); \
+    return *sl_pool; \
+  }
+#else
+#define DECLARE_POOLED_ALLOCATION
+#define DEFINE_POOLED_ALLOCATION(type)
+#endif
+
+#endif
@@ -31,11 +31,13 @@
 #include "Entity.hh"
 #include "XMLUtils.hh"
 #include "Number.hh"
+#include "MemoryPool.hh"
 #include "Engine.hh"
 #include "tinyxml.h"
 #include "CommonDefs.hh"
 
 #include <list>
+#include <vector>
 #include <sstream>
 #include <iostream>
 #include <fstream>
@@ -344,6 +346,7 @@ private:
   static bool testBadIdUsage();
   static bool testIdConversion();
   static bool testConstId();
+  static bool testTableChurn();
 };
 
 bool IdTests::test() {
@@ -357,6 +360,7 @@ bool IdTests::test() {
   EUROPA_runTest(testBadIdUsage);
   EUROPA_runTest(testIdConversion);
   EUROPA_runTest(testConstId);
+  EUROPA_runTest(testTableChurn);
   return(true);
 }
 
@@ -587,6 +591,31 @@ bool IdTests::testConstId()
   return true;
 }
 
+bool IdTests::testTableChurn()
+{
+#ifndef EUROPA_FAST
+  unsigned long initialSize = IdTable::size();
+#endif
+  // Enough entries to force the table to grow, then remove every other one so
+  // removal has to shift probe chains back.
+  std::vector< Id<Foo> > foos;
+  for(unsigned int i = 0; i < 1000; i++)
+    foos.push_back(Id<Foo>(new Foo()));
+  non_fast_only_assert(IdTable::size() == initialSize + 1000);
+
+  for(unsigned int i = 0; i < foos.size(); i += 2)
+    foos[i].release();
+  non_fast_only_assert(IdTable::size() == initialSize + 500);
+
+  for(unsigned int i = 1; i < foos.size(); i += 2) {
+    CPPUNIT_ASSERT(foos[i].isValid());
+    non_fast_only_assert(IdTable::allocated((unsigned long) (Foo*) foos[i]));
+    foos[i].release();
+  }
+  non_fast_only_assert(IdTable::size() == initialSize);
+  return true;
+}
+
 class LabelTests {
 public:
   static bool test(){
@@ -594,6 +623,7 @@ public:
     EUROPA_runTest(testElementCounting);
     EUROPA_runTest(testElementAccess);
     EUROPA_runTest(testComparisons);
+    EUROPA_runTest(testConcurrentInsertion);
     return true;
   }
 
@@ -665,6 +695,36 @@ private:
     CPPUNIT_ASSERT(!lbl5.contains("I"));
     return true;
   }
+
+  static void* internLabels(void* arg) {
+    std::vector<edouble>& keys = *static_cast<std::vector<edouble>*>(arg);
+    for(unsigned int i = 0; i < keys.size(); i++) {
+      std::stringstream str;
+      str << "ConcurrentLabel" << i;
+      keys[i] = LabelStr(str.str()).getKey();
+    }
+    return NULL;
+  }
+
+  static bool testConcurrentInsertion(){
+    // Every thread interns the same new strings, enough to grow each stripe and the key index.
+    const unsigned int threadCount = 4;
+    std::vector< std::vector<edouble> > keys(threadCount, std::vector<edouble>(5000));
+    pthread_t threads[threadCount];
+    for(unsigned int t = 0; t < threadCount; t++)
+      pthread_create(&threads[t], NULL, internLabels, &keys[t]);
+    for(unsigned int t = 0; t < threadCount; t++)
+      pthread_join(threads[t], NULL);
+
+    for(unsigned int i = 0; i < keys[0].size(); i++) {
+      std::stringstream str;
+      str << "ConcurrentLabel" << i;
+      for(unsigned int t = 1; t < threadCount; t++)
+        CPPUNIT_ASSERT(keys[t][i] == keys[0][i]);
+      CPPUNIT_ASSERT(LabelStr(keys[0][i]).toString() == str.str());
+    }
+    return true;
+  }
 };
 
 class EntityTest {
@@ -894,6 +954,8 @@ public:
     EUROPA_runTest(testEintInfinity);
     EUROPA_runTest(testEdouble);
     EUROPA_runTest(testEdoubleInfinity);
+    EUROPA_runTest(testInfiniteOperands);
+    EUROPA_runTest(testOverflow);
     return true;
   }
 private:
@@ -1040,6 +1102,196 @@ private:
     CPPUNIT_ASSERT((minf + pinf) == 0);
     return true;
   }
+
+  static bool testInfiniteOperands() {
+    eint pinf(std::numeric_limits<eint>::infinity());
+    eint minf(std::numeric_limits<eint>::minus_infinity());
+    edouble dpinf(std::numeric_limits<edouble>::infinity());
+    edouble dminf(std::numeric_limits<edouble>::minus_infinity());
+
+    CPPUNIT_ASSERT((pinf - 100) == pinf);
+    CPPUNIT_ASSERT((100 - pinf) == minf);
+    CPPUNIT_ASSERT((pinf * 3) == pinf);
+    CPPUNIT_ASSERT((pinf * -3) == minf);
+    CPPUNIT_ASSERT((minf * -3) == pinf);
+    CPPUNIT_ASSERT((pinf * 0) == 0);
+    CPPUNIT_ASSERT((pinf / 4) == pinf);
+    CPPUNIT_ASSERT((minf / 4) == minf);
+    CPPUNIT_ASSERT((eint(7) / pinf) == 0);
+    CPPUNIT_ASSERT((eint(7) / 2) == 3);
+    CPPUNIT_ASSERT((eint(-7) / 2) == -3);
+    CPPUNIT_ASSERT((eint(12) / 4UL) == 3);
+    CPPUNIT_ASSERT((eint(-12) / 4UL) == -3);
+    CPPUNIT_ASSERT((pinf / 4UL) == pinf);
+    CPPUNIT_ASSERT((eint(12) / 4L) == 3);
+    CPPUNIT_ASSERT((eint(12) * 4UL) == 48);
+
+    CPPUNIT_ASSERT((dpinf * 0.5) == dpinf);
+    CPPUNIT_ASSERT((dpinf * -0.5) == dminf);
+    CPPUNIT_ASSERT((dminf + 1e6) == dminf);
+    CPPUNIT_ASSERT((dpinf / 1e6) == dpinf);
+    CPPUNIT_ASSERT((edouble(2.5) / dminf) == 0);
+    CPPUNIT_ASSERT((edouble(2.5) * 2) == 5);
+    CPPUNIT_ASSERT((eint(2) + edouble(0.5)) == 2.5);
+    CPPUNIT_ASSERT((pinf + edouble(-0.5)) == dpinf);
+    return true;
+  }
+
+  static bool testOverflow() {
+    eint big(cast_basis(std::numeric_limits<eint>::max()) / 2 + 1);
+    edouble dbig(cast_double(std::numeric_limits<edouble>::max()) / 2 + 1);
+#ifdef EUROPA_FAST_NUMERICS
+    // Results past infinity saturate
+    CPPUNIT_ASSERT((big * 4) == std::numeric_limits<eint>::infinity());
+    CPPUNIT_ASSERT((-big * 4) == std::numeric_limits<eint>::minus_infinity());
+    CPPUNIT_ASSERT((dbig * 4) == std::numeric_limits<edouble>::infinity());
+    CPPUNIT_ASSERT((eint(5) / 0) == std::numeric_limits<eint>::infinity());
+#elif !defined(NO_OVERFLOW_CHECKING)
+    // Results past infinity are errors
+    bool thrown = false;
+    try {
+      CPPUNIT_ASSERT(big * 4 > 0);
+    }
+    catch(const std::overflow_error&) {
+      thrown = true;
+    }
+    CPPUNIT_ASSERT(thrown);
+    thrown = false;
+    try {
+      CPPUNIT_ASSERT(-dbig * 4 < 0);
+    }
+    catch(const std::underflow_error&) {
+      thrown = true;
+    }
+    CPPUNIT_ASSERT(thrown);
+#endif
+    CPPUNIT_ASSERT((big - big + big) == big);
+    return true;
+  }
+};
+
+class PooledObject {
+public:
+  DECLARE_POOLED_ALLOCATION
+  PooledObject() {data[0] = 'a';}
+  virtual ~PooledObject() {}
+private:
+  char data[40];
+};
+
+class LargePooledObject : public PooledObject {
+  char moreData[1024];
+};
+
+DEFINE_POOLED_ALLOCATION(PooledObject)
+
+class MemoryPoolTest {
+public:
+  static bool test() {
+#ifndef EUROPA_NO_MEMORY_POOLS
+    EUROPA_runTest(testRecycling);
+    EUROPA_runTest(testRelease);
+    EUROPA_runTest(testThreads);
+#endif
+    return true;
+  }
+
+#ifndef EUROPA_NO_MEMORY_POOLS
+  static bool testRecycling() {
+    MemoryPool::Stats before = PooledObject::memoryPool().getStats();
+    std::vector<PooledObject*> objects;
+    for(int i = 0; i < 10000; i++)
+      objects.push_back(i % 100 == 0 ? new LargePooledObject() : new PooledObject());
+    MemoryPool::Stats stats = PooledObject::memoryPool().getStats();
+    CPPUNIT_ASSERT(stats.liveObjects == before.liveObjects + 10000);
+    CPPUNIT_ASSERT(stats.allocations == before.allocations + 10000);
+    CPPUNIT_ASSERT(stats.liveBytes == before.liveBytes + 9900 * sizeof(PooledObject) + 100 * sizeof(LargePooledObject));
+    CPPUNIT_ASSERT(stats.reservedBytes >= stats.liveBytes);
+
+    // Free every other object, and the same number allocated again come from the freed cells
+    for(unsigned int i = 1; i < objects.size(); i += 2) {
+      delete objects[i];
+      objects[i] = new PooledObject();
+    }
+    MemoryPool::Stats after = PooledObject::memoryPool().getStats();
+    CPPUNIT_ASSERT(after.liveObjects == stats.liveObjects);
+    CPPUNIT_ASSERT(after.recycled == stats.recycled + 5000);
+    CPPUNIT_ASSERT(after.reservedBytes == stats.reservedBytes);
+
+    for(unsigned int i = 0; i < objects.size(); i++)
+      delete objects[i];
+    CPPUNIT_ASSERT(PooledObject::memoryPool().getStats().liveObjects == before.liveObjects);
+    return true;
+  }
+
+  static bool testRelease() {
+    std::vector<PooledObject*> objects;
+    for(int i = 0; i < 10000; i++)
+      objects.push_back(new PooledObject());
+    for(unsigned int i = 0; i < objects.size(); i++)
+      delete objects[i];
+
+    // At most one chunk is kept until trimmed
+    CPPUNIT_ASSERT(PooledObject::memoryPool().getStats().liveObjects == 0);
+    CPPUNIT_ASSERT(PooledObject::memoryPool().getStats().reservedBytes <= 64 * 1024);
+    MemoryPool::trimAll();
+    CPPUNIT_ASSERT(PooledObject::memoryPool().getStats().reservedBytes == 0);
+
+    std::vector<std::pair<std::string, MemoryPool::Stats> > allStats;
+    MemoryPool::getAllStats(allStats);
+    bool found = false;
+    for(unsigned int i = 0; i < allStats.size(); i++)
+      found = found || allStats[i].first == "PooledObject";
+    CPPUNIT_ASSERT(found);
+    return true;
+  }
+
+  static void* allocateObjects(void* arg) {
+    std::vector<PooledObject*>& objects = *static_cast<std::vector<PooledObject*>*>(arg);
+    for(unsigned int i = 0; i < objects.size(); i++)
+      objects[i] = new PooledObject();
+    return NULL;
+  }
+
+  static void* deleteObjects(void* arg) {
+    std::vector<PooledObject*>& objects = *static_cast<std::vector<PooledObject*>*>(arg);
+    for(unsigned int i = 0; i < objects.size(); i++)
+      delete objects[i];
+    return NULL;
+  }
+
+  static bool testThreads() {
+    MemoryPool& pool = PooledObject::memoryPool();
+    pool.trim();
+    MemoryPool::Stats before = pool.getStats();
+
+    // Threads allocate from chunks of their own, and objects of a thread that has exited are freed at once
+    const unsigned int threadCount = 4;
+    std::vector< std::vector<PooledObject*> > objects(threadCount, std::vector<PooledObject*>(5000));
+    pthread_t threads[threadCount];
+    for(unsigned int t = 0; t < threadCount; t++)
+      pthread_create(&threads[t], NULL, allocateObjects, &objects[t]);
+    for(unsigned int t = 0; t < threadCount; t++)
+      pthread_join(threads[t], NULL);
+    CPPUNIT_ASSERT(pool.getStats().liveObjects == before.liveObjects + threadCount * 5000);
+    for(unsigned int t = 0; t < threadCount; t++)
+      deleteObjects(&objects[t]);
+    CPPUNIT_ASSERT(pool.getStats().liveObjects == before.liveObjects);
+
+    // Objects freed by another thread go back to their owner
+    allocateObjects(&objects[0]);
+    pthread_t thread;
+    pthread_create(&thread, NULL, deleteObjects, &objects[0]);
+    pthread_join(thread, NULL);
+    pool.trim();
+    MemoryPool::Stats after = pool.getStats();
+    CPPUNIT_ASSERT(after.liveObjects == before.liveObjects);
+    CPPUNIT_ASSERT(after.liveBytes == before.liveBytes);
+    CPPUNIT_ASSERT(after.allocations == before.allocations + (threadCount + 1) * 5000);
+    CPPUNIT_ASSERT(after.reservedBytes == before.reservedBytes);
+    return true;
+  }
+#endif
 };
 
 void UtilModuleTests::errorTests()
@@ -1078,3 +1330,8 @@ void UtilModuleTests::xmlIOTests()
 {
 	XMLIOTest::test();
 }
+
+void UtilModuleTests::memoryPoolTests()
+{
+	MemoryPoolTest::test();
+}
@@ -19,6 +19,7 @@ class UtilModuleTests : public CppUnit::TestFixture {
   CPPUNIT_TEST(xmlTests);
   CPPUNIT_TEST(numberTests);
   CPPUNIT_TEST(xmlIOTests);
+  CPPUNIT_TEST(memoryPoolTests);
 //   CPPUNIT_TEST(loggerTests);
   CPPUNIT_TEST_SUITE_END();
 
@@ -36,6 +37,7 @@ public:
   void xmlTests();
   void numberTests();
   void xmlIOTests();
+  void memoryPoolTests();
 //   void loggerTests();
 };
 